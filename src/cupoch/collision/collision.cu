@@ -22,9 +22,11 @@
 #include <lbvh/query.cuh>
 
 #include "cupoch/collision/collision.h"
+#include "cupoch/geometry/distancetransform.h"
 #include "cupoch/geometry/intersection_test.h"
 #include "cupoch/geometry/lineset.h"
 #include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/geometry/sparse_occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 
 namespace cupoch {
@@ -590,6 +592,105 @@ struct convert_index_functor2 {
     }
 };
 
+struct occupancy_voxel_to_voxel_functor {
+    occupancy_voxel_to_voxel_functor(int resolution)
+        : resolution_(resolution){};
+    const int resolution_;
+    __device__ thrust::tuple<Eigen::Vector3i, geometry::Voxel> operator()(
+            const geometry::OccupancyVoxel& v) const {
+        const Eigen::Vector3i key = v.grid_index_.cast<int>() -
+                                    Eigen::Vector3i::Constant(resolution_ / 2);
+        return thrust::make_tuple(key, geometry::Voxel(key, v.color_));
+    }
+};
+
+std::shared_ptr<geometry::VoxelGrid> CreateOccupiedVoxelGrid(
+        const geometry::SparseOccupancyGrid& occgrid) {
+    auto out = std::make_shared<geometry::VoxelGrid>();
+    out->voxel_size_ = occgrid.voxel_size_;
+    out->origin_ = occgrid.origin_;
+    auto occupied = occgrid.ExtractOccupiedVoxels();
+    out->voxels_keys_.resize(occupied->size());
+    out->voxels_values_.resize(occupied->size());
+    thrust::transform(occupied->begin(), occupied->end(),
+                      make_tuple_begin(out->voxels_keys_, out->voxels_values_),
+                      occupancy_voxel_to_voxel_functor(occgrid.resolution_));
+    return out;
+}
+
+struct bounding_sphere_functor {
+    __device__ thrust::tuple<Eigen::Vector3f, float> operator()(
+            const PrimitivePack& primitive) const {
+        const Eigen::Vector3f center =
+                primitive.primitive_.transform_.block<3, 1>(0, 3);
+        switch (primitive.primitive_.type_) {
+            case Primitive::PrimitiveType::Box:
+                return thrust::make_tuple(
+                        center, 0.5f * primitive.box_.lengths_.norm());
+            case Primitive::PrimitiveType::Sphere:
+                return thrust::make_tuple(center, primitive.sphere_.radius_);
+            case Primitive::PrimitiveType::Capsule:
+                return thrust::make_tuple(center,
+                                          0.5f * primitive.capsule_.height_ +
+                                                  primitive.capsule_.radius_);
+            case Primitive::PrimitiveType::Cylinder: {
+                const Cylinder& cylinder = primitive.cylinder_;
+                return thrust::make_tuple(
+                        center, sqrtf(cylinder.radius_ * cylinder.radius_ +
+                                      0.25f * cylinder.height_ *
+                                              cylinder.height_));
+            }
+            default:
+                return thrust::make_tuple(center, 0.0f);
+        }
+    }
+};
+
+struct intersect_sphere_distance_functor {
+    intersect_sphere_distance_functor(const geometry::DistanceVoxel* voxels,
+                                      float voxel_size,
+                                      int resolution,
+                                      const Eigen::Vector3f& origin,
+                                      const Eigen::Vector3i& ring_offset,
+                                      float margin)
+        : voxels_(voxels),
+          voxel_size_(voxel_size),
+          resolution_(resolution),
+          origin_(origin),
+          ring_offset_(ring_offset),
+          margin_(margin){};
+    const geometry::DistanceVoxel* voxels_;
+    const float voxel_size_;
+    const int resolution_;
+    const Eigen::Vector3f origin_;
+    const Eigen::Vector3i ring_offset_;
+    const float margin_;
+    __device__ Eigen::Vector2i operator()(
+            const thrust::tuple<size_t, Eigen::Vector3f, float, float>& x)
+            const {
+        const Eigen::Vector3f& center = thrust::get<1>(x);
+        const float radius = thrust::get<2>(x);
+        const float dist = thrust::get<3>(x);
+        const Eigen::Vector3i idx =
+                Eigen::device_vectorize<float, 3, ::floor>(
+                        ((center - origin_) / voxel_size_).array() +
+                        0.5f * resolution_)
+                        .cast<int>();
+        // The distances are measured between voxel centers, so half of the
+        // voxel diagonal is added to stay conservative.
+        if ((idx.array() < 0).any() || (idx.array() >= resolution_).any() ||
+            dist > radius + margin_ + 0.5f * sqrtf(3.0f) * voxel_size_) {
+            return Eigen::Vector2i(-1, -1);
+        }
+        const Eigen::Vector3ui16 nearest =
+                voxels_[RingIndexOf(idx, ring_offset_, resolution_)]
+                        .nearest_index_;
+        if (nearest[0] >= resolution_) return Eigen::Vector2i(-1, -1);
+        return Eigen::Vector2i(thrust::get<0>(x),
+                               IndexOf(nearest.cast<int>(), resolution_));
+    }
+};
+
 }  // namespace
 
 CollisionResult::CollisionResult()
@@ -1219,5 +1320,105 @@ std::shared_ptr<CollisionResult> ComputeIntersection(
     return intsct.Compute<geometry::OccupancyGrid>(occgrid, margin);
 }
 
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const PrimitiveArray& primitives,
+        const geometry::DistanceTransform& dt,
+        float margin) {
+    auto out = std::make_shared<CollisionResult>(
+            CollisionResult::CollisionType::Primitives,
+            CollisionResult::CollisionType::DistanceTransform);
+    if (primitives.empty()) {
+        utility::LogWarning("[ComputeIntersection] primitives are empty.");
+        return out;
+    }
+    utility::device_vector<Eigen::Vector3f> centers(primitives.size());
+    utility::device_vector<float> radii(primitives.size());
+    thrust::transform(primitives.begin(), primitives.end(),
+                      make_tuple_begin(centers, radii),
+                      bounding_sphere_functor());
+    const auto dists = dt.GetInterpolatedDistances(centers).first;
+    intersect_sphere_distance_functor func(
+            thrust::raw_pointer_cast(dt.voxels_.data()), dt.voxel_size_,
+            dt.resolution_, dt.origin_, dt.ring_offset_, margin);
+    out->collision_index_pairs_.resize(primitives.size());
+    thrust::transform(enumerate_begin(centers, radii, dists),
+                      enumerate_end(centers, radii, dists),
+                      out->collision_index_pairs_.begin(), func);
+    remove_negative(utility::exec_policy(0)->on(0),
+                    out->collision_index_pairs_);
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::DistanceTransform& dt,
+        const PrimitiveArray& primitives,
+        float margin) {
+    auto out = ComputeIntersection(primitives, dt, margin);
+    out->first_ = CollisionResult::CollisionType::DistanceTransform;
+    out->second_ = CollisionResult::CollisionType::Primitives;
+    swap_index(out->collision_index_pairs_);
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::VoxelGrid& voxelgrid,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(voxelgrid, *occvoxels, margin);
+    out->second_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const geometry::VoxelGrid& voxelgrid,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(*occvoxels, voxelgrid, margin);
+    out->first_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::LineSet<3>& lineset,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(lineset, *occvoxels, margin);
+    out->second_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const geometry::LineSet<3>& lineset,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(*occvoxels, lineset, margin);
+    out->first_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const PrimitiveArray& primitives,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(primitives, *occvoxels, margin);
+    out->second_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const PrimitiveArray& primitives,
+        float margin) {
+    auto occvoxels = CreateOccupiedVoxelGrid(occgrid);
+    auto out = ComputeIntersection(*occvoxels, primitives, margin);
+    out->first_ = CollisionResult::CollisionType::OccupancyGrid;
+    return out;
+}
+
 }  // namespace collision
 }  // namespace cupoch
\ No newline at end of file
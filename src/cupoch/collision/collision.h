@@ -29,9 +29,11 @@ namespace cupoch {
 
 namespace geometry {
 class VoxelGrid;
+class DistanceTransform;
 template <int Dim>
 class LineSet;
 class OccupancyGrid;
+class SparseOccupancyGrid;
 }  // namespace geometry
 
 namespace collision {
@@ -43,6 +45,7 @@ struct CollisionResult {
         VoxelGrid = 2,
         OccupancyGrid = 3,
         LineSet = 4,
+        DistanceTransform = 5,
     };
     CollisionType first_;
     CollisionType second_;
@@ -140,6 +143,55 @@ std::shared_ptr<CollisionResult> ComputeIntersection(
         const PrimitiveArray& primitives,
         float margin = 0.0f);
 
+/// Collision against a SparseOccupancyGrid is computed on its occupied voxels.
+/// The indices of the sparse grid in the result refer to the order of
+/// SparseOccupancyGrid::ExtractOccupiedVoxels().
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::VoxelGrid& voxelgrid,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const geometry::VoxelGrid& voxelgrid,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::LineSet<3>& lineset,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const geometry::LineSet<3>& lineset,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const PrimitiveArray& primitives,
+        const geometry::SparseOccupancyGrid& occgrid,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::SparseOccupancyGrid& occgrid,
+        const PrimitiveArray& primitives,
+        float margin = 0.0f);
+
+/// Collision against a DistanceTransform compares the interpolated distance
+/// at the primitive center with its radius plus half of the voxel diagonal,
+/// since the distances are measured between voxel centers; primitives other
+/// than spheres are checked by their bounding sphere. The check is thus
+/// conservative by up to one voxel. The second index is the linear index of
+/// the nearest obstacle voxel. Primitives outside of the grid do not collide.
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const PrimitiveArray& primitives,
+        const geometry::DistanceTransform& dt,
+        float margin = 0.0f);
+
+std::shared_ptr<CollisionResult> ComputeIntersection(
+        const geometry::DistanceTransform& dt,
+        const PrimitiveArray& primitives,
+        float margin = 0.0f);
+
 std::shared_ptr<CollisionResult> ComputeIntersection(
         const PrimitiveArray& primitives1,
         const PrimitiveArray& primitives2,
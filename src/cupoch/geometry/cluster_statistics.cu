@@ -0,0 +1,281 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/scatter.h>
+
+#include "cupoch/geometry/cluster_statistics.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/eigenvalue.h"
+#include "cupoch/utility/helper.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+typedef thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f, int>
+        SumMinMaxCount;
+
+struct point_to_sum_min_max_count_functor {
+    __device__ SumMinMaxCount operator()(const Eigen::Vector3f &pt) const {
+        return thrust::make_tuple(pt, pt, pt, 1);
+    }
+};
+
+struct sum_min_max_count_functor {
+    __device__ SumMinMaxCount operator()(const SumMinMaxCount &lhs,
+                                         const SumMinMaxCount &rhs) const {
+        return thrust::make_tuple(
+                Eigen::Vector3f(thrust::get<0>(lhs) + thrust::get<0>(rhs)),
+                Eigen::Vector3f(thrust::get<1>(lhs).array().min(
+                        thrust::get<1>(rhs).array())),
+                Eigen::Vector3f(thrust::get<2>(lhs).array().max(
+                        thrust::get<2>(rhs).array())),
+                thrust::get<3>(lhs) + thrust::get<3>(rhs));
+    }
+};
+
+struct centered_outer_product_functor {
+    centered_outer_product_functor(const Eigen::Vector3f *centroids)
+        : centroids_(centroids){};
+    const Eigen::Vector3f *centroids_;
+    __device__ Eigen::Matrix3f operator()(
+            const thrust::tuple<int, Eigen::Vector3f> &x) const {
+        const Eigen::Vector3f centered =
+                thrust::get<1>(x) - centroids_[thrust::get<0>(x)];
+        return centered * centered.transpose();
+    }
+};
+
+// Principal axes sorted by decreasing variance, forming a right-handed frame.
+struct principal_axes_functor {
+    __device__ Eigen::Matrix3f operator()(const Eigen::Matrix3f &cov) const {
+        Eigen::Matrix3f a = cov;
+        const auto evecs = utility::FastEigen3x3(a);
+        Eigen::Vector3f x_axis = thrust::get<1>(evecs);
+        if (x_axis.squaredNorm() == 0) return Eigen::Matrix3f::Identity();
+        x_axis.normalize();
+        Eigen::Vector3f z_axis = thrust::get<0>(evecs);
+        z_axis -= x_axis * x_axis.dot(z_axis);
+        if (z_axis.squaredNorm() < 1.0e-12) {
+            z_axis = (abs(x_axis[0]) < 0.9) ? Eigen::Vector3f::UnitX()
+                                            : Eigen::Vector3f::UnitY();
+            z_axis -= x_axis * x_axis.dot(z_axis);
+        }
+        z_axis.normalize();
+        Eigen::Matrix3f R;
+        R.col(0) = x_axis;
+        R.col(1) = z_axis.cross(x_axis);
+        R.col(2) = z_axis;
+        return R;
+    }
+};
+
+struct project_to_principal_axes_functor {
+    project_to_principal_axes_functor(const Eigen::Vector3f *centroids,
+                                      const Eigen::Matrix3f *rotations)
+        : centroids_(centroids), rotations_(rotations){};
+    const Eigen::Vector3f *centroids_;
+    const Eigen::Matrix3f *rotations_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator()(
+            const thrust::tuple<int, Eigen::Vector3f> &x) const {
+        const int label = thrust::get<0>(x);
+        const Eigen::Vector3f local = rotations_[label].transpose() *
+                                      (thrust::get<1>(x) - centroids_[label]);
+        return thrust::make_tuple(local, local);
+    }
+};
+
+struct min_max_functor {
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator()(
+            const thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> &lhs,
+            const thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> &rhs) const {
+        return thrust::make_tuple(
+                Eigen::Vector3f(thrust::get<0>(lhs).array().min(
+                        thrust::get<0>(rhs).array())),
+                Eigen::Vector3f(thrust::get<1>(lhs).array().max(
+                        thrust::get<1>(rhs).array())));
+    }
+};
+
+struct compute_obb_functor {
+    compute_obb_functor(const Eigen::Vector3f *centroids,
+                        const Eigen::Matrix3f *rotations,
+                        const Eigen::Vector3f *local_min_bounds,
+                        const Eigen::Vector3f *local_max_bounds)
+        : centroids_(centroids),
+          rotations_(rotations),
+          local_min_bounds_(local_min_bounds),
+          local_max_bounds_(local_max_bounds){};
+    const Eigen::Vector3f *centroids_;
+    const Eigen::Matrix3f *rotations_;
+    const Eigen::Vector3f *local_min_bounds_;
+    const Eigen::Vector3f *local_max_bounds_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator()(
+            size_t idx) const {
+        const Eigen::Vector3f local_center =
+                0.5 * (local_min_bounds_[idx] + local_max_bounds_[idx]);
+        return thrust::make_tuple(
+                Eigen::Vector3f(rotations_[idx] * local_center +
+                                centroids_[idx]),
+                Eigen::Vector3f(local_max_bounds_[idx] -
+                                local_min_bounds_[idx]));
+    }
+};
+
+}  // namespace
+
+std::vector<AxisAlignedBoundingBox<3>>
+ClusterStatistics::GetAxisAlignedBoundingBoxes() const {
+    thrust::host_vector<Eigen::Vector3f> min_bounds = min_bounds_;
+    thrust::host_vector<Eigen::Vector3f> max_bounds = max_bounds_;
+    std::vector<AxisAlignedBoundingBox<3>> boxes;
+    boxes.reserve(min_bounds.size());
+    for (size_t i = 0; i < min_bounds.size(); ++i) {
+        boxes.emplace_back(min_bounds[i], max_bounds[i]);
+    }
+    return boxes;
+}
+
+std::vector<OrientedBoundingBox> ClusterStatistics::GetOrientedBoundingBoxes()
+        const {
+    thrust::host_vector<Eigen::Vector3f> centers = obb_centers_;
+    thrust::host_vector<Eigen::Matrix3f> rotations = obb_rotations_;
+    thrust::host_vector<Eigen::Vector3f> extents = obb_extents_;
+    std::vector<OrientedBoundingBox> boxes;
+    boxes.reserve(centers.size());
+    for (size_t i = 0; i < centers.size(); ++i) {
+        boxes.emplace_back(centers[i], rotations[i], extents[i]);
+    }
+    return boxes;
+}
+
+std::shared_ptr<ClusterStatistics> ClusterStatistics::CreateFromLabels(
+        const PointCloud &pointcloud,
+        const utility::device_vector<int> &labels,
+        int num_clusters) {
+    auto out = std::make_shared<ClusterStatistics>();
+    if (labels.size() != pointcloud.points_.size()) {
+        utility::LogError(
+                "[ClusterStatistics::CreateFromLabels] The number of labels "
+                "does not match the number of points.");
+        return out;
+    }
+    if (num_clusters <= 0) return out;
+
+    // Group the labeled points by cluster. Noise and labels beyond
+    // num_clusters are dropped.
+    utility::device_vector<int> sorted_labels = labels;
+    utility::device_vector<Eigen::Vector3f> sorted_points = pointcloud.points_;
+    remove_if_vectors(
+            utility::exec_policy(0)->on(0),
+            [num_clusters] __device__(
+                    const thrust::tuple<int, Eigen::Vector3f> &x) {
+                const int label = thrust::get<0>(x);
+                return label < 0 || label >= num_clusters;
+            },
+            sorted_labels, sorted_points);
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), sorted_labels.begin(),
+                        sorted_labels.end(), sorted_points.begin());
+    const size_t n_pt = sorted_points.size();
+
+    // Sums, bounds and counts in a single segmented reduction.
+    out->counts_.resize(num_clusters, 0);
+    out->centroids_.resize(num_clusters, Eigen::Vector3f::Zero());
+    out->min_bounds_.resize(num_clusters, Eigen::Vector3f::Zero());
+    out->max_bounds_.resize(num_clusters, Eigen::Vector3f::Zero());
+    utility::device_vector<int> keys(n_pt);
+    utility::device_vector<Eigen::Vector3f> sums(n_pt);
+    utility::device_vector<Eigen::Vector3f> min_bounds(n_pt);
+    utility::device_vector<Eigen::Vector3f> max_bounds(n_pt);
+    utility::device_vector<int> counts(n_pt);
+    auto end = thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), sorted_labels.begin(),
+            sorted_labels.end(),
+            thrust::make_transform_iterator(
+                    sorted_points.begin(),
+                    point_to_sum_min_max_count_functor()),
+            keys.begin(),
+            make_tuple_begin(sums, min_bounds, max_bounds, counts),
+            thrust::equal_to<int>(), sum_min_max_count_functor());
+    const size_t n_present = thrust::distance(keys.begin(), end.first);
+    keys.resize(n_present);
+    thrust::transform(sums.begin(), sums.begin() + n_present, counts.begin(),
+                      sums.begin(),
+                      [] __device__(const Eigen::Vector3f &sum, int count) {
+                          return Eigen::Vector3f(sum / count);
+                      });
+    thrust::scatter(make_tuple_begin(sums, min_bounds, max_bounds, counts),
+                    make_tuple_begin(sums, min_bounds, max_bounds, counts) +
+                            n_present,
+                    keys.begin(),
+                    make_tuple_begin(out->centroids_, out->min_bounds_,
+                                     out->max_bounds_, out->counts_));
+
+    // Principal axes from the per-cluster covariances.
+    utility::device_vector<Eigen::Matrix3f> covariances(n_present);
+    thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), sorted_labels.begin(),
+            sorted_labels.end(),
+            thrust::make_transform_iterator(
+                    make_tuple_begin(sorted_labels, sorted_points),
+                    centered_outer_product_functor(
+                            thrust::raw_pointer_cast(out->centroids_.data()))),
+            thrust::make_discard_iterator(), covariances.begin());
+    out->obb_rotations_.resize(num_clusters, Eigen::Matrix3f::Identity());
+    thrust::transform(covariances.begin(), covariances.end(),
+                      covariances.begin(), principal_axes_functor());
+    thrust::scatter(covariances.begin(), covariances.end(), keys.begin(),
+                    out->obb_rotations_.begin());
+
+    // Extents along the principal axes.
+    auto local_begin = make_tuple_begin(min_bounds, max_bounds);
+    thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), sorted_labels.begin(),
+            sorted_labels.end(),
+            thrust::make_transform_iterator(
+                    make_tuple_begin(sorted_labels, sorted_points),
+                    project_to_principal_axes_functor(
+                            thrust::raw_pointer_cast(out->centroids_.data()),
+                            thrust::raw_pointer_cast(
+                                    out->obb_rotations_.data()))),
+            thrust::make_discard_iterator(), local_begin,
+            thrust::equal_to<int>(), min_max_functor());
+    utility::device_vector<Eigen::Vector3f> local_min_bounds(
+            num_clusters, Eigen::Vector3f::Zero());
+    utility::device_vector<Eigen::Vector3f> local_max_bounds(
+            num_clusters, Eigen::Vector3f::Zero());
+    thrust::scatter(local_begin, local_begin + n_present, keys.begin(),
+                    make_tuple_begin(local_min_bounds, local_max_bounds));
+    out->obb_centers_.resize(num_clusters);
+    out->obb_extents_.resize(num_clusters);
+    thrust::transform(
+            thrust::make_counting_iterator<size_t>(0),
+            thrust::make_counting_iterator<size_t>(num_clusters),
+            make_tuple_begin(out->obb_centers_, out->obb_extents_),
+            compute_obb_functor(
+                    thrust::raw_pointer_cast(out->centroids_.data()),
+                    thrust::raw_pointer_cast(out->obb_rotations_.data()),
+                    thrust::raw_pointer_cast(local_min_bounds.data()),
+                    thrust::raw_pointer_cast(local_max_bounds.data())));
+    return out;
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/utility/device_vector.h"
+
+namespace cupoch {
+namespace geometry {
+
+class PointCloud;
+
+/// \class ClusterStatistics
+///
+/// \brief Per-cluster statistics of a labeled point cloud. The i-th entry of
+/// every member belongs to the cluster with label i.
+class ClusterStatistics {
+public:
+    ClusterStatistics() {}
+    ~ClusterStatistics() {}
+
+    /// Number of clusters.
+    size_t NumClusters() const { return counts_.size(); }
+    bool IsEmpty() const { return counts_.empty(); }
+
+    /// Returns the axis aligned bounding boxes of the clusters.
+    std::vector<AxisAlignedBoundingBox<3>> GetAxisAlignedBoundingBoxes() const;
+    /// Returns the PCA-based oriented bounding boxes of the clusters.
+    std::vector<OrientedBoundingBox> GetOrientedBoundingBoxes() const;
+
+    /// Computes the statistics of the clusters given by \p labels, which
+    /// range from 0 to \p num_clusters - 1. Points with labels out of this
+    /// range are ignored.
+    static std::shared_ptr<ClusterStatistics> CreateFromLabels(
+            const PointCloud &pointcloud,
+            const utility::device_vector<int> &labels,
+            int num_clusters);
+
+public:
+    utility::device_vector<int> counts_;
+    utility::device_vector<Eigen::Vector3f> centroids_;
+    utility::device_vector<Eigen::Vector3f> min_bounds_;
+    utility::device_vector<Eigen::Vector3f> max_bounds_;
+    utility::device_vector<Eigen::Vector3f> obb_centers_;
+    utility::device_vector<Eigen::Matrix3f> obb_rotations_;
+    utility::device_vector<Eigen::Vector3f> obb_extents_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -23,12 +23,41 @@
 
 #include "cupoch/geometry/geometry_base.h"
 #include "cupoch/utility/device_vector.h"
+#include "cupoch/utility/helper.h"
 
 namespace cupoch {
 namespace geometry {
 
 class OrientedBoundingBox;
 
+/// Returns the storage index of \p grid_index in a dense grid whose voxels
+/// are addressed as a ring buffer shifted by \p offset. Both \p grid_index
+/// and \p offset must be in [0, resolution).
+__host__ __device__ inline int RingIndexOf(const Eigen::Vector3i &grid_index,
+                                           const Eigen::Vector3i &offset,
+                                           int resolution) {
+    Eigen::Vector3i idx = grid_index + offset;
+#pragma unroll
+    for (int i = 0; i < 3; ++i) {
+        if (idx[i] >= resolution) idx[i] -= resolution;
+    }
+    return IndexOf(idx, resolution);
+}
+
+/// Inverse of RingIndexOf.
+__host__ __device__ inline Eigen::Vector3i RingKeyOf(
+        size_t idx, const Eigen::Vector3i &offset, int resolution) {
+    auto key = KeyOf(idx, resolution);
+    Eigen::Vector3i grid_index(thrust::get<0>(key), thrust::get<1>(key),
+                               thrust::get<2>(key));
+    grid_index -= offset;
+#pragma unroll
+    for (int i = 0; i < 3; ++i) {
+        if (grid_index[i] < 0) grid_index[i] += resolution;
+    }
+    return grid_index;
+}
+
 template <class VoxelType>
 class DenseGrid : public GeometryBase3D {
 public:
@@ -55,6 +84,16 @@ public:
 
     virtual DenseGrid &Reconstruct(float voxel_size, int resolution);
 
+    /// \brief Moves the grid window by \p shift voxels keeping the voxels
+    /// which remain inside of it.
+    ///
+    /// The voxels are addressed as a ring buffer, so only the slabs newly
+    /// exposed by the motion are reset instead of rebuilding the whole grid.
+    virtual DenseGrid &ShiftWindow(const Eigen::Vector3i &shift);
+    /// Moves the grid window so that its center is the voxel nearest to
+    /// \p center.
+    DenseGrid &Recenter(const Eigen::Vector3f &center);
+
     int GetVoxelIndex(const Eigen::Vector3f &point) const;
     thrust::tuple<bool, VoxelType> GetVoxel(const Eigen::Vector3f &point) const;
 
@@ -62,6 +101,8 @@ public:
     float voxel_size_ = 0.0;
     int resolution_ = 0;
     Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    /// Ring buffer offset of the voxel storage in [0, resolution).
+    Eigen::Vector3i ring_offset_ = Eigen::Vector3i::Zero();
     utility::device_vector<VoxelType> voxels_;
 };
 
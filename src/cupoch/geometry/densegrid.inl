@@ -25,6 +25,37 @@
 namespace cupoch {
 namespace geometry {
 
+namespace {
+
+template <class VoxelType>
+struct clear_ring_slab_functor {
+    clear_ring_slab_functor(VoxelType *voxels,
+                            int axis,
+                            int start,
+                            const Eigen::Vector3i &offset,
+                            int resolution)
+        : voxels_(voxels),
+          axis_(axis),
+          start_(start),
+          offset_(offset),
+          resolution_(resolution){};
+    VoxelType *voxels_;
+    const int axis_;
+    const int start_;
+    const Eigen::Vector3i offset_;
+    const int resolution_;
+    __device__ void operator()(size_t idx) {
+        const int res2 = resolution_ * resolution_;
+        Eigen::Vector3i grid_index;
+        grid_index[axis_] = start_ + idx / res2;
+        grid_index[(axis_ + 1) % 3] = (idx % res2) / resolution_;
+        grid_index[(axis_ + 2) % 3] = idx % resolution_;
+        voxels_[RingIndexOf(grid_index, offset_, resolution_)] = VoxelType();
+    }
+};
+
+}  // namespace
+
 template <class VoxelType>
 DenseGrid<VoxelType>::DenseGrid(Geometry::GeometryType type)
     : GeometryBase3D(type) {}
@@ -46,6 +77,7 @@ DenseGrid<VoxelType>::DenseGrid(Geometry::GeometryType type,
       voxel_size_(src_grid.voxel_size_),
       resolution_(src_grid.resolution_),
       origin_(src_grid.origin_),
+      ring_offset_(src_grid.ring_offset_),
       voxels_(src_grid.voxels_) {}
 template <class VoxelType>
 DenseGrid<VoxelType>::~DenseGrid() {}
@@ -55,6 +87,7 @@ DenseGrid<VoxelType> &DenseGrid<VoxelType>::Clear() {
     voxel_size_ = 0.0;
     resolution_ = 0;
     origin_ = Eigen::Vector3f::Zero();
+    ring_offset_ = Eigen::Vector3i::Zero();
     voxels_.clear();
     return *this;
 }
@@ -129,10 +162,44 @@ DenseGrid<VoxelType> &DenseGrid<VoxelType>::Reconstruct(float voxel_size,
                                                         int resolution) {
     voxel_size_ = voxel_size;
     resolution_ = resolution;
+    ring_offset_ = Eigen::Vector3i::Zero();
     voxels_.resize(resolution_ * resolution_ * resolution_, VoxelType());
     return *this;
 }
 
+template <class VoxelType>
+DenseGrid<VoxelType> &DenseGrid<VoxelType>::ShiftWindow(
+        const Eigen::Vector3i &shift) {
+    origin_ += shift.cast<float>() * voxel_size_;
+    if ((shift.array().abs() >= resolution_).any()) {
+        thrust::fill(voxels_.begin(), voxels_.end(), VoxelType());
+        ring_offset_ = Eigen::Vector3i::Zero();
+        return *this;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (shift[i] == 0) continue;
+        ring_offset_[i] =
+                ((ring_offset_[i] + shift[i]) % resolution_ + resolution_) %
+                resolution_;
+        const int start = (shift[i] > 0) ? resolution_ - shift[i] : 0;
+        const size_t n_slab =
+                size_t(std::abs(shift[i])) * resolution_ * resolution_;
+        clear_ring_slab_functor<VoxelType> func(
+                thrust::raw_pointer_cast(voxels_.data()), i, start,
+                ring_offset_, resolution_);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_slab), func);
+    }
+    return *this;
+}
+
+template <class VoxelType>
+DenseGrid<VoxelType> &DenseGrid<VoxelType>::Recenter(
+        const Eigen::Vector3f &center) {
+    Eigen::Vector3f diff = (center - origin_) / voxel_size_;
+    return ShiftWindow(diff.array().round().matrix().cast<int>());
+}
+
 template <class VoxelType>
 int DenseGrid<VoxelType>::GetVoxelIndex(const Eigen::Vector3f &point) const {
     Eigen::Vector3f voxel_f = (point - origin_) / voxel_size_;
@@ -140,9 +207,10 @@ int DenseGrid<VoxelType>::GetVoxelIndex(const Eigen::Vector3f &point) const {
     Eigen::Vector3i voxel_idx =
             (Eigen::floor(voxel_f.array())).matrix().cast<int>() +
             Eigen::Vector3i::Constant(h_res);
-    int idx = IndexOf(voxel_idx, resolution_);
-    if (idx < 0 || idx >= resolution_ * resolution_ * resolution_) return -1;
-    return idx;
+    if ((voxel_idx.array() < 0).any() ||
+        (voxel_idx.array() >= resolution_).any())
+        return -1;
+    return RingIndexOf(voxel_idx, ring_offset_, resolution_);
 }
 
 template <class VoxelType>
@@ -21,6 +21,7 @@
 #include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/geometry/densegrid.inl"
 #include "cupoch/geometry/distancetransform.h"
+#include "cupoch/geometry/occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch/utility/platform.h"
 
@@ -260,6 +261,288 @@ struct compute_obstacle_cells_functor {
     };
 };
 
+__constant__ int face_neighbor_offsets[6][3] = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+// Voxel which no obstacle has reached.
+__host__ __device__ DistanceVoxel UnreachedDistanceVoxel() {
+    DistanceVoxel v(Eigen::Vector3ui16::Constant(
+                            std::numeric_limits<unsigned short>::max()),
+                    DistanceVoxel::NotSite);
+    v.distance_ = std::numeric_limits<float>::max();
+    return v;
+}
+
+__device__ bool IsInGrid(const Eigen::Vector3i& idxs, int resolution) {
+    return idxs[0] >= 0 && idxs[1] >= 0 && idxs[2] >= 0 &&
+           idxs[0] < resolution && idxs[1] < resolution &&
+           idxs[2] < resolution;
+}
+
+// An obstacle is a voxel which is its own nearest site.
+__device__ bool IsLiveSite(const DistanceVoxel* voxels,
+                           const Eigen::Vector3ui16& site,
+                           int resolution) {
+    if (site[0] >= resolution || site[1] >= resolution ||
+        site[2] >= resolution)
+        return false;
+    const Eigen::Vector3ui16 own =
+            voxels[IndexOf(site.cast<int>(), resolution)].nearest_index_;
+    return own[0] == site[0] && own[1] == site[1] && own[2] == site[2];
+}
+
+__device__ int SquaredDistance(const Eigen::Vector3i& idxs,
+                               const Eigen::Vector3ui16& site) {
+    return (site.cast<int>() - idxs).squaredNorm();
+}
+
+// Moves the nearest obstacle indices of the voxels kept by ShiftWindow to the
+// new window. Newly exposed voxels and voxels whose obstacle left the window
+// get no nearest obstacle.
+struct shift_nearest_index_functor {
+    shift_nearest_index_functor(DistanceVoxel* voxels,
+                                const Eigen::Vector3i& shift,
+                                const Eigen::Vector3i& ring_offset,
+                                int resolution)
+        : voxels_(voxels),
+          shift_(shift),
+          ring_offset_(ring_offset),
+          resolution_(resolution){};
+    DistanceVoxel* voxels_;
+    const Eigen::Vector3i shift_;
+    const Eigen::Vector3i ring_offset_;
+    const int resolution_;
+    __device__ void operator()(size_t idx) {
+        const int res2 = resolution_ * resolution_;
+        const Eigen::Vector3i idxs(idx / res2, (idx % res2) / resolution_,
+                                   idx % resolution_);
+        const Eigen::Vector3i prev = idxs + shift_;
+        DistanceVoxel& v =
+                voxels_[RingIndexOf(idxs, ring_offset_, resolution_)];
+        const Eigen::Vector3i nearest = v.nearest_index_.cast<int>() - shift_;
+        if (IsInGrid(prev, resolution_) && IsInGrid(nearest, resolution_) &&
+            v.nearest_index_[0] < resolution_) {
+            v.nearest_index_ = nearest.cast<unsigned short>();
+        } else {
+            v.nearest_index_ = Eigen::Vector3ui16::Constant(
+                    std::numeric_limits<unsigned short>::max());
+        }
+    }
+};
+
+struct set_obstacle_functor {
+    set_obstacle_functor(DistanceVoxel* voxels, int resolution, bool added)
+        : voxels_(voxels), resolution_(resolution), added_(added){};
+    DistanceVoxel* voxels_;
+    const int resolution_;
+    const bool added_;
+    __device__ void operator()(const Eigen::Vector3i& idxs) {
+        int i = IndexOf(idxs, resolution_);
+        const Eigen::Vector3ui16 site = idxs.cast<unsigned short>();
+        if (added_) {
+            DistanceVoxel v(site, 0);
+            v.distance_ = 0;
+            voxels_[i] = v;
+        } else if (IsLiveSite(voxels_, site, resolution_)) {
+            voxels_[i] = UnreachedDistanceVoxel();
+        }
+    }
+};
+
+struct expand_frontier_functor {
+    expand_frontier_functor(const Eigen::Vector3i* frontier, int resolution)
+        : frontier_(frontier), resolution_(resolution){};
+    const Eigen::Vector3i* frontier_;
+    const int resolution_;
+    __device__ Eigen::Vector3i operator()(size_t idx) const {
+        const int k = idx % 6;
+        Eigen::Vector3i n = frontier_[idx / 6] +
+                            Eigen::Vector3i(face_neighbor_offsets[k][0],
+                                            face_neighbor_offsets[k][1],
+                                            face_neighbor_offsets[k][2]);
+        return IsInGrid(n, resolution_) ? n : Eigen::Vector3i::Constant(-1);
+    }
+};
+
+// Clears the neighbors attached to a removed obstacle and returns them as the
+// next raise frontier. Neighbors keeping a live obstacle are returned as
+// seeds of the lower wavefront.
+struct raise_functor {
+    raise_functor(DistanceVoxel* voxels, int resolution)
+        : voxels_(voxels), resolution_(resolution){};
+    DistanceVoxel* voxels_;
+    const int resolution_;
+    __device__ thrust::tuple<Eigen::Vector3i, Eigen::Vector3i> operator()(
+            const Eigen::Vector3i& idxs) {
+        const Eigen::Vector3i none = Eigen::Vector3i::Constant(-1);
+        if (idxs[0] < 0) return thrust::make_tuple(none, none);
+        int i = IndexOf(idxs, resolution_);
+        const Eigen::Vector3ui16 site = voxels_[i].nearest_index_;
+        if (site[0] >= resolution_ || site[1] >= resolution_ ||
+            site[2] >= resolution_) {
+            return thrust::make_tuple(none, none);
+        }
+        if (IsLiveSite(voxels_, site, resolution_)) {
+            return thrust::make_tuple(none, idxs);
+        }
+        voxels_[i] = UnreachedDistanceVoxel();
+        return thrust::make_tuple(idxs, none);
+    }
+};
+
+// Pulls the nearest live obstacle of the face neighbors. The new voxels are
+// written by a separate scatter so that every pass reads a stable field.
+struct lower_functor {
+    lower_functor(const DistanceVoxel* voxels,
+                  float voxel_size,
+                  int resolution,
+                  int max_dist2)
+        : voxels_(voxels),
+          voxel_size_(voxel_size),
+          resolution_(resolution),
+          max_dist2_(max_dist2){};
+    const DistanceVoxel* voxels_;
+    const float voxel_size_;
+    const int resolution_;
+    const int max_dist2_;
+    __device__ thrust::tuple<bool, DistanceVoxel> operator()(
+            const Eigen::Vector3i& idxs) const {
+        const DistanceVoxel cur = voxels_[IndexOf(idxs, resolution_)];
+        int best = std::numeric_limits<int>::max();
+        Eigen::Vector3ui16 best_site = cur.nearest_index_;
+        for (int k = 0; k < 6; ++k) {
+            Eigen::Vector3i n =
+                    idxs + Eigen::Vector3i(face_neighbor_offsets[k][0],
+                                           face_neighbor_offsets[k][1],
+                                           face_neighbor_offsets[k][2]);
+            if (!IsInGrid(n, resolution_)) continue;
+            const Eigen::Vector3ui16 site =
+                    voxels_[IndexOf(n, resolution_)].nearest_index_;
+            if (!IsLiveSite(voxels_, site, resolution_)) continue;
+            const int d2 = SquaredDistance(idxs, site);
+            if (d2 < best && (max_dist2_ < 0 || d2 <= max_dist2_)) {
+                best = d2;
+                best_site = site;
+            }
+        }
+        if (IsLiveSite(voxels_, cur.nearest_index_, resolution_)) {
+            if (SquaredDistance(idxs, cur.nearest_index_) <= best) {
+                return thrust::make_tuple(false, cur);
+            }
+        } else if (best == std::numeric_limits<int>::max()) {
+            const bool unreached = cur.nearest_index_[0] >= resolution_;
+            return thrust::make_tuple(!unreached, UnreachedDistanceVoxel());
+        }
+        DistanceVoxel out(best_site, 0);
+        out.distance_ = sqrtf(best) * voxel_size_;
+        return thrust::make_tuple(true, out);
+    }
+};
+
+struct is_occupied_functor {
+    is_occupied_functor(const OccupancyVoxel* voxels,
+                        int resolution,
+                        const Eigen::Vector3i& ring_offset,
+                        float occ_prob_thres_log)
+        : voxels_(voxels),
+          resolution_(resolution),
+          ring_offset_(ring_offset),
+          occ_prob_thres_log_(occ_prob_thres_log){};
+    const OccupancyVoxel* voxels_;
+    const int resolution_;
+    const Eigen::Vector3i ring_offset_;
+    const float occ_prob_thres_log_;
+    __device__ bool operator()(const Eigen::Vector3i& idxs) const {
+        float p = voxels_[RingIndexOf(idxs, ring_offset_, resolution_)]
+                          .prob_log_;
+        return !isnan(p) && p > occ_prob_thres_log_;
+    }
+};
+
+struct interpolate_distance_functor {
+    interpolate_distance_functor(const DistanceVoxel* voxels,
+                                 float voxel_size,
+                                 int resolution,
+                                 const Eigen::Vector3f& origin,
+                                 const Eigen::Vector3i& ring_offset)
+        : voxels_(voxels),
+          voxel_size_(voxel_size),
+          resolution_(resolution),
+          origin_(origin),
+          ring_offset_(ring_offset){};
+    const DistanceVoxel* voxels_;
+    const float voxel_size_;
+    const int resolution_;
+    const Eigen::Vector3f origin_;
+    const Eigen::Vector3i ring_offset_;
+    __device__ thrust::tuple<float, Eigen::Vector3f> operator()(
+            const Eigen::Vector3f& query) const {
+        const Eigen::Vector3f qv =
+                (query - origin_) / voxel_size_ +
+                Eigen::Vector3f::Constant(0.5 * resolution_);
+        if ((qv.array() < 0).any() || (qv.array() >= resolution_).any()) {
+            return thrust::make_tuple(0.0f, Eigen::Vector3f::Zero().eval());
+        }
+        // Coordinates in units of voxel centers.
+        const Eigen::Vector3f pv =
+                (qv.array() - 0.5f).max(0.0f).min(resolution_ - 1.0f).matrix();
+        const Eigen::Vector3i base =
+                Eigen::device_vectorize<float, 3, ::floor>(pv.array())
+                        .cast<int>()
+                        .min(resolution_ - 2)
+                        .max(0)
+                        .matrix();
+        const Eigen::Vector3f t = pv - base.cast<float>();
+        float dist = 0.0f;
+        Eigen::Vector3f grad = Eigen::Vector3f::Zero();
+        for (int k = 0; k < 8; ++k) {
+            const Eigen::Vector3i corner(k & 1, (k >> 1) & 1, (k >> 2) & 1);
+            const float c =
+                    voxels_[RingIndexOf(base + corner, ring_offset_,
+                                        resolution_)]
+                            .distance_;
+            const Eigen::Array3f w =
+                    (corner.array() == 1).select(t.array(), 1.0f - t.array());
+            const Eigen::Array3f dw = (corner.array() == 1)
+                                              .select(Eigen::Array3f::Ones(),
+                                                      -Eigen::Array3f::Ones());
+            dist += w[0] * w[1] * w[2] * c;
+            grad[0] += dw[0] * w[1] * w[2] * c;
+            grad[1] += w[0] * dw[1] * w[2] * c;
+            grad[2] += w[0] * w[1] * dw[2] * c;
+        }
+        return thrust::make_tuple(dist, (grad / voxel_size_).eval());
+    }
+};
+
+// Removes the unused slots of an expanded frontier and its duplicates.
+void CompactFrontier(utility::device_vector<Eigen::Vector3i>& frontier) {
+    auto end = thrust::remove_if(
+            frontier.begin(), frontier.end(),
+            [] __device__(const Eigen::Vector3i& idxs) { return idxs[0] < 0; });
+    thrust::sort(frontier.begin(), end);
+    end = thrust::unique(frontier.begin(), end);
+    frontier.resize(thrust::distance(frontier.begin(), end));
+}
+
+void ExpandFrontier(const utility::device_vector<Eigen::Vector3i>& frontier,
+                    int resolution,
+                    utility::device_vector<Eigen::Vector3i>& neighbors) {
+    neighbors.resize(frontier.size() * 6);
+    expand_frontier_functor func(thrust::raw_pointer_cast(frontier.data()),
+                                 resolution);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(neighbors.size()),
+                      neighbors.begin(), func);
+}
+
+bool IsSameWindow(const DistanceTransform& dt, const OccupancyGrid& occgrid) {
+    return dt.resolution_ == occgrid.resolution_ &&
+           std::abs(dt.voxel_size_ - occgrid.voxel_size_) <=
+                   std::numeric_limits<float>::epsilon() &&
+           (dt.origin_ - occgrid.origin_).norm() <= 1.0e-4 * dt.voxel_size_;
+}
+
 }  // namespace
 
 template class DenseGrid<DistanceVoxel>;
@@ -292,6 +575,16 @@ DistanceTransform::DistanceTransform(const DistanceTransform& other)
 
 DistanceTransform::~DistanceTransform() {}
 
+DistanceTransform& DistanceTransform::ShiftWindow(
+        const Eigen::Vector3i& shift) {
+    DenseGrid::ShiftWindow(shift);
+    shift_nearest_index_functor func(thrust::raw_pointer_cast(voxels_.data()),
+                                     shift, ring_offset_, resolution_);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(voxels_.size()), func);
+    return *this;
+}
+
 DistanceTransform& DistanceTransform::Reconstruct(float voxel_size,
                                                   int resolution) {
     DenseGrid::Reconstruct(voxel_size, resolution);
@@ -301,6 +594,12 @@ DistanceTransform& DistanceTransform::Reconstruct(float voxel_size,
 
 DistanceTransform& DistanceTransform::ComputeEDT(
         const utility::device_vector<Eigen::Vector3i>& points) {
+    if (points.empty()) {
+        ring_offset_ = Eigen::Vector3i::Zero();
+        is_signed_ = false;
+        thrust::fill(voxels_.begin(), voxels_.end(), UnreachedDistanceVoxel());
+        return *this;
+    }
     ComputeVoronoiDiagram(points);
     compute_distance_functor func(thrust::raw_pointer_cast(voxels_.data()),
                                   voxel_size_, resolution_);
@@ -310,28 +609,183 @@ DistanceTransform& DistanceTransform::ComputeEDT(
 }
 
 DistanceTransform& DistanceTransform::ComputeEDT(const VoxelGrid& voxelgrid) {
-    if (std::abs(voxel_size_ - voxelgrid.voxel_size_) >
-        std::numeric_limits<float>::epsilon()) {
+    utility::device_vector<Eigen::Vector3i> obs_cells;
+    if (!ComputeObstacleCells(voxelgrid, obs_cells)) return *this;
+    return ComputeEDT(obs_cells);
+}
+
+DistanceTransform& DistanceTransform::ComputeSignedEDT(
+        const utility::device_vector<Eigen::Vector3i>& points) {
+    ComputeEDT(points);
+    if (points.empty()) return *this;
+    utility::device_vector<DistanceVoxel> outside = voxels_;
+    // The free voxels are the sites of the inverted diagram.
+    thrust::transform(
+            enumerate_begin(outside), enumerate_end(outside), buffer_.begin(),
+            [res = resolution_] __device__(
+                    const thrust::tuple<size_t, DistanceVoxel>& x) {
+                const DistanceVoxel& v = thrust::get<1>(x);
+                if (v.distance_ <= 0) return DistanceVoxel();
+                const auto key = KeyOf(thrust::get<0>(x), res);
+                return DistanceVoxel(
+                        Eigen::Vector3ui16(thrust::get<0>(key),
+                                           thrust::get<1>(key),
+                                           thrust::get<2>(key)),
+                        0);
+            });
+    ComputeVoronoiDiagramFromBuffer();
+    compute_distance_functor func(thrust::raw_pointer_cast(voxels_.data()),
+                                  voxel_size_, resolution_);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(voxels_.size()), func);
+    // Both sides are shifted by half a voxel so that the zero level lies on
+    // the obstacle faces and the gradient is about 1 across them.
+    thrust::transform(outside.begin(), outside.end(), voxels_.begin(),
+                      voxels_.begin(),
+                      [hv = 0.5f * voxel_size_] __device__(
+                              const DistanceVoxel& out,
+                              const DistanceVoxel& in) {
+                          DistanceVoxel v = out;
+                          v.distance_ = (out.distance_ <= 0)
+                                                ? hv - in.distance_
+                                                : out.distance_ - hv;
+                          return v;
+                      });
+    is_signed_ = true;
+    return *this;
+}
+
+DistanceTransform& DistanceTransform::ComputeSignedEDT(
+        const VoxelGrid& voxelgrid) {
+    utility::device_vector<Eigen::Vector3i> obs_cells;
+    if (!ComputeObstacleCells(voxelgrid, obs_cells)) return *this;
+    return ComputeSignedEDT(obs_cells);
+}
+
+DistanceTransform& DistanceTransform::ComputeEDT(
+        const OccupancyGrid& occgrid) {
+    if (!IsSameWindow(*this, occgrid)) {
         utility::LogError(
-                "Unsupport computing Voronoi diagrams from different voxel "
-                "size.");
+                "[ComputeEDT] the occupancy grid does not cover the same "
+                "window.");
         return *this;
     }
-    utility::device_vector<Eigen::Vector3i> obs_cells(
-            voxelgrid.voxels_keys_.size());
-    compute_obstacle_cells_functor func(voxel_size_, resolution_,
-                                        voxelgrid.origin_, origin_);
-    thrust::transform(voxelgrid.voxels_keys_.begin(),
-                      voxelgrid.voxels_keys_.end(), obs_cells.begin(), func);
+    auto occvoxels = occgrid.ExtractOccupiedVoxels();
+    utility::device_vector<Eigen::Vector3i> obs_cells(occvoxels->size());
+    thrust::transform(occvoxels->begin(), occvoxels->end(), obs_cells.begin(),
+                      [] __device__(const OccupancyVoxel& voxel) {
+                          return voxel.grid_index_.cast<int>().eval();
+                      });
     return ComputeEDT(obs_cells);
 }
 
+DistanceTransform& DistanceTransform::UpdateEDT(
+        const utility::device_vector<Eigen::Vector3i>& added_obstacles,
+        const utility::device_vector<Eigen::Vector3i>& removed_obstacles,
+        float max_distance) {
+    if (ring_offset_ != Eigen::Vector3i::Zero()) {
+        utility::LogError(
+                "[UpdateEDT] the window was shifted since the last "
+                "ComputeEDT.");
+        return *this;
+    }
+    if (is_signed_) {
+        utility::LogError("[UpdateEDT] signed distances are not supported.");
+        return *this;
+    }
+    DistanceVoxel* voxels = thrust::raw_pointer_cast(voxels_.data());
+    thrust::for_each(removed_obstacles.begin(), removed_obstacles.end(),
+                     set_obstacle_functor(voxels, resolution_, false));
+    thrust::for_each(added_obstacles.begin(), added_obstacles.end(),
+                     set_obstacle_functor(voxels, resolution_, true));
+
+    // Raise: clear every voxel whose nearest obstacle was removed and collect
+    // the voxels bordering the cleared region.
+    utility::device_vector<Eigen::Vector3i> frontier = removed_obstacles;
+    utility::device_vector<Eigen::Vector3i> seeds = added_obstacles;
+    utility::device_vector<Eigen::Vector3i> neighbors;
+    utility::device_vector<Eigen::Vector3i> border;
+    raise_functor raise_func(voxels, resolution_);
+    while (!frontier.empty()) {
+        ExpandFrontier(frontier, resolution_, neighbors);
+        frontier.resize(neighbors.size());
+        border.resize(neighbors.size());
+        thrust::transform(neighbors.begin(), neighbors.end(),
+                          make_tuple_begin(frontier, border), raise_func);
+        CompactFrontier(frontier);
+        CompactFrontier(border);
+        seeds.insert(seeds.end(), border.begin(), border.end());
+    }
+
+    // Lower: propagate the obstacles outwards until no distance improves.
+    CompactFrontier(seeds);
+    frontier.swap(seeds);
+    const int max_cells = std::ceil(max_distance / voxel_size_);
+    const int max_dist2 = (max_distance > 0.0) ? max_cells * max_cells : -1;
+    lower_functor lower_func(voxels, voxel_size_, resolution_, max_dist2);
+    utility::device_vector<bool> changed;
+    utility::device_vector<DistanceVoxel> updated;
+    while (!frontier.empty()) {
+        ExpandFrontier(frontier, resolution_, neighbors);
+        CompactFrontier(neighbors);
+        changed.resize(neighbors.size());
+        updated.resize(neighbors.size());
+        thrust::transform(neighbors.begin(), neighbors.end(),
+                          make_tuple_begin(changed, updated), lower_func);
+        thrust::scatter_if(
+                updated.begin(), updated.end(),
+                thrust::make_transform_iterator(
+                        neighbors.begin(),
+                        [res = resolution_] __device__(
+                                const Eigen::Vector3i& idxs) {
+                            return IndexOf(idxs, res);
+                        }),
+                changed.begin(), voxels_.begin());
+        frontier.resize(neighbors.size());
+        auto end = thrust::copy_if(neighbors.begin(), neighbors.end(),
+                                   changed.begin(), frontier.begin(),
+                                   thrust::identity<bool>());
+        frontier.resize(thrust::distance(frontier.begin(), end));
+    }
+    return *this;
+}
+
+DistanceTransform& DistanceTransform::UpdateEDT(OccupancyGrid& occgrid,
+                                                float max_distance) {
+    if (!IsSameWindow(*this, occgrid)) {
+        utility::LogError(
+                "[UpdateEDT] the occupancy grid does not cover the same "
+                "window.");
+        return *this;
+    }
+    utility::device_vector<Eigen::Vector3i> changed;
+    changed.swap(occgrid.changed_voxels_);
+    thrust::sort(changed.begin(), changed.end());
+    auto end = thrust::unique(changed.begin(), changed.end());
+    is_occupied_functor func(thrust::raw_pointer_cast(occgrid.voxels_.data()),
+                             occgrid.resolution_, occgrid.ring_offset_,
+                             occgrid.occ_prob_thres_log_);
+    auto mid = thrust::partition(changed.begin(), end, func);
+    utility::device_vector<Eigen::Vector3i> added(changed.begin(), mid);
+    utility::device_vector<Eigen::Vector3i> removed(mid, end);
+    return UpdateEDT(added, removed, max_distance);
+}
+
 DistanceTransform& DistanceTransform::ComputeVoronoiDiagram(
         const utility::device_vector<Eigen::Vector3i>& points) {
+    // The whole diagram is recomputed in window order, so any ring buffer
+    // offset left by ShiftWindow is discarded here.
+    ring_offset_ = Eigen::Vector3i::Zero();
+    is_signed_ = false;
+    thrust::fill(buffer_.begin(), buffer_.end(), DistanceVoxel());
     set_points_functor func0(thrust::raw_pointer_cast(buffer_.data()),
                              resolution_);
     thrust::for_each(points.begin(), points.end(), func0);
+    ComputeVoronoiDiagramFromBuffer();
+    return *this;
+}
 
+void DistanceTransform::ComputeVoronoiDiagramFromBuffer() {
     flood_z_functor func1(thrust::raw_pointer_cast(buffer_.data()),
                           thrust::raw_pointer_cast(voxels_.data()),
                           resolution_);
@@ -366,41 +820,46 @@ DistanceTransform& DistanceTransform::ComputeVoronoiDiagram(
             thrust::raw_pointer_cast(buffer_.data()),
             thrust::raw_pointer_cast(voxels_.data()), resolution_);
     cudaSafeCall(cudaDeviceSynchronize());
-    return *this;
 }
 
-DistanceTransform& DistanceTransform::ComputeVoronoiDiagram(
-        const VoxelGrid& voxelgrid) {
+bool DistanceTransform::ComputeObstacleCells(
+        const VoxelGrid& voxelgrid,
+        utility::device_vector<Eigen::Vector3i>& obs_cells) const {
     if (std::abs(voxel_size_ - voxelgrid.voxel_size_) >
         std::numeric_limits<float>::epsilon()) {
         utility::LogError(
                 "Unsupport computing Voronoi diagrams from different voxel "
                 "size.");
-        return *this;
+        return false;
     }
-    utility::device_vector<Eigen::Vector3i> obs_cells(
-            voxelgrid.voxels_keys_.size());
+    obs_cells.resize(voxelgrid.voxels_keys_.size());
     compute_obstacle_cells_functor func(voxel_size_, resolution_,
                                         voxelgrid.origin_, origin_);
     thrust::transform(voxelgrid.voxels_keys_.begin(),
                       voxelgrid.voxels_keys_.end(), obs_cells.begin(), func);
+    return true;
+}
+
+DistanceTransform& DistanceTransform::ComputeVoronoiDiagram(
+        const VoxelGrid& voxelgrid) {
+    utility::device_vector<Eigen::Vector3i> obs_cells;
+    if (!ComputeObstacleCells(voxelgrid, obs_cells)) return *this;
     return ComputeVoronoiDiagram(obs_cells);
 }
 
 float DistanceTransform::GetDistance(const Eigen::Vector3f& query) const {
-    Eigen::Vector3f qv =
-            (query - origin_ +
-             0.5 * voxel_size_ * Eigen::Vector3f::Constant(resolution_)) /
-            voxel_size_;
-    Eigen::Vector3i idx = (Eigen::floor(qv.array())).cast<int>();
-    DistanceVoxel v = voxels_[IndexOf(idx, resolution_)];
+    auto idx = GetVoxelIndex(query);
+    if (idx < 0) return 0.0;
+    DistanceVoxel v = voxels_[idx];
     return v.distance_;
 }
 
 utility::device_vector<float> DistanceTransform::GetDistances(
         const utility::device_vector<Eigen::Vector3f>& queries) const {
-    auto func = [voxel_size = voxel_size_, resolution = resolution_,
-                 origin = origin_] __device__(const Eigen::Vector3f& query) {
+    auto func = [voxels = thrust::raw_pointer_cast(voxels_.data()),
+                 voxel_size = voxel_size_, resolution = resolution_,
+                 origin = origin_, ring_offset = ring_offset_] __device__(
+                        const Eigen::Vector3f& query) {
         Eigen::Vector3f qv =
                 (query - origin +
                  0.5 * voxel_size * Eigen::Vector3f::Constant(resolution)) /
@@ -408,20 +867,30 @@ utility::device_vector<float> DistanceTransform::GetDistances(
         Eigen::Vector3i idx =
                 Eigen::device_vectorize<float, 3, ::floor>(qv.array())
                         .cast<int>();
-        return IndexOf(idx, resolution);
+        if (idx[0] < 0 || idx[1] < 0 || idx[2] < 0 || idx[0] >= resolution ||
+            idx[1] >= resolution || idx[2] >= resolution) {
+            return 0.0f;
+        }
+        return voxels[RingIndexOf(idx, ring_offset, resolution)].distance_;
     };
     utility::device_vector<float> dists(queries.size());
-    thrust::transform(
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(queries.begin(), func)),
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(queries.end(), func)),
-            dists.begin(),
-            [] __device__(const DistanceVoxel& v) { return v.distance_; });
+    thrust::transform(queries.begin(), queries.end(), dists.begin(), func);
     return dists;
 }
 
+std::pair<utility::device_vector<float>,
+          utility::device_vector<Eigen::Vector3f>>
+DistanceTransform::GetInterpolatedDistances(
+        const utility::device_vector<Eigen::Vector3f>& queries) const {
+    utility::device_vector<float> dists(queries.size());
+    utility::device_vector<Eigen::Vector3f> grads(queries.size());
+    interpolate_distance_functor func(thrust::raw_pointer_cast(voxels_.data()),
+                                      voxel_size_, resolution_, origin_,
+                                      ring_offset_);
+    thrust::transform(queries.begin(), queries.end(),
+                      make_tuple_begin(dists, grads), func);
+    return std::make_pair(std::move(dists), std::move(grads));
+}
+
 }  // namespace geometry
 }  // namespace cupoch
\ No newline at end of file
@@ -58,23 +58,75 @@ public:
     ~DistanceTransform();
 
     DistanceTransform &Reconstruct(float voxel_size, int resolution);
+    /// Moves the window and the nearest obstacle indices of the kept voxels
+    /// with it. Newly exposed voxels and voxels whose nearest obstacle left
+    /// the window get the largest index, i.e. no nearest obstacle.
+    DistanceTransform &ShiftWindow(const Eigen::Vector3i &shift) override;
 
     DistanceTransform &ComputeEDT(
             const utility::device_vector<Eigen::Vector3i> &points);
     DistanceTransform &ComputeEDT(const VoxelGrid &voxelgrid);
+    /// Computes the distances from the occupied voxels of \p occgrid, which
+    /// must cover the same window as this grid.
+    DistanceTransform &ComputeEDT(const OccupancyGrid &occgrid);
+    /// Updates the distances after obstacles were added or removed, touching
+    /// only the voxels whose nearest obstacle changes. A raise wavefront
+    /// clears the voxels attached to \p removed_obstacles and a lower
+    /// wavefront then propagates the new and bordering obstacles. If
+    /// \p max_distance is positive, the propagation stops there and farther
+    /// voxels only keep a distance of at least \p max_distance. Requires a
+    /// previous ComputeEDT and no ShiftWindow since then. Signed fields are
+    /// not supported.
+    DistanceTransform &UpdateEDT(
+            const utility::device_vector<Eigen::Vector3i> &added_obstacles,
+            const utility::device_vector<Eigen::Vector3i> &removed_obstacles,
+            float max_distance = -1.0);
+    /// Updates the distances from the changed_voxels_ recorded by \p occgrid
+    /// and consumes them.
+    DistanceTransform &UpdateEDT(OccupancyGrid &occgrid,
+                                 float max_distance = -1.0);
+    /// Computes signed distances: positive distances to the nearest obstacle
+    /// outside and negative distances to the nearest free voxel inside
+    /// obstacles, obtained from an inverted EDT. Both are measured between
+    /// voxel centers minus half a voxel, so that the zero level lies on the
+    /// obstacle faces.
+    DistanceTransform &ComputeSignedEDT(
+            const utility::device_vector<Eigen::Vector3i> &points);
+    DistanceTransform &ComputeSignedEDT(const VoxelGrid &voxelgrid);
     DistanceTransform &ComputeVoronoiDiagram(
             const utility::device_vector<Eigen::Vector3i> &points);
     DistanceTransform &ComputeVoronoiDiagram(const VoxelGrid &voxelgrid);
 
+    /// Returns the distance at \p query. Queries outside of the grid return 0
+    /// and voxels not reached by any obstacle return the largest float.
+    /// After ShiftWindow, distances inside the kept region remain valid while
+    /// the newly exposed voxels read 0 until the next ComputeEDT.
     float GetDistance(const Eigen::Vector3f &query) const;
     utility::device_vector<float> GetDistances(
             const utility::device_vector<Eigen::Vector3f> &queries) const;
+    /// Returns the distances at \p queries trilinearly interpolated between
+    /// voxel centers together with their analytic gradients. Queries outside
+    /// of the grid return 0 with a zero gradient.
+    std::pair<utility::device_vector<float>,
+              utility::device_vector<Eigen::Vector3f>>
+    GetInterpolatedDistances(
+            const utility::device_vector<Eigen::Vector3f> &queries) const;
+
+    bool IsSigned() const { return is_signed_; };
 
     static std::shared_ptr<DistanceTransform> CreateFromOccupancyGrid(
             const OccupancyGrid &input);
 
 private:
+    /// Runs the Voronoi diagram computation on the sites stored in buffer_.
+    void ComputeVoronoiDiagramFromBuffer();
+    /// Converts voxel grid keys to indices of this grid.
+    bool ComputeObstacleCells(
+            const VoxelGrid &voxelgrid,
+            utility::device_vector<Eigen::Vector3i> &obs_cells) const;
+
     utility::device_vector<DistanceVoxel> buffer_;
+    bool is_signed_ = false;
 };
 
 }  // namespace geometry
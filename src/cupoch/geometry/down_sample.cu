@@ -18,8 +18,10 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  **/
+#include <thrust/binary_search.h>
 #include <thrust/gather.h>
 #include <thrust/iterator/discard_iterator.h>
+#include <thrust/random.h>
 #include <thrust/set_operations.h>
 #include <thrust/sort.h>
 #include <thrust/async/copy.h>
@@ -101,6 +103,174 @@ struct check_distance_threshold_functor {
     }
 };
 
+struct farthest_point_update_functor {
+    farthest_point_update_functor(const Eigen::Vector3f &last_point)
+        : last_point_(last_point){};
+    const Eigen::Vector3f last_point_;
+    __device__ float operator()(const Eigen::Vector3f &point,
+                                float min_distance) const {
+        return min(min_distance, (point - last_point_).squaredNorm());
+    }
+};
+
+struct argmax_distance_functor {
+    __device__ thrust::tuple<float, size_t> operator()(
+            const thrust::tuple<float, size_t> &lhs,
+            const thrust::tuple<float, size_t> &rhs) const {
+        const float ld = thrust::get<0>(lhs);
+        const float rd = thrust::get<0>(rhs);
+        if (ld != rd) return (ld > rd) ? lhs : rhs;
+        return (thrust::get<1>(lhs) < thrust::get<1>(rhs)) ? lhs : rhs;
+    }
+};
+
+struct random_priority_functor {
+    random_priority_functor(int seed) : seed_(seed){};
+    const int seed_;
+    __device__ unsigned int operator()(size_t idx) const {
+        thrust::default_random_engine eng(seed_);
+        eng.discard(idx);
+        return eng();
+    }
+};
+
+__device__ int PoissonDiskPhase(const Eigen::Vector3i &key) {
+    return (key[0] % 3) * 9 + (key[1] % 3) * 3 + key[2] % 3;
+}
+
+struct poisson_disk_phase_functor {
+    __device__ int operator()(const Eigen::Vector3i &key) const {
+        return PoissonDiskPhase(key);
+    }
+};
+
+// Each cell has a size of radius / sqrt(3), so that it contains at most one
+// sample and the disk of a sample is covered by the neighboring cells within
+// two cells. Cells whose keys are congruent modulo 3 are at least two cells
+// apart and can therefore be sampled in parallel.
+struct poisson_disk_sample_functor {
+    poisson_disk_sample_functor(const Eigen::Vector3f *points,
+                                const Eigen::Vector3i *cell_keys,
+                                const int *cell_offsets,
+                                const size_t *sorted_indices,
+                                const int *phase_cells,
+                                int *cell_samples,
+                                int n_cells,
+                                float radius)
+        : points_(points),
+          cell_keys_(cell_keys),
+          cell_offsets_(cell_offsets),
+          sorted_indices_(sorted_indices),
+          phase_cells_(phase_cells),
+          cell_samples_(cell_samples),
+          n_cells_(n_cells),
+          radius2_(radius * radius){};
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3i *cell_keys_;
+    const int *cell_offsets_;
+    const size_t *sorted_indices_;
+    const int *phase_cells_;
+    int *cell_samples_;
+    const int n_cells_;
+    const float radius2_;
+    __device__ void operator()(size_t idx) {
+        const int cell = phase_cells_[idx];
+        const Eigen::Vector3i key = cell_keys_[cell];
+        int neighbor_samples[124];
+        int n_neighbors = 0;
+        for (int dx = -2; dx <= 2; ++dx) {
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dz = -2; dz <= 2; ++dz) {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    // skip the corner cells that are not closer than radius
+                    const int ex = max(abs(dx) - 1, 0);
+                    const int ey = max(abs(dy) - 1, 0);
+                    const int ez = max(abs(dz) - 1, 0);
+                    if (ex * ex + ey * ey + ez * ez >= 3) continue;
+                    const Eigen::Vector3i nkey =
+                            key + Eigen::Vector3i(dx, dy, dz);
+                    const Eigen::Vector3i *found = thrust::lower_bound(
+                            thrust::seq, cell_keys_, cell_keys_ + n_cells_,
+                            nkey);
+                    if (found == cell_keys_ + n_cells_ || *found != nkey)
+                        continue;
+                    const int sample = cell_samples_[found - cell_keys_];
+                    if (sample >= 0) neighbor_samples[n_neighbors++] = sample;
+                }
+            }
+        }
+        for (int i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+            const Eigen::Vector3f &pt = points_[sorted_indices_[i]];
+            bool accepted = true;
+            for (int j = 0; j < n_neighbors; ++j) {
+                if ((points_[neighbor_samples[j]] - pt).squaredNorm() <
+                    radius2_) {
+                    accepted = false;
+                    break;
+                }
+            }
+            if (accepted) {
+                cell_samples_[cell] = sorted_indices_[i];
+                return;
+            }
+        }
+    }
+};
+
+struct organized_down_sample_functor {
+    organized_down_sample_functor(const Eigen::Vector3f *points,
+                                  const Eigen::Vector3f *normals,
+                                  const Eigen::Vector3f *colors,
+                                  int width,
+                                  int out_width,
+                                  float max_distance)
+        : points_(points),
+          normals_(normals),
+          colors_(colors),
+          width_(width),
+          out_width_(out_width),
+          max_distance_(max_distance){};
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3f *normals_;
+    const Eigen::Vector3f *colors_;
+    const int width_;
+    const int out_width_;
+    const float max_distance_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>
+    operator()(size_t idx) const {
+        const int y = idx / out_width_;
+        const int x = idx % out_width_;
+        Eigen::Vector3f point = Eigen::Vector3f::Zero();
+        Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+        Eigen::Vector3f color = Eigen::Vector3f::Zero();
+        Eigen::Vector3f ref;
+        int n = 0;
+#pragma unroll
+        for (int i = 0; i < 4; ++i) {
+            const int j = (2 * y + i / 2) * width_ + 2 * x + i % 2;
+            const Eigen::Vector3f &p = points_[j];
+            if (!isfinite(p(0)) || !isfinite(p(1)) || !isfinite(p(2))) {
+                continue;
+            }
+            if (n == 0) {
+                ref = p;
+            } else if ((p - ref).norm() > max_distance_) {
+                continue;
+            }
+            point += p;
+            if (normals_) normal += normals_[j];
+            if (colors_) color += colors_[j];
+            ++n;
+        }
+        if (n == 0) {
+            const Eigen::Vector3f nan_v = Eigen::Vector3f::Constant(
+                    std::numeric_limits<float>::quiet_NaN());
+            return thrust::make_tuple(nan_v, nan_v, nan_v);
+        }
+        return thrust::make_tuple(point / n, normal.normalized(), color / n);
+    }
+};
+
 }  // namespace
 
 std::shared_ptr<PointCloud> PointCloud::SelectByIndex(
@@ -294,6 +464,169 @@ std::shared_ptr<PointCloud> PointCloud::UniformDownSample(
     return output;
 }
 
+std::shared_ptr<PointCloud> PointCloud::OrganizedDownSample(
+        int width, int height, float max_distance) const {
+    auto output = std::make_shared<PointCloud>();
+    if (width <= 0 || height <= 0 || points_.size() != width * height) {
+        utility::LogError(
+                "[OrganizedDownSample] The point cloud is not organized as "
+                "{}x{} points.",
+                width, height);
+        return output;
+    }
+    const bool has_normals = HasNormals();
+    const bool has_colors = HasColors();
+    const int out_width = width / 2;
+    const size_t n_out = out_width * (height / 2);
+    output->points_.resize(n_out);
+    output->normals_.resize(n_out);
+    output->colors_.resize(n_out);
+    organized_down_sample_functor func(
+            thrust::raw_pointer_cast(points_.data()),
+            has_normals ? thrust::raw_pointer_cast(normals_.data()) : nullptr,
+            has_colors ? thrust::raw_pointer_cast(colors_.data()) : nullptr,
+            width, out_width, max_distance);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_out),
+                      make_tuple_begin(output->points_, output->normals_,
+                                       output->colors_),
+                      func);
+    if (!has_normals) output->normals_.clear();
+    if (!has_colors) output->colors_.clear();
+    return output;
+}
+
+std::shared_ptr<PointCloud> PointCloud::FarthestPointDownSample(
+        size_t num_samples, size_t start_index) const {
+    const size_t n_pt = points_.size();
+    if (num_samples == 0) {
+        return std::make_shared<PointCloud>();
+    }
+    if (num_samples >= n_pt) {
+        return std::make_shared<PointCloud>(*this);
+    }
+    if (start_index >= n_pt) {
+        utility::LogError("[FarthestPointDownSample] Illegal start index.");
+        return std::make_shared<PointCloud>();
+    }
+    thrust::host_vector<size_t> selected(num_samples);
+    selected[0] = start_index;
+    utility::device_vector<float> min_distances(
+            n_pt, std::numeric_limits<float>::infinity());
+    for (size_t i = 1; i < num_samples; ++i) {
+        const Eigen::Vector3f last_point = points_[selected[i - 1]];
+        thrust::transform(points_.begin(), points_.end(),
+                          min_distances.begin(), min_distances.begin(),
+                          farthest_point_update_functor(last_point));
+        auto farthest = thrust::reduce(
+                utility::exec_policy(0)->on(0),
+                thrust::make_zip_iterator(thrust::make_tuple(
+                        min_distances.begin(),
+                        thrust::make_counting_iterator<size_t>(0))),
+                thrust::make_zip_iterator(thrust::make_tuple(
+                        min_distances.end(),
+                        thrust::make_counting_iterator(n_pt))),
+                thrust::make_tuple(-1.0f, size_t(0)),
+                argmax_distance_functor());
+        selected[i] = thrust::get<1>(farthest);
+    }
+    utility::device_vector<size_t> indices = selected;
+    return SelectByIndex(indices);
+}
+
+std::shared_ptr<PointCloud> PointCloud::PoissonDiskDownSample(float radius,
+                                                              int seed) const {
+    auto output = std::make_shared<PointCloud>();
+    if (radius <= 0.0) {
+        utility::LogWarning("[PoissonDiskDownSample] radius <= 0.\n");
+        return output;
+    }
+    if (points_.empty()) return output;
+
+    const float cell_size = radius / std::sqrt(3.0f);
+    const Eigen::Vector3f min_bound = GetMinBound();
+    if (cell_size * std::numeric_limits<int>::max() <
+        (GetMaxBound() - min_bound).maxCoeff()) {
+        utility::LogWarning("[PoissonDiskDownSample] radius is too small.\n");
+        return output;
+    }
+
+    // Group the points by cell in a random order inside each cell.
+    const size_t n_pt = points_.size();
+    utility::device_vector<unsigned int> priorities(n_pt);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt),
+                      priorities.begin(), random_priority_functor(seed));
+    utility::device_vector<size_t> sorted_indices(n_pt);
+    thrust::sequence(sorted_indices.begin(), sorted_indices.end());
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), priorities.begin(),
+                        priorities.end(), sorted_indices.begin());
+    utility::device_vector<Eigen::Vector3i> keys(n_pt);
+    thrust::transform(
+            thrust::make_permutation_iterator(points_.begin(),
+                                              sorted_indices.begin()),
+            thrust::make_permutation_iterator(points_.begin(),
+                                              sorted_indices.end()),
+            keys.begin(), compute_key_functor(min_bound, cell_size));
+    thrust::stable_sort_by_key(utility::exec_policy(0)->on(0), keys.begin(),
+                               keys.end(), sorted_indices.begin());
+
+    utility::device_vector<Eigen::Vector3i> cell_keys(n_pt);
+    utility::device_vector<int> cell_offsets(n_pt + 1, 0);
+    auto end = thrust::reduce_by_key(utility::exec_policy(0)->on(0),
+                                     keys.begin(), keys.end(),
+                                     thrust::make_constant_iterator<int>(1),
+                                     cell_keys.begin(), cell_offsets.begin());
+    const int n_cells = thrust::distance(cell_keys.begin(), end.first);
+    cell_keys.resize(n_cells);
+    cell_offsets.resize(n_cells + 1);
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                           cell_offsets.begin(), cell_offsets.end(),
+                           cell_offsets.begin());
+
+    // Sort the cells by their phase and sample one phase after the other.
+    utility::device_vector<int> phases(n_cells);
+    thrust::transform(cell_keys.begin(), cell_keys.end(), phases.begin(),
+                      poisson_disk_phase_functor());
+    utility::device_vector<int> phase_cells(n_cells);
+    thrust::sequence(phase_cells.begin(), phase_cells.end());
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), phases.begin(),
+                        phases.end(), phase_cells.begin());
+    utility::device_vector<int> phase_offsets(28);
+    thrust::lower_bound(phases.begin(), phases.end(),
+                        thrust::make_counting_iterator(0),
+                        thrust::make_counting_iterator(28),
+                        phase_offsets.begin());
+    thrust::host_vector<int> h_phase_offsets = phase_offsets;
+
+    utility::device_vector<int> cell_samples(n_cells, -1);
+    poisson_disk_sample_functor func(
+            thrust::raw_pointer_cast(points_.data()),
+            thrust::raw_pointer_cast(cell_keys.data()),
+            thrust::raw_pointer_cast(cell_offsets.data()),
+            thrust::raw_pointer_cast(sorted_indices.data()),
+            thrust::raw_pointer_cast(phase_cells.data()),
+            thrust::raw_pointer_cast(cell_samples.data()), n_cells, radius);
+    for (int p = 0; p < 27; ++p) {
+        thrust::for_each(
+                thrust::make_counting_iterator<size_t>(h_phase_offsets[p]),
+                thrust::make_counting_iterator<size_t>(h_phase_offsets[p + 1]),
+                func);
+    }
+
+    utility::device_vector<size_t> indices(n_cells);
+    auto indices_end = thrust::copy_if(
+            cell_samples.begin(), cell_samples.end(), indices.begin(),
+            [] __device__(int idx) { return idx >= 0; });
+    indices.resize(thrust::distance(indices.begin(), indices_end));
+    thrust::sort(utility::exec_policy(0)->on(0), indices.begin(),
+                 indices.end());
+    utility::LogDebug(
+            "Pointcloud down sampled from {:d} points to {:d} points.\n",
+            (int)points_.size(), (int)indices.size());
+    return SelectByIndex(indices);
+}
+
 std::tuple<std::shared_ptr<PointCloud>, utility::device_vector<size_t>>
 PointCloud::RemoveRadiusOutliers(size_t nb_points, float search_radius) const {
     if (nb_points < 1 || search_radius <= 0) {
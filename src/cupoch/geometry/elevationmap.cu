@@ -0,0 +1,604 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/iterator/constant_iterator.h>
+
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/elevationmap.h"
+#include "cupoch/geometry/graph.h"
+#include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/platform.h"
+
+namespace cupoch {
+namespace geometry {
+
+namespace {
+
+typedef thrust::tuple<float, float, float, int> HeightStats;
+
+__host__ __device__ int CellIndexOf(const Eigen::Vector2f &point,
+                                    const Eigen::Vector2f &origin,
+                                    float cell_size,
+                                    int resolution,
+                                    const Eigen::Vector2i &ring_offset) {
+    if (isnan(point[0]) || isnan(point[1])) return -1;
+    const Eigen::Vector2f q = (point - origin) / cell_size;
+    const Eigen::Vector2i grid_index(int(floorf(q[0])) + resolution / 2,
+                                     int(floorf(q[1])) + resolution / 2);
+    if (grid_index[0] < 0 || grid_index[0] >= resolution ||
+        grid_index[1] < 0 || grid_index[1] >= resolution)
+        return -1;
+    return RingIndexOf(grid_index, ring_offset, resolution);
+}
+
+/// Inverse of RingIndexOf.
+__device__ Eigen::Vector2i RingKeyOf(int idx,
+                                     const Eigen::Vector2i &offset,
+                                     int resolution) {
+    Eigen::Vector2i grid_index(idx / resolution - offset[0],
+                               idx % resolution - offset[1]);
+    if (grid_index[0] < 0) grid_index[0] += resolution;
+    if (grid_index[1] < 0) grid_index[1] += resolution;
+    return grid_index;
+}
+
+struct compute_cell_height_functor {
+    compute_cell_height_functor(const Eigen::Vector2f &origin,
+                                float cell_size,
+                                int resolution,
+                                const Eigen::Vector2i &ring_offset)
+        : origin_(origin),
+          cell_size_(cell_size),
+          resolution_(resolution),
+          ring_offset_(ring_offset){};
+    const Eigen::Vector2f origin_;
+    const float cell_size_;
+    const int resolution_;
+    const Eigen::Vector2i ring_offset_;
+    __device__ thrust::tuple<int, float> operator()(
+            const Eigen::Vector3f &point) const {
+        if (isnan(point[2])) return thrust::make_tuple(-1, 0.0f);
+        return thrust::make_tuple(
+                CellIndexOf(point.head<2>(), origin_, cell_size_, resolution_,
+                            ring_offset_),
+                point[2]);
+    }
+};
+
+struct reduce_height_stats_functor {
+    __device__ HeightStats operator()(const HeightStats &lhs,
+                                      const HeightStats &rhs) const {
+        return thrust::make_tuple(
+                fminf(thrust::get<0>(lhs), thrust::get<0>(rhs)),
+                fmaxf(thrust::get<1>(lhs), thrust::get<1>(rhs)),
+                thrust::get<2>(lhs) + thrust::get<2>(rhs),
+                thrust::get<3>(lhs) + thrust::get<3>(rhs));
+    }
+};
+
+struct fuse_height_functor {
+    fuse_height_functor(ElevationCell *cells,
+                        float height_variance,
+                        float min_variance,
+                        float mahalanobis_thres)
+        : cells_(cells),
+          height_variance_(height_variance),
+          min_variance_(min_variance),
+          mahalanobis_thres_(mahalanobis_thres){};
+    ElevationCell *cells_;
+    const float height_variance_;
+    const float min_variance_;
+    const float mahalanobis_thres_;
+    __device__ void operator()(
+            const thrust::tuple<int, float, float, float, int> &x) {
+        ElevationCell &cell = cells_[thrust::get<0>(x)];
+        const float min_h = thrust::get<1>(x);
+        const float max_h = thrust::get<2>(x);
+        const float sum_h = thrust::get<3>(x);
+        const int count = thrust::get<4>(x);
+        if (isnan(cell.height_)) {
+            cell.height_ = max_h;
+            cell.variance_ = height_variance_;
+            cell.min_height_ = min_h;
+            cell.max_height_ = max_h;
+            cell.mean_height_ = sum_h / count;
+            cell.num_points_ = count;
+            return;
+        }
+        const float diff = max_h - cell.height_;
+        const float var_sum = cell.variance_ + height_variance_;
+        if (diff * diff > mahalanobis_thres_ * mahalanobis_thres_ * var_sum) {
+            if (diff > 0.0f) {
+                cell.height_ = max_h;
+                cell.variance_ = height_variance_;
+            }
+        } else {
+            const float gain = cell.variance_ / var_sum;
+            cell.height_ += gain * diff;
+            cell.variance_ =
+                    fmaxf((1.0f - gain) * cell.variance_, min_variance_);
+        }
+        cell.min_height_ = fminf(cell.min_height_, min_h);
+        cell.max_height_ = fmaxf(cell.max_height_, max_h);
+        const int n = cell.num_points_ + count;
+        cell.mean_height_ = (cell.mean_height_ * cell.num_points_ + sum_h) / n;
+        cell.num_points_ = n;
+    }
+};
+
+struct occupied_voxel_top_functor {
+    occupied_voxel_top_functor(float voxel_size,
+                               int resolution,
+                               const Eigen::Vector3f &origin)
+        : voxel_size_(voxel_size), resolution_(resolution), origin_(origin){};
+    const float voxel_size_;
+    const int resolution_;
+    const Eigen::Vector3f origin_;
+    __device__ Eigen::Vector3f operator()(const OccupancyVoxel &v) const {
+        return (v.grid_index_.cast<int>() -
+                Eigen::Vector3i::Constant(resolution_ / 2))
+                               .cast<float>() *
+                       voxel_size_ +
+               Eigen::Vector3f(0.5f, 0.5f, 1.0f) * voxel_size_ + origin_;
+    }
+};
+
+struct compute_traversability_functor {
+    compute_traversability_functor(ElevationCell *cells,
+                                   const ElevationMap &map)
+        : cells_(cells),
+          cell_size_(map.cell_size_),
+          resolution_(map.resolution_),
+          ring_offset_(map.ring_offset_),
+          radius_(map.traversability_radius_),
+          critical_slope_(map.critical_slope_),
+          critical_roughness_(map.critical_roughness_),
+          critical_step_height_(map.critical_step_height_),
+          slope_weight_(map.slope_weight_),
+          roughness_weight_(map.roughness_weight_),
+          step_height_weight_(map.step_height_weight_){};
+    ElevationCell *cells_;
+    const float cell_size_;
+    const int resolution_;
+    const Eigen::Vector2i ring_offset_;
+    const int radius_;
+    const float critical_slope_;
+    const float critical_roughness_;
+    const float critical_step_height_;
+    const float slope_weight_;
+    const float roughness_weight_;
+    const float step_height_weight_;
+    __device__ float NeighborHeight(const Eigen::Vector2i &gidx,
+                                    int dx,
+                                    int dy) const {
+        const Eigen::Vector2i nidx(gidx[0] + dx, gidx[1] + dy);
+        if (nidx[0] < 0 || nidx[0] >= resolution_ || nidx[1] < 0 ||
+            nidx[1] >= resolution_)
+            return std::numeric_limits<float>::quiet_NaN();
+        return cells_[RingIndexOf(nidx, ring_offset_, resolution_)].height_;
+    }
+    __device__ void operator()(size_t idx) {
+        ElevationCell &cell = cells_[idx];
+        if (isnan(cell.height_)) {
+            cell.slope_ = std::numeric_limits<float>::quiet_NaN();
+            cell.roughness_ = std::numeric_limits<float>::quiet_NaN();
+            cell.step_height_ = std::numeric_limits<float>::quiet_NaN();
+            cell.traversability_ = std::numeric_limits<float>::quiet_NaN();
+            return;
+        }
+        const Eigen::Vector2i gidx = RingKeyOf(idx, ring_offset_, resolution_);
+        // Normal equations of the plane z = a * x + b * y + c in the frame
+        // of the cell.
+        Eigen::Matrix3f ata = Eigen::Matrix3f::Zero();
+        Eigen::Vector3f atb = Eigen::Vector3f::Zero();
+        float min_h = cell.height_;
+        float max_h = cell.height_;
+        for (int dx = -radius_; dx <= radius_; ++dx) {
+            for (int dy = -radius_; dy <= radius_; ++dy) {
+                const float h = NeighborHeight(gidx, dx, dy);
+                if (isnan(h)) continue;
+                const Eigen::Vector3f a(dx * cell_size_, dy * cell_size_, 1.0f);
+                ata += a * a.transpose();
+                atb += a * h;
+                min_h = fminf(min_h, h);
+                max_h = fmaxf(max_h, h);
+            }
+        }
+        float slope = 0.0f;
+        float roughness = 0.0f;
+        if (ata(2, 2) >= 3.0f && fabsf(ata.determinant()) > 1.0e-12f) {
+            const Eigen::Vector3f plane = ata.inverse() * atb;
+            slope = atanf(sqrtf(plane[0] * plane[0] + plane[1] * plane[1]));
+            float sq_sum = 0.0f;
+            for (int dx = -radius_; dx <= radius_; ++dx) {
+                for (int dy = -radius_; dy <= radius_; ++dy) {
+                    const float h = NeighborHeight(gidx, dx, dy);
+                    if (isnan(h)) continue;
+                    const float r = h - (plane[0] * dx * cell_size_ +
+                                         plane[1] * dy * cell_size_ + plane[2]);
+                    sq_sum += r * r;
+                }
+            }
+            roughness = sqrtf(sq_sum / ata(2, 2));
+        }
+        const float step_height = max_h - min_h;
+        cell.slope_ = slope;
+        cell.roughness_ = roughness;
+        cell.step_height_ = step_height;
+        if (slope > critical_slope_ || roughness > critical_roughness_ ||
+            step_height > critical_step_height_) {
+            cell.traversability_ = 0.0f;
+            return;
+        }
+        const float t = 1.0f - slope_weight_ * slope / critical_slope_ -
+                        roughness_weight_ * roughness / critical_roughness_ -
+                        step_height_weight_ * step_height /
+                                critical_step_height_;
+        cell.traversability_ = fminf(fmaxf(t, 0.0f), 1.0f);
+    }
+};
+
+struct cell_to_point_functor {
+    cell_to_point_functor(const ElevationMap &map)
+        : cell_size_(map.cell_size_),
+          resolution_(map.resolution_),
+          origin_(map.origin_),
+          ring_offset_(map.ring_offset_){};
+    const float cell_size_;
+    const int resolution_;
+    const Eigen::Vector2f origin_;
+    const Eigen::Vector2i ring_offset_;
+    __device__ Eigen::Vector3f operator()(
+            const thrust::tuple<size_t, ElevationCell> &x) const {
+        const Eigen::Vector2i gidx =
+                RingKeyOf(thrust::get<0>(x), ring_offset_, resolution_);
+        const Eigen::Vector2f xy =
+                (gidx - Eigen::Vector2i::Constant(resolution_ / 2))
+                                .cast<float>() *
+                        cell_size_ +
+                Eigen::Vector2f::Constant(0.5f * cell_size_) + origin_;
+        return Eigen::Vector3f(xy[0], xy[1], thrust::get<1>(x).height_);
+    }
+};
+
+struct clear_ring_slab_2d_functor {
+    clear_ring_slab_2d_functor(ElevationCell *cells,
+                               int axis,
+                               int start,
+                               const Eigen::Vector2i &offset,
+                               int resolution)
+        : cells_(cells),
+          axis_(axis),
+          start_(start),
+          offset_(offset),
+          resolution_(resolution){};
+    ElevationCell *cells_;
+    const int axis_;
+    const int start_;
+    const Eigen::Vector2i offset_;
+    const int resolution_;
+    __device__ void operator()(size_t idx) {
+        Eigen::Vector2i grid_index;
+        grid_index[axis_] = start_ + idx / resolution_;
+        grid_index[1 - axis_] = idx % resolution_;
+        cells_[RingIndexOf(grid_index, offset_, resolution_)] = ElevationCell();
+    }
+};
+
+struct compute_edge_cost_functor {
+    compute_edge_cost_functor(const ElevationCell *cells,
+                              int resolution,
+                              const Eigen::Vector2i &ring_offset,
+                              float min_traversability,
+                              bool allow_unknown,
+                              float traversability_cost)
+        : cells_(cells),
+          resolution_(resolution),
+          ring_offset_(ring_offset),
+          min_traversability_(min_traversability),
+          allow_unknown_(allow_unknown),
+          traversability_cost_(traversability_cost){};
+    const ElevationCell *cells_;
+    const int resolution_;
+    const Eigen::Vector2i ring_offset_;
+    const float min_traversability_;
+    const bool allow_unknown_;
+    const float traversability_cost_;
+    __device__ float Traversability(int node) const {
+        const Eigen::Vector2i gidx(node / resolution_, node % resolution_);
+        const float t =
+                cells_[RingIndexOf(gidx, ring_offset_, resolution_)]
+                        .traversability_;
+        if (isnan(t)) return (allow_unknown_) ? 0.5f : -1.0f;
+        return t;
+    }
+    __device__ float operator()(const Eigen::Vector2i &edge,
+                                float weight) const {
+        const float t0 = Traversability(edge[0]);
+        const float t1 = Traversability(edge[1]);
+        if (t0 < 0.0f || t1 < 0.0f || t0 <= min_traversability_ ||
+            t1 <= min_traversability_) {
+            return std::numeric_limits<float>::infinity();
+        }
+        return weight *
+               (1.0f + traversability_cost_ * (1.0f - 0.5f * (t0 + t1)));
+    }
+};
+
+}  // namespace
+
+ElevationMap::ElevationMap()
+    : GeometryBase2D(Geometry::GeometryType::ElevationMap) {
+    cells_.resize(resolution_ * resolution_);
+}
+
+ElevationMap::ElevationMap(float cell_size,
+                           int resolution,
+                           const Eigen::Vector2f &origin)
+    : GeometryBase2D(Geometry::GeometryType::ElevationMap),
+      cell_size_(cell_size),
+      resolution_(resolution),
+      origin_(origin) {
+    cells_.resize(resolution_ * resolution_);
+}
+
+ElevationMap::ElevationMap(const ElevationMap &other)
+    : GeometryBase2D(Geometry::GeometryType::ElevationMap),
+      cell_size_(other.cell_size_),
+      resolution_(other.resolution_),
+      origin_(other.origin_),
+      ring_offset_(other.ring_offset_),
+      cells_(other.cells_),
+      min_variance_(other.min_variance_),
+      mahalanobis_thres_(other.mahalanobis_thres_),
+      traversability_radius_(other.traversability_radius_),
+      critical_slope_(other.critical_slope_),
+      critical_roughness_(other.critical_roughness_),
+      critical_step_height_(other.critical_step_height_),
+      slope_weight_(other.slope_weight_),
+      roughness_weight_(other.roughness_weight_),
+      step_height_weight_(other.step_height_weight_),
+      traversability_cost_(other.traversability_cost_) {}
+
+ElevationMap::~ElevationMap() {}
+
+ElevationMap &ElevationMap::Clear() {
+    thrust::fill(cells_.begin(), cells_.end(), ElevationCell());
+    ring_offset_ = Eigen::Vector2i::Zero();
+    return *this;
+}
+
+bool ElevationMap::IsEmpty() const { return !HasCells(); }
+
+Eigen::Vector2f ElevationMap::GetMinBound() const {
+    return origin_ - Eigen::Vector2f::Constant((resolution_ / 2) * cell_size_);
+}
+
+Eigen::Vector2f ElevationMap::GetMaxBound() const {
+    return origin_ + Eigen::Vector2f::Constant(
+                             (resolution_ - resolution_ / 2) * cell_size_);
+}
+
+Eigen::Vector2f ElevationMap::GetCenter() const {
+    return 0.5 * (GetMinBound() + GetMaxBound());
+}
+
+AxisAlignedBoundingBox<2> ElevationMap::GetAxisAlignedBoundingBox() const {
+    return AxisAlignedBoundingBox<2>(GetMinBound(), GetMaxBound());
+}
+
+ElevationMap &ElevationMap::Transform(const Eigen::Matrix3f &transformation) {
+    utility::LogError("ElevationMap::Transform is not supported");
+    return *this;
+}
+
+ElevationMap &ElevationMap::Translate(const Eigen::Vector2f &translation,
+                                      bool relative) {
+    if (relative) {
+        origin_ += translation;
+    } else {
+        origin_ = translation;
+    }
+    return *this;
+}
+
+ElevationMap &ElevationMap::Scale(const float scale, bool center) {
+    cell_size_ *= scale;
+    return *this;
+}
+
+ElevationMap &ElevationMap::Rotate(const Eigen::Matrix2f &R, bool center) {
+    utility::LogError("ElevationMap::Rotate is not supported");
+    return *this;
+}
+
+int ElevationMap::GetCellIndex(const Eigen::Vector2f &point) const {
+    return CellIndexOf(point, origin_, cell_size_, resolution_, ring_offset_);
+}
+
+thrust::tuple<bool, ElevationCell> ElevationMap::GetCell(
+        const Eigen::Vector2f &point) const {
+    const int idx = GetCellIndex(point);
+    if (idx < 0) return thrust::make_tuple(false, ElevationCell());
+    ElevationCell cell = cells_[idx];
+    return thrust::make_tuple(true, cell);
+}
+
+std::shared_ptr<PointCloud> ElevationMap::ExtractPointCloud() const {
+    auto out = std::make_shared<PointCloud>();
+    out->points_.resize(cells_.size());
+    thrust::transform(
+            make_tuple_iterator(thrust::make_counting_iterator<size_t>(0),
+                                cells_.begin()),
+            make_tuple_iterator(thrust::make_counting_iterator(cells_.size()),
+                                cells_.end()),
+            out->points_.begin(), cell_to_point_functor(*this));
+    auto end = thrust::remove_if(
+            out->points_.begin(), out->points_.end(),
+            [] __device__(const Eigen::Vector3f &p) { return isnan(p[2]); });
+    out->points_.resize(thrust::distance(out->points_.begin(), end));
+    return out;
+}
+
+ElevationMap &ElevationMap::Reconstruct(float cell_size, int resolution) {
+    cell_size_ = cell_size;
+    resolution_ = resolution;
+    ring_offset_ = Eigen::Vector2i::Zero();
+    cells_.resize(resolution_ * resolution_);
+    thrust::fill(cells_.begin(), cells_.end(), ElevationCell());
+    return *this;
+}
+
+ElevationMap &ElevationMap::ShiftWindow(const Eigen::Vector2i &shift) {
+    origin_ += shift.cast<float>() * cell_size_;
+    if ((shift.array().abs() >= resolution_).any()) {
+        thrust::fill(cells_.begin(), cells_.end(), ElevationCell());
+        ring_offset_ = Eigen::Vector2i::Zero();
+        return *this;
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (shift[i] == 0) continue;
+        ring_offset_[i] =
+                ((ring_offset_[i] + shift[i]) % resolution_ + resolution_) %
+                resolution_;
+        const int start = (shift[i] > 0) ? resolution_ - shift[i] : 0;
+        const size_t n_slab = size_t(std::abs(shift[i])) * resolution_;
+        clear_ring_slab_2d_functor func(thrust::raw_pointer_cast(cells_.data()),
+                                        i, start, ring_offset_, resolution_);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_slab), func);
+    }
+    return *this;
+}
+
+ElevationMap &ElevationMap::Recenter(const Eigen::Vector2f &center) {
+    Eigen::Vector2f diff = (center - origin_) / cell_size_;
+    return ShiftWindow(diff.array().round().matrix().cast<int>());
+}
+
+ElevationMap &ElevationMap::Integrate(
+        const utility::device_vector<Eigen::Vector3f> &points,
+        float height_variance) {
+    if (points.empty()) return *this;
+    if (height_variance <= 0.0) {
+        utility::LogError(
+                "[ElevationMap::Integrate] height_variance must be positive.");
+        return *this;
+    }
+    utility::device_vector<int> indices(points.size());
+    utility::device_vector<float> heights(points.size());
+    compute_cell_height_functor func(origin_, cell_size_, resolution_,
+                                     ring_offset_);
+    thrust::transform(points.begin(), points.end(),
+                      make_tuple_begin(indices, heights), func);
+    remove_if_vectors(
+            [] __device__(const thrust::tuple<int, float> &x) {
+                return thrust::get<0>(x) < 0;
+            },
+            indices, heights);
+    if (indices.empty()) return *this;
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), indices.begin(),
+                        indices.end(), heights.begin());
+
+    // Statistics of the points of each cell, then one fusion per cell.
+    const size_t n = indices.size();
+    utility::device_vector<int> cell_indices(n);
+    utility::device_vector<float> min_heights(n);
+    utility::device_vector<float> max_heights(n);
+    utility::device_vector<float> sum_heights(n);
+    utility::device_vector<int> counts(n);
+    auto end = thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), indices.begin(), indices.end(),
+            make_tuple_iterator(heights.begin(), heights.begin(),
+                                heights.begin(),
+                                thrust::make_constant_iterator<int>(1)),
+            cell_indices.begin(),
+            make_tuple_begin(min_heights, max_heights, sum_heights, counts),
+            thrust::equal_to<int>(), reduce_height_stats_functor());
+    resize_all(thrust::distance(cell_indices.begin(), end.first), cell_indices,
+               min_heights, max_heights, sum_heights, counts);
+    fuse_height_functor fuse_func(thrust::raw_pointer_cast(cells_.data()),
+                                  height_variance, min_variance_,
+                                  mahalanobis_thres_);
+    thrust::for_each(make_tuple_begin(cell_indices, min_heights, max_heights,
+                                      sum_heights, counts),
+                     make_tuple_end(cell_indices, min_heights, max_heights,
+                                    sum_heights, counts),
+                     fuse_func);
+    return *this;
+}
+
+ElevationMap &ElevationMap::Integrate(const PointCloud &pointcloud,
+                                      float height_variance) {
+    return Integrate(pointcloud.points_, height_variance);
+}
+
+ElevationMap &ElevationMap::Integrate(const OccupancyGrid &occupancy_grid,
+                                      float height_variance) {
+    auto voxels = occupancy_grid.ExtractOccupiedVoxels();
+    utility::device_vector<Eigen::Vector3f> points(voxels->size());
+    thrust::transform(voxels->begin(), voxels->end(), points.begin(),
+                      occupied_voxel_top_functor(occupancy_grid.voxel_size_,
+                                                 occupancy_grid.resolution_,
+                                                 occupancy_grid.origin_));
+    return Integrate(points, height_variance);
+}
+
+ElevationMap &ElevationMap::UpdateTraversability() {
+    compute_traversability_functor func(thrust::raw_pointer_cast(cells_.data()),
+                                        *this);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(cells_.size()), func);
+    return *this;
+}
+
+std::shared_ptr<Graph<2>> ElevationMap::CreateGraph(float min_traversability,
+                                                    bool allow_unknown) const {
+    const Eigen::Vector2f half_cell =
+            Eigen::Vector2f::Constant(0.5f * cell_size_);
+    auto out = Graph<2>::CreateFromAxisAlignedBoundingBox(
+            GetMinBound() + half_cell, GetMaxBound() + half_cell,
+            Eigen::Vector2i::Constant(resolution_));
+    compute_edge_cost_functor func(thrust::raw_pointer_cast(cells_.data()),
+                                   resolution_, ring_offset_,
+                                   min_traversability, allow_unknown,
+                                   traversability_cost_);
+    thrust::transform(out->lines_.begin(), out->lines_.end(),
+                      out->edge_weights_.begin(), out->edge_weights_.begin(),
+                      func);
+    remove_if_vectors(
+            [] __device__(const thrust::tuple<Eigen::Vector2i, float> &x) {
+                return isinf(thrust::get<1>(x));
+            },
+            out->lines_, out->edge_weights_);
+    if (out->lines_.empty()) {
+        thrust::fill(out->edge_index_offsets_.begin(),
+                     out->edge_index_offsets_.end(), 0);
+        return out;
+    }
+    out->ConstructGraph(false);
+    return out;
+}
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+#include <thrust/tuple.h>
+
+#include "cupoch/geometry/geometry_base.h"
+#include "cupoch/utility/device_vector.h"
+
+namespace cupoch {
+namespace geometry {
+
+class PointCloud;
+class OccupancyGrid;
+template <int Dim>
+class Graph;
+
+/// Returns the storage index of \p grid_index in a square grid whose cells
+/// are addressed as a ring buffer shifted by \p offset. Both \p grid_index
+/// and \p offset must be in [0, resolution).
+__host__ __device__ inline int RingIndexOf(const Eigen::Vector2i &grid_index,
+                                           const Eigen::Vector2i &offset,
+                                           int resolution) {
+    Eigen::Vector2i idx = grid_index + offset;
+    if (idx[0] >= resolution) idx[0] -= resolution;
+    if (idx[1] >= resolution) idx[1] -= resolution;
+    return idx[0] * resolution + idx[1];
+}
+
+class ElevationCell {
+public:
+    __host__ __device__ ElevationCell() {}
+    __host__ __device__ ~ElevationCell() {}
+
+public:
+    /// Elevation of the top surface fused with a one dimensional Kalman
+    /// filter.
+    float height_ = std::numeric_limits<float>::quiet_NaN();
+    float variance_ = std::numeric_limits<float>::infinity();
+    float min_height_ = std::numeric_limits<float>::quiet_NaN();
+    float max_height_ = std::numeric_limits<float>::quiet_NaN();
+    /// Average of the heights of all the points observed in the cell.
+    float mean_height_ = std::numeric_limits<float>::quiet_NaN();
+    int num_points_ = 0;
+    /// Traversability layers computed by UpdateTraversability.
+    float slope_ = std::numeric_limits<float>::quiet_NaN();
+    float roughness_ = std::numeric_limits<float>::quiet_NaN();
+    float step_height_ = std::numeric_limits<float>::quiet_NaN();
+    /// Score in [0, 1], 0 meaning not traversable.
+    float traversability_ = std::numeric_limits<float>::quiet_NaN();
+};
+
+/// \class ElevationMap
+///
+/// \brief 2.5D grid map storing the elevation of the terrain around a ground
+/// robot together with traversability layers.
+///
+/// The map covers resolution x resolution cells centered on origin_. The
+/// cells are stored as a ring buffer so that ShiftWindow only clears the
+/// cells leaving the window.
+class ElevationMap : public GeometryBase2D {
+public:
+    ElevationMap();
+    ElevationMap(float cell_size,
+                 int resolution = 256,
+                 const Eigen::Vector2f &origin = Eigen::Vector2f::Zero());
+    ElevationMap(const ElevationMap &other);
+    ~ElevationMap();
+
+    ElevationMap &Clear() override;
+    bool IsEmpty() const override;
+    Eigen::Vector2f GetMinBound() const override;
+    Eigen::Vector2f GetMaxBound() const override;
+    Eigen::Vector2f GetCenter() const override;
+    AxisAlignedBoundingBox<2> GetAxisAlignedBoundingBox() const override;
+    ElevationMap &Transform(const Eigen::Matrix3f &transformation) override;
+    ElevationMap &Translate(const Eigen::Vector2f &translation,
+                            bool relative = true) override;
+    ElevationMap &Scale(const float scale, bool center = true) override;
+    ElevationMap &Rotate(const Eigen::Matrix2f &R, bool center = true) override;
+
+    bool HasCells() const { return cells_.size() > 0; }
+    /// Returns the storage index of the cell containing \p point, or -1 if
+    /// the point is outside of the map.
+    int GetCellIndex(const Eigen::Vector2f &point) const;
+    thrust::tuple<bool, ElevationCell> GetCell(
+            const Eigen::Vector2f &point) const;
+    /// Returns the fused height of the known cells as points located at the
+    /// cell centers.
+    std::shared_ptr<PointCloud> ExtractPointCloud() const;
+
+    ElevationMap &Reconstruct(float cell_size, int resolution);
+    /// Moves the window by \p shift cells. The cells leaving the window are
+    /// cleared and the other cells keep their values.
+    ElevationMap &ShiftWindow(const Eigen::Vector2i &shift);
+    /// Shifts the window by whole cells so that its center is the closest to
+    /// \p center.
+    ElevationMap &Recenter(const Eigen::Vector2f &center);
+
+    /// \brief Fuses the heights of the points falling in the map.
+    ///
+    /// The points are grouped per cell in parallel. The highest point of a
+    /// cell is fused into its elevation with a Kalman update, unless it lies
+    /// more than mahalanobis_thres_ standard deviations away. A higher point
+    /// then replaces the elevation and a lower one is ignored, so that the
+    /// map follows the top surface. The minimum, maximum and mean heights
+    /// accumulate all the points.
+    ///
+    /// \param points Points in the map frame.
+    /// \param height_variance Variance of the height measurement of a point.
+    ElevationMap &Integrate(
+            const utility::device_vector<Eigen::Vector3f> &points,
+            float height_variance = 0.0025);
+    ElevationMap &Integrate(const PointCloud &pointcloud,
+                            float height_variance = 0.0025);
+    /// Fuses the top faces of the occupied voxels of \p occupancy_grid.
+    ElevationMap &Integrate(const OccupancyGrid &occupancy_grid,
+                            float height_variance = 0.0025);
+
+    /// \brief Computes the slope, roughness, step height and traversability
+    /// layers of the known cells.
+    ///
+    /// A plane is fitted by least squares to the known cells within
+    /// traversability_radius_ cells. The slope is the angle of the plane,
+    /// the roughness the standard deviation of the residuals and the step
+    /// height the range of the heights in the window. Cells exceeding one
+    /// of the critical values get a traversability of 0.
+    ElevationMap &UpdateTraversability();
+
+    /// \brief Creates an 8-connected graph on the cell centers for path
+    /// planning.
+    ///
+    /// The graph is built with Graph::CreateFromAxisAlignedBoundingBox, the
+    /// node of the cell (i, j) of the window being i * resolution_ + j. Edges
+    /// touching a cell whose traversability is at most \p min_traversability
+    /// are removed and the distance weights of the other edges are scaled by
+    /// 1 + traversability_cost_ * (1 - mean traversability).
+    ///
+    /// \param min_traversability Traversability threshold of the nodes.
+    /// \param allow_unknown If true, unknown cells are traversable with a
+    /// traversability of 0.5.
+    std::shared_ptr<Graph<2>> CreateGraph(float min_traversability = 0.0,
+                                          bool allow_unknown = false) const;
+
+public:
+    float cell_size_ = 0.1;
+    int resolution_ = 256;
+    Eigen::Vector2f origin_ = Eigen::Vector2f::Zero();
+    Eigen::Vector2i ring_offset_ = Eigen::Vector2i::Zero();
+    utility::device_vector<ElevationCell> cells_;
+    /// Lower bound of the fused variance so that the map keeps adapting.
+    float min_variance_ = 1.0e-6;
+    float mahalanobis_thres_ = 2.5;
+    int traversability_radius_ = 1;
+    float critical_slope_ = 0.5;
+    float critical_roughness_ = 0.05;
+    float critical_step_height_ = 0.15;
+    float slope_weight_ = 1.0 / 3.0;
+    float roughness_weight_ = 1.0 / 3.0;
+    float step_height_weight_ = 1.0 / 3.0;
+    float traversability_cost_ = 4.0;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
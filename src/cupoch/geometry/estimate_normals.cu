@@ -22,20 +22,25 @@
 
 #include <Eigen/Geometry>
 
+#include "cupoch/geometry/graph.h"
 #include "cupoch/geometry/kdtree_flann.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/utility/console.h"
 #include "cupoch/utility/eigenvalue.h"
-#include "cupoch/utility/range.h"
+#include "cupoch/utility/helper.h"
 
 using namespace cupoch;
 using namespace cupoch::geometry;
 
 namespace {
 
-__device__ Eigen::Vector3f ComputeNormal(const Eigen::Matrix<float, 9, 1> &cum,
-                                         int count) {
-    if (count < 3) return Eigen::Vector3f(0.0, 0.0, 1.0);
+// Upper bound of the number of neighbor indices kept on the device at once.
+// Queries are processed in chunks so that the index buffer does not scale
+// with the size of the point cloud.
+static const size_t MAX_SEARCH_BUFFER_SIZE = 1 << 24;
+
+__device__ Eigen::Matrix3f ComputeCovariance(
+        const Eigen::Matrix<float, 9, 1> &cum, int count) {
     Eigen::Matrix<float, 9, 1> cumulants = cum / (float)count;
     Eigen::Matrix3f covariance;
     covariance(0, 0) = cumulants(3) - cumulants(0) * cumulants(0);
@@ -47,39 +52,76 @@ __device__ Eigen::Vector3f ComputeNormal(const Eigen::Matrix<float, 9, 1> &cum,
     covariance(2, 0) = covariance(0, 2);
     covariance(1, 2) = cumulants(7) - cumulants(1) * cumulants(2);
     covariance(2, 1) = covariance(1, 2);
-
-    return thrust::get<0>(utility::FastEigen3x3(covariance));
+    return covariance;
 }
 
+// Accumulates the covariance of each query's neighborhood in registers and
+// solves the eigen problem in the same pass, so no per-neighbor cumulants
+// are materialized in global memory.
 struct compute_normal_functor {
-    compute_normal_functor(){};
-    __device__ Eigen::Vector3f operator()(
-            const thrust::tuple<Eigen::Matrix<float, 9, 1>, int> &x) const {
-        Eigen::Vector3f normal =
-                ComputeNormal(thrust::get<0>(x), thrust::get<1>(x));
-        return (normal.norm() == 0.0) ? Eigen::Vector3f(0.0, 0.0, 1.0) : normal;
-    }
-};
-
-struct compute_cumulant_functor {
-    compute_cumulant_functor(const Eigen::Vector3f *points) : points_(points){};
+    compute_normal_functor(const Eigen::Vector3f *points,
+                           const int *indices,
+                           int knn,
+                           const Eigen::Vector3f *prev_normals,
+                           size_t offset,
+                           size_t n_prev)
+        : points_(points),
+          indices_(indices),
+          knn_(knn),
+          prev_normals_(prev_normals),
+          offset_(offset),
+          n_prev_(n_prev){};
     const Eigen::Vector3f *points_;
-    __device__ thrust::tuple<Eigen::Matrix<float, 9, 1>, int> operator()(
-            int idx) const {
-        Eigen::Matrix<float, 9, 1> cm;
-        cm.setZero();
-        if (idx < 0) return thrust::make_tuple(cm, 0);
-        const Eigen::Vector3f point = points_[idx];
-        cm(0) = point(0);
-        cm(1) = point(1);
-        cm(2) = point(2);
-        cm(3) = point(0) * point(0);
-        cm(4) = point(0) * point(1);
-        cm(5) = point(0) * point(2);
-        cm(6) = point(1) * point(1);
-        cm(7) = point(1) * point(2);
-        cm(8) = point(2) * point(2);
-        return thrust::make_tuple(cm, 1);
+    const int *indices_;
+    const int knn_;
+    const Eigen::Vector3f *prev_normals_;
+    const size_t offset_;
+    const size_t n_prev_;
+    __device__ thrust::tuple<Eigen::Vector3f, float, float> operator()(
+            size_t idx) const {
+        Eigen::Matrix<float, 9, 1> cum = Eigen::Matrix<float, 9, 1>::Zero();
+        int count = 0;
+        for (int k = 0; k < knn_; ++k) {
+            const int idx_k = __ldg(&indices_[idx * knn_ + k]);
+            if (idx_k < 0) continue;
+            const Eigen::Vector3f point = points_[idx_k];
+            cum(0) += point(0);
+            cum(1) += point(1);
+            cum(2) += point(2);
+            cum(3) += point(0) * point(0);
+            cum(4) += point(0) * point(1);
+            cum(5) += point(0) * point(2);
+            cum(6) += point(1) * point(1);
+            cum(7) += point(1) * point(2);
+            cum(8) += point(2) * point(2);
+            ++count;
+        }
+        if (count < 3) {
+            return thrust::make_tuple(Eigen::Vector3f(0.0, 0.0, 1.0), 0.0f,
+                                      0.0f);
+        }
+        const Eigen::Matrix3f covariance = ComputeCovariance(cum, count);
+        Eigen::Matrix3f work = covariance;
+        const auto evecs = utility::FastEigen3x3(work);
+        Eigen::Vector3f normal = thrust::get<0>(evecs);
+        if (normal.norm() == 0.0) {
+            return thrust::make_tuple(Eigen::Vector3f(0.0, 0.0, 1.0), 0.0f,
+                                      0.0f);
+        }
+        const size_t i = offset_ + idx;
+        if (i < n_prev_ && normal.dot(prev_normals_[i]) < 0.0) {
+            normal *= -1.0;
+        }
+        // Eigenvalues are recovered from the Rayleigh quotients of the
+        // extreme eigenvectors and the trace of the covariance.
+        const Eigen::Vector3f &major = thrust::get<1>(evecs);
+        const float trace = covariance.trace();
+        const float l0 = normal.dot(covariance * normal);
+        const float l2 = major.dot(covariance * major);
+        const float l1 = trace - l0 - l2;
+        const float curvature = (trace > 0.0f) ? l0 / trace : 0.0f;
+        const float planarity = (l2 > 0.0f) ? (l1 - l0) / l2 : 0.0f;
+        return thrust::make_tuple(normal, curvature, planarity);
     }
 };
 
@@ -97,55 +139,159 @@ struct align_normals_direction_functor {
     }
 };
 
-}  // namespace
+struct riemannian_graph_edge_functor {
+    riemannian_graph_edge_functor(const Eigen::Vector3f *normals, int knn)
+        : normals_(normals), knn_(knn){};
+    const Eigen::Vector3f *normals_;
+    const int knn_;
+    __device__ thrust::tuple<Eigen::Vector2i, float> operator()(
+            size_t idx, int j) const {
+        const int i = idx / knn_;
+        if (j < 0 || i == j) {
+            return thrust::make_tuple(Eigen::Vector2i(-1, -1), 0.0f);
+        }
+        const float w = 1.0f - fabsf(normals_[i].dot(normals_[j]));
+        return thrust::make_tuple(Eigen::Vector2i(i, j), fmaxf(w, 0.0f));
+    }
+};
 
-bool PointCloud::EstimateNormals(const KDTreeSearchParam &search_param) {
-    if (HasNormals() == false) {
-        normals_.resize(points_.size());
+// Expands the BFS frontier over the spanning tree. Every node of a tree has a
+// single parent, so a node is reached by exactly one frontier node and the
+// normal can be flipped without synchronization.
+struct propagate_normal_orientation_functor {
+    propagate_normal_orientation_functor(const Eigen::Vector2i *edges,
+                                         const int *edge_index_offsets,
+                                         const int *frontier,
+                                         const int *frontier_offsets,
+                                         int *visited,
+                                         Eigen::Vector3f *normals,
+                                         int *next_frontier)
+        : edges_(edges),
+          edge_index_offsets_(edge_index_offsets),
+          frontier_(frontier),
+          frontier_offsets_(frontier_offsets),
+          visited_(visited),
+          normals_(normals),
+          next_frontier_(next_frontier){};
+    const Eigen::Vector2i *edges_;
+    const int *edge_index_offsets_;
+    const int *frontier_;
+    const int *frontier_offsets_;
+    int *visited_;
+    Eigen::Vector3f *normals_;
+    int *next_frontier_;
+    __device__ void operator()(size_t idx) {
+        const int v = frontier_[idx];
+        const Eigen::Vector3f nv = normals_[v];
+        int *out = next_frontier_ + frontier_offsets_[idx];
+        for (int k = edge_index_offsets_[v]; k < edge_index_offsets_[v + 1];
+             ++k) {
+            const int w = edges_[k][1];
+            if (visited_[w]) {
+                *out++ = -1;
+                continue;
+            }
+            visited_[w] = 1;
+            if (nv.dot(normals_[w]) < 0.0) normals_[w] *= -1.0;
+            *out++ = w;
+        }
     }
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(*this);
-    utility::device_vector<int> indices;
-    utility::device_vector<float> distance2;
-    kdtree.Search(points_, search_param, indices, distance2);
-    int knn;
+};
+
+int GetMaxNeighbors(const KDTreeSearchParam &search_param) {
     switch (search_param.GetSearchType()) {
         case KDTreeSearchParam::SearchType::Knn:
-            knn = ((const KDTreeSearchParamKNN &)search_param).knn_;
-            break;
+            return ((const KDTreeSearchParamKNN &)search_param).knn_;
         case KDTreeSearchParam::SearchType::Radius:
-            knn = ((const KDTreeSearchParamRadius &)search_param).max_nn_;
-            break;
+            return ((const KDTreeSearchParamRadius &)search_param).max_nn_;
         default:
             utility::LogError("Unknown search param type.");
-            return false;
+            return -1;
+    }
+}
+
+template <typename CurvatureIterator, typename PlanarityIterator>
+bool EstimateNormalsImpl(PointCloud &pcd,
+                         const KDTreeSearchParam &search_param,
+                         size_t start_index,
+                         CurvatureIterator curvatures,
+                         PlanarityIterator planarities) {
+    const size_t n_pt = pcd.points_.size();
+    if (start_index > n_pt) {
+        utility::LogWarning(
+                "[EstimateNormals] start_index {:d} exceeds the number of "
+                "points {:d}.",
+                (int)start_index, (int)n_pt);
+        return false;
+    }
+    const size_t n_prev = std::min(pcd.normals_.size(), n_pt);
+    pcd.normals_.resize(n_pt);
+    // The points before start_index without a normal get the default one.
+    if (start_index > n_prev) {
+        thrust::fill(pcd.normals_.begin() + n_prev,
+                     pcd.normals_.begin() + start_index,
+                     Eigen::Vector3f(0.0, 0.0, 1.0));
     }
-    if (knn <= 0) {
-        thrust::fill(normals_.begin(), normals_.end(),
+    if (start_index == n_pt) return true;
+    const int knn = GetMaxNeighbors(search_param);
+    if (knn < 0) return false;
+    if (knn == 0) {
+        thrust::fill(pcd.normals_.begin() + start_index, pcd.normals_.end(),
                      Eigen::Vector3f(0.0, 0.0, 1.0));
         return true;
     }
-    size_t n_pt = points_.size();
-    utility::device_vector<Eigen::Matrix<float, 9, 1>> cumulants(n_pt);
-    utility::device_vector<int> counts(n_pt);
-    thrust::repeated_range<thrust::counting_iterator<size_t>> range(
-            thrust::make_counting_iterator<size_t>(0),
-            thrust::make_counting_iterator(n_pt), knn);
-    thrust::reduce_by_key(
-            utility::exec_policy(0)->on(0), range.begin(), range.end(),
-            thrust::make_transform_iterator(
-                    indices.begin(),
-                    compute_cumulant_functor(
-                            thrust::raw_pointer_cast(points_.data()))),
-            thrust::make_discard_iterator(),
-            make_tuple_begin(cumulants, counts), thrust::equal_to<size_t>(),
-            add_tuple_functor<Eigen::Matrix<float, 9, 1>, int>());
-    thrust::transform(make_tuple_begin(cumulants, counts),
-                      make_tuple_end(cumulants, counts), normals_.begin(),
-                      compute_normal_functor());
+    KDTreeFlann kdtree;
+    kdtree.SetGeometry(pcd);
+    const size_t chunk_size =
+            std::max(MAX_SEARCH_BUFFER_SIZE / knn, size_t(1));
+    utility::device_vector<int> indices;
+    utility::device_vector<float> distance2;
+    for (size_t offset = start_index; offset < n_pt; offset += chunk_size) {
+        const size_t n_query = std::min(chunk_size, n_pt - offset);
+        kdtree.Search<utility::device_vector<Eigen::Vector3f>::const_iterator,
+                      3>(pcd.points_.begin() + offset,
+                         pcd.points_.begin() + offset + n_query, search_param,
+                         indices, distance2);
+        compute_normal_functor func(
+                thrust::raw_pointer_cast(pcd.points_.data()),
+                thrust::raw_pointer_cast(indices.data()), knn,
+                thrust::raw_pointer_cast(pcd.normals_.data()), offset, n_prev);
+        thrust::transform(
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator(n_query),
+                make_tuple_iterator(pcd.normals_.begin() + offset,
+                                    curvatures + (offset - start_index),
+                                    planarities + (offset - start_index)),
+                func);
+    }
     return true;
 }
 
+}  // namespace
+
+bool PointCloud::EstimateNormals(const KDTreeSearchParam &search_param,
+                                 size_t start_index) {
+    return EstimateNormalsImpl(*this, search_param, start_index,
+                               thrust::make_discard_iterator(),
+                               thrust::make_discard_iterator());
+}
+
+std::tuple<utility::device_vector<float>, utility::device_vector<float>>
+PointCloud::EstimateNormalsWithCurvatures(
+        const KDTreeSearchParam &search_param, size_t start_index) {
+    utility::device_vector<float> curvatures;
+    utility::device_vector<float> planarities;
+    if (start_index <= points_.size()) {
+        resize_all(points_.size() - start_index, curvatures, planarities);
+    }
+    if (!EstimateNormalsImpl(*this, search_param, start_index,
+                             curvatures.begin(), planarities.begin())) {
+        curvatures.clear();
+        planarities.clear();
+    }
+    return std::make_tuple(std::move(curvatures), std::move(planarities));
+}
+
 bool PointCloud::OrientNormalsToAlignWithDirection(
         const Eigen::Vector3f &orientation_reference) {
     if (HasNormals() == false) {
@@ -158,3 +304,93 @@ bool PointCloud::OrientNormalsToAlignWithDirection(
     thrust::for_each(normals_.begin(), normals_.end(), func);
     return true;
 }
+
+bool PointCloud::OrientNormalsConsistentTangentPlane(size_t k) {
+    if (HasNormals() == false) {
+        utility::LogWarning(
+                "[OrientNormalsConsistentTangentPlane] No normals in the "
+                "PointCloud. Call EstimateNormals() first.\n");
+        return false;
+    }
+    const size_t n_pt = points_.size();
+    if (n_pt < 2 || k == 0) return true;
+
+    // Riemannian graph over the k nearest neighbors. Edges between nearly
+    // parallel normals are cheap, so the spanning tree propagates the
+    // orientation along smooth regions first.
+    const int knn = std::min<int>(k + 1, NUM_MAX_NN);
+    KDTreeFlann kdtree;
+    kdtree.SetGeometry(*this);
+    utility::device_vector<int> indices;
+    utility::device_vector<float> distance2;
+    kdtree.SearchKNN(points_, knn, indices, distance2);
+    utility::device_vector<Eigen::Vector2i> edges(indices.size());
+    utility::device_vector<float> weights(indices.size());
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(indices.size()),
+                      indices.begin(), make_tuple_begin(edges, weights),
+                      riemannian_graph_edge_functor(
+                              thrust::raw_pointer_cast(normals_.data()), knn));
+    remove_if_vectors(
+            utility::exec_policy(0)->on(0),
+            [] __device__(const thrust::tuple<Eigen::Vector2i, float> &x) {
+                return thrust::get<0>(x)[0] < 0;
+            },
+            edges, weights);
+    if (edges.empty()) return true;
+    Graph<3> graph(points_);
+    graph.AddEdges(edges, weights);
+    auto mst = graph.MinimumSpanningTree();
+    if (mst->lines_.empty()) return true;
+    const auto labels = mst->ConnectedComponents();
+
+    // Start from the highest point of each component and keep its normal.
+    utility::device_vector<int> sorted_labels = labels;
+    utility::device_vector<int> nodes(n_pt);
+    thrust::sequence(nodes.begin(), nodes.end(), 0);
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), sorted_labels.begin(),
+                        sorted_labels.end(), nodes.begin());
+    utility::device_vector<int> frontier(n_pt);
+    const Eigen::Vector3f *points = thrust::raw_pointer_cast(points_.data());
+    auto end = thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), sorted_labels.begin(),
+            sorted_labels.end(), nodes.begin(), thrust::make_discard_iterator(),
+            frontier.begin(), thrust::equal_to<int>(),
+            [points] __device__(int lhs, int rhs) {
+                return (points[lhs][2] >= points[rhs][2]) ? lhs : rhs;
+            });
+    frontier.resize(thrust::distance(frontier.begin(), end.second));
+
+    utility::device_vector<int> visited(n_pt, 0);
+    int *visited_ptr = thrust::raw_pointer_cast(visited.data());
+    thrust::for_each(frontier.begin(), frontier.end(),
+                     [visited_ptr] __device__(int v) { visited_ptr[v] = 1; });
+    const int *offsets =
+            thrust::raw_pointer_cast(mst->edge_index_offsets_.data());
+    utility::device_vector<int> frontier_offsets;
+    utility::device_vector<int> next_frontier;
+    while (!frontier.empty()) {
+        frontier_offsets.resize(frontier.size() + 1);
+        thrust::transform(frontier.begin(), frontier.end(),
+                          frontier_offsets.begin(),
+                          [offsets] __device__(int v) {
+                              return offsets[v + 1] - offsets[v];
+                          });
+        frontier_offsets[frontier.size()] = 0;
+        thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                               frontier_offsets.begin(), frontier_offsets.end(),
+                               frontier_offsets.begin());
+        next_frontier.resize(frontier_offsets[frontier.size()]);
+        propagate_normal_orientation_functor func(
+                thrust::raw_pointer_cast(mst->lines_.data()), offsets,
+                thrust::raw_pointer_cast(frontier.data()),
+                thrust::raw_pointer_cast(frontier_offsets.data()),
+                visited_ptr, thrust::raw_pointer_cast(normals_.data()),
+                thrust::raw_pointer_cast(next_frontier.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(frontier.size()), func);
+        remove_scalar_negative(utility::exec_policy(0)->on(0), next_frontier);
+        frontier.swap(next_frontier);
+    }
+    return true;
+}
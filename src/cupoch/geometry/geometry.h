@@ -64,6 +64,12 @@ public:
         AxisAlignedBoundingBox = 13,
         /// LaserScanBuffer
         LaserScanBuffer = 14,
+        /// SparseOccupancyGrid
+        SparseOccupancyGrid = 15,
+        /// OctreeOccupancyGrid
+        OctreeOccupancyGrid = 16,
+        /// ElevationMap
+        ElevationMap = 17,
     };
 
 public:
@@ -80,5 +80,34 @@ struct compute_voxel_vertices_functor {
     }
 };
 
+// Hooks the components of u and v onto the smaller of their labels, for the
+// label propagation of connected components.
+__device__ inline void HookMinLabel(int* labels, int u, int v, int* changed) {
+    const int lu = labels[u];
+    const int lv = labels[v];
+    if (lu < lv) {
+        atomicMin(&labels[lv], lu);
+        *changed = 1;
+    } else if (lv < lu) {
+        atomicMin(&labels[lu], lv);
+        *changed = 1;
+    }
+}
+
+// Replaces each parent by the root of its tree.
+struct pointer_jumping_functor {
+    pointer_jumping_functor(int* parents) : parents_(parents){};
+    int* parents_;
+    __device__ void operator()(size_t idx) {
+        int p = parents_[idx];
+        int pp = parents_[p];
+        while (p != pp) {
+            p = pp;
+            pp = parents_[p];
+        }
+        parents_[idx] = p;
+    }
+};
+
 }  // namespace geometry
 }  // namespace cupoch
\ No newline at end of file
@@ -23,6 +23,8 @@
 
 #include <stdgpu/unordered_set.cuh>
 
+#include <climits>
+
 #include "cupoch/geometry/geometry_functor.h"
 #include "cupoch/geometry/graph.h"
 #include "cupoch/geometry/kdtree_flann.h"
@@ -141,6 +143,102 @@ struct check_edge_functor {
     }
 };
 
+struct normalize_edge_functor {
+    __device__ Eigen::Vector2i operator()(const Eigen::Vector2i &e) const {
+        return (e[0] <= e[1]) ? e : Eigen::Vector2i(e[1], e[0]);
+    }
+};
+
+// Each component keeps its lightest outgoing edge. The key packs the
+// (non-negative) weight bits above the edge index so that ties are broken
+// consistently and the selected edges never form a cycle.
+struct find_min_edge_functor {
+    find_min_edge_functor(const Eigen::Vector2i *edges,
+                          const float *weights,
+                          const int *components,
+                          unsigned long long *min_edges)
+        : edges_(edges),
+          weights_(weights),
+          components_(components),
+          min_edges_(min_edges){};
+    const Eigen::Vector2i *edges_;
+    const float *weights_;
+    const int *components_;
+    unsigned long long *min_edges_;
+    __device__ void operator()(size_t idx) {
+        const Eigen::Vector2i e = edges_[idx];
+        const int cu = components_[e[0]];
+        const int cv = components_[e[1]];
+        if (cu == cv) return;
+        const unsigned long long key =
+                ((unsigned long long)__float_as_uint(fmaxf(weights_[idx], 0.0f))
+                 << 32) |
+                (unsigned long long)idx;
+        atomicMin(&min_edges_[cu], key);
+        atomicMin(&min_edges_[cv], key);
+    }
+};
+
+struct hook_components_functor {
+    hook_components_functor(const Eigen::Vector2i *edges,
+                            const int *components,
+                            const unsigned long long *min_edges,
+                            int *parents,
+                            int *mst_flags)
+        : edges_(edges),
+          components_(components),
+          min_edges_(min_edges),
+          parents_(parents),
+          mst_flags_(mst_flags){};
+    const Eigen::Vector2i *edges_;
+    const int *components_;
+    const unsigned long long *min_edges_;
+    int *parents_;
+    int *mst_flags_;
+    __device__ void operator()(size_t idx) {
+        const int c = components_[idx];
+        if (c != (int)idx) {
+            parents_[idx] = c;
+            return;
+        }
+        const unsigned long long key = min_edges_[idx];
+        if (key == ULLONG_MAX) {
+            parents_[idx] = c;
+            return;
+        }
+        const int k = (int)(key & 0xffffffff);
+        const Eigen::Vector2i e = edges_[k];
+        const int cu = components_[e[0]];
+        mst_flags_[k] = 1;
+        parents_[idx] = (cu == c) ? components_[e[1]] : cu;
+    }
+};
+
+struct break_mutual_hooks_functor {
+    break_mutual_hooks_functor(const int *components, int *parents)
+        : components_(components), parents_(parents){};
+    const int *components_;
+    int *parents_;
+    __device__ void operator()(size_t idx) {
+        const int c = (int)idx;
+        if (components_[c] != c) return;
+        const int p = parents_[c];
+        if (p != c && parents_[p] == c && c < p) {
+            parents_[c] = c;
+        }
+    }
+};
+
+struct propagate_min_label_functor {
+    propagate_min_label_functor(int *labels, int *changed)
+        : labels_(labels), changed_(changed){};
+    int *labels_;
+    int *changed_;
+    __device__ void operator()(const Eigen::Vector2i &e) {
+        HookMinLabel(labels_, e[0], e[1], changed_);
+    }
+};
+
 }  // namespace
 
 template <int Dim>
@@ -782,6 +880,117 @@ std::shared_ptr<thrust::host_vector<int>> Graph<Dim>::DijkstraPath(
     return path_nodes;
 }
 
+template <int Dim>
+std::shared_ptr<Graph<Dim>> Graph<Dim>::MinimumSpanningTree() const {
+    auto out = std::make_shared<Graph<Dim>>();
+    out->points_ = this->points_;
+    const size_t n_nodes = this->points_.size();
+    if (!IsConstructed()) {
+        utility::LogError(
+                "[MinimumSpanningTree] this graph is not constructed.");
+        return out;
+    }
+
+    // Collapse both directions of each edge into one undirected edge and
+    // keep the lightest weight among duplicates.
+    utility::device_vector<Eigen::Vector2i> edges(this->lines_.size());
+    utility::device_vector<float> weights = edge_weights_;
+    thrust::transform(this->lines_.begin(), this->lines_.end(), edges.begin(),
+                      normalize_edge_functor());
+    remove_if_vectors(
+            utility::exec_policy(0)->on(0),
+            [] __device__(const thrust::tuple<Eigen::Vector2i, float> &x) {
+                const Eigen::Vector2i &e = thrust::get<0>(x);
+                return e[0] == e[1];
+            },
+            edges, weights);
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), weights.begin(),
+                        weights.end(), edges.begin());
+    thrust::stable_sort_by_key(utility::exec_policy(0)->on(0), edges.begin(),
+                               edges.end(), weights.begin());
+    auto end = thrust::unique_by_key(utility::exec_policy(0)->on(0),
+                                     edges.begin(), edges.end(),
+                                     weights.begin());
+    resize_all(thrust::distance(edges.begin(), end.first), edges, weights);
+
+    const size_t n_edges = edges.size();
+    utility::device_vector<int> components(n_nodes);
+    utility::device_vector<int> parents(n_nodes);
+    utility::device_vector<unsigned long long> min_edges(n_nodes);
+    utility::device_vector<int> mst_flags(n_edges, 0);
+    thrust::sequence(components.begin(), components.end(), 0);
+    find_min_edge_functor find_func(
+            thrust::raw_pointer_cast(edges.data()),
+            thrust::raw_pointer_cast(weights.data()),
+            thrust::raw_pointer_cast(components.data()),
+            thrust::raw_pointer_cast(min_edges.data()));
+    hook_components_functor hook_func(
+            thrust::raw_pointer_cast(edges.data()),
+            thrust::raw_pointer_cast(components.data()),
+            thrust::raw_pointer_cast(min_edges.data()),
+            thrust::raw_pointer_cast(parents.data()),
+            thrust::raw_pointer_cast(mst_flags.data()));
+    break_mutual_hooks_functor break_func(
+            thrust::raw_pointer_cast(components.data()),
+            thrust::raw_pointer_cast(parents.data()));
+    pointer_jumping_functor jump_func(thrust::raw_pointer_cast(parents.data()));
+    while (true) {
+        thrust::fill(min_edges.begin(), min_edges.end(), ULLONG_MAX);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_edges), find_func);
+        if (thrust::find_if(min_edges.begin(), min_edges.end(),
+                            [] __device__(unsigned long long key) {
+                                return key != ULLONG_MAX;
+                            }) == min_edges.end())
+            break;
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_nodes), hook_func);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_nodes), break_func);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_nodes), jump_func);
+        components.swap(parents);
+        hook_func.components_ = thrust::raw_pointer_cast(components.data());
+        hook_func.parents_ = thrust::raw_pointer_cast(parents.data());
+        find_func.components_ = thrust::raw_pointer_cast(components.data());
+        break_func.components_ = thrust::raw_pointer_cast(components.data());
+        break_func.parents_ = thrust::raw_pointer_cast(parents.data());
+        jump_func.parents_ = thrust::raw_pointer_cast(parents.data());
+    }
+
+    remove_if_vectors(
+            utility::exec_policy(0)->on(0),
+            [] __device__(const thrust::tuple<Eigen::Vector2i, float, int> &x) {
+                return thrust::get<2>(x) == 0;
+            },
+            edges, weights, mst_flags);
+    if (edges.empty()) {
+        out->edge_index_offsets_.resize(n_nodes + 1, 0);
+        return out;
+    }
+    out->AddEdges(edges, weights);
+    return out;
+}
+
+template <int Dim>
+utility::device_vector<int> Graph<Dim>::ConnectedComponents() const {
+    utility::device_vector<int> labels(this->points_.size());
+    thrust::sequence(labels.begin(), labels.end(), 0);
+    utility::device_vector<int> changed(1, 1);
+    propagate_min_label_functor prop_func(
+            thrust::raw_pointer_cast(labels.data()),
+            thrust::raw_pointer_cast(changed.data()));
+    pointer_jumping_functor jump_func(thrust::raw_pointer_cast(labels.data()));
+    while (changed[0] != 0) {
+        changed[0] = 0;
+        thrust::for_each(this->lines_.begin(), this->lines_.end(), prop_func);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(labels.size()),
+                         jump_func);
+    }
+    return labels;
+}
+
 template class Graph<2>;
 template class Graph<3>;
 
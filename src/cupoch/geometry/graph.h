@@ -127,6 +127,15 @@ public:
     std::shared_ptr<thrust::host_vector<int>> DijkstraPath(
             int start_node_index, int end_node_index) const;
 
+    /// Compute the minimum spanning forest of the graph with the parallel
+    /// Boruvka algorithm. Edges are treated as undirected and the edge
+    /// weights are expected to be non-negative.
+    std::shared_ptr<Graph<Dim>> MinimumSpanningTree() const;
+
+    /// Label the connected components of the graph. The label of each node
+    /// is the smallest node index in its component.
+    utility::device_vector<int> ConnectedComponents() const;
+
     template <int D = Dim, std::enable_if_t<(D == 3 || D == 2)> * = nullptr>
     static std::shared_ptr<Graph<Dim>> CreateFromTriangleMesh(
             const TriangleMesh &input);
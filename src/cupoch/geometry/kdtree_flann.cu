@@ -27,6 +27,38 @@
 using namespace cupoch;
 using namespace cupoch::geometry;
 
+namespace {
+
+struct float4_to_vector3f_functor {
+    __device__ Eigen::Vector3f operator()(const float4_t &x) const {
+        return Eigen::Vector3f(x.x, x.y, x.z);
+    }
+};
+
+struct compute_query_morton_code_functor {
+    compute_query_morton_code_functor(const Eigen::Vector3f &min_bound,
+                                      float scale)
+        : min_bound_(min_bound), scale_(scale){};
+    const Eigen::Vector3f min_bound_;
+    const float scale_;
+    __device__ uint64_t operator()(const float4_t &x) const {
+        return MortonCodeOf(Eigen::Vector3f(x.x, x.y, x.z), min_bound_,
+                            scale_);
+    }
+};
+
+struct restore_query_order_functor {
+    restore_query_order_functor(const size_t *order, int row_size)
+        : order_(order), row_size_(row_size){};
+    const size_t *order_;
+    const int row_size_;
+    __device__ size_t operator()(size_t idx) const {
+        return order_[idx / row_size_] * row_size_ + idx % row_size_;
+    }
+};
+
+}  // namespace
+
 KDTreeFlann::KDTreeFlann() {}
 
 KDTreeFlann::KDTreeFlann(const Geometry &data) { SetGeometry(data); }
@@ -48,6 +80,54 @@ bool KDTreeFlann::SetGeometry(const Geometry &geometry) {
     }
 }
 
+void KDTreeFlann::ComputeMortonBounds() {
+    float4_to_vector3f_functor func;
+    auto begin = thrust::make_transform_iterator(data_.begin(), func);
+    auto end = thrust::make_transform_iterator(data_.end(), func);
+    const float4_t first = data_[0];
+    const Eigen::Vector3f init(first.x, first.y, first.z);
+    morton_min_bound_ =
+            thrust::reduce(utility::exec_policy(0)->on(0), begin, end, init,
+                           thrust::elementwise_minimum<Eigen::Vector3f>());
+    const Eigen::Vector3f max_bound =
+            thrust::reduce(utility::exec_policy(0)->on(0), begin, end, init,
+                           thrust::elementwise_maximum<Eigen::Vector3f>());
+    const float extent = (max_bound - morton_min_bound_).maxCoeff();
+    morton_scale_ =
+            (extent > 0.0f) ? (MORTON_AXIS_CELLS - 1) / extent : 0.0f;
+}
+
+void KDTreeFlann::ReorderQueries(utility::device_vector<float4_t> &query,
+                                 utility::device_vector<size_t> &order) const {
+    utility::device_vector<uint64_t> codes(query.size());
+    thrust::transform(query.begin(), query.end(), codes.begin(),
+                      compute_query_morton_code_functor(morton_min_bound_,
+                                                        morton_scale_));
+    order.resize(query.size());
+    thrust::sequence(order.begin(), order.end());
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), codes.begin(),
+                        codes.end(), make_tuple_begin(query, order));
+}
+
+void KDTreeFlann::RestoreQueryOrder(
+        const utility::device_vector<size_t> &order,
+        int row_size,
+        utility::device_vector<int> &indices,
+        utility::device_vector<float> &distance2) const {
+    auto map = thrust::make_transform_iterator(
+            thrust::make_counting_iterator<size_t>(0),
+            restore_query_order_functor(thrust::raw_pointer_cast(order.data()),
+                                        row_size));
+    utility::device_vector<int> restored_indices(indices.size());
+    thrust::scatter(utility::exec_policy(0)->on(0), indices.begin(),
+                    indices.end(), map, restored_indices.begin());
+    indices.swap(restored_indices);
+    utility::device_vector<float> restored_distance2(distance2.size());
+    thrust::scatter(utility::exec_policy(0)->on(0), distance2.begin(),
+                    distance2.end(), map, restored_distance2.begin());
+    distance2.swap(restored_distance2);
+}
+
 template <typename T>
 int KDTreeFlann::Search(const utility::device_vector<T> &query,
                         const KDTreeSearchParam &param,
@@ -119,12 +119,28 @@ public:
     template <typename T>
     bool SetRawData(const utility::device_vector<T> &data);
 
+    /// Queries are reordered along a Morton (Z-order) curve before the
+    /// search when there are at least this many of them, so that neighboring
+    /// threads traverse similar parts of the tree. The results keep the
+    /// order of the queries.
+    size_t reorder_queries_threshold_ = 1 << 15;
+
 protected:
+    void ComputeMortonBounds();
+    void ReorderQueries(utility::device_vector<float4_t> &query,
+                        utility::device_vector<size_t> &order) const;
+    void RestoreQueryOrder(const utility::device_vector<size_t> &order,
+                           int row_size,
+                           utility::device_vector<int> &indices,
+                           utility::device_vector<float> &distance2) const;
+
     utility::device_vector<float4_t> data_;
     std::unique_ptr<flann::Matrix<float>> flann_dataset_;
     std::unique_ptr<flann::KDTreeCuda3dIndex<flann::L2<float>>> flann_index_;
     size_t dimension_ = 0;
     size_t dataset_size_ = 0;
+    Eigen::Vector3f morton_min_bound_ = Eigen::Vector3f::Zero();
+    float morton_scale_ = 0.0f;
 };
 
 }  // namespace geometry
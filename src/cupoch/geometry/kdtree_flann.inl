@@ -76,6 +76,10 @@ int KDTreeFlann::SearchKNN(InputIterator first,
     size_t num_query = thrust::distance(first, last);
     utility::device_vector<float4_t> query_f4(num_query);
     thrust::transform(first, last, query_f4.begin(), func);
+    utility::device_vector<size_t> order;
+    if (num_query >= reorder_queries_threshold_) {
+        ReorderQueries(query_f4, order);
+    }
     flann::Matrix<float> query_flann(
             (float *)(thrust::raw_pointer_cast(query_f4.data())), num_query,
             dimension_, sizeof(float) * 4);
@@ -90,6 +94,7 @@ int KDTreeFlann::SearchKNN(InputIterator first,
     param.matrices_in_gpu_ram = true;
     int k = flann_index_->knnSearch(query_flann, indices_flann, dists_flann,
                                     knn, param);
+    if (!order.empty()) RestoreQueryOrder(order, knn, indices, distance2);
     return k;
 }
 
@@ -104,6 +109,10 @@ int KDTreeFlann::SearchRadius(InputIterator first,
     size_t num_query = thrust::distance(first, last);
     utility::device_vector<float4_t> query_f4(num_query);
     thrust::transform(first, last, query_f4.begin(), func);
+    utility::device_vector<size_t> order;
+    if (num_query >= reorder_queries_threshold_) {
+        ReorderQueries(query_f4, order);
+    }
     flann::Matrix<float> query_flann(
             (float *)(thrust::raw_pointer_cast(query_f4.data())), num_query,
             dimension_, sizeof(float) * 4);
@@ -118,6 +127,7 @@ int KDTreeFlann::SearchRadius(InputIterator first,
                                      query_flann.rows, max_nn);
     int k = flann_index_->radiusSearch(query_flann, indices_flann, dists_flann,
                                        float(radius * radius), param);
+    if (!order.empty()) RestoreQueryOrder(order, max_nn, indices, distance2);
     return k;
 }
 
@@ -140,6 +150,7 @@ bool KDTreeFlann::SetRawData(InputIterator first, InputIterator last) {
     flann_index_.reset(new flann::KDTreeCuda3dIndex<flann::L2<float>>(
             *flann_dataset_, index_params));
     flann_index_->buildIndex();
+    ComputeMortonBounds();
     return true;
 }
 
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/neighbor_list.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+struct count_valid_neighbors_functor {
+    count_valid_neighbors_functor(const int *indices, int max_nn)
+        : indices_(indices), max_nn_(max_nn){};
+    const int *indices_;
+    const int max_nn_;
+    __device__ int operator()(size_t idx) const {
+        int count = 0;
+        for (int k = 0; k < max_nn_; ++k) {
+            if (__ldg(&indices_[idx * max_nn_ + k]) >= 0) ++count;
+        }
+        return count;
+    }
+};
+
+}  // namespace
+
+std::shared_ptr<NeighborList> NeighborList::CreateFromSearchResult(
+        const utility::device_vector<int> &indices,
+        const utility::device_vector<float> &distance2,
+        int max_nn) {
+    auto out = std::make_shared<NeighborList>();
+    if (max_nn <= 0 || indices.size() != distance2.size() ||
+        indices.size() % max_nn != 0) {
+        utility::LogError(
+                "[NeighborList::CreateFromSearchResult] Illegal search "
+                "result.");
+        return out;
+    }
+    const size_t n_query = indices.size() / max_nn;
+    out->offsets_.resize(n_query + 1);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_query),
+                      out->offsets_.begin(),
+                      count_valid_neighbors_functor(
+                              thrust::raw_pointer_cast(indices.data()),
+                              max_nn));
+    out->offsets_[n_query] = 0;
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                           out->offsets_.begin(), out->offsets_.end(),
+                           out->offsets_.begin());
+    const int n_total = out->offsets_[n_query];
+    resize_all(n_total, out->indices_, out->distance2_);
+    thrust::copy_if(make_tuple_begin(indices, distance2),
+                    make_tuple_end(indices, distance2), indices.begin(),
+                    make_tuple_begin(out->indices_, out->distance2_),
+                    [] __device__(int idx) { return idx >= 0; });
+    return out;
+}
+
+std::shared_ptr<NeighborList> NeighborList::CreateFromPointCloud(
+        const PointCloud &pointcloud, const KDTreeSearchParam &search_param) {
+    int max_nn;
+    switch (search_param.GetSearchType()) {
+        case KDTreeSearchParam::SearchType::Knn:
+            max_nn = ((const KDTreeSearchParamKNN &)search_param).knn_;
+            break;
+        case KDTreeSearchParam::SearchType::Radius:
+            max_nn = ((const KDTreeSearchParamRadius &)search_param).max_nn_;
+            break;
+        default:
+            utility::LogError("Unknown search param type.");
+            return std::make_shared<NeighborList>();
+    }
+    if (!pointcloud.HasPoints() || max_nn <= 0) {
+        auto out = std::make_shared<NeighborList>();
+        out->offsets_.resize(pointcloud.points_.size() + 1, 0);
+        return out;
+    }
+    KDTreeFlann kdtree;
+    kdtree.SetGeometry(pointcloud);
+    utility::device_vector<int> indices;
+    utility::device_vector<float> distance2;
+    kdtree.Search(pointcloud.points_, search_param, indices, distance2);
+    return CreateFromSearchResult(indices, distance2, max_nn);
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+
+#include <memory>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/utility/device_vector.h"
+
+namespace cupoch {
+namespace geometry {
+
+class PointCloud;
+
+/// \class NeighborList
+///
+/// \brief Neighbor lists of a set of query points in compressed sparse row
+/// layout. The neighbors of the i-th query are stored in
+/// indices_[offsets_[i]] ... indices_[offsets_[i + 1] - 1].
+///
+/// A NeighborList can be computed once and reused by iterative filters, so
+/// that the nearest neighbor search is not repeated in every iteration.
+class NeighborList {
+public:
+    NeighborList() {}
+    NeighborList(const NeighborList &other)
+        : offsets_(other.offsets_),
+          indices_(other.indices_),
+          distance2_(other.distance2_) {}
+    ~NeighborList() {}
+
+    /// Number of query points.
+    size_t Size() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+    bool IsEmpty() const { return Size() == 0; }
+    /// Total number of stored neighbors.
+    size_t NumNeighbors() const { return indices_.size(); }
+
+    /// Compresses a padded search result with \p max_nn entries per query,
+    /// where missing neighbors are marked with negative indices.
+    static std::shared_ptr<NeighborList> CreateFromSearchResult(
+            const utility::device_vector<int> &indices,
+            const utility::device_vector<float> &distance2,
+            int max_nn);
+
+    /// Searches the neighbors of every point of \p pointcloud within the
+    /// point cloud itself. Each point is a neighbor of itself.
+    static std::shared_ptr<NeighborList> CreateFromPointCloud(
+            const PointCloud &pointcloud,
+            const KDTreeSearchParam &search_param);
+
+public:
+    utility::device_vector<int> offsets_;
+    utility::device_vector<int> indices_;
+    utility::device_vector<float> distance2_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
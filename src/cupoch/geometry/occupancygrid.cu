@@ -20,9 +20,13 @@
  **/
 #include <thrust/iterator/discard_iterator.h>
 
+#include <stdgpu/unordered_set.cuh>
+
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/geometry/densegrid.inl"
 #include "cupoch/geometry/geometry_functor.h"
+#include "cupoch/geometry/image.h"
 #include "cupoch/geometry/intersection_test.h"
 #include "cupoch/geometry/occupancygrid.h"
 #include "cupoch/geometry/pointcloud.h"
@@ -33,23 +37,103 @@
 namespace cupoch {
 namespace geometry {
 
+typedef stdgpu::unordered_set<Eigen::Vector3i,
+                              utility::hash_eigen<Eigen::Vector3i>>
+        VoxelIndexSet;
+
 namespace {
 
 struct extract_range_voxels_functor {
     extract_range_voxels_functor(const Eigen::Vector3i& extents,
                                  int resolution,
-                                 const Eigen::Vector3i& min_bound)
-        : extents_(extents), resolution_(resolution), min_bound_(min_bound){};
+                                 const Eigen::Vector3i& min_bound,
+                                 const Eigen::Vector3i& ring_offset)
+        : extents_(extents),
+          resolution_(resolution),
+          min_bound_(min_bound),
+          ring_offset_(ring_offset){};
     const Eigen::Vector3i extents_;
     const int resolution_;
     const Eigen::Vector3i min_bound_;
-    __device__ int operator()(size_t idx) const {
+    const Eigen::Vector3i ring_offset_;
+    __device__ Eigen::Vector3i GridIndexOf(size_t idx) const {
         int x = idx / (extents_[1] * extents_[2]);
         int yz = idx % (extents_[1] * extents_[2]);
         int y = yz / extents_[2];
         int z = yz % extents_[2];
-        Eigen::Vector3i gidx = min_bound_ + Eigen::Vector3i(x, y, z);
-        return IndexOf(gidx, resolution_);
+        return min_bound_ + Eigen::Vector3i(x, y, z);
+    }
+    __device__ int operator()(size_t idx) const {
+        return RingIndexOf(GridIndexOf(idx), ring_offset_, resolution_);
+    }
+};
+
+struct get_range_voxel_functor : public extract_range_voxels_functor {
+    get_range_voxel_functor(const OccupancyVoxel* voxels,
+                            const Eigen::Vector3i& extents,
+                            int resolution,
+                            const Eigen::Vector3i& min_bound,
+                            const Eigen::Vector3i& ring_offset)
+        : extract_range_voxels_functor(
+                  extents, resolution, min_bound, ring_offset),
+          voxels_(voxels){};
+    const OccupancyVoxel* voxels_;
+    __device__ OccupancyVoxel operator()(size_t idx) const {
+        const Eigen::Vector3i gidx = GridIndexOf(idx);
+        OccupancyVoxel v =
+                voxels_[RingIndexOf(gidx, ring_offset_, resolution_)];
+        v.grid_index_ = gidx.cast<unsigned short>();
+        return v;
+    }
+};
+
+struct range_voxel_index_functor : public extract_range_voxels_functor {
+    range_voxel_index_functor(const Eigen::Vector3i& extents,
+                              int resolution,
+                              const Eigen::Vector3i& min_bound,
+                              const Eigen::Vector3i& ring_offset)
+        : extract_range_voxels_functor(
+                  extents, resolution, min_bound, ring_offset){};
+    __device__ Eigen::Vector3i operator()(size_t idx) const {
+        return GridIndexOf(idx);
+    }
+};
+
+struct set_free_voxel_functor : public extract_range_voxels_functor {
+    set_free_voxel_functor(OccupancyVoxel* voxels,
+                           const Eigen::Vector3i& extents,
+                           int resolution,
+                           const Eigen::Vector3i& min_bound,
+                           const Eigen::Vector3i& ring_offset,
+                           float prob_miss_log,
+                           float occ_prob_thres_log)
+        : extract_range_voxels_functor(
+                  extents, resolution, min_bound, ring_offset),
+          voxels_(voxels),
+          prob_miss_log_(prob_miss_log),
+          occ_prob_thres_log_(occ_prob_thres_log){};
+    OccupancyVoxel* voxels_;
+    const float prob_miss_log_;
+    const float occ_prob_thres_log_;
+    // Returns true when the voxel crossed the occupancy threshold.
+    __device__ bool operator()(size_t idx) {
+        OccupancyVoxel& v = voxels_[RingIndexOf(GridIndexOf(idx), ring_offset_,
+                                                resolution_)];
+        const bool was_occupied =
+                !isnan(v.prob_log_) && v.prob_log_ > occ_prob_thres_log_;
+        v.prob_log_ = (isnan(v.prob_log_)) ? 0 : v.prob_log_;
+        v.prob_log_ += prob_miss_log_;
+        return was_occupied != (v.prob_log_ > occ_prob_thres_log_);
+    }
+};
+
+struct out_of_range_voxel_functor {
+    out_of_range_voxel_functor(int resolution) : resolution_(resolution){};
+    const int resolution_;
+    __device__ bool operator()(const Eigen::Vector3i& idx) const {
+        return idx[0] < 0 || idx[1] < 0 || idx[2] < 0 ||
+               idx[0] >= resolution_ || idx[1] >= resolution_ ||
+               idx[2] >= resolution_;
     }
 };
 
@@ -92,7 +176,7 @@ __device__ int VoxelTraversal(Eigen::Vector3i* voxels,
     float tDeltaZ = (stepZ != 0) ? voxel_size / fabs(ray[2])
                                  : std::numeric_limits<float>::infinity();
 
-    voxels[n_voxels] = current_voxel + half_resolution;
+    if (voxels) voxels[n_voxels] = current_voxel + half_resolution;
     ++n_voxels;
 
     while (n_voxels < n_buffer) {
@@ -120,7 +204,7 @@ __device__ int VoxelTraversal(Eigen::Vector3i* voxels,
             if (dist_from_origin > length) {
                 break;
             } else {
-                voxels[n_voxels] = current_voxel + half_resolution;
+                if (voxels) voxels[n_voxels] = current_voxel + half_resolution;
                 ++n_voxels;
             }
         }
@@ -130,29 +214,35 @@ __device__ int VoxelTraversal(Eigen::Vector3i* voxels,
 
 struct compute_voxel_traversal_functor {
     compute_voxel_traversal_functor(Eigen::Vector3i* voxels,
+                                    const int* offsets,
                                     int n_step,
                                     const Eigen::Vector3f& viewpoint,
                                     const Eigen::Vector3i& half_resolution,
                                     float voxel_size,
                                     const Eigen::Vector3f& origin)
         : voxels_(voxels),
+          offsets_(offsets),
           n_step_(n_step),
           viewpoint_(viewpoint),
           half_resolution_(half_resolution),
           voxel_size_(voxel_size),
           origin_(origin){};
     Eigen::Vector3i* voxels_;
+    const int* offsets_;
     const int n_step_;
     const Eigen::Vector3f viewpoint_;
     const Eigen::Vector3i half_resolution_;
     const float voxel_size_;
     const Eigen::Vector3f origin_;
-    __device__ void operator()(
-            const thrust::tuple<size_t, Eigen::Vector3f>& x) {
+    /// Counts the traversed voxels when no output buffer is given, otherwise
+    /// writes them from the offset of the ray.
+    __device__ int operator()(
+            const thrust::tuple<size_t, Eigen::Vector3f>& x) const {
         const int idx = thrust::get<0>(x);
         const Eigen::Vector3f end = thrust::get<1>(x);
-        VoxelTraversal(voxels_ + idx * n_step_, n_step_, half_resolution_,
-                       viewpoint_, end - origin_, voxel_size_);
+        Eigen::Vector3i* out = (voxels_) ? voxels_ + offsets_[idx] : nullptr;
+        return VoxelTraversal(out, n_step_, half_resolution_, viewpoint_,
+                              end - origin_, voxel_size_);
     }
 };
 
@@ -160,33 +250,31 @@ void ComputeFreeVoxels(const utility::device_vector<Eigen::Vector3f>& points,
                        const Eigen::Vector3f& viewpoint,
                        float voxel_size,
                        int resolution,
-                       Eigen::Vector3f& origin,
+                       const Eigen::Vector3f& origin,
                        int n_div,
                        utility::device_vector<Eigen::Vector3i>& free_voxels) {
     if (points.empty()) return;
     size_t n_points = points.size();
-    size_t max_idx = resolution * resolution * resolution;
     Eigen::Vector3i half_resolution = Eigen::Vector3i::Constant(resolution / 2);
-    free_voxels.resize(
-            n_div * 3 * n_points,
-            Eigen::Vector3i::Constant(geometry::INVALID_VOXEL_INDEX));
+    // Count the voxels of each ray first so that the buffer only holds the
+    // voxels actually traversed.
+    utility::device_vector<int> offsets(n_points + 1, 0);
+    compute_voxel_traversal_functor count_func(
+            nullptr, nullptr, n_div * 3, viewpoint - origin, half_resolution,
+            voxel_size, origin);
+    thrust::transform(enumerate_begin(points), enumerate_end(points),
+                      offsets.begin(), count_func);
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0), offsets.begin(),
+                           offsets.end(), offsets.begin());
+    free_voxels.resize(offsets.back());
     compute_voxel_traversal_functor func(
-            thrust::raw_pointer_cast(free_voxels.data()), n_div * 3,
+            thrust::raw_pointer_cast(free_voxels.data()),
+            thrust::raw_pointer_cast(offsets.data()), n_div * 3,
             viewpoint - origin, half_resolution, voxel_size, origin);
     thrust::for_each(enumerate_begin(points), enumerate_end(points), func);
-    auto end1 = thrust::remove_if(
-            free_voxels.begin(), free_voxels.end(),
-            [max_idx] __device__(const Eigen::Vector3i& idx) -> bool {
-                return idx[0] < 0 || idx[1] < 0 || idx[2] < 0 ||
-                       idx[0] >= max_idx || idx[1] >= max_idx ||
-                       idx[2] >= max_idx;
-            });
-    free_voxels.resize(thrust::distance(free_voxels.begin(), end1));
-    thrust::sort(utility::exec_policy(0)->on(0), free_voxels.begin(),
-                 free_voxels.end());
-    auto end2 = thrust::unique(utility::exec_policy(0)->on(0),
-                               free_voxels.begin(), free_voxels.end());
-    free_voxels.resize(thrust::distance(free_voxels.begin(), end2));
+    auto end = thrust::remove_if(free_voxels.begin(), free_voxels.end(),
+                                 out_of_range_voxel_functor(resolution));
+    free_voxels.resize(thrust::distance(free_voxels.begin(), end));
 }
 
 struct create_occupancy_voxels_functor {
@@ -217,13 +305,12 @@ struct create_occupancy_voxels_functor {
 
 void ComputeOccupiedVoxels(
         const utility::device_vector<Eigen::Vector3f>& points,
-        const utility::device_vector<bool> hit_flags,
+        const utility::device_vector<bool>& hit_flags,
         float voxel_size,
         int resolution,
-        Eigen::Vector3f& origin,
+        const Eigen::Vector3f& origin,
         utility::device_vector<Eigen::Vector3i>& occupied_voxels) {
     occupied_voxels.resize(points.size());
-    size_t max_idx = resolution * resolution * resolution;
     Eigen::Vector3i half_resolution = Eigen::Vector3i::Constant(resolution / 2);
     create_occupancy_voxels_functor func(origin, half_resolution, voxel_size);
     thrust::transform(make_tuple_begin(points, hit_flags),
@@ -231,54 +318,308 @@ void ComputeOccupiedVoxels(
                       occupied_voxels.begin(), func);
     auto end1 = thrust::remove_if(
             occupied_voxels.begin(), occupied_voxels.end(),
-            [max_idx] __device__(const Eigen::Vector3i& idx) -> bool {
-                return idx[0] < 0 || idx[1] < 0 || idx[2] < 0 ||
-                       idx[0] >= max_idx || idx[1] >= max_idx ||
-                       idx[2] >= max_idx;
-            });
+            out_of_range_voxel_functor(resolution));
     occupied_voxels.resize(thrust::distance(occupied_voxels.begin(), end1));
-    thrust::sort(utility::exec_policy(0)->on(0), occupied_voxels.begin(),
-                 occupied_voxels.end());
-    auto end2 = thrust::unique(utility::exec_policy(0)->on(0),
-                               occupied_voxels.begin(), occupied_voxels.end());
-    occupied_voxels.resize(thrust::distance(occupied_voxels.begin(), end2));
+}
+
+struct insert_voxel_index_functor {
+    insert_voxel_index_functor(const VoxelIndexSet& visited)
+        : visited_(visited){};
+    VoxelIndexSet visited_;
+    __device__ bool operator()(const Eigen::Vector3i& voxel) {
+        return visited_.insert(voxel).second;
+    }
+};
+
+/// Keeps the first occurrence of each voxel which is not yet in \p visited.
+void RemoveVisitedVoxels(VoxelIndexSet& visited,
+                         utility::device_vector<Eigen::Vector3i>& voxels) {
+    utility::device_vector<bool> is_new(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), is_new.begin(),
+                      insert_voxel_index_functor(visited));
+    auto end = thrust::remove_if(voxels.begin(), voxels.end(), is_new.begin(),
+                                 thrust::logical_not<bool>());
+    voxels.resize(thrust::distance(voxels.begin(), end));
 }
 
 struct add_occupancy_functor {
     add_occupancy_functor(OccupancyVoxel* voxels,
                           int resolution,
+                          const Eigen::Vector3i& ring_offset,
                           float clamping_thres_min,
                           float clamping_thres_max,
                           float prob_miss_log,
                           float prob_hit_log,
+                          float occ_prob_thres_log,
                           bool occupied)
         : voxels_(voxels),
           resolution_(resolution),
+          ring_offset_(ring_offset),
           clamping_thres_min_(clamping_thres_min),
           clamping_thres_max_(clamping_thres_max),
           prob_miss_log_(prob_miss_log),
           prob_hit_log_(prob_hit_log),
+          occ_prob_thres_log_(occ_prob_thres_log),
           occupied_(occupied){};
     OccupancyVoxel* voxels_;
     const int resolution_;
+    const Eigen::Vector3i ring_offset_;
     const float clamping_thres_min_;
     const float clamping_thres_max_;
     const float prob_miss_log_;
     const float prob_hit_log_;
+    const float occ_prob_thres_log_;
     const bool occupied_;
-    __device__ void operator()(const Eigen::Vector3i& voxel) {
-        size_t idx = IndexOf(voxel, resolution_);
+    // Returns true when the voxel crossed the occupancy threshold.
+    __device__ bool operator()(const Eigen::Vector3i& voxel) {
+        size_t idx = RingIndexOf(voxel, ring_offset_, resolution_);
         float p = voxels_[idx].prob_log_;
+        const bool was_occupied = !isnan(p) && p > occ_prob_thres_log_;
         p = (isnan(p)) ? 0 : p;
         p += (occupied_) ? prob_hit_log_ : prob_miss_log_;
-        voxels_[idx].prob_log_ =
-                min(max(p, clamping_thres_min_), clamping_thres_max_);
+        p = min(max(p, clamping_thres_min_), clamping_thres_max_);
+        voxels_[idx].prob_log_ = p;
         voxels_[idx].grid_index_ = voxel.cast<unsigned short>();
+        return was_occupied != (p > occ_prob_thres_log_);
+    }
+};
+
+__host__ __device__ int NumBlocksOf(int resolution) {
+    return (resolution + OCCUPANCY_BLOCK_RESOLUTION - 1) /
+           OCCUPANCY_BLOCK_RESOLUTION;
+}
+
+struct compute_active_block_functor {
+    compute_active_block_functor(int resolution,
+                                 const Eigen::Vector3i& ring_offset)
+        : resolution_(resolution), ring_offset_(ring_offset){};
+    const int resolution_;
+    const Eigen::Vector3i ring_offset_;
+    __device__ int operator()(const Eigen::Vector3i& voxel) const {
+        auto key = KeyOf(RingIndexOf(voxel, ring_offset_, resolution_),
+                         resolution_);
+        return IndexOf(thrust::get<0>(key) / OCCUPANCY_BLOCK_RESOLUTION,
+                       thrust::get<1>(key) / OCCUPANCY_BLOCK_RESOLUTION,
+                       thrust::get<2>(key) / OCCUPANCY_BLOCK_RESOLUTION,
+                       NumBlocksOf(resolution_));
+    }
+};
+
+/// Maps the i-th voxel of the active blocks to its storage index.
+struct active_voxel_functor {
+    active_voxel_functor(const int* blocks, int resolution)
+        : blocks_(blocks), resolution_(resolution){};
+    const int* blocks_;
+    const int resolution_;
+    // Returns -1 for the voxels of a partial block outside of the grid.
+    __device__ int VoxelIndexOf(int block, int local) const {
+        auto b = KeyOf(block, NumBlocksOf(resolution_));
+        auto l = KeyOf(local, OCCUPANCY_BLOCK_RESOLUTION);
+        const int x = thrust::get<0>(b) * OCCUPANCY_BLOCK_RESOLUTION +
+                      thrust::get<0>(l);
+        const int y = thrust::get<1>(b) * OCCUPANCY_BLOCK_RESOLUTION +
+                      thrust::get<1>(l);
+        const int z = thrust::get<2>(b) * OCCUPANCY_BLOCK_RESOLUTION +
+                      thrust::get<2>(l);
+        if (x >= resolution_ || y >= resolution_ || z >= resolution_) {
+            return -1;
+        }
+        return IndexOf(x, y, z, resolution_);
+    }
+    __device__ int VoxelIndexOf(size_t i) const {
+        return VoxelIndexOf(blocks_[i / OCCUPANCY_BLOCK_VOXEL_NUM],
+                            i % OCCUPANCY_BLOCK_VOXEL_NUM);
+    }
+};
+
+struct active_voxel_grid_index_functor : public active_voxel_functor {
+    active_voxel_grid_index_functor(const int* blocks,
+                                    int resolution,
+                                    const Eigen::Vector3i& ring_offset)
+        : active_voxel_functor(blocks, resolution),
+          ring_offset_(ring_offset){};
+    const Eigen::Vector3i ring_offset_;
+    __device__ Eigen::Vector3i operator()(size_t i) const {
+        return RingKeyOf(VoxelIndexOf(i), ring_offset_, resolution_);
+    }
+};
+
+/// Returns whether a block holds a known voxel.
+struct check_known_block_functor : public active_voxel_functor {
+    check_known_block_functor(const OccupancyVoxel* voxels, int resolution)
+        : active_voxel_functor(nullptr, resolution), voxels_(voxels){};
+    const OccupancyVoxel* voxels_;
+    __device__ bool operator()(int block) const {
+        for (int j = 0; j < OCCUPANCY_BLOCK_VOXEL_NUM; ++j) {
+            const int idx = VoxelIndexOf(block, j);
+            if (idx >= 0 && !isnan(voxels_[idx].prob_log_)) return true;
+        }
+        return false;
+    }
+};
+
+struct decay_occupancy_functor : public active_voxel_functor {
+    decay_occupancy_functor(OccupancyVoxel* voxels,
+                            const int* blocks,
+                            int resolution,
+                            float factor,
+                            float unknown_thres,
+                            float occ_prob_thres_log)
+        : active_voxel_functor(blocks, resolution),
+          voxels_(voxels),
+          factor_(factor),
+          unknown_thres_(unknown_thres),
+          occ_prob_thres_log_(occ_prob_thres_log){};
+    OccupancyVoxel* voxels_;
+    const float factor_;
+    const float unknown_thres_;
+    const float occ_prob_thres_log_;
+    // Returns true when the voxel crossed the occupancy threshold.
+    __device__ bool operator()(size_t i) const {
+        const int idx = VoxelIndexOf(i);
+        if (idx < 0) return false;
+        float p = voxels_[idx].prob_log_;
+        if (isnan(p)) return false;
+        const bool was_occupied = p > occ_prob_thres_log_;
+        p *= factor_;
+        if (fabsf(p) < unknown_thres_) {
+            p = std::numeric_limits<float>::quiet_NaN();
+        }
+        voxels_[idx].prob_log_ = p;
+        return was_occupied != (!isnan(p) && p > occ_prob_thres_log_);
+    }
+};
+
+struct clear_visible_voxels_functor : public active_voxel_grid_index_functor {
+    clear_visible_voxels_functor(OccupancyVoxel* voxels,
+                                 const int* blocks,
+                                 int resolution,
+                                 const Eigen::Vector3i& ring_offset,
+                                 float voxel_size,
+                                 const Eigen::Vector3f& origin,
+                                 const float* depth,
+                                 int width,
+                                 int height,
+                                 const Eigen::Matrix3f& intrinsic,
+                                 const Eigen::Matrix4f& extrinsic,
+                                 float depth_margin,
+                                 float clamping_thres_min,
+                                 float prob_miss_log,
+                                 float occ_prob_thres_log)
+        : active_voxel_grid_index_functor(blocks, resolution, ring_offset),
+          voxels_(voxels),
+          voxel_size_(voxel_size),
+          origin_(origin),
+          depth_(depth),
+          width_(width),
+          height_(height),
+          intrinsic_(intrinsic),
+          extrinsic_(extrinsic),
+          depth_margin_(depth_margin),
+          clamping_thres_min_(clamping_thres_min),
+          prob_miss_log_(prob_miss_log),
+          occ_prob_thres_log_(occ_prob_thres_log){};
+    OccupancyVoxel* voxels_;
+    const float voxel_size_;
+    const Eigen::Vector3f origin_;
+    const float* depth_;
+    const int width_;
+    const int height_;
+    const Eigen::Matrix3f intrinsic_;
+    const Eigen::Matrix4f extrinsic_;
+    const float depth_margin_;
+    const float clamping_thres_min_;
+    const float prob_miss_log_;
+    const float occ_prob_thres_log_;
+    // Returns true when the voxel crossed the occupancy threshold.
+    __device__ bool operator()(size_t i) const {
+        const int idx = VoxelIndexOf(i);
+        if (idx < 0) return false;
+        float p = voxels_[idx].prob_log_;
+        if (isnan(p) || p <= occ_prob_thres_log_) return false;
+        const Eigen::Vector3i gidx = RingKeyOf(idx, ring_offset_, resolution_);
+        const Eigen::Vector3f center =
+                (gidx - Eigen::Vector3i::Constant(resolution_ / 2))
+                                .cast<float>() *
+                        voxel_size_ +
+                Eigen::Vector3f::Constant(0.5f * voxel_size_) + origin_;
+        const Eigen::Vector3f pt = extrinsic_.block<3, 3>(0, 0) * center +
+                                   extrinsic_.block<3, 1>(0, 3);
+        if (pt[2] <= 0) return false;
+        const Eigen::Vector3f uv = intrinsic_ * pt / pt[2];
+        const int u = floorf(uv[0]);
+        const int v = floorf(uv[1]);
+        if (u < 0 || v < 0 || u >= width_ || v >= height_) return false;
+        const float d = depth_[v * width_ + u];
+        if (!(d > pt[2] + depth_margin_)) return false;
+        p = max(p + prob_miss_log_, clamping_thres_min_);
+        voxels_[idx].prob_log_ = p;
+        return p <= occ_prob_thres_log_;
     }
 };
 
 }  // namespace
 
+void ComputeInsertedVoxels(
+        const utility::device_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range,
+        float voxel_size,
+        int resolution,
+        const Eigen::Vector3f& origin,
+        utility::device_vector<Eigen::Vector3i>& free_voxels,
+        utility::device_vector<Eigen::Vector3i>& occupied_voxels) {
+    free_voxels.clear();
+    occupied_voxels.clear();
+    if (points.empty()) return;
+
+    utility::device_vector<Eigen::Vector3f> ranged_points(points.size());
+    utility::device_vector<float> ranged_dists(points.size());
+    utility::device_vector<bool> hit_flags(points.size());
+
+    thrust::transform(
+            points.begin(), points.end(),
+            make_tuple_begin(ranged_points, ranged_dists, hit_flags),
+            [viewpoint, max_range] __device__(const Eigen::Vector3f& pt) {
+                const Eigen::Vector3f pt_vp = pt - viewpoint;
+                const float dist = pt_vp.norm();
+                const bool is_hit = max_range < 0 || dist <= max_range;
+                const Eigen::Vector3f ranged_pt =
+                        (is_hit)
+                                ? pt
+                                : ((dist == 0) ? viewpoint
+                                               : viewpoint + pt_vp / dist *
+                                                                     max_range);
+                return thrust::make_tuple(
+                        ranged_pt,
+                        (ranged_pt - viewpoint).array().abs().maxCoeff(),
+                        is_hit);
+            });
+    float max_dist =
+            *(thrust::max_element(ranged_dists.begin(), ranged_dists.end()));
+    int n_div = int(std::ceil(max_dist / voxel_size));
+
+    if (n_div > 0) {
+        // comupute free voxels
+        ComputeFreeVoxels(ranged_points, viewpoint, voxel_size, resolution,
+                          origin, n_div + 1, free_voxels);
+    } else {
+        thrust::copy(points.begin(), points.end(), ranged_points.begin());
+        thrust::fill(hit_flags.begin(), hit_flags.end(), true);
+    }
+    // compute occupied voxels
+    ComputeOccupiedVoxels(ranged_points, hit_flags, voxel_size, resolution,
+                          origin, occupied_voxels);
+
+    // Deduplicate through a hash set instead of sorting. The occupied voxels
+    // are inserted first so that they are also removed from the free ones.
+    VoxelIndexSet visited = VoxelIndexSet::createDeviceObject(
+            std::max<int>(occupied_voxels.size() + free_voxels.size(), 1));
+    RemoveVisitedVoxels(visited, occupied_voxels);
+    RemoveVisitedVoxels(visited, free_voxels);
+    VoxelIndexSet::destroyDeviceObject(visited);
+}
+
 template class DenseGrid<OccupancyVoxel>;
 
 OccupancyGrid::OccupancyGrid()
@@ -307,12 +648,22 @@ OccupancyGrid::OccupancyGrid(const OccupancyGrid& other)
       prob_hit_log_(other.prob_hit_log_),
       prob_miss_log_(other.prob_miss_log_),
       occ_prob_thres_log_(other.occ_prob_thres_log_),
-      visualize_free_area_(other.visualize_free_area_) {}
+      visualize_free_area_(other.visualize_free_area_),
+      track_changed_voxels_(other.track_changed_voxels_),
+      changed_voxels_(other.changed_voxels_),
+      decay_rate_(other.decay_rate_),
+      decay_unknown_thres_(other.decay_unknown_thres_),
+      decay_stamp_(other.decay_stamp_),
+      track_active_blocks_(other.track_active_blocks_),
+      active_blocks_(other.active_blocks_),
+      active_block_flags_(other.active_block_flags_) {}
 
 OccupancyGrid& OccupancyGrid::Clear() {
     DenseGrid::Clear();
     min_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
     max_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
+    changed_voxels_.clear();
+    ResetActiveBlocks();
     return *this;
 }
 
@@ -351,6 +702,8 @@ thrust::tuple<bool, OccupancyVoxel> OccupancyGrid::GetVoxel(
     auto idx = GetVoxelIndex(point);
     if (idx < 0) return thrust::make_tuple(false, OccupancyVoxel());
     OccupancyVoxel voxel = voxels_[idx];
+    voxel.grid_index_ =
+            RingKeyOf(idx, ring_offset_, resolution_).cast<unsigned short>();
     return thrust::make_tuple(!std::isnan(voxel.prob_log_), voxel);
 }
 
@@ -361,17 +714,14 @@ OccupancyGrid::ExtractBoundVoxels(Func check_func) const {
             max_bound_ - min_bound_ + Eigen::Vector3ui16::Ones();
     auto out = std::make_shared<utility::device_vector<OccupancyVoxel>>();
     out->resize(diff[0] * diff[1] * diff[2]);
-    extract_range_voxels_functor func(diff.cast<int>(), resolution_,
-                                      min_bound_.cast<int>());
+    get_range_voxel_functor func(thrust::raw_pointer_cast(voxels_.data()),
+                                 diff.cast<int>(), resolution_,
+                                 min_bound_.cast<int>(), ring_offset_);
     auto end = thrust::copy_if(
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(
-                            thrust::make_counting_iterator<size_t>(0), func)),
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(
-                            thrust::make_counting_iterator(out->size()), func)),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(0), func),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator(out->size()), func),
             out->begin(), check_func);
     out->resize(thrust::distance(out->begin(), end));
     return out;
@@ -380,8 +730,7 @@ OccupancyGrid::ExtractBoundVoxels(Func check_func) const {
 std::shared_ptr<utility::device_vector<OccupancyVoxel>>
 OccupancyGrid::ExtractKnownVoxels() const {
     auto check_fn = [th = occ_prob_thres_log_] __device__(
-                            const thrust::tuple<OccupancyVoxel>& x) {
-        const OccupancyVoxel& v = thrust::get<0>(x);
+                            const OccupancyVoxel& v) {
         return !isnan(v.prob_log_);
     };
     return ExtractBoundVoxels(check_fn);
@@ -390,8 +739,7 @@ OccupancyGrid::ExtractKnownVoxels() const {
 std::shared_ptr<utility::device_vector<OccupancyVoxel>>
 OccupancyGrid::ExtractFreeVoxels() const {
     auto check_fn = [th = occ_prob_thres_log_] __device__(
-                            const thrust::tuple<OccupancyVoxel>& x) {
-        const OccupancyVoxel& v = thrust::get<0>(x);
+                            const OccupancyVoxel& v) {
         return !isnan(v.prob_log_) && v.prob_log_ <= th;
     };
     return ExtractBoundVoxels(check_fn);
@@ -400,8 +748,7 @@ OccupancyGrid::ExtractFreeVoxels() const {
 std::shared_ptr<utility::device_vector<OccupancyVoxel>>
 OccupancyGrid::ExtractOccupiedVoxels() const {
     auto check_fn = [th = occ_prob_thres_log_] __device__(
-                            const thrust::tuple<OccupancyVoxel>& x) {
-        const OccupancyVoxel& v = thrust::get<0>(x);
+                            const OccupancyVoxel& v) {
         return !isnan(v.prob_log_) && v.prob_log_ > th;
     };
     return ExtractBoundVoxels(check_fn);
@@ -409,6 +756,26 @@ OccupancyGrid::ExtractOccupiedVoxels() const {
 
 OccupancyGrid& OccupancyGrid::Reconstruct(float voxel_size, int resolution) {
     DenseGrid::Reconstruct(voxel_size, resolution);
+    changed_voxels_.clear();
+    ResetActiveBlocks();
+    return *this;
+}
+
+OccupancyGrid& OccupancyGrid::ShiftWindow(const Eigen::Vector3i& shift) {
+    DenseGrid::ShiftWindow(shift);
+    // Recorded indices refer to the previous window.
+    changed_voxels_.clear();
+    const Eigen::Array3i lower = Eigen::Array3i::Zero();
+    const Eigen::Array3i upper = Eigen::Array3i::Constant(resolution_ - 1);
+    Eigen::Array3i imin_bound = min_bound_.cast<int>().array() - shift.array();
+    Eigen::Array3i imax_bound = max_bound_.cast<int>().array() - shift.array();
+    if ((imax_bound < lower).any() || (imin_bound > upper).any()) {
+        min_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
+        max_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
+    } else {
+        min_bound_ = imin_bound.max(lower).matrix().cast<unsigned short>();
+        max_bound_ = imax_bound.min(upper).matrix().cast<unsigned short>();
+    }
     return *this;
 }
 
@@ -438,23 +805,36 @@ OccupancyGrid& OccupancyGrid::SetFreeArea(const Eigen::Vector3f& min_bound,
                          .cast<unsigned short>();
     Eigen::Vector3ui16 diff =
             max_bound_ - min_bound_ + Eigen::Vector3ui16::Ones();
-    extract_range_voxels_functor func(diff.cast<int>(), resolution_,
-                                      min_bound_.cast<int>());
-    thrust::for_each(
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(
-                            thrust::make_counting_iterator<size_t>(0), func)),
-            thrust::make_permutation_iterator(
-                    voxels_.begin(),
-                    thrust::make_transform_iterator(
-                            thrust::make_counting_iterator<size_t>(
-                                    diff[0] * diff[1] * diff[2]),
-                            func)),
-            [pml = prob_miss_log_] __device__(geometry::OccupancyVoxel & v) {
-                v.prob_log_ = (isnan(v.prob_log_)) ? 0 : v.prob_log_;
-                v.prob_log_ += pml;
-            });
+    const size_t n = size_t(diff[0]) * diff[1] * diff[2];
+    set_free_voxel_functor func(thrust::raw_pointer_cast(voxels_.data()),
+                                diff.cast<int>(), resolution_,
+                                min_bound_.cast<int>(), ring_offset_,
+                                prob_miss_log_, occ_prob_thres_log_);
+    if (!track_changed_voxels_) {
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n), func);
+    } else {
+        utility::device_vector<bool> changed(n);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n), changed.begin(),
+                          func);
+        const size_t n_changed =
+                thrust::count(changed.begin(), changed.end(), true);
+        const size_t n_prev = changed_voxels_.size();
+        changed_voxels_.resize(n_prev + n_changed);
+        range_voxel_index_functor index_func(diff.cast<int>(), resolution_,
+                                             min_bound_.cast<int>(),
+                                             ring_offset_);
+        thrust::copy_if(thrust::make_transform_iterator(
+                                thrust::make_counting_iterator<size_t>(0),
+                                index_func),
+                        thrust::make_transform_iterator(
+                                thrust::make_counting_iterator(n), index_func),
+                        changed.begin(), changed_voxels_.begin() + n_prev,
+                        thrust::identity<bool>());
+    }
+    // The area may span many blocks, so they are collected again lazily.
+    ResetActiveBlocks();
     return *this;
 }
 
@@ -464,55 +844,11 @@ OccupancyGrid& OccupancyGrid::Insert(
         float max_range) {
     if (points.empty()) return *this;
 
-    utility::device_vector<Eigen::Vector3f> ranged_points(points.size());
-    utility::device_vector<float> ranged_dists(points.size());
-    utility::device_vector<bool> hit_flags(points.size());
-
-    thrust::transform(
-            points.begin(), points.end(),
-            make_tuple_begin(ranged_points, ranged_dists, hit_flags),
-            [viewpoint, max_range] __device__(const Eigen::Vector3f& pt) {
-                const Eigen::Vector3f pt_vp = pt - viewpoint;
-                const float dist = pt_vp.norm();
-                const bool is_hit = max_range < 0 || dist <= max_range;
-                const Eigen::Vector3f ranged_pt =
-                        (is_hit)
-                                ? pt
-                                : ((dist == 0) ? viewpoint
-                                               : viewpoint + pt_vp / dist *
-                                                                     max_range);
-                return thrust::make_tuple(
-                        ranged_pt,
-                        (ranged_pt - viewpoint).array().abs().maxCoeff(),
-                        is_hit);
-            });
-    float max_dist =
-            *(thrust::max_element(ranged_dists.begin(), ranged_dists.end()));
-    int n_div = int(std::ceil(max_dist / voxel_size_));
-
     utility::device_vector<Eigen::Vector3i> free_voxels;
     utility::device_vector<Eigen::Vector3i> occupied_voxels;
-    if (n_div > 0) {
-        // comupute free voxels
-        ComputeFreeVoxels(ranged_points, viewpoint, voxel_size_, resolution_,
-                          origin_, n_div + 1, free_voxels);
-    } else {
-        thrust::copy(points.begin(), points.end(), ranged_points.begin());
-        thrust::fill(hit_flags.begin(), hit_flags.end(), true);
-    }
-    // compute occupied voxels
-    ComputeOccupiedVoxels(ranged_points, hit_flags, voxel_size_, resolution_,
-                          origin_, occupied_voxels);
-
-    if (n_div > 0) {
-        utility::device_vector<Eigen::Vector3i> free_voxels_res(
-                free_voxels.size());
-        auto end = thrust::set_difference(
-                free_voxels.begin(), free_voxels.end(), occupied_voxels.begin(),
-                occupied_voxels.end(), free_voxels_res.begin());
-        free_voxels_res.resize(thrust::distance(free_voxels_res.begin(), end));
-        AddVoxels(free_voxels_res, false);
-    }
+    ComputeInsertedVoxels(points, viewpoint, max_range, voxel_size_,
+                          resolution_, origin_, free_voxels, occupied_voxels);
+    AddVoxels(free_voxels, false);
     AddVoxels(occupied_voxels, true);
     return *this;
 }
@@ -537,15 +873,16 @@ OccupancyGrid& OccupancyGrid::Insert(const geometry::PointCloud& pointcloud,
 
 OccupancyGrid& OccupancyGrid::AddVoxel(const Eigen::Vector3i& voxel,
                                        bool occupied) {
-    int idx = IndexOf(voxel, resolution_);
-    size_t max_idx = resolution_ * resolution_ * resolution_;
-    if (idx < 0 || idx >= max_idx) {
+    if ((voxel.array() < 0).any() || (voxel.array() >= resolution_).any()) {
         utility::LogError(
                 "[OccupancyGrid] a provided voxeld is not occupancy grid "
                 "range.");
         return *this;
     } else {
+        int idx = RingIndexOf(voxel, ring_offset_, resolution_);
         OccupancyVoxel org_ov = voxels_[idx];
+        const bool was_occupied = !std::isnan(org_ov.prob_log_) &&
+                                  org_ov.prob_log_ > occ_prob_thres_log_;
         if (std::isnan(org_ov.prob_log_)) org_ov.prob_log_ = 0.0;
         org_ov.prob_log_ += (occupied) ? prob_hit_log_ : prob_miss_log_;
         org_ov.prob_log_ =
@@ -555,6 +892,13 @@ OccupancyGrid& OccupancyGrid::AddVoxel(const Eigen::Vector3i& voxel,
         voxels_[idx] = org_ov;
         min_bound_ = min_bound_.array().min(org_ov.grid_index_.array());
         max_bound_ = max_bound_.array().max(org_ov.grid_index_.array());
+        if (track_changed_voxels_ &&
+            was_occupied != (org_ov.prob_log_ > occ_prob_thres_log_)) {
+            changed_voxels_.push_back(voxel);
+        }
+        if (track_active_blocks_) {
+            AddActiveBlocks(utility::device_vector<Eigen::Vector3i>(1, voxel));
+        }
     }
     return *this;
 }
@@ -562,19 +906,162 @@ OccupancyGrid& OccupancyGrid::AddVoxel(const Eigen::Vector3i& voxel,
 OccupancyGrid& OccupancyGrid::AddVoxels(
         const utility::device_vector<Eigen::Vector3i>& voxels, bool occupied) {
     if (voxels.empty()) return *this;
-    Eigen::Vector3i fv = voxels.front();
-    Eigen::Vector3i bv = voxels.back();
-    Eigen::Vector3ui16 fvu = fv.cast<unsigned short>();
-    Eigen::Vector3ui16 bvu = bv.cast<unsigned short>();
-    min_bound_ = min_bound_.array().min(fvu.array());
-    min_bound_ = min_bound_.array().min(bvu.array());
-    max_bound_ = max_bound_.array().max(fvu.array());
-    max_bound_ = max_bound_.array().max(bvu.array());
+    Eigen::Vector3i vmin = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Constant(resolution_ - 1).eval(),
+            thrust::elementwise_minimum<Eigen::Vector3i>());
+    Eigen::Vector3i vmax = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Zero().eval(),
+            thrust::elementwise_maximum<Eigen::Vector3i>());
+    min_bound_ = min_bound_.array().min(vmin.cast<unsigned short>().array());
+    max_bound_ = max_bound_.array().max(vmax.cast<unsigned short>().array());
+    if (track_active_blocks_) AddActiveBlocks(voxels);
     add_occupancy_functor func(thrust::raw_pointer_cast(voxels_.data()),
-                               resolution_, clamping_thres_min_,
+                               resolution_, ring_offset_, clamping_thres_min_,
                                clamping_thres_max_, prob_miss_log_,
-                               prob_hit_log_, occupied);
-    thrust::for_each(voxels.begin(), voxels.end(), func);
+                               prob_hit_log_, occ_prob_thres_log_, occupied);
+    if (!track_changed_voxels_) {
+        thrust::for_each(voxels.begin(), voxels.end(), func);
+        return *this;
+    }
+    utility::device_vector<bool> changed(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), changed.begin(), func);
+    const size_t n_prev = changed_voxels_.size();
+    changed_voxels_.resize(n_prev + voxels.size());
+    auto end = thrust::copy_if(voxels.begin(), voxels.end(), changed.begin(),
+                               changed_voxels_.begin() + n_prev,
+                               thrust::identity<bool>());
+    changed_voxels_.resize(thrust::distance(changed_voxels_.begin(), end));
+    return *this;
+}
+
+template <typename Func>
+void OccupancyGrid::UpdateActiveVoxels(Func func) {
+    const size_t n = active_blocks_.size() * OCCUPANCY_BLOCK_VOXEL_NUM;
+    if (!track_changed_voxels_) {
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n), func);
+        return;
+    }
+    utility::device_vector<bool> changed(n);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n), changed.begin(),
+                      func);
+    const size_t n_changed =
+            thrust::count(changed.begin(), changed.end(), true);
+    if (n_changed == 0) return;
+    const size_t n_prev = changed_voxels_.size();
+    changed_voxels_.resize(n_prev + n_changed);
+    active_voxel_grid_index_functor index_func(
+            thrust::raw_pointer_cast(active_blocks_.data()), resolution_,
+            ring_offset_);
+    thrust::copy_if(thrust::make_transform_iterator(
+                            thrust::make_counting_iterator<size_t>(0),
+                            index_func),
+                    thrust::make_transform_iterator(
+                            thrust::make_counting_iterator(n), index_func),
+                    changed.begin(), changed_voxels_.begin() + n_prev,
+                    thrust::identity<bool>());
+}
+
+void OccupancyGrid::BuildActiveBlocks() {
+    const int n_axis = NumBlocksOf(resolution_);
+    const size_t n_blocks = size_t(n_axis) * n_axis * n_axis;
+    active_block_flags_.resize(n_blocks);
+    thrust::transform(
+            thrust::make_counting_iterator<int>(0),
+            thrust::make_counting_iterator<int>(n_blocks),
+            active_block_flags_.begin(),
+            check_known_block_functor(thrust::raw_pointer_cast(voxels_.data()),
+                                      resolution_));
+    active_blocks_.resize(thrust::count(active_block_flags_.begin(),
+                                        active_block_flags_.end(), true));
+    thrust::copy_if(thrust::make_counting_iterator<int>(0),
+                    thrust::make_counting_iterator<int>(n_blocks),
+                    active_block_flags_.begin(), active_blocks_.begin(),
+                    thrust::identity<bool>());
+    track_active_blocks_ = true;
+}
+
+void OccupancyGrid::AddActiveBlocks(
+        const utility::device_vector<Eigen::Vector3i>& voxels) {
+    utility::device_vector<int> blocks(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), blocks.begin(),
+                      compute_active_block_functor(resolution_, ring_offset_));
+    const bool* flags = thrust::raw_pointer_cast(active_block_flags_.data());
+    auto end1 = thrust::remove_if(
+            blocks.begin(), blocks.end(),
+            [flags] __device__(int block) { return flags[block]; });
+    blocks.resize(thrust::distance(blocks.begin(), end1));
+    if (blocks.empty()) return;
+    thrust::sort(utility::exec_policy(0)->on(0), blocks.begin(), blocks.end());
+    auto end2 = thrust::unique(blocks.begin(), blocks.end());
+    blocks.resize(thrust::distance(blocks.begin(), end2));
+    thrust::scatter(thrust::make_constant_iterator(true),
+                    thrust::make_constant_iterator(true) + blocks.size(),
+                    blocks.begin(), active_block_flags_.begin());
+    active_blocks_.insert(active_blocks_.end(), blocks.begin(), blocks.end());
+}
+
+void OccupancyGrid::ResetActiveBlocks() {
+    track_active_blocks_ = false;
+    active_blocks_.clear();
+    active_block_flags_.clear();
+}
+
+OccupancyGrid& OccupancyGrid::Decay(double stamp) {
+    const double dt = stamp - decay_stamp_;
+    if (std::isnan(decay_stamp_) || dt > 0) decay_stamp_ = stamp;
+    if (!(dt > 0) || decay_rate_ <= 0) return *this;
+    if (!track_active_blocks_) BuildActiveBlocks();
+    decay_occupancy_functor func(
+            thrust::raw_pointer_cast(voxels_.data()),
+            thrust::raw_pointer_cast(active_blocks_.data()), resolution_,
+            std::exp(-decay_rate_ * dt), decay_unknown_thres_,
+            occ_prob_thres_log_);
+    UpdateActiveVoxels(func);
+
+    // Drop the blocks whose voxels all became unknown.
+    utility::device_vector<bool> known(active_blocks_.size());
+    thrust::transform(
+            active_blocks_.begin(), active_blocks_.end(), known.begin(),
+            check_known_block_functor(thrust::raw_pointer_cast(voxels_.data()),
+                                      resolution_));
+    thrust::scatter_if(thrust::make_constant_iterator(false),
+                       thrust::make_constant_iterator(false) + known.size(),
+                       active_blocks_.begin(), known.begin(),
+                       active_block_flags_.begin(),
+                       thrust::logical_not<bool>());
+    remove_if_vectors(
+            [] __device__(const thrust::tuple<int, bool>& x) {
+                return !thrust::get<1>(x);
+            },
+            active_blocks_, known);
+    return *this;
+}
+
+OccupancyGrid& OccupancyGrid::ClearVisibleVoxels(
+        const Image& depth,
+        const camera::PinholeCameraIntrinsic& intrinsic,
+        const Eigen::Matrix4f& extrinsic,
+        float depth_margin) {
+    if (depth.num_of_channels_ != 1 || depth.bytes_per_channel_ != 4) {
+        utility::LogError(
+                "[OccupancyGrid::ClearVisibleVoxels] Unsupported image "
+                "format.");
+        return *this;
+    }
+    if (!track_active_blocks_) BuildActiveBlocks();
+    clear_visible_voxels_functor func(
+            thrust::raw_pointer_cast(voxels_.data()),
+            thrust::raw_pointer_cast(active_blocks_.data()), resolution_,
+            ring_offset_, voxel_size_, origin_,
+            (const float*)thrust::raw_pointer_cast(depth.data_.data()),
+            depth.width_, depth.height_, intrinsic.intrinsic_matrix_,
+            extrinsic, depth_margin, clamping_thres_min_, prob_miss_log_,
+            occ_prob_thres_log_);
+    UpdateActiveVoxels(func);
     return *this;
 }
 
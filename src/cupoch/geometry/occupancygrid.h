@@ -24,9 +24,21 @@
 
 namespace cupoch {
 
+namespace camera {
+class PinholeCameraIntrinsic;
+}
+
 namespace geometry {
 class PointCloud;
 class VoxelGrid;
+class Image;
+
+/// Number of voxels along each axis of a block in SparseOccupancyGrid and of
+/// the active blocks tracked by OccupancyGrid.
+const int OCCUPANCY_BLOCK_RESOLUTION = 8;
+const int OCCUPANCY_BLOCK_VOXEL_NUM = OCCUPANCY_BLOCK_RESOLUTION *
+                                      OCCUPANCY_BLOCK_RESOLUTION *
+                                      OCCUPANCY_BLOCK_RESOLUTION;
 
 class OccupancyVoxel {
 public:
@@ -98,6 +110,7 @@ public:
     ExtractOccupiedVoxels() const;
 
     OccupancyGrid& Reconstruct(float voxel_size, int resolution);
+    OccupancyGrid& ShiftWindow(const Eigen::Vector3i& shift) override;
     OccupancyGrid& SetFreeArea(const Eigen::Vector3f& min_bound,
                                const Eigen::Vector3f& max_bound);
 
@@ -118,6 +131,38 @@ public:
             const utility::device_vector<Eigen::Vector3i>& voxels,
             bool occupied = false);
 
+    /// \brief Decays the log-odds of the known voxels toward unknown.
+    ///
+    /// The log-odds are multiplied by exp(-decay_rate_ * (stamp -
+    /// decay_stamp_)) and voxels whose magnitude falls below
+    /// decay_unknown_thres_ become unknown, so that stale obstacles fade out
+    /// unless they are observed again. Only the blocks holding known voxels
+    /// are visited. The first call only records \p stamp.
+    OccupancyGrid& Decay(double stamp);
+
+    /// \brief Updates as a miss every occupied voxel that a depth image sees
+    /// through.
+    ///
+    /// A voxel is seen through when its center projects onto a pixel whose
+    /// depth is larger than the depth of the center by more than
+    /// \p depth_margin. This clears moving obstacles that no ray of a sparse
+    /// scan traverses exactly.
+    ///
+    /// \param depth Single channel float depth image in meters.
+    /// \param intrinsic Intrinsic parameters of the depth camera.
+    /// \param extrinsic Transformation from the world to the camera frame.
+    /// \param depth_margin Minimum depth difference in meters.
+    OccupancyGrid& ClearVisibleVoxels(
+            const Image& depth,
+            const camera::PinholeCameraIntrinsic& intrinsic,
+            const Eigen::Matrix4f& extrinsic,
+            float depth_margin = 0.1);
+
+    /// Returns the number of blocks of OCCUPANCY_BLOCK_RESOLUTION^3 voxels
+    /// holding known voxels. The blocks are tracked once Decay or
+    /// ClearVisibleVoxels has been called.
+    size_t NumActiveBlocks() const { return active_blocks_.size(); }
+
     static std::shared_ptr<OccupancyGrid> CreateFromVoxelGrid(
             const VoxelGrid& input);
 
@@ -125,6 +170,11 @@ private:
     template <typename Func>
     std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractBoundVoxels(
             Func func) const;
+    template <typename Func>
+    void UpdateActiveVoxels(Func func);
+    void BuildActiveBlocks();
+    void AddActiveBlocks(const utility::device_vector<Eigen::Vector3i>& voxels);
+    void ResetActiveBlocks();
 
 public:
     Eigen::Vector3ui16 min_bound_ = Eigen::Vector3ui16::Zero();
@@ -135,8 +185,46 @@ public:
     float prob_miss_log_ = -0.4f;
     float occ_prob_thres_log_ = 0.0f;
     bool visualize_free_area_ = true;
+    /// If true, AddVoxel(s), Insert, SetFreeArea, Decay and
+    /// ClearVisibleVoxels record the voxels crossing occ_prob_thres_log_ in
+    /// changed_voxels_ so that a DistanceTransform can be updated
+    /// incrementally.
+    bool track_changed_voxels_ = false;
+    /// Voxels whose occupancy changed since the list was last consumed.
+    /// The list may hold duplicates and is cleared by ShiftWindow.
+    utility::device_vector<Eigen::Vector3i> changed_voxels_;
+    /// Decay rate of the log-odds per unit of time used by Decay.
+    float decay_rate_ = 0.0f;
+    /// Decayed voxels whose log-odds magnitude falls below this value become
+    /// unknown.
+    float decay_unknown_thres_ = 0.1f;
+    /// Stamp of the last call to Decay.
+    double decay_stamp_ = std::numeric_limits<double>::quiet_NaN();
+
+private:
+    /// Blocks holding known voxels, indexed in the storage of the ring
+    /// buffer so that ShiftWindow keeps them valid.
+    bool track_active_blocks_ = false;
+    utility::device_vector<int> active_blocks_;
+    utility::device_vector<bool> active_block_flags_;
 };
 
+/// \brief Function to compute the voxels updated by inserting a scan.
+///
+/// \p free_voxels holds the voxels traversed by the rays from \p viewpoint to
+/// \p points and \p occupied_voxels the voxels hit by the ray end points.
+/// Indices are shifted by half of \p resolution like OccupancyVoxel. Both
+/// lists are unique in no particular order and no voxel appears in both.
+void ComputeInsertedVoxels(
+        const utility::device_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range,
+        float voxel_size,
+        int resolution,
+        const Eigen::Vector3f& origin,
+        utility::device_vector<Eigen::Vector3i>& free_voxels,
+        utility::device_vector<Eigen::Vector3i>& occupied_voxels);
+
 }  // namespace geometry
 
 }  // namespace cupoch
\ No newline at end of file
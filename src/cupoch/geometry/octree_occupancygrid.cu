@@ -0,0 +1,1003 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/binary_search.h>
+#include <thrust/execution_policy.h>
+#include <thrust/logical.h>
+#include <thrust/merge.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/octree_occupancygrid.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/platform.h"
+
+namespace cupoch {
+namespace geometry {
+
+namespace {
+
+// Number of voxels at the finest depth covered by a node at depth.
+__host__ __device__ inline uint64_t NodeSpan(int depth, int max_depth) {
+    return uint64_t(1) << (3 * (max_depth - depth));
+}
+
+// Upper bound on the number of nodes that expanding pruned leaves may
+// produce, so that a fine depth over a deep tree does not exhaust memory.
+constexpr size_t kMaxExpandedNodes = size_t(1) << 26;
+
+struct is_out_of_range_functor {
+    is_out_of_range_functor(int resolution) : resolution_(resolution){};
+    const int resolution_;
+    __device__ bool operator()(const Eigen::Vector3i& voxel) const {
+        return voxel[0] < 0 || voxel[1] < 0 || voxel[2] < 0 ||
+               voxel[0] >= resolution_ || voxel[1] >= resolution_ ||
+               voxel[2] >= resolution_;
+    }
+};
+
+struct compute_morton_code_functor {
+    __device__ uint64_t operator()(const Eigen::Vector3i& voxel) const {
+        return MortonCodeOf(voxel);
+    }
+};
+
+// Returns whether a target voxel lies in a leaf and flags the leaf for
+// splitting if it is above the finest depth.
+struct find_container_functor {
+    find_container_functor(const uint64_t* codes,
+                           const unsigned char* depths,
+                           bool* split_flags,
+                           int max_depth)
+        : codes_(codes),
+          depths_(depths),
+          split_flags_(split_flags),
+          max_depth_(max_depth){};
+    const uint64_t* codes_;
+    const unsigned char* depths_;
+    bool* split_flags_;
+    const int max_depth_;
+    __device__ bool operator()(
+            const thrust::tuple<uint64_t, size_t>& x) const {
+        const size_t pos = thrust::get<1>(x);
+        if (pos == 0) return false;
+        const size_t i = pos - 1;
+        if (thrust::get<0>(x) >= codes_[i] + NodeSpan(depths_[i], max_depth_))
+            return false;
+        if (depths_[i] < max_depth_) split_flags_[i] = true;
+        return true;
+    }
+};
+
+struct split_leaves_functor {
+    split_leaves_functor(const uint64_t* codes,
+                         const unsigned char* depths,
+                         const OccupancyVoxel* voxels,
+                         const bool* flags,
+                         const size_t* offsets,
+                         uint64_t* out_codes,
+                         unsigned char* out_depths,
+                         OccupancyVoxel* out_voxels,
+                         int max_depth)
+        : codes_(codes),
+          depths_(depths),
+          voxels_(voxels),
+          flags_(flags),
+          offsets_(offsets),
+          out_codes_(out_codes),
+          out_depths_(out_depths),
+          out_voxels_(out_voxels),
+          max_depth_(max_depth){};
+    const uint64_t* codes_;
+    const unsigned char* depths_;
+    const OccupancyVoxel* voxels_;
+    const bool* flags_;
+    const size_t* offsets_;
+    uint64_t* out_codes_;
+    unsigned char* out_depths_;
+    OccupancyVoxel* out_voxels_;
+    const int max_depth_;
+    __device__ void operator()(size_t idx) {
+        const size_t offset = offsets_[idx];
+        if (!flags_[idx]) {
+            out_codes_[offset] = codes_[idx];
+            out_depths_[offset] = depths_[idx];
+            out_voxels_[offset] = voxels_[idx];
+            return;
+        }
+        const int depth = depths_[idx] + 1;
+        const uint64_t span = NodeSpan(depth, max_depth_);
+        for (int c = 0; c < 8; ++c) {
+            const uint64_t code = codes_[idx] + c * span;
+            OccupancyVoxel v = voxels_[idx];
+            v.grid_index_ = MortonKeyOf(code).cast<unsigned short>();
+            out_codes_[offset + c] = code;
+            out_depths_[offset + c] = depth;
+            out_voxels_[offset + c] = v;
+        }
+    }
+};
+
+struct add_octree_occupancy_functor {
+    add_octree_occupancy_functor(OccupancyVoxel* voxels,
+                                 float clamping_thres_min,
+                                 float clamping_thres_max,
+                                 float prob_miss_log,
+                                 float prob_hit_log,
+                                 bool occupied)
+        : voxels_(voxels),
+          clamping_thres_min_(clamping_thres_min),
+          clamping_thres_max_(clamping_thres_max),
+          prob_miss_log_(prob_miss_log),
+          prob_hit_log_(prob_hit_log),
+          occupied_(occupied){};
+    OccupancyVoxel* voxels_;
+    const float clamping_thres_min_;
+    const float clamping_thres_max_;
+    const float prob_miss_log_;
+    const float prob_hit_log_;
+    const bool occupied_;
+    __device__ void operator()(size_t idx) {
+        float p = voxels_[idx].prob_log_;
+        p = (isnan(p)) ? 0 : p;
+        p += (occupied_) ? prob_hit_log_ : prob_miss_log_;
+        voxels_[idx].prob_log_ =
+                min(max(p, clamping_thres_min_), clamping_thres_max_);
+    }
+};
+
+// Returns whether the leaf is the first of eight siblings at depth which
+// share the same log-odds. The following seven leaves must be the remaining
+// children, not leaves of the next parent that fill a gap.
+struct check_collapse_functor {
+    check_collapse_functor(const uint64_t* codes,
+                           const unsigned char* depths,
+                           const OccupancyVoxel* voxels,
+                           size_t n,
+                           int depth,
+                           int max_depth)
+        : codes_(codes),
+          depths_(depths),
+          voxels_(voxels),
+          n_(n),
+          depth_(depth),
+          max_depth_(max_depth){};
+    const uint64_t* codes_;
+    const unsigned char* depths_;
+    const OccupancyVoxel* voxels_;
+    const size_t n_;
+    const int depth_;
+    const int max_depth_;
+    __device__ bool operator()(size_t idx) const {
+        if (idx + 7 >= n_ || depths_[idx] != depth_) return false;
+        if (codes_[idx] % NodeSpan(depth_ - 1, max_depth_) != 0) return false;
+        const float p = voxels_[idx].prob_log_;
+        if (isnan(p)) return false;
+        const uint64_t span = NodeSpan(depth_, max_depth_);
+        for (int c = 1; c < 8; ++c) {
+            if (depths_[idx + c] != depth_ ||
+                codes_[idx + c] != codes_[idx] + c * span ||
+                voxels_[idx + c].prob_log_ != p)
+                return false;
+        }
+        return true;
+    }
+};
+
+struct collapse_functor {
+    collapse_functor(const bool* collapse,
+                     unsigned char* depths,
+                     bool* removed,
+                     int depth)
+        : collapse_(collapse),
+          depths_(depths),
+          removed_(removed),
+          depth_(depth){};
+    const bool* collapse_;
+    unsigned char* depths_;
+    bool* removed_;
+    const int depth_;
+    __device__ void operator()(size_t idx) {
+        if (!collapse_[idx]) return;
+        depths_[idx] = depth_ - 1;
+        for (int c = 1; c < 8; ++c) removed_[idx + c] = true;
+    }
+};
+
+struct is_below_depth_functor {
+    is_below_depth_functor(int depth) : depth_(depth){};
+    const int depth_;
+    __device__ bool operator()(unsigned char d) const { return d > depth_; }
+};
+
+struct mask_code_functor {
+    mask_code_functor(uint64_t mask) : mask_(mask){};
+    const uint64_t mask_;
+    __device__ uint64_t operator()(uint64_t code) const { return code & mask_; }
+};
+
+struct max_occupancy_functor {
+    __device__ OccupancyVoxel operator()(const OccupancyVoxel& lhs,
+                                         const OccupancyVoxel& rhs) const {
+        if (isnan(lhs.prob_log_)) return rhs;
+        if (isnan(rhs.prob_log_)) return lhs;
+        return (lhs.prob_log_ >= rhs.prob_log_) ? lhs : rhs;
+    }
+};
+
+// Nodes at depth holding finer leaves are looked up in node_codes, which
+// summarizes those leaves beforehand, so that each query only runs binary
+// searches.
+struct get_octree_voxel_functor {
+    get_octree_voxel_functor(const uint64_t* codes,
+                             const unsigned char* depths,
+                             const OccupancyVoxel* voxels,
+                             size_t n,
+                             const uint64_t* node_codes,
+                             const OccupancyVoxel* node_voxels,
+                             size_t n_nodes,
+                             float voxel_size,
+                             const Eigen::Vector3f& origin,
+                             int depth,
+                             int max_depth)
+        : codes_(codes),
+          depths_(depths),
+          voxels_(voxels),
+          n_(n),
+          node_codes_(node_codes),
+          node_voxels_(node_voxels),
+          n_nodes_(n_nodes),
+          voxel_size_(voxel_size),
+          origin_(origin),
+          depth_(depth),
+          max_depth_(max_depth){};
+    const uint64_t* codes_;
+    const unsigned char* depths_;
+    const OccupancyVoxel* voxels_;
+    const size_t n_;
+    const uint64_t* node_codes_;
+    const OccupancyVoxel* node_voxels_;
+    const size_t n_nodes_;
+    const float voxel_size_;
+    const Eigen::Vector3f origin_;
+    const int depth_;
+    const int max_depth_;
+    __device__ OccupancyVoxel operator()(const Eigen::Vector3f& point) const {
+        const int resolution = 1 << max_depth_;
+        Eigen::Vector3f ref_coord = (point - origin_) / voxel_size_;
+        Eigen::Vector3i voxel =
+                Eigen::device_vectorize<float, 3, ::floor>(ref_coord)
+                        .cast<int>() +
+                Eigen::Vector3i::Constant(resolution / 2);
+        if (voxel[0] < 0 || voxel[1] < 0 || voxel[2] < 0 ||
+            voxel[0] >= resolution || voxel[1] >= resolution ||
+            voxel[2] >= resolution) {
+            return OccupancyVoxel();
+        }
+        const int shift = max_depth_ - depth_;
+        OccupancyVoxel out(Eigen::Vector3i(voxel[0] >> shift,
+                                           voxel[1] >> shift,
+                                           voxel[2] >> shift));
+        const uint64_t span = NodeSpan(depth_, max_depth_);
+        const uint64_t begin = MortonCodeOf(voxel) & ~(span - 1);
+        const uint64_t* itr =
+                thrust::upper_bound(thrust::seq, codes_, codes_ + n_, begin);
+        const size_t i = thrust::distance(codes_, itr);
+        // A leaf at or above depth holds the whole node.
+        if (i > 0 &&
+            begin < codes_[i - 1] + NodeSpan(depths_[i - 1], max_depth_)) {
+            out.prob_log_ = voxels_[i - 1].prob_log_;
+            out.color_ = voxels_[i - 1].color_;
+            return out;
+        }
+        const uint64_t* node = thrust::lower_bound(
+                thrust::seq, node_codes_, node_codes_ + n_nodes_, begin);
+        if (node != node_codes_ + n_nodes_ && *node == begin) {
+            const OccupancyVoxel& v =
+                    node_voxels_[thrust::distance(node_codes_, node)];
+            out.prob_log_ = v.prob_log_;
+            out.color_ = v.color_;
+        }
+        return out;
+    }
+};
+
+struct expand_coarse_leaves_functor {
+    expand_coarse_leaves_functor(const uint64_t* codes,
+                                 const unsigned char* depths,
+                                 const OccupancyVoxel* voxels,
+                                 OccupancyVoxel* out,
+                                 int depth,
+                                 int max_depth)
+        : codes_(codes),
+          depths_(depths),
+          voxels_(voxels),
+          out_(out),
+          depth_(depth),
+          max_depth_(max_depth){};
+    const uint64_t* codes_;
+    const unsigned char* depths_;
+    const OccupancyVoxel* voxels_;
+    OccupancyVoxel* out_;
+    const int depth_;
+    const int max_depth_;
+    __device__ void operator()(const thrust::tuple<size_t, size_t>& x) {
+        const size_t idx = thrust::get<0>(x);
+        const size_t offset = thrust::get<1>(x);
+        const uint64_t span = NodeSpan(depth_, max_depth_);
+        const uint64_t n = NodeSpan(depths_[idx], max_depth_) / span;
+        const int shift = max_depth_ - depth_;
+        for (uint64_t k = 0; k < n; ++k) {
+            OccupancyVoxel v = voxels_[idx];
+            const Eigen::Vector3i key = MortonKeyOf(codes_[idx] + k * span);
+            v.grid_index_ = Eigen::Vector3ui16(key[0] >> shift, key[1] >> shift,
+                                               key[2] >> shift);
+            out_[offset + k] = v;
+        }
+    }
+};
+
+void WriteChildBits(std::vector<uint8_t>& stream, uint16_t bits) {
+    stream.push_back(bits & 0xff);
+    stream.push_back(bits >> 8);
+}
+
+}  // namespace
+
+OctreeOccupancyGrid::OctreeOccupancyGrid()
+    : OctreeOccupancyGrid(0.05, 16, Eigen::Vector3f::Zero()) {}
+OctreeOccupancyGrid::OctreeOccupancyGrid(float voxel_size,
+                                         int max_depth,
+                                         const Eigen::Vector3f& origin)
+    : GeometryBase3D(Geometry::GeometryType::OctreeOccupancyGrid),
+      voxel_size_(voxel_size),
+      max_depth_(max_depth),
+      origin_(origin) {
+    if (max_depth_ < 1 || max_depth_ > 16) {
+        utility::LogWarning(
+                "[OctreeOccupancyGrid] max_depth must be in [1, 16], but {}. "
+                "16 is used instead.",
+                max_depth_);
+        max_depth_ = 16;
+    }
+    min_bound_ = Eigen::Vector3ui16::Constant(GetResolution() / 2);
+    max_bound_ = Eigen::Vector3ui16::Constant(GetResolution() / 2);
+}
+OctreeOccupancyGrid::~OctreeOccupancyGrid() {}
+OctreeOccupancyGrid::OctreeOccupancyGrid(const OctreeOccupancyGrid& other)
+    : GeometryBase3D(Geometry::GeometryType::OctreeOccupancyGrid),
+      voxel_size_(other.voxel_size_),
+      max_depth_(other.max_depth_),
+      origin_(other.origin_),
+      codes_(other.codes_),
+      depths_(other.depths_),
+      voxels_(other.voxels_),
+      min_bound_(other.min_bound_),
+      max_bound_(other.max_bound_),
+      clamping_thres_min_(other.clamping_thres_min_),
+      clamping_thres_max_(other.clamping_thres_max_),
+      prob_hit_log_(other.prob_hit_log_),
+      prob_miss_log_(other.prob_miss_log_),
+      occ_prob_thres_log_(other.occ_prob_thres_log_),
+      visualize_free_area_(other.visualize_free_area_) {}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Clear() {
+    codes_.clear();
+    depths_.clear();
+    voxels_.clear();
+    min_bound_ = Eigen::Vector3ui16::Constant(GetResolution() / 2);
+    max_bound_ = Eigen::Vector3ui16::Constant(GetResolution() / 2);
+    return *this;
+}
+
+bool OctreeOccupancyGrid::IsEmpty() const { return !HasVoxels(); }
+
+Eigen::Vector3f OctreeOccupancyGrid::GetMinBound() const {
+    return (min_bound_.cast<int>() -
+            Eigen::Vector3i::Constant(GetResolution() / 2))
+                           .cast<float>() *
+                   voxel_size_ +
+           origin_;
+}
+
+Eigen::Vector3f OctreeOccupancyGrid::GetMaxBound() const {
+    return (max_bound_.cast<int>() -
+            Eigen::Vector3i::Constant(GetResolution() / 2 - 1))
+                           .cast<float>() *
+                   voxel_size_ +
+           origin_;
+}
+
+Eigen::Vector3f OctreeOccupancyGrid::GetCenter() const {
+    return 0.5 * (GetMinBound() + GetMaxBound());
+}
+
+AxisAlignedBoundingBox<3> OctreeOccupancyGrid::GetAxisAlignedBoundingBox()
+        const {
+    AxisAlignedBoundingBox<3> box;
+    box.min_bound_ = GetMinBound();
+    box.max_bound_ = GetMaxBound();
+    return box;
+}
+
+OrientedBoundingBox OctreeOccupancyGrid::GetOrientedBoundingBox() const {
+    return OrientedBoundingBox::CreateFromAxisAlignedBoundingBox(
+            GetAxisAlignedBoundingBox());
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Transform(
+        const Eigen::Matrix4f& transformation) {
+    utility::LogError("OctreeOccupancyGrid::Transform is not supported");
+    return *this;
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Translate(
+        const Eigen::Vector3f& translation, bool relative) {
+    origin_ += translation;
+    return *this;
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Scale(const float scale,
+                                                bool center) {
+    voxel_size_ *= scale;
+    return *this;
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Rotate(const Eigen::Matrix3f& R,
+                                                 bool center) {
+    utility::LogError("OctreeOccupancyGrid::Rotate is not supported");
+    return *this;
+}
+
+bool OctreeOccupancyGrid::IsOccupied(const Eigen::Vector3f& point) const {
+    OccupancyVoxel voxel = thrust::get<1>(GetVoxel(point));
+    return !std::isnan(voxel.prob_log_) &&
+           voxel.prob_log_ > occ_prob_thres_log_;
+}
+
+bool OctreeOccupancyGrid::IsUnknown(const Eigen::Vector3f& point) const {
+    return !thrust::get<0>(GetVoxel(point));
+}
+
+thrust::tuple<bool, OccupancyVoxel> OctreeOccupancyGrid::GetVoxel(
+        const Eigen::Vector3f& point, int depth) const {
+    utility::device_vector<Eigen::Vector3f> points(1, point);
+    OccupancyVoxel voxel = GetVoxels(points, depth)[0];
+    return thrust::make_tuple(!std::isnan(voxel.prob_log_), voxel);
+}
+
+utility::device_vector<OccupancyVoxel> OctreeOccupancyGrid::GetVoxels(
+        const utility::device_vector<Eigen::Vector3f>& points,
+        int depth) const {
+    depth = (depth < 0) ? max_depth_ : std::min(depth, max_depth_);
+    // Leaves below depth are merged into their node at depth.
+    const size_t n_fine = thrust::count_if(depths_.begin(), depths_.end(),
+                                           is_below_depth_functor(depth));
+    utility::device_vector<uint64_t> node_codes(n_fine);
+    utility::device_vector<OccupancyVoxel> node_voxels(n_fine);
+    if (n_fine > 0) {
+        utility::device_vector<uint64_t> fine_codes(n_fine);
+        utility::device_vector<OccupancyVoxel> fine_voxels(n_fine);
+        thrust::copy_if(make_tuple_begin(codes_, voxels_),
+                        make_tuple_end(codes_, voxels_), depths_.begin(),
+                        make_tuple_begin(fine_codes, fine_voxels),
+                        is_below_depth_functor(depth));
+        const mask_code_functor mask_func(~(NodeSpan(depth, max_depth_) - 1));
+        auto end = thrust::reduce_by_key(
+                thrust::make_transform_iterator(fine_codes.begin(), mask_func),
+                thrust::make_transform_iterator(fine_codes.end(), mask_func),
+                fine_voxels.begin(), node_codes.begin(), node_voxels.begin(),
+                thrust::equal_to<uint64_t>(), max_occupancy_functor());
+        const size_t n_nodes = thrust::distance(node_codes.begin(), end.first);
+        node_codes.resize(n_nodes);
+        node_voxels.resize(n_nodes);
+    }
+    utility::device_vector<OccupancyVoxel> out(points.size());
+    get_octree_voxel_functor func(
+            thrust::raw_pointer_cast(codes_.data()),
+            thrust::raw_pointer_cast(depths_.data()),
+            thrust::raw_pointer_cast(voxels_.data()), codes_.size(),
+            thrust::raw_pointer_cast(node_codes.data()),
+            thrust::raw_pointer_cast(node_voxels.data()), node_codes.size(),
+            voxel_size_, origin_, depth, max_depth_);
+    thrust::transform(points.begin(), points.end(), out.begin(), func);
+    return out;
+}
+
+template <typename Func>
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+OctreeOccupancyGrid::ExtractVoxels(int depth, Func check_func) const {
+    depth = (depth < 0) ? max_depth_ : std::min(depth, max_depth_);
+    const int shift = max_depth_ - depth;
+    const uint64_t mask = ~(NodeSpan(depth, max_depth_) - 1);
+    // Leaves at or below depth are merged into their node at depth.
+    const size_t n_fine = thrust::count_if(
+            depths_.begin(), depths_.end(),
+            [depth] __device__(unsigned char d) { return d >= depth; });
+    utility::device_vector<uint64_t> fine_codes(n_fine);
+    utility::device_vector<OccupancyVoxel> fine_voxels(n_fine);
+    thrust::copy_if(
+            make_tuple_begin(codes_, voxels_), make_tuple_end(codes_, voxels_),
+            depths_.begin(), make_tuple_begin(fine_codes, fine_voxels),
+            [depth] __device__(unsigned char d) { return d >= depth; });
+    thrust::transform(fine_codes.begin(), fine_codes.end(), fine_codes.begin(),
+                      [mask] __device__(uint64_t code) { return code & mask; });
+    utility::device_vector<uint64_t> node_codes(n_fine);
+    utility::device_vector<OccupancyVoxel> node_voxels(n_fine);
+    auto end = thrust::reduce_by_key(fine_codes.begin(), fine_codes.end(),
+                                     fine_voxels.begin(), node_codes.begin(),
+                                     node_voxels.begin(),
+                                     thrust::equal_to<uint64_t>(),
+                                     max_occupancy_functor());
+    const size_t n_nodes = thrust::distance(node_voxels.begin(), end.second);
+    node_voxels.resize(n_nodes);
+    thrust::transform(node_codes.begin(), node_codes.begin() + n_nodes,
+                      node_voxels.begin(), node_voxels.begin(),
+                      [shift] __device__(uint64_t code, OccupancyVoxel v) {
+                          const Eigen::Vector3i key = MortonKeyOf(code);
+                          v.grid_index_ = Eigen::Vector3ui16(key[0] >> shift,
+                                                             key[1] >> shift,
+                                                             key[2] >> shift);
+                          return v;
+                      });
+
+    // Leaves above depth are expanded into their nodes at depth.
+    utility::device_vector<size_t> coarse_indices(depths_.size());
+    auto coarse_end = thrust::copy_if(
+            thrust::make_counting_iterator<size_t>(0),
+            thrust::make_counting_iterator(depths_.size()),
+            make_tuple_begin(depths_, voxels_), coarse_indices.begin(),
+            [depth, check_func] __device__(
+                    const thrust::tuple<unsigned char, OccupancyVoxel>& x) {
+                return thrust::get<0>(x) < depth &&
+                       check_func(thrust::get<1>(x));
+            });
+    coarse_indices.resize(thrust::distance(coarse_indices.begin(), coarse_end));
+    utility::device_vector<size_t> offsets(coarse_indices.size());
+    auto count_fn = [depths = thrust::raw_pointer_cast(depths_.data()), depth,
+                     max_depth = max_depth_] __device__(size_t idx) {
+        return static_cast<size_t>(NodeSpan(depths[idx], max_depth) /
+                                   NodeSpan(depth, max_depth));
+    };
+    const size_t n_coarse = thrust::transform_reduce(
+            coarse_indices.begin(), coarse_indices.end(), count_fn, size_t(0),
+            thrust::plus<size_t>());
+    if (n_nodes + n_coarse > kMaxExpandedNodes) {
+        utility::LogError(
+                "[OctreeOccupancyGrid] extracting {} nodes at depth {} "
+                "exceeds the limit of {}, use a coarser depth.",
+                n_nodes + n_coarse, depth, kMaxExpandedNodes);
+        return std::make_shared<utility::device_vector<OccupancyVoxel>>();
+    }
+    thrust::transform_exclusive_scan(coarse_indices.begin(),
+                                     coarse_indices.end(), offsets.begin(),
+                                     count_fn, size_t(0),
+                                     thrust::plus<size_t>());
+
+    auto out = std::make_shared<utility::device_vector<OccupancyVoxel>>(
+            n_nodes + n_coarse);
+    auto out_end = thrust::copy_if(node_voxels.begin(), node_voxels.end(),
+                                   out->begin(), check_func);
+    const size_t n_checked = thrust::distance(out->begin(), out_end);
+    expand_coarse_leaves_functor func(
+            thrust::raw_pointer_cast(codes_.data()),
+            thrust::raw_pointer_cast(depths_.data()),
+            thrust::raw_pointer_cast(voxels_.data()),
+            thrust::raw_pointer_cast(out->data()) + n_checked, depth,
+            max_depth_);
+    thrust::for_each(make_tuple_begin(coarse_indices, offsets),
+                     make_tuple_end(coarse_indices, offsets), func);
+    out->resize(n_checked + n_coarse);
+    return out;
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+OctreeOccupancyGrid::ExtractKnownVoxels(int depth) const {
+    auto check_fn = [] __device__(const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_);
+    };
+    return ExtractVoxels(depth, check_fn);
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+OctreeOccupancyGrid::ExtractFreeVoxels(int depth) const {
+    auto check_fn = [th = occ_prob_thres_log_] __device__(
+                            const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_) && v.prob_log_ <= th;
+    };
+    return ExtractVoxels(depth, check_fn);
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+OctreeOccupancyGrid::ExtractOccupiedVoxels(int depth) const {
+    auto check_fn = [th = occ_prob_thres_log_] __device__(
+                            const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_) && v.prob_log_ > th;
+    };
+    return ExtractVoxels(depth, check_fn);
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Insert(
+        const utility::device_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    if (points.empty()) return *this;
+
+    utility::device_vector<Eigen::Vector3i> free_voxels;
+    utility::device_vector<Eigen::Vector3i> occupied_voxels;
+    ComputeInsertedVoxels(points, viewpoint, max_range, voxel_size_,
+                          GetResolution(), origin_, free_voxels,
+                          occupied_voxels);
+    AddVoxels(free_voxels, false);
+    AddVoxels(occupied_voxels, true);
+    return Prune();
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Insert(
+        const utility::pinned_host_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    utility::device_vector<Eigen::Vector3f> dev_points(points.size());
+    cudaSafeCall(cudaMemcpy(
+            thrust::raw_pointer_cast(dev_points.data()), points.data(),
+            points.size() * sizeof(Eigen::Vector3f), cudaMemcpyHostToDevice));
+    return Insert(dev_points, viewpoint, max_range);
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Insert(
+        const geometry::PointCloud& pointcloud,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    return Insert(pointcloud.points_, viewpoint, max_range);
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::AddVoxel(const Eigen::Vector3i& voxel,
+                                                   bool occupied) {
+    if ((voxel.array() < 0).any() ||
+        (voxel.array() >= GetResolution()).any()) {
+        utility::LogError(
+                "[OctreeOccupancyGrid] a provided voxel is not occupancy grid "
+                "range.");
+        return *this;
+    }
+    utility::device_vector<Eigen::Vector3i> voxels(1, voxel);
+    return AddVoxels(voxels, occupied);
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::AddVoxels(
+        const utility::device_vector<Eigen::Vector3i>& voxels, bool occupied) {
+    if (voxels.empty()) return *this;
+    if (thrust::any_of(voxels.begin(), voxels.end(),
+                       is_out_of_range_functor(GetResolution()))) {
+        utility::LogError(
+                "[OctreeOccupancyGrid] a provided voxel is not occupancy grid "
+                "range.");
+        return *this;
+    }
+    const bool was_empty = !HasVoxels();
+    Eigen::Vector3i vmin = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Constant(GetResolution() - 1).eval(),
+            thrust::elementwise_minimum<Eigen::Vector3i>());
+    Eigen::Vector3i vmax = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Zero().eval(),
+            thrust::elementwise_maximum<Eigen::Vector3i>());
+    if (was_empty) {
+        min_bound_ = vmin.cast<unsigned short>();
+        max_bound_ = vmax.cast<unsigned short>();
+    } else {
+        min_bound_ = min_bound_.array().min(
+                vmin.cast<unsigned short>().array());
+        max_bound_ = max_bound_.array().max(
+                vmax.cast<unsigned short>().array());
+    }
+
+    utility::device_vector<uint64_t> targets(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), targets.begin(),
+                      compute_morton_code_functor());
+    thrust::sort(utility::exec_policy(0)->on(0), targets.begin(),
+                 targets.end());
+    targets.resize(thrust::distance(
+            targets.begin(), thrust::unique(targets.begin(), targets.end())));
+
+    // Split the pruned leaves holding a target down to the finest depth.
+    utility::device_vector<size_t> positions(targets.size());
+    utility::device_vector<bool> contained(targets.size());
+    utility::device_vector<bool> flags;
+    while (true) {
+        flags.resize(codes_.size());
+        thrust::fill(flags.begin(), flags.end(), false);
+        thrust::upper_bound(codes_.begin(), codes_.end(), targets.begin(),
+                            targets.end(), positions.begin());
+        find_container_functor func(
+                thrust::raw_pointer_cast(codes_.data()),
+                thrust::raw_pointer_cast(depths_.data()),
+                thrust::raw_pointer_cast(flags.data()), max_depth_);
+        thrust::transform(make_tuple_begin(targets, positions),
+                          make_tuple_end(targets, positions),
+                          contained.begin(), func);
+        if (!thrust::any_of(flags.begin(), flags.end(),
+                            thrust::identity<bool>()))
+            break;
+        SplitLeaves(flags);
+    }
+
+    // Targets in unknown space become new leaves.
+    utility::device_vector<uint64_t> new_codes(targets.size());
+    auto end = thrust::copy_if(targets.begin(), targets.end(),
+                               contained.begin(), new_codes.begin(),
+                               thrust::logical_not<bool>());
+    new_codes.resize(thrust::distance(new_codes.begin(), end));
+    if (!new_codes.empty()) {
+        utility::device_vector<unsigned char> new_depths(new_codes.size(),
+                                                         max_depth_);
+        utility::device_vector<OccupancyVoxel> new_voxels(new_codes.size());
+        thrust::transform(new_codes.begin(), new_codes.end(),
+                          new_voxels.begin(), [] __device__(uint64_t code) {
+                              return OccupancyVoxel(MortonKeyOf(code));
+                          });
+        const size_t n = codes_.size() + new_codes.size();
+        utility::device_vector<uint64_t> merged_codes(n);
+        utility::device_vector<unsigned char> merged_depths(n);
+        utility::device_vector<OccupancyVoxel> merged_voxels(n);
+        thrust::merge_by_key(codes_.begin(), codes_.end(), new_codes.begin(),
+                             new_codes.end(),
+                             make_tuple_begin(depths_, voxels_),
+                             make_tuple_begin(new_depths, new_voxels),
+                             merged_codes.begin(),
+                             make_tuple_begin(merged_depths, merged_voxels));
+        codes_.swap(merged_codes);
+        depths_.swap(merged_depths);
+        voxels_.swap(merged_voxels);
+    }
+
+    thrust::lower_bound(codes_.begin(), codes_.end(), targets.begin(),
+                        targets.end(), positions.begin());
+    add_octree_occupancy_functor func(
+            thrust::raw_pointer_cast(voxels_.data()), clamping_thres_min_,
+            clamping_thres_max_, prob_miss_log_, prob_hit_log_, occupied);
+    thrust::for_each(positions.begin(), positions.end(), func);
+    return *this;
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Prune() {
+    for (int depth = max_depth_; depth > 0; --depth) {
+        const size_t n = codes_.size();
+        if (n < 8) break;
+        utility::device_vector<bool> collapse(n);
+        check_collapse_functor check_func(
+                thrust::raw_pointer_cast(codes_.data()),
+                thrust::raw_pointer_cast(depths_.data()),
+                thrust::raw_pointer_cast(voxels_.data()), n, depth,
+                max_depth_);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n), collapse.begin(),
+                          check_func);
+        if (!thrust::any_of(collapse.begin(), collapse.end(),
+                            thrust::identity<bool>()))
+            continue;
+        utility::device_vector<bool> removed(n, false);
+        collapse_functor func(thrust::raw_pointer_cast(collapse.data()),
+                              thrust::raw_pointer_cast(depths_.data()),
+                              thrust::raw_pointer_cast(removed.data()), depth);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n), func);
+        remove_if_vectors(
+                [] __device__(const thrust::tuple<uint64_t, unsigned char,
+                                                  OccupancyVoxel, bool>& x) {
+                    return thrust::get<3>(x);
+                },
+                codes_, depths_, voxels_, removed);
+    }
+    return *this;
+}
+
+OctreeOccupancyGrid& OctreeOccupancyGrid::Expand(int depth) {
+    depth = (depth < 0) ? max_depth_ : std::min(depth, max_depth_);
+    const size_t n_leaves = thrust::transform_reduce(
+            depths_.begin(), depths_.end(),
+            [depth, max_depth = max_depth_] __device__(unsigned char d) {
+                return (d < depth) ? static_cast<size_t>(
+                                             NodeSpan(d, max_depth) /
+                                             NodeSpan(depth, max_depth))
+                                   : size_t(1);
+            },
+            size_t(0), thrust::plus<size_t>());
+    if (n_leaves > kMaxExpandedNodes) {
+        utility::LogError(
+                "[OctreeOccupancyGrid] expanding to {} leaves at depth {} "
+                "exceeds the limit of {}, use a coarser depth.",
+                n_leaves, depth, kMaxExpandedNodes);
+        return *this;
+    }
+    utility::device_vector<bool> flags;
+    while (true) {
+        flags.resize(depths_.size());
+        thrust::transform(
+                depths_.begin(), depths_.end(), flags.begin(),
+                [depth] __device__(unsigned char d) { return d < depth; });
+        if (!thrust::any_of(flags.begin(), flags.end(),
+                            thrust::identity<bool>()))
+            break;
+        SplitLeaves(flags);
+    }
+    return *this;
+}
+
+std::vector<uint8_t> OctreeOccupancyGrid::ExportBinaryStream() const {
+    std::vector<uint8_t> stream(1 + 4 * sizeof(float));
+    stream[0] = max_depth_;
+    std::memcpy(stream.data() + 1, &voxel_size_, sizeof(float));
+    std::memcpy(stream.data() + 1 + sizeof(float), origin_.data(),
+                3 * sizeof(float));
+    if (!HasVoxels()) return stream;
+
+    thrust::host_vector<uint64_t> codes = codes_;
+    thrust::host_vector<unsigned char> depths = depths_;
+    thrust::host_vector<OccupancyVoxel> voxels = voxels_;
+    // Writes the children of the node at code and depth, then recurses into
+    // the inner ones.
+    std::function<void(uint64_t, int)> write_node = [&](uint64_t code,
+                                                        int depth) {
+        const uint64_t span = NodeSpan(depth + 1, max_depth_);
+        uint16_t bits = 0;
+        for (int c = 0; c < 8; ++c) {
+            const uint64_t child = code + c * span;
+            const size_t i =
+                    std::upper_bound(codes.begin(), codes.end(), child) -
+                    codes.begin();
+            uint16_t state = 0;
+            if (i > 0 &&
+                child < codes[i - 1] + NodeSpan(depths[i - 1], max_depth_)) {
+                state = (voxels[i - 1].prob_log_ > occ_prob_thres_log_) ? 1
+                                                                         : 2;
+            } else if (i < codes.size() && codes[i] < child + span) {
+                state = 3;
+            }
+            bits |= state << (2 * c);
+        }
+        WriteChildBits(stream, bits);
+        for (int c = 0; c < 8; ++c) {
+            if (((bits >> (2 * c)) & 3) == 3) {
+                write_node(code + c * span, depth + 1);
+            }
+        }
+    };
+    write_node(0, 0);
+    return stream;
+}
+
+bool OctreeOccupancyGrid::ImportBinaryStream(
+        const std::vector<uint8_t>& stream) {
+    const size_t header_size = 1 + 4 * sizeof(float);
+    if (stream.size() < header_size || stream[0] < 1 || stream[0] > 16) {
+        utility::LogWarning("[ImportBinaryStream] invalid stream header.");
+        return false;
+    }
+    const int max_depth = stream[0];
+    thrust::host_vector<uint64_t> codes;
+    thrust::host_vector<unsigned char> depths;
+    thrust::host_vector<OccupancyVoxel> voxels;
+    size_t pos = header_size;
+    std::function<bool(uint64_t, int)> read_node = [&](uint64_t code,
+                                                       int depth) {
+        if (pos + 2 > stream.size() || depth >= max_depth) return false;
+        const uint16_t bits = stream[pos] | (stream[pos + 1] << 8);
+        pos += 2;
+        const uint64_t span = NodeSpan(depth + 1, max_depth);
+        for (int c = 0; c < 8; ++c) {
+            const int state = (bits >> (2 * c)) & 3;
+            const uint64_t child = code + c * span;
+            if (state == 1 || state == 2) {
+                codes.push_back(child);
+                depths.push_back(depth + 1);
+                voxels.push_back(OccupancyVoxel(
+                        MortonKeyOf(child),
+                        (state == 1) ? clamping_thres_max_
+                                     : clamping_thres_min_));
+            } else if (state == 3 && !read_node(child, depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (pos < stream.size() &&
+        (!read_node(0, 0) || pos != stream.size())) {
+        utility::LogWarning("[ImportBinaryStream] invalid stream body.");
+        return false;
+    }
+    max_depth_ = max_depth;
+    std::memcpy(&voxel_size_, stream.data() + 1, sizeof(float));
+    std::memcpy(origin_.data(), stream.data() + 1 + sizeof(float),
+                3 * sizeof(float));
+    codes_ = codes;
+    depths_ = depths;
+    voxels_ = voxels;
+    ComputeBounds();
+    return true;
+}
+
+void OctreeOccupancyGrid::SplitLeaves(
+        const utility::device_vector<bool>& flags) {
+    const size_t n = codes_.size();
+    utility::device_vector<size_t> offsets(n);
+    auto count_fn = [] __device__(bool flag) {
+        return flag ? size_t(8) : size_t(1);
+    };
+    thrust::transform_exclusive_scan(flags.begin(), flags.end(),
+                                     offsets.begin(), count_fn, size_t(0),
+                                     thrust::plus<size_t>());
+    const size_t n_out = thrust::transform_reduce(
+            flags.begin(), flags.end(), count_fn, size_t(0),
+            thrust::plus<size_t>());
+    utility::device_vector<uint64_t> out_codes(n_out);
+    utility::device_vector<unsigned char> out_depths(n_out);
+    utility::device_vector<OccupancyVoxel> out_voxels(n_out);
+    split_leaves_functor func(thrust::raw_pointer_cast(codes_.data()),
+                              thrust::raw_pointer_cast(depths_.data()),
+                              thrust::raw_pointer_cast(voxels_.data()),
+                              thrust::raw_pointer_cast(flags.data()),
+                              thrust::raw_pointer_cast(offsets.data()),
+                              thrust::raw_pointer_cast(out_codes.data()),
+                              thrust::raw_pointer_cast(out_depths.data()),
+                              thrust::raw_pointer_cast(out_voxels.data()),
+                              max_depth_);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n), func);
+    codes_.swap(out_codes);
+    depths_.swap(out_depths);
+    voxels_.swap(out_voxels);
+}
+
+void OctreeOccupancyGrid::ComputeBounds() {
+    const int resolution = GetResolution();
+    if (!HasVoxels()) {
+        min_bound_ = Eigen::Vector3ui16::Constant(resolution / 2);
+        max_bound_ = Eigen::Vector3ui16::Constant(resolution / 2);
+        return;
+    }
+    const Eigen::Vector3i vmin = thrust::transform_reduce(
+            codes_.begin(), codes_.end(),
+            [] __device__(uint64_t code) { return MortonKeyOf(code); },
+            Eigen::Vector3i::Constant(resolution - 1).eval(),
+            thrust::elementwise_minimum<Eigen::Vector3i>());
+    const Eigen::Vector3i vmax = thrust::transform_reduce(
+            make_tuple_begin(codes_, depths_), make_tuple_end(codes_, depths_),
+            [max_depth = max_depth_] __device__(
+                    const thrust::tuple<uint64_t, unsigned char>& x) {
+                const int size = 1 << (max_depth - thrust::get<1>(x));
+                return (MortonKeyOf(thrust::get<0>(x)) +
+                        Eigen::Vector3i::Constant(size - 1))
+                        .eval();
+            },
+            Eigen::Vector3i::Zero().eval(),
+            thrust::elementwise_maximum<Eigen::Vector3i>());
+    min_bound_ = vmin.cast<unsigned short>();
+    max_bound_ = vmax.cast<unsigned short>();
+}
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+#include <thrust/tuple.h>
+
+#include <vector>
+
+#include "cupoch/geometry/geometry_base.h"
+#include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/utility/device_vector.h"
+#include "cupoch/utility/eigen.h"
+
+namespace cupoch {
+
+namespace geometry {
+class PointCloud;
+class OrientedBoundingBox;
+
+/// \class OctreeOccupancyGrid
+///
+/// \brief Multi-resolution occupancy map stored as a linear octree.
+///
+/// Only the leaves of the octree are stored, sorted by the Morton code of
+/// their first voxel at the finest depth. Prune() collapses eight sibling
+/// leaves with the same log-odds into their parent, so that homogeneous
+/// regions cost a single node. A node above the leaves takes the maximum
+/// log-odds of its known descendants as in OctoMap. Voxel indices at depth d
+/// follow the OccupancyGrid convention with a resolution of 2^d, i.e. the
+/// finest voxels cover 2^max_depth_ voxels along each axis around
+/// \p origin_.
+class OctreeOccupancyGrid : public GeometryBase3D {
+public:
+    OctreeOccupancyGrid();
+    OctreeOccupancyGrid(
+            float voxel_size,
+            int max_depth = 16,
+            const Eigen::Vector3f& origin = Eigen::Vector3f::Zero());
+    ~OctreeOccupancyGrid();
+    OctreeOccupancyGrid(const OctreeOccupancyGrid& other);
+
+    OctreeOccupancyGrid& Clear() override;
+    bool IsEmpty() const override;
+    Eigen::Vector3f GetMinBound() const override;
+    Eigen::Vector3f GetMaxBound() const override;
+    Eigen::Vector3f GetCenter() const override;
+    AxisAlignedBoundingBox<3> GetAxisAlignedBoundingBox() const override;
+    OrientedBoundingBox GetOrientedBoundingBox() const;
+    OctreeOccupancyGrid& Transform(
+            const Eigen::Matrix4f& transformation) override;
+    OctreeOccupancyGrid& Translate(const Eigen::Vector3f& translation,
+                                   bool relative = true) override;
+    OctreeOccupancyGrid& Scale(const float scale, bool center = true) override;
+    OctreeOccupancyGrid& Rotate(const Eigen::Matrix3f& R,
+                                bool center = true) override;
+
+    bool HasVoxels() const { return !codes_.empty(); }
+    bool HasColors() const {
+        return true;  // By default, the colors are (1.0, 1.0, 1.0)
+    }
+    /// Returns the number of stored leaves.
+    size_t NumLeaves() const { return codes_.size(); }
+    /// Returns the number of voxels along each axis at the finest depth.
+    int GetResolution() const { return 1 << max_depth_; }
+
+    bool IsOccupied(const Eigen::Vector3f& point) const;
+    bool IsUnknown(const Eigen::Vector3f& point) const;
+    /// Returns the node containing \p point at \p depth, or at the finest
+    /// depth if \p depth is negative.
+    thrust::tuple<bool, OccupancyVoxel> GetVoxel(const Eigen::Vector3f& point,
+                                                 int depth = -1) const;
+    /// Batched version of GetVoxel. Unknown nodes have a NaN log-odds.
+    utility::device_vector<OccupancyVoxel> GetVoxels(
+            const utility::device_vector<Eigen::Vector3f>& points,
+            int depth = -1) const;
+    /// Returns the nodes at \p depth. Leaves above \p depth are expanded, so
+    /// a coarse depth gives a cheap conservative map for long-range checks.
+    /// An expansion beyond 2^26 nodes is rejected with an empty result.
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractKnownVoxels(
+            int depth = -1) const;
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractFreeVoxels(
+            int depth = -1) const;
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+    ExtractOccupiedVoxels(int depth = -1) const;
+
+    /// Inserts a scan and prunes the tree.
+    OctreeOccupancyGrid& Insert(
+            const utility::device_vector<Eigen::Vector3f>& points,
+            const Eigen::Vector3f& viewpoint,
+            float max_range = -1.0);
+    OctreeOccupancyGrid& Insert(
+            const utility::pinned_host_vector<Eigen::Vector3f>& points,
+            const Eigen::Vector3f& viewpoint,
+            float max_range = -1.0);
+    OctreeOccupancyGrid& Insert(const PointCloud& pointcloud,
+                                const Eigen::Vector3f& viewpoint,
+                                float max_range = -1.0);
+
+    /// Updates voxels given at the finest depth. Pruned leaves on their way
+    /// are split as needed; the tree is not pruned afterwards.
+    OctreeOccupancyGrid& AddVoxel(const Eigen::Vector3i& voxel,
+                                  bool occupied = false);
+    OctreeOccupancyGrid& AddVoxels(
+            const utility::device_vector<Eigen::Vector3i>& voxels,
+            bool occupied = false);
+
+    /// Collapses every group of eight sibling leaves sharing the same
+    /// log-odds into their parent, bottom-up.
+    OctreeOccupancyGrid& Prune();
+    /// Splits the leaves above \p depth (the finest depth if negative).
+    /// Nothing is split if the tree would grow beyond 2^26 leaves.
+    OctreeOccupancyGrid& Expand(int depth = -1);
+
+    /// Serializes the tree structure into a compact stream. Each inner node
+    /// is written in depth-first order as 2 bits per child (00 unknown,
+    /// 01 occupied leaf, 10 free leaf, 11 inner node) after a header holding
+    /// max_depth_, voxel_size_ and origin_. Log-odds are not kept.
+    std::vector<uint8_t> ExportBinaryStream() const;
+    /// Restores a tree written by ExportBinaryStream. Occupied and free
+    /// leaves get the clamping thresholds as log-odds.
+    bool ImportBinaryStream(const std::vector<uint8_t>& stream);
+
+private:
+    void SplitLeaves(const utility::device_vector<bool>& flags);
+    void ComputeBounds();
+    template <typename Func>
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractVoxels(
+            int depth, Func func) const;
+
+public:
+    float voxel_size_ = 0.05;
+    int max_depth_ = 16;
+    Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    /// Morton code at the finest depth of the first voxel of each leaf, in
+    /// ascending order.
+    utility::device_vector<uint64_t> codes_;
+    /// Depth of each leaf.
+    utility::device_vector<unsigned char> depths_;
+    /// Log-odds and color of each leaf. grid_index_ is the first voxel of
+    /// the leaf at the finest depth.
+    utility::device_vector<OccupancyVoxel> voxels_;
+
+    Eigen::Vector3ui16 min_bound_ = Eigen::Vector3ui16::Zero();
+    Eigen::Vector3ui16 max_bound_ = Eigen::Vector3ui16::Zero();
+    float clamping_thres_min_ = -2.0f;
+    float clamping_thres_max_ = 3.5f;
+    float prob_hit_log_ = 0.85f;
+    float prob_miss_log_ = -0.4f;
+    float occ_prob_thres_log_ = 0.0f;
+    bool visualize_free_area_ = true;
+};
+
+}  // namespace geometry
+
+}  // namespace cupoch
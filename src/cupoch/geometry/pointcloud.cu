@@ -53,6 +53,26 @@ struct check_nan_functor {
     }
 };
 
+struct compute_point_morton_code_functor {
+    compute_point_morton_code_functor(const Eigen::Vector3f &min_bound,
+                                      float scale)
+        : min_bound_(min_bound), scale_(scale){};
+    const Eigen::Vector3f min_bound_;
+    const float scale_;
+    __device__ uint64_t operator()(const Eigen::Vector3f &point) const {
+        return MortonCodeOf(point, min_bound_, scale_);
+    }
+};
+
+template <typename T>
+void PermuteVector(const utility::device_vector<size_t> &indices,
+                   utility::device_vector<T> &vec) {
+    utility::device_vector<T> sorted(indices.size());
+    thrust::gather(utility::exec_policy(0)->on(0), indices.begin(),
+                   indices.end(), vec.begin(), sorted.begin());
+    vec.swap(sorted);
+}
+
 struct gaussian_filter_functor {
     gaussian_filter_functor(const Eigen::Vector3f *points,
                             const Eigen::Vector3f *normals,
@@ -321,6 +341,28 @@ PointCloud &PointCloud::RemoveNoneFinitePoints(bool remove_nan,
     return *this;
 }
 
+utility::device_vector<size_t> PointCloud::SortByMortonCode() {
+    const size_t n_points = points_.size();
+    utility::device_vector<size_t> indices(n_points);
+    thrust::sequence(indices.begin(), indices.end());
+    if (n_points < 2) return indices;
+    const bool has_normal = HasNormals();
+    const bool has_color = HasColors();
+    const Eigen::Vector3f min_bound = GetMinBound();
+    const float extent = (GetMaxBound() - min_bound).maxCoeff();
+    const float scale =
+            (extent > 0.0f) ? (MORTON_AXIS_CELLS - 1) / extent : 0.0f;
+    utility::device_vector<uint64_t> codes(n_points);
+    thrust::transform(points_.begin(), points_.end(), codes.begin(),
+                      compute_point_morton_code_functor(min_bound, scale));
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), codes.begin(),
+                        codes.end(), indices.begin());
+    PermuteVector(indices, points_);
+    if (has_normal) PermuteVector(indices, normals_);
+    if (has_color) PermuteVector(indices, colors_);
+    return indices;
+}
+
 std::shared_ptr<PointCloud> PointCloud::GaussianFilter(
         float search_radius, float sigma2, int num_max_search_points) {
     auto out = std::make_shared<PointCloud>();
@@ -21,6 +21,8 @@
 #pragma once
 #include <thrust/host_vector.h>
 
+#include <limits>
+
 #include "cupoch/geometry/geometry_base.h"
 #include "cupoch/geometry/kdtree_search_param.h"
 #include "cupoch/utility/device_vector.h"
@@ -34,9 +36,11 @@ class PinholeCameraIntrinsic;
 
 namespace geometry {
 
+class ClusterStatistics;
 class Image;
 class RGBDImage;
 class LaserScanBuffer;
+class NeighborList;
 class OccupancyGrid;
 class OrientedBoundingBox;
 
@@ -104,6 +108,15 @@ public:
     PointCloud &RemoveNoneFinitePoints(bool remove_nan = true,
                                        bool remove_infinite = true);
 
+    /// \brief Reorders the points along a Morton (Z-order) curve.
+    ///
+    /// Neighboring points end up close in memory, which makes the gathers
+    /// of neighbor-search-backed algorithms more coherent. Normals and
+    /// colors are permuted together with the points.
+    ///
+    /// \return Returns the original index of each reordered point.
+    utility::device_vector<size_t> SortByMortonCode();
+
     /// \brief Function to select points from \p input pointcloud into
     /// \p output pointcloud.
     ///
@@ -125,6 +138,46 @@ public:
     /// uniformly \param every_k_points indicates the sample rate.
     std::shared_ptr<PointCloud> UniformDownSample(size_t every_k_points) const;
 
+    /// \brief Function to halve the resolution of an organized pointcloud.
+    ///
+    /// The pointcloud stores width x height points in row major order with
+    /// NaN for the invalid pixels, e.g. the output of a raycast. Each output
+    /// point averages the valid points of a 2x2 block lying within
+    /// \p max_distance of the first valid one, so that depth discontinuities
+    /// are not blended. Normals are renormalized.
+    ///
+    /// \param width Width of the organized pointcloud.
+    /// \param height Height of the organized pointcloud.
+    /// \param max_distance Maximum distance of the averaged points.
+    std::shared_ptr<PointCloud> OrganizedDownSample(
+            int width,
+            int height,
+            float max_distance =
+                    std::numeric_limits<float>::infinity()) const;
+
+    /// \brief Function to downsample input pointcloud into output pointcloud
+    /// by farthest point sampling.
+    ///
+    /// Each iteration picks the point farthest from the points selected so
+    /// far, which gives a subset with good spatial coverage.
+    ///
+    /// \param num_samples Number of points to be sampled.
+    /// \param start_index Index of the first selected point.
+    std::shared_ptr<PointCloud> FarthestPointDownSample(
+            size_t num_samples, size_t start_index = 0) const;
+
+    /// \brief Function to downsample input pointcloud into output pointcloud
+    /// by Poisson-disk sampling.
+    ///
+    /// The selected points are at least \p radius apart from each other and
+    /// every rejected input point is closer than \p radius to a selected
+    /// point.
+    ///
+    /// \param radius Minimum distance between the selected points.
+    /// \param seed Seed of the random visiting order of the points.
+    std::shared_ptr<PointCloud> PoissonDiskDownSample(float radius,
+                                                      int seed = 0) const;
+
     std::tuple<std::shared_ptr<PointCloud>, utility::device_vector<size_t>>
     RemoveRadiusOutliers(size_t nb_points, float search_radius) const;
 
@@ -135,6 +188,54 @@ public:
                                                float sigma2,
                                                int num_max_search_points = 50);
 
+    /// Gaussian filter over precomputed neighbor lists, which can be reused
+    /// across multiple filtering passes.
+    std::shared_ptr<PointCloud> GaussianFilter(const NeighborList &neighbors,
+                                               float sigma2) const;
+
+    /// \brief Function to smooth the point cloud by moving least squares.
+    ///
+    /// Each point is projected onto a local polynomial surface fitted to its
+    /// neighbors with Gaussian weights, and the normals are set to the
+    /// surface normals. If both upsampling parameters are positive, the
+    /// local surface around each point is additionally sampled on a grid in
+    /// the tangent plane.
+    ///
+    /// \param neighbors Neighbor lists of the points.
+    /// \param search_radius Radius of the Gaussian weight function.
+    /// \param polynomial_order Order of the fitted surface (1 or 2).
+    /// \param upsampling_radius Radius of the sampled tangent disk.
+    /// \param upsampling_step Grid step of the upsampling.
+    std::shared_ptr<PointCloud> SmoothMLS(const NeighborList &neighbors,
+                                          float search_radius,
+                                          int polynomial_order = 2,
+                                          float upsampling_radius = 0.0f,
+                                          float upsampling_step = 0.0f) const;
+
+    /// \brief Function to filter the normals with a bilateral filter.
+    ///
+    /// \param neighbors Neighbor lists of the points.
+    /// \param sigma_s Standard deviation of the spatial weight.
+    /// \param sigma_n Standard deviation of the normal deviation weight.
+    /// \param num_iterations Number of filtering passes.
+    std::shared_ptr<PointCloud> BilateralFilterNormals(
+            const NeighborList &neighbors,
+            float sigma_s,
+            float sigma_n,
+            int num_iterations = 1) const;
+
+    /// \brief Function to denoise the points with an edge-aware bilateral
+    /// filter, which moves each point along its normal.
+    ///
+    /// \param neighbors Neighbor lists of the points.
+    /// \param sigma_s Standard deviation of the spatial weight.
+    /// \param sigma_r Standard deviation of the height (range) weight.
+    /// \param num_iterations Number of filtering passes.
+    std::shared_ptr<PointCloud> BilateralFilter(const NeighborList &neighbors,
+                                                float sigma_s,
+                                                float sigma_r,
+                                                int num_iterations = 1) const;
+
     std::shared_ptr<PointCloud> PassThroughFilter(int axis_no,
                                                   float min_bound,
                                                   float max_bound);
@@ -157,9 +258,23 @@ public:
     /// \param cloud is the input point cloud. It also stores the output
     /// normals. Normals are oriented with respect to the input point cloud if
     /// normals exist in the input. \param search_param The KDTree search
-    /// parameters
+    /// parameters \param start_index Only the normals of the points from
+    /// this index on are (re-)estimated, which allows incremental estimation
+    /// for newly appended points.
     bool EstimateNormals(
-            const KDTreeSearchParam &search_param = KDTreeSearchParamKNN());
+            const KDTreeSearchParam &search_param = KDTreeSearchParamKNN(),
+            size_t start_index = 0);
+
+    /// Function to compute the normals of a point cloud together with the
+    /// surface variation (curvature) l0 / (l0 + l1 + l2) and the planarity
+    /// (l1 - l0) / l2 of each neighborhood, where l0 <= l1 <= l2 are the
+    /// eigenvalues of the covariance matrix.
+    /// Returns the curvatures and planarities of the points from
+    /// \param start_index on.
+    std::tuple<utility::device_vector<float>, utility::device_vector<float>>
+    EstimateNormalsWithCurvatures(
+            const KDTreeSearchParam &search_param = KDTreeSearchParamKNN(),
+            size_t start_index = 0);
 
     /// Function to orient the normals of a point cloud
     /// \param cloud is the input point cloud. It must have normals.
@@ -168,6 +283,14 @@ public:
             const Eigen::Vector3f &orientation_reference =
                     Eigen::Vector3f(0.0, 0.0, 1.0));
 
+    /// Function to consistently orient the normals of a point cloud based on
+    /// tangent planes, as described in Hoppe et al., "Surface Reconstruction
+    /// from Unorganized Points", 1992. The orientation is propagated along the
+    /// minimum spanning tree of a Riemannian graph over the \param k nearest
+    /// neighbors. The normal of the highest point of each connected component
+    /// keeps its orientation.
+    bool OrientNormalsConsistentTangentPlane(size_t k);
+
     /// Cluster PointCloud using the DBSCAN algorithm
     /// Ester et al., "A Density-Based Algorithm for Discovering Clusters
     /// in Large Spatial Databases with Noise", 1996
@@ -179,6 +302,50 @@ public:
             bool print_progress = false,
             size_t max_edges = NUM_MAX_NN) const;
 
+    /// \brief Cluster PointCloud by Euclidean connectivity.
+    ///
+    /// Points closer than \p tolerance are connected and every connected
+    /// component forms a cluster. Unlike DBSCAN, there is no core point rule.
+    /// Clusters with fewer than \p min_cluster_size or more than
+    /// \p max_cluster_size points are labeled -1.
+    ///
+    /// \param tolerance Maximum distance between connected points.
+    /// \param min_cluster_size Minimum number of points of a cluster.
+    /// \param max_cluster_size Maximum number of points of a cluster.
+    /// \param max_edges Maximum number of neighbors searched per point.
+    /// \return Returns the point labels and the per-cluster statistics.
+    std::tuple<utility::device_vector<int>, std::shared_ptr<ClusterStatistics>>
+    ClusterEuclidean(float tolerance,
+                     size_t min_cluster_size = 1,
+                     size_t max_cluster_size = std::numeric_limits<int>::max(),
+                     size_t max_edges = NUM_MAX_NN) const;
+
+    /// \brief Segment PointCloud into smooth regions by region growing.
+    ///
+    /// Neighboring points whose normals deviate less than
+    /// \p angle_threshold are connected, and regions only grow through
+    /// points whose curvature is below \p curvature_threshold. Points with a
+    /// larger curvature join the most similar adjacent region. Clusters with
+    /// fewer than \p min_cluster_size or more than \p max_cluster_size
+    /// points are labeled -1.
+    ///
+    /// \param neighbors Neighbor lists of the points.
+    /// \param curvatures Curvatures of the points, e.g. computed by
+    /// EstimateNormalsWithCurvatures.
+    /// \param angle_threshold Maximum angle between normals in radians.
+    /// \param curvature_threshold Maximum curvature of growing points.
+    /// \param min_cluster_size Minimum number of points of a cluster.
+    /// \param max_cluster_size Maximum number of points of a cluster.
+    /// \return Returns the point labels and the per-cluster statistics.
+    std::tuple<utility::device_vector<int>, std::shared_ptr<ClusterStatistics>>
+    ClusterRegionGrowing(
+            const NeighborList &neighbors,
+            const utility::device_vector<float> &curvatures,
+            float angle_threshold,
+            float curvature_threshold,
+            size_t min_cluster_size = 1,
+            size_t max_cluster_size = std::numeric_limits<int>::max()) const;
+
     /// \brief Segment PointCloud plane using the RANSAC algorithm.
     ///
     /// \param distance_threshold Max distance a point can be from the plane
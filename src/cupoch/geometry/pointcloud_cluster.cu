@@ -18,9 +18,16 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  **/
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/scatter.h>
+
+#include "cupoch/geometry/cluster_statistics.h"
+#include "cupoch/geometry/geometry_functor.h"
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/neighbor_list.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
 
 using namespace cupoch;
 using namespace cupoch::geometry;
@@ -99,6 +106,149 @@ struct set_label_functor {
     }
 };
 
+// Hooks the components of connected points onto the smaller root index.
+// If normals are given, points are only connected when their normals
+// deviate less than the angle threshold. Inactive points are not connected.
+struct propagate_min_label_csr_functor {
+    propagate_min_label_csr_functor(const int *offsets,
+                                    const int *indices,
+                                    const Eigen::Vector3f *normals,
+                                    const bool *active,
+                                    float cos_threshold,
+                                    int *labels,
+                                    int *changed)
+        : offsets_(offsets),
+          indices_(indices),
+          normals_(normals),
+          active_(active),
+          cos_threshold_(cos_threshold),
+          labels_(labels),
+          changed_(changed){};
+    const int *offsets_;
+    const int *indices_;
+    const Eigen::Vector3f *normals_;
+    const bool *active_;
+    const float cos_threshold_;
+    int *labels_;
+    int *changed_;
+    __device__ bool IsConnected(int i, int j) const {
+        if (i == j) return false;
+        if (active_ && !active_[j]) return false;
+        return !normals_ ||
+               abs(normals_[i].dot(normals_[j])) >= cos_threshold_;
+    }
+    __device__ void operator()(size_t idx) {
+        if (active_ && !active_[idx]) return;
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = indices_[k];
+            if (IsConnected(idx, j)) HookMinLabel(labels_, idx, j, changed_);
+        }
+    }
+};
+
+// Assigns an inactive point to the region of the adjacent active point with
+// the most similar normal.
+struct attach_inactive_points_functor {
+    attach_inactive_points_functor(const int *offsets,
+                                   const int *indices,
+                                   const Eigen::Vector3f *normals,
+                                   const bool *active,
+                                   float cos_threshold,
+                                   const int *labels)
+        : offsets_(offsets),
+          indices_(indices),
+          normals_(normals),
+          active_(active),
+          cos_threshold_(cos_threshold),
+          labels_(labels){};
+    const int *offsets_;
+    const int *indices_;
+    const Eigen::Vector3f *normals_;
+    const bool *active_;
+    const float cos_threshold_;
+    const int *labels_;
+    __device__ int operator()(size_t idx) const {
+        if (active_[idx]) return labels_[idx];
+        int label = idx;
+        float best = cos_threshold_;
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = indices_[k];
+            if (!active_[j]) continue;
+            const float c = abs(normals_[idx].dot(normals_[j]));
+            if (c >= best) {
+                best = c;
+                label = labels_[j];
+            }
+        }
+        return label;
+    }
+};
+
+utility::device_vector<int> ConnectNeighbors(const NeighborList &neighbors,
+                                             const Eigen::Vector3f *normals,
+                                             const bool *active,
+                                             float cos_threshold) {
+    const size_t n_pt = neighbors.Size();
+    utility::device_vector<int> labels(n_pt);
+    thrust::sequence(labels.begin(), labels.end(), 0);
+    utility::device_vector<int> changed(1, 1);
+    propagate_min_label_csr_functor prop_func(
+            thrust::raw_pointer_cast(neighbors.offsets_.data()),
+            thrust::raw_pointer_cast(neighbors.indices_.data()), normals,
+            active, cos_threshold, thrust::raw_pointer_cast(labels.data()),
+            thrust::raw_pointer_cast(changed.data()));
+    pointer_jumping_functor jump_func(thrust::raw_pointer_cast(labels.data()));
+    while (changed[0] != 0) {
+        changed[0] = 0;
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt), prop_func);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt), jump_func);
+    }
+    return labels;
+}
+
+// Relabels the components given by their root indices to consecutive cluster
+// labels ordered by the root index, and drops the clusters out of the size
+// range. Returns the number of clusters.
+int CompactClusterLabels(utility::device_vector<int> &labels,
+                         size_t min_cluster_size,
+                         size_t max_cluster_size) {
+    const size_t n_pt = labels.size();
+    utility::device_vector<int> sorted_labels = labels;
+    thrust::sort(utility::exec_policy(0)->on(0), sorted_labels.begin(),
+                 sorted_labels.end());
+    utility::device_vector<int> roots(n_pt);
+    utility::device_vector<int> sizes(n_pt);
+    auto end = thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), sorted_labels.begin(),
+            sorted_labels.end(), thrust::make_constant_iterator<int>(1),
+            roots.begin(), sizes.begin());
+    const size_t n_roots = thrust::distance(roots.begin(), end.first);
+    utility::device_vector<int> valid(n_roots);
+    thrust::transform(sizes.begin(), sizes.begin() + n_roots, valid.begin(),
+                      [min_cluster_size, max_cluster_size] __device__(
+                              int size) {
+                          return (int)((size_t)size >= min_cluster_size &&
+                                       (size_t)size <= max_cluster_size);
+                      });
+    utility::device_vector<int> cluster_ids(n_roots);
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0), valid.begin(),
+                           valid.end(), cluster_ids.begin());
+    utility::device_vector<int> root_to_cluster(n_pt, -1);
+    thrust::scatter_if(cluster_ids.begin(), cluster_ids.end(), roots.begin(),
+                       valid.begin(), root_to_cluster.begin());
+    const int *root_to_cluster_ptr =
+            thrust::raw_pointer_cast(root_to_cluster.data());
+    thrust::transform(labels.begin(), labels.end(), labels.begin(),
+                      [root_to_cluster_ptr] __device__(int label) {
+                          return (label >= 0) ? root_to_cluster_ptr[label]
+                                              : -1;
+                      });
+    if (n_roots == 0) return 0;
+    return cluster_ids[n_roots - 1] + valid[n_roots - 1];
+}
+
 }  // namespace
 
 // https://www.sciencedirect.com/science/article/pii/S1877050913003438
@@ -172,4 +322,80 @@ utility::device_vector<int> PointCloud::ClusterDBSCAN(float eps,
         }
     }
     return clusters;
-}
\ No newline at end of file
+}
+
+std::tuple<utility::device_vector<int>, std::shared_ptr<ClusterStatistics>>
+PointCloud::ClusterEuclidean(float tolerance,
+                             size_t min_cluster_size,
+                             size_t max_cluster_size,
+                             size_t max_edges) const {
+    if (tolerance <= 0) {
+        utility::LogError("[ClusterEuclidean] tolerance <= 0.");
+        return std::make_tuple(utility::device_vector<int>(),
+                               std::make_shared<ClusterStatistics>());
+    }
+    if (points_.empty()) {
+        return std::make_tuple(utility::device_vector<int>(),
+                               std::make_shared<ClusterStatistics>());
+    }
+    auto neighbors = NeighborList::CreateFromPointCloud(
+            *this, KDTreeSearchParamRadius(tolerance, max_edges + 1));
+    auto labels = ConnectNeighbors(*neighbors, nullptr, nullptr, 0.0);
+    const int n_clusters =
+            CompactClusterLabels(labels, min_cluster_size, max_cluster_size);
+    auto stats = ClusterStatistics::CreateFromLabels(*this, labels, n_clusters);
+    return std::make_tuple(std::move(labels), stats);
+}
+
+std::tuple<utility::device_vector<int>, std::shared_ptr<ClusterStatistics>>
+PointCloud::ClusterRegionGrowing(
+        const NeighborList &neighbors,
+        const utility::device_vector<float> &curvatures,
+        float angle_threshold,
+        float curvature_threshold,
+        size_t min_cluster_size,
+        size_t max_cluster_size) const {
+    if (!HasNormals()) {
+        utility::LogError(
+                "[ClusterRegionGrowing] No normals in the PointCloud.");
+        return std::make_tuple(utility::device_vector<int>(),
+                               std::make_shared<ClusterStatistics>());
+    }
+    if (neighbors.Size() != points_.size() ||
+        curvatures.size() != points_.size()) {
+        utility::LogError(
+                "[ClusterRegionGrowing] The sizes of the neighbor lists and "
+                "curvatures do not match the number of points.");
+        return std::make_tuple(utility::device_vector<int>(),
+                               std::make_shared<ClusterStatistics>());
+    }
+    if (points_.empty()) {
+        return std::make_tuple(utility::device_vector<int>(),
+                               std::make_shared<ClusterStatistics>());
+    }
+    const float cos_threshold = std::cos(angle_threshold);
+    utility::device_vector<bool> active(points_.size());
+    thrust::transform(curvatures.begin(), curvatures.end(), active.begin(),
+                      [curvature_threshold] __device__(float curvature) {
+                          return curvature < curvature_threshold;
+                      });
+    auto labels = ConnectNeighbors(neighbors,
+                                   thrust::raw_pointer_cast(normals_.data()),
+                                   thrust::raw_pointer_cast(active.data()),
+                                   cos_threshold);
+    attach_inactive_points_functor func(
+            thrust::raw_pointer_cast(neighbors.offsets_.data()),
+            thrust::raw_pointer_cast(neighbors.indices_.data()),
+            thrust::raw_pointer_cast(normals_.data()),
+            thrust::raw_pointer_cast(active.data()), cos_threshold,
+            thrust::raw_pointer_cast(labels.data()));
+    utility::device_vector<int> attached(points_.size());
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(points_.size()),
+                      attached.begin(), func);
+    const int n_clusters =
+            CompactClusterLabels(attached, min_cluster_size, max_cluster_size);
+    auto stats =
+            ClusterStatistics::CreateFromLabels(*this, attached, n_clusters);
+    return std::make_tuple(std::move(attached), stats);
+}
@@ -0,0 +1,551 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/iterator/discard_iterator.h>
+
+#include "cupoch/geometry/neighbor_list.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/eigenvalue.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/range.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+/// Local surface estimated by moving least squares around a point.
+/// The surface is the height function
+/// f(u, v) = c0 + c1 u + c2 v + c3 u^2 + c4 u v + c5 v^2
+/// along normal_ over the tangent frame (u_axis_, v_axis_) at origin_.
+struct MLSSurface {
+    __host__ __device__ MLSSurface()
+        : origin_(Eigen::Vector3f::Zero()),
+          u_axis_(Eigen::Vector3f::UnitX()),
+          v_axis_(Eigen::Vector3f::UnitY()),
+          normal_(Eigen::Vector3f::UnitZ()),
+          coeffs_(Eigen::Matrix<float, 6, 1>::Zero()),
+          query_uv_(Eigen::Vector2f::Zero()),
+          valid_(false){};
+    Eigen::Vector3f origin_;
+    Eigen::Vector3f u_axis_;
+    Eigen::Vector3f v_axis_;
+    Eigen::Vector3f normal_;
+    Eigen::Matrix<float, 6, 1> coeffs_;
+    Eigen::Vector2f query_uv_;
+    bool valid_;
+
+    __device__ Eigen::Vector3f Position(float u, float v) const {
+        const float h = coeffs_[0] + coeffs_[1] * u + coeffs_[2] * v +
+                        coeffs_[3] * u * u + coeffs_[4] * u * v +
+                        coeffs_[5] * v * v;
+        return origin_ + u * u_axis_ + v * v_axis_ + h * normal_;
+    }
+
+    __device__ Eigen::Vector3f Normal(float u, float v) const {
+        const float fu = coeffs_[1] + 2.0f * coeffs_[3] * u + coeffs_[4] * v;
+        const float fv = coeffs_[2] + coeffs_[4] * u + 2.0f * coeffs_[5] * v;
+        return (normal_ - fu * u_axis_ - fv * v_axis_).normalized();
+    }
+};
+
+template <int N>
+__device__ bool SolveCholesky(Eigen::Matrix<float, N, N> A,
+                              Eigen::Matrix<float, N, 1> &x) {
+#pragma unroll
+    for (int j = 0; j < N; ++j) {
+        float d = A(j, j);
+        for (int k = 0; k < j; ++k) d -= A(j, k) * A(j, k);
+        if (d <= 1.0e-12f) return false;
+        d = sqrtf(d);
+        A(j, j) = d;
+        for (int i = j + 1; i < N; ++i) {
+            float s = A(i, j);
+            for (int k = 0; k < j; ++k) s -= A(i, k) * A(j, k);
+            A(i, j) = s / d;
+        }
+    }
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+        float s = x[i];
+        for (int k = 0; k < i; ++k) s -= A(i, k) * x[k];
+        x[i] = s / A(i, i);
+    }
+#pragma unroll
+    for (int i = N - 1; i >= 0; --i) {
+        float s = x[i];
+        for (int k = i + 1; k < N; ++k) s -= A(k, i) * x[k];
+        x[i] = s / A(i, i);
+    }
+    return true;
+}
+
+struct compute_mls_surface_functor {
+    compute_mls_surface_functor(const Eigen::Vector3f *points,
+                                const int *offsets,
+                                const int *indices,
+                                float sqr_gauss_param,
+                                int polynomial_order)
+        : points_(points),
+          offsets_(offsets),
+          indices_(indices),
+          sqr_gauss_param_(sqr_gauss_param),
+          polynomial_order_(polynomial_order){};
+    const Eigen::Vector3f *points_;
+    const int *offsets_;
+    const int *indices_;
+    const float sqr_gauss_param_;
+    const int polynomial_order_;
+    __device__ MLSSurface operator()(size_t idx) const {
+        MLSSurface surf;
+        const Eigen::Vector3f query = points_[idx];
+        surf.origin_ = query;
+        const int begin = offsets_[idx];
+        const int end = offsets_[idx + 1];
+        if (end - begin < 3) return surf;
+
+        float total_weight = 0.0f;
+        Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+        for (int k = begin; k < end; ++k) {
+            const Eigen::Vector3f p = points_[__ldg(&indices_[k])];
+            const float w = expf(-(p - query).squaredNorm() / sqr_gauss_param_);
+            mean += w * p;
+            total_weight += w;
+        }
+        if (total_weight <= 0.0f) return surf;
+        mean /= total_weight;
+        Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+        for (int k = begin; k < end; ++k) {
+            const Eigen::Vector3f p = points_[__ldg(&indices_[k])];
+            const float w = expf(-(p - query).squaredNorm() / sqr_gauss_param_);
+            const Eigen::Vector3f d = p - mean;
+            covariance += w * d * d.transpose();
+        }
+        covariance /= total_weight;
+        const auto evecs = utility::FastEigen3x3(covariance);
+        const Eigen::Vector3f normal = thrust::get<0>(evecs);
+        if (normal.norm() == 0.0f) return surf;
+        surf.origin_ = mean;
+        surf.normal_ = normal;
+        surf.u_axis_ = thrust::get<1>(evecs);
+        surf.v_axis_ = normal.cross(surf.u_axis_);
+        const Eigen::Vector3f dq = query - mean;
+        surf.query_uv_ = Eigen::Vector2f(dq.dot(surf.u_axis_),
+                                         dq.dot(surf.v_axis_));
+        surf.valid_ = true;
+        if (polynomial_order_ < 2 || end - begin < 6) return surf;
+
+        Eigen::Matrix<float, 6, 6> A = Eigen::Matrix<float, 6, 6>::Zero();
+        Eigen::Matrix<float, 6, 1> b = Eigen::Matrix<float, 6, 1>::Zero();
+        for (int k = begin; k < end; ++k) {
+            const Eigen::Vector3f p = points_[__ldg(&indices_[k])];
+            const float w = expf(-(p - query).squaredNorm() / sqr_gauss_param_);
+            const Eigen::Vector3f d = p - mean;
+            const float u = d.dot(surf.u_axis_);
+            const float v = d.dot(surf.v_axis_);
+            Eigen::Matrix<float, 6, 1> r;
+            r << 1.0f, u, v, u * u, u * v, v * v;
+            A += w * r * r.transpose();
+            b += w * d.dot(normal) * r;
+        }
+        if (SolveCholesky<6>(A, b)) surf.coeffs_ = b;
+        return surf;
+    }
+};
+
+struct sample_mls_surface_functor {
+    sample_mls_surface_functor(const MLSSurface *surfaces,
+                               const Eigen::Vector3f *points,
+                               const Eigen::Vector3f *normals,
+                               int n_grid,
+                               float step,
+                               float radius,
+                               bool has_normal)
+        : surfaces_(surfaces),
+          points_(points),
+          normals_(normals),
+          n_grid_(n_grid),
+          step_(step),
+          radius_(radius),
+          has_normal_(has_normal){};
+    const MLSSurface *surfaces_;
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3f *normals_;
+    const int n_grid_;
+    const float step_;
+    const float radius_;
+    const bool has_normal_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator()(
+            size_t idx) const {
+        const int n_samples = n_grid_ * n_grid_;
+        const int i = idx / n_samples;
+        const int s = idx % n_samples;
+        const int half = n_grid_ / 2;
+        const float du = (s / n_grid_ - half) * step_;
+        const float dv = (s % n_grid_ - half) * step_;
+        const MLSSurface &surf = surfaces_[i];
+        if (!surf.valid_) {
+            if (s != half * n_grid_ + half) {
+                return thrust::make_tuple(
+                        Eigen::Vector3f::Constant(
+                                std::numeric_limits<float>::quiet_NaN()),
+                        Eigen::Vector3f::Zero());
+            }
+            return thrust::make_tuple(points_[i],
+                                      has_normal_ ? normals_[i]
+                                                  : Eigen::Vector3f::UnitZ());
+        }
+        if (du * du + dv * dv > radius_ * radius_) {
+            return thrust::make_tuple(
+                    Eigen::Vector3f::Constant(
+                            std::numeric_limits<float>::quiet_NaN()),
+                    Eigen::Vector3f::Zero());
+        }
+        const float u = surf.query_uv_[0] + du;
+        const float v = surf.query_uv_[1] + dv;
+        Eigen::Vector3f normal = surf.Normal(u, v);
+        if (has_normal_ && normal.dot(normals_[i]) < 0.0f) normal *= -1.0f;
+        return thrust::make_tuple(surf.Position(u, v), normal);
+    }
+};
+
+struct bilateral_normal_filter_functor {
+    bilateral_normal_filter_functor(const Eigen::Vector3f *points,
+                                    const Eigen::Vector3f *normals,
+                                    const int *offsets,
+                                    const int *indices,
+                                    float sigma_s,
+                                    float sigma_n)
+        : points_(points),
+          normals_(normals),
+          offsets_(offsets),
+          indices_(indices),
+          inv_sigma_s2_(1.0f / (sigma_s * sigma_s)),
+          inv_sigma_n2_(1.0f / (sigma_n * sigma_n)){};
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3f *normals_;
+    const int *offsets_;
+    const int *indices_;
+    const float inv_sigma_s2_;
+    const float inv_sigma_n2_;
+    __device__ Eigen::Vector3f operator()(size_t idx) const {
+        const Eigen::Vector3f pi = points_[idx];
+        const Eigen::Vector3f ni = normals_[idx];
+        Eigen::Vector3f res = Eigen::Vector3f::Zero();
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = __ldg(&indices_[k]);
+            Eigen::Vector3f nj = normals_[j];
+            if (ni.dot(nj) < 0.0f) nj = -nj;
+            const float dn = 1.0f - ni.dot(nj);
+            const float w =
+                    expf(-0.5f * (pi - points_[j]).squaredNorm() *
+                                 inv_sigma_s2_ -
+                         0.5f * dn * dn * inv_sigma_n2_);
+            res += w * nj;
+        }
+        const float norm = res.norm();
+        return (norm > 0.0f) ? Eigen::Vector3f(res / norm) : ni;
+    }
+};
+
+// Moves each point along its normal by the bilateral-weighted average of the
+// neighbors' heights above the tangent plane, which smooths noise while
+// preserving sharp features (Fleishman et al., "Bilateral Mesh Denoising").
+struct bilateral_point_filter_functor {
+    bilateral_point_filter_functor(const Eigen::Vector3f *points,
+                                   const Eigen::Vector3f *normals,
+                                   const int *offsets,
+                                   const int *indices,
+                                   float sigma_s,
+                                   float sigma_r)
+        : points_(points),
+          normals_(normals),
+          offsets_(offsets),
+          indices_(indices),
+          inv_sigma_s2_(1.0f / (sigma_s * sigma_s)),
+          inv_sigma_r2_(1.0f / (sigma_r * sigma_r)){};
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3f *normals_;
+    const int *offsets_;
+    const int *indices_;
+    const float inv_sigma_s2_;
+    const float inv_sigma_r2_;
+    __device__ Eigen::Vector3f operator()(size_t idx) const {
+        const Eigen::Vector3f pi = points_[idx];
+        const Eigen::Vector3f ni = normals_[idx];
+        float sum = 0.0f;
+        float total_weight = 0.0f;
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const Eigen::Vector3f d = points_[__ldg(&indices_[k])] - pi;
+            const float h = ni.dot(d);
+            const float w = expf(-0.5f * d.squaredNorm() * inv_sigma_s2_ -
+                                 0.5f * h * h * inv_sigma_r2_);
+            sum += w * h;
+            total_weight += w;
+        }
+        if (total_weight <= 0.0f) return pi;
+        return pi + ni * (sum / total_weight);
+    }
+};
+
+struct gaussian_filter_csr_functor {
+    gaussian_filter_csr_functor(const Eigen::Vector3f *points,
+                                const Eigen::Vector3f *normals,
+                                const Eigen::Vector3f *colors,
+                                const int *offsets,
+                                const int *indices,
+                                float sigma2,
+                                bool has_normal,
+                                bool has_color)
+        : points_(points),
+          normals_(normals),
+          colors_(colors),
+          offsets_(offsets),
+          indices_(indices),
+          sigma2_(sigma2),
+          has_normal_(has_normal),
+          has_color_(has_color){};
+    const Eigen::Vector3f *points_;
+    const Eigen::Vector3f *normals_;
+    const Eigen::Vector3f *colors_;
+    const int *offsets_;
+    const int *indices_;
+    const float sigma2_;
+    const bool has_normal_;
+    const bool has_color_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>
+    operator()(size_t idx) const {
+        const Eigen::Vector3f pi = points_[idx];
+        float total_weight = 0.0;
+        Eigen::Vector3f res_p = Eigen::Vector3f::Zero();
+        Eigen::Vector3f res_n = Eigen::Vector3f::Zero();
+        Eigen::Vector3f res_c = Eigen::Vector3f::Zero();
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = __ldg(&indices_[k]);
+            const float weight =
+                    exp(-0.5 * (points_[j] - pi).squaredNorm() / sigma2_);
+            res_p += weight * points_[j];
+            if (has_normal_) res_n += weight * normals_[j];
+            if (has_color_) res_c += weight * colors_[j];
+            total_weight += weight;
+        }
+        if (total_weight <= 0.0) {
+            return thrust::make_tuple(
+                    pi, has_normal_ ? normals_[idx] : res_n,
+                    has_color_ ? colors_[idx] : res_c);
+        }
+        res_p /= total_weight;
+        res_n /= total_weight;
+        res_c /= total_weight;
+        return thrust::make_tuple(res_p, res_n, res_c);
+    }
+};
+
+bool CheckNeighborList(const PointCloud &pcd,
+                       const NeighborList &neighbors,
+                       const char *name) {
+    if (neighbors.Size() != pcd.points_.size()) {
+        utility::LogError(
+                "[{}] The neighbor list does not match the point cloud.", name);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::shared_ptr<PointCloud> PointCloud::GaussianFilter(
+        const NeighborList &neighbors, float sigma2) const {
+    auto out = std::make_shared<PointCloud>();
+    if (sigma2 <= 0) {
+        utility::LogError(
+                "[GaussianFilter] Illegal input parameters, sigma2 must be "
+                "positive.");
+        return out;
+    }
+    if (!CheckNeighborList(*this, neighbors, "GaussianFilter")) return out;
+    const bool has_normal = HasNormals();
+    const bool has_color = HasColors();
+    const size_t n_pt = points_.size();
+    out->points_.resize(n_pt);
+    if (has_normal) out->normals_.resize(n_pt);
+    if (has_color) out->colors_.resize(n_pt);
+    gaussian_filter_csr_functor func(
+            thrust::raw_pointer_cast(points_.data()),
+            thrust::raw_pointer_cast(normals_.data()),
+            thrust::raw_pointer_cast(colors_.data()),
+            thrust::raw_pointer_cast(neighbors.offsets_.data()),
+            thrust::raw_pointer_cast(neighbors.indices_.data()), sigma2,
+            has_normal, has_color);
+    if (has_normal && has_color) {
+        thrust::transform(
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator(n_pt),
+                make_tuple_begin(out->points_, out->normals_, out->colors_),
+                func);
+    } else if (has_normal) {
+        thrust::transform(
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator(n_pt),
+                make_tuple_iterator(out->points_.begin(), out->normals_.begin(),
+                                    thrust::make_discard_iterator()),
+                func);
+    } else if (has_color) {
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n_pt),
+                          make_tuple_iterator(out->points_.begin(),
+                                              thrust::make_discard_iterator(),
+                                              out->colors_.begin()),
+                          func);
+    } else {
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n_pt),
+                          make_tuple_iterator(out->points_.begin(),
+                                              thrust::make_discard_iterator(),
+                                              thrust::make_discard_iterator()),
+                          func);
+    }
+    return out;
+}
+
+std::shared_ptr<PointCloud> PointCloud::SmoothMLS(
+        const NeighborList &neighbors,
+        float search_radius,
+        int polynomial_order,
+        float upsampling_radius,
+        float upsampling_step) const {
+    auto out = std::make_shared<PointCloud>();
+    if (search_radius <= 0 || polynomial_order < 1 || polynomial_order > 2) {
+        utility::LogError(
+                "[SmoothMLS] Illegal input parameters, radius must be "
+                "positive and polynomial order must be 1 or 2.");
+        return out;
+    }
+    if (!CheckNeighborList(*this, neighbors, "SmoothMLS")) return out;
+    const bool upsampling = upsampling_radius > 0 && upsampling_step > 0;
+    const int n_grid =
+            (upsampling) ? 2 * int(upsampling_radius / upsampling_step) + 1
+                         : 1;
+    const size_t n_pt = points_.size();
+    utility::device_vector<MLSSurface> surfaces(n_pt);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt), surfaces.begin(),
+                      compute_mls_surface_functor(
+                              thrust::raw_pointer_cast(points_.data()),
+                              thrust::raw_pointer_cast(
+                                      neighbors.offsets_.data()),
+                              thrust::raw_pointer_cast(
+                                      neighbors.indices_.data()),
+                              search_radius * search_radius,
+                              polynomial_order));
+    const size_t n_samples = n_grid * n_grid;
+    const bool has_normal = HasNormals();
+    resize_all(n_pt * n_samples, out->points_, out->normals_);
+    sample_mls_surface_functor func(
+            thrust::raw_pointer_cast(surfaces.data()),
+            thrust::raw_pointer_cast(points_.data()),
+            thrust::raw_pointer_cast(normals_.data()), n_grid,
+            upsampling_step, (upsampling) ? upsampling_radius : 0.0f,
+            has_normal);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt * n_samples),
+                      make_tuple_begin(out->points_, out->normals_), func);
+    if (HasColors()) {
+        out->colors_.resize(n_pt * n_samples);
+        thrust::repeated_range<
+                utility::device_vector<Eigen::Vector3f>::const_iterator>
+                range(colors_.begin(), colors_.end(), n_samples);
+        thrust::copy(range.begin(), range.end(), out->colors_.begin());
+    }
+    if (upsampling) out->RemoveNoneFinitePoints(true, false);
+    return out;
+}
+
+std::shared_ptr<PointCloud> PointCloud::BilateralFilterNormals(
+        const NeighborList &neighbors,
+        float sigma_s,
+        float sigma_n,
+        int num_iterations) const {
+    auto out = std::make_shared<PointCloud>(*this);
+    if (!HasNormals()) {
+        utility::LogWarning(
+                "[BilateralFilterNormals] No normals in the PointCloud. Call "
+                "EstimateNormals() first.");
+        return out;
+    }
+    if (sigma_s <= 0 || sigma_n <= 0) {
+        utility::LogError(
+                "[BilateralFilterNormals] Illegal input parameters, sigmas "
+                "must be positive.");
+        return out;
+    }
+    if (!CheckNeighborList(*this, neighbors, "BilateralFilterNormals"))
+        return out;
+    utility::device_vector<Eigen::Vector3f> normals(normals_.size());
+    for (int i = 0; i < num_iterations; ++i) {
+        bilateral_normal_filter_functor func(
+                thrust::raw_pointer_cast(out->points_.data()),
+                thrust::raw_pointer_cast(out->normals_.data()),
+                thrust::raw_pointer_cast(neighbors.offsets_.data()),
+                thrust::raw_pointer_cast(neighbors.indices_.data()), sigma_s,
+                sigma_n);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(normals.size()),
+                          normals.begin(), func);
+        out->normals_.swap(normals);
+    }
+    return out;
+}
+
+std::shared_ptr<PointCloud> PointCloud::BilateralFilter(
+        const NeighborList &neighbors,
+        float sigma_s,
+        float sigma_r,
+        int num_iterations) const {
+    auto out = std::make_shared<PointCloud>(*this);
+    if (!HasNormals()) {
+        utility::LogWarning(
+                "[BilateralFilter] No normals in the PointCloud. Call "
+                "EstimateNormals() first.");
+        return out;
+    }
+    if (sigma_s <= 0 || sigma_r <= 0) {
+        utility::LogError(
+                "[BilateralFilter] Illegal input parameters, sigmas must be "
+                "positive.");
+        return out;
+    }
+    if (!CheckNeighborList(*this, neighbors, "BilateralFilter")) return out;
+    utility::device_vector<Eigen::Vector3f> points(points_.size());
+    for (int i = 0; i < num_iterations; ++i) {
+        bilateral_point_filter_functor func(
+                thrust::raw_pointer_cast(out->points_.data()),
+                thrust::raw_pointer_cast(out->normals_.data()),
+                thrust::raw_pointer_cast(neighbors.offsets_.data()),
+                thrust::raw_pointer_cast(neighbors.indices_.data()), sigma_s,
+                sigma_r);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(points.size()),
+                          points.begin(), func);
+        out->points_.swap(points);
+    }
+    return out;
+}
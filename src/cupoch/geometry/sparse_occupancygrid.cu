@@ -0,0 +1,526 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <stdgpu/unordered_map.cuh>
+
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/sparse_occupancygrid.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/platform.h"
+
+namespace cupoch {
+namespace geometry {
+
+typedef stdgpu::unordered_map<Eigen::Vector3i,
+                              int,
+                              utility::hash_eigen<Eigen::Vector3i>>
+        OccupancyBlockMap;
+class SparseOccupancyGrid::BlockMapImpl {
+public:
+    OccupancyBlockMap blocks_;
+    size_t capacity_ = 0;
+};
+
+namespace {
+
+__device__ int FloorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+__device__ Eigen::Vector3i BlockOf(const Eigen::Vector3i& voxel) {
+    return Eigen::Vector3i(FloorDiv(voxel[0], OCCUPANCY_BLOCK_RESOLUTION),
+                           FloorDiv(voxel[1], OCCUPANCY_BLOCK_RESOLUTION),
+                           FloorDiv(voxel[2], OCCUPANCY_BLOCK_RESOLUTION));
+}
+
+__device__ int OffsetInBlock(const Eigen::Vector3i& voxel,
+                             const Eigen::Vector3i& block) {
+    return IndexOf(voxel - block * OCCUPANCY_BLOCK_RESOLUTION,
+                   OCCUPANCY_BLOCK_RESOLUTION);
+}
+
+__global__ void InsertBlocksKernel(const Eigen::Vector3i* keys,
+                                   int n,
+                                   int slot_offset,
+                                   OccupancyBlockMap blocks) {
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (idx >= n) return;
+    blocks.emplace(keys[idx], slot_offset + idx);
+}
+
+struct is_out_of_range_functor {
+    is_out_of_range_functor(int resolution) : resolution_(resolution){};
+    const int resolution_;
+    __device__ bool operator()(const Eigen::Vector3i& voxel) const {
+        return voxel[0] < 0 || voxel[1] < 0 || voxel[2] < 0 ||
+               voxel[0] >= resolution_ || voxel[1] >= resolution_ ||
+               voxel[2] >= resolution_;
+    }
+};
+
+struct compute_block_key_functor {
+    __device__ Eigen::Vector3i operator()(const Eigen::Vector3i& voxel) const {
+        return BlockOf(voxel);
+    }
+};
+
+struct is_allocated_block_functor {
+    is_allocated_block_functor(const OccupancyBlockMap& blocks)
+        : blocks_(blocks){};
+    const OccupancyBlockMap blocks_;
+    __device__ bool operator()(const Eigen::Vector3i& key) const {
+        return blocks_.contains(key);
+    }
+};
+
+struct initialize_block_voxels_functor {
+    initialize_block_voxels_functor(const Eigen::Vector3i* block_keys,
+                                    size_t slot_offset)
+        : block_keys_(block_keys), slot_offset_(slot_offset){};
+    const Eigen::Vector3i* block_keys_;
+    const size_t slot_offset_;
+    __device__ OccupancyVoxel operator()(size_t idx) const {
+        const size_t slot = slot_offset_ + idx / OCCUPANCY_BLOCK_VOXEL_NUM;
+        auto local = KeyOf(idx % OCCUPANCY_BLOCK_VOXEL_NUM,
+                           OCCUPANCY_BLOCK_RESOLUTION);
+        Eigen::Vector3i gidx =
+                block_keys_[slot] * OCCUPANCY_BLOCK_RESOLUTION +
+                Eigen::Vector3i(thrust::get<0>(local), thrust::get<1>(local),
+                                thrust::get<2>(local));
+        return OccupancyVoxel(gidx);
+    }
+};
+
+struct add_sparse_occupancy_functor {
+    add_sparse_occupancy_functor(const OccupancyBlockMap& blocks,
+                                 OccupancyVoxel* voxels,
+                                 float clamping_thres_min,
+                                 float clamping_thres_max,
+                                 float prob_miss_log,
+                                 float prob_hit_log,
+                                 bool occupied)
+        : blocks_(blocks),
+          voxels_(voxels),
+          clamping_thres_min_(clamping_thres_min),
+          clamping_thres_max_(clamping_thres_max),
+          prob_miss_log_(prob_miss_log),
+          prob_hit_log_(prob_hit_log),
+          occupied_(occupied){};
+    const OccupancyBlockMap blocks_;
+    OccupancyVoxel* voxels_;
+    const float clamping_thres_min_;
+    const float clamping_thres_max_;
+    const float prob_miss_log_;
+    const float prob_hit_log_;
+    const bool occupied_;
+    __device__ void operator()(const Eigen::Vector3i& voxel) {
+        const Eigen::Vector3i block = BlockOf(voxel);
+        auto itr = blocks_.find(block);
+        if (itr == blocks_.end()) return;
+        OccupancyVoxel& v =
+                voxels_[itr->second * OCCUPANCY_BLOCK_VOXEL_NUM +
+                        OffsetInBlock(voxel, block)];
+        float p = v.prob_log_;
+        p = (isnan(p)) ? 0 : p;
+        p += (occupied_) ? prob_hit_log_ : prob_miss_log_;
+        v.prob_log_ = min(max(p, clamping_thres_min_), clamping_thres_max_);
+    }
+};
+
+struct get_sparse_voxel_functor {
+    get_sparse_voxel_functor(const OccupancyBlockMap& blocks,
+                             const OccupancyVoxel* voxels,
+                             float voxel_size,
+                             int resolution,
+                             const Eigen::Vector3f& origin)
+        : blocks_(blocks),
+          voxels_(voxels),
+          voxel_size_(voxel_size),
+          resolution_(resolution),
+          origin_(origin){};
+    const OccupancyBlockMap blocks_;
+    const OccupancyVoxel* voxels_;
+    const float voxel_size_;
+    const int resolution_;
+    const Eigen::Vector3f origin_;
+    __device__ OccupancyVoxel operator()(const Eigen::Vector3f& point) const {
+        Eigen::Vector3f ref_coord = (point - origin_) / voxel_size_;
+        Eigen::Vector3i voxel =
+                Eigen::device_vectorize<float, 3, ::floor>(ref_coord)
+                        .cast<int>() +
+                Eigen::Vector3i::Constant(resolution_ / 2);
+        if (voxel[0] < 0 || voxel[1] < 0 || voxel[2] < 0 ||
+            voxel[0] >= resolution_ || voxel[1] >= resolution_ ||
+            voxel[2] >= resolution_) {
+            return OccupancyVoxel();
+        }
+        const Eigen::Vector3i block = BlockOf(voxel);
+        auto itr = blocks_.find(block);
+        if (itr == blocks_.end()) return OccupancyVoxel(voxel);
+        return voxels_[itr->second * OCCUPANCY_BLOCK_VOXEL_NUM +
+                       OffsetInBlock(voxel, block)];
+    }
+};
+
+}  // namespace
+
+SparseOccupancyGrid::SparseOccupancyGrid()
+    : SparseOccupancyGrid(0.05, Eigen::Vector3f::Zero()) {}
+SparseOccupancyGrid::SparseOccupancyGrid(float voxel_size,
+                                         const Eigen::Vector3f& origin,
+                                         int block_capacity)
+    : GeometryBase3D(Geometry::GeometryType::SparseOccupancyGrid),
+      voxel_size_(voxel_size),
+      origin_(origin),
+      min_bound_(Eigen::Vector3ui16::Constant(resolution_ / 2)),
+      max_bound_(Eigen::Vector3ui16::Constant(resolution_ / 2)) {
+    impl_ = std::make_shared<BlockMapImpl>();
+    impl_->capacity_ = std::max(block_capacity, 1);
+    impl_->blocks_ = OccupancyBlockMap::createDeviceObject(impl_->capacity_);
+}
+SparseOccupancyGrid::~SparseOccupancyGrid() {
+    OccupancyBlockMap::destroyDeviceObject(impl_->blocks_);
+}
+SparseOccupancyGrid::SparseOccupancyGrid(const SparseOccupancyGrid& other)
+    : GeometryBase3D(Geometry::GeometryType::SparseOccupancyGrid),
+      voxel_size_(other.voxel_size_),
+      resolution_(other.resolution_),
+      origin_(other.origin_),
+      voxels_(other.voxels_),
+      block_keys_(other.block_keys_),
+      num_blocks_(other.num_blocks_),
+      min_bound_(other.min_bound_),
+      max_bound_(other.max_bound_),
+      clamping_thres_min_(other.clamping_thres_min_),
+      clamping_thres_max_(other.clamping_thres_max_),
+      prob_hit_log_(other.prob_hit_log_),
+      prob_miss_log_(other.prob_miss_log_),
+      occ_prob_thres_log_(other.occ_prob_thres_log_),
+      visualize_free_area_(other.visualize_free_area_) {
+    impl_ = std::make_shared<BlockMapImpl>();
+    CreateBlockMap(other.impl_->capacity_);
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::operator=(
+        const SparseOccupancyGrid& other) {
+    if (this == &other) return *this;
+    voxel_size_ = other.voxel_size_;
+    resolution_ = other.resolution_;
+    origin_ = other.origin_;
+    voxels_ = other.voxels_;
+    block_keys_ = other.block_keys_;
+    num_blocks_ = other.num_blocks_;
+    min_bound_ = other.min_bound_;
+    max_bound_ = other.max_bound_;
+    clamping_thres_min_ = other.clamping_thres_min_;
+    clamping_thres_max_ = other.clamping_thres_max_;
+    prob_hit_log_ = other.prob_hit_log_;
+    prob_miss_log_ = other.prob_miss_log_;
+    occ_prob_thres_log_ = other.occ_prob_thres_log_;
+    visualize_free_area_ = other.visualize_free_area_;
+    OccupancyBlockMap::destroyDeviceObject(impl_->blocks_);
+    CreateBlockMap(other.impl_->capacity_);
+    return *this;
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Clear() {
+    impl_->blocks_.clear();
+    voxels_.clear();
+    block_keys_.clear();
+    num_blocks_ = 0;
+    min_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
+    max_bound_ = Eigen::Vector3ui16::Constant(resolution_ / 2);
+    return *this;
+}
+
+bool SparseOccupancyGrid::IsEmpty() const { return !HasVoxels(); }
+
+Eigen::Vector3f SparseOccupancyGrid::GetMinBound() const {
+    return (min_bound_.cast<int>() - Eigen::Vector3i::Constant(resolution_ / 2))
+                           .cast<float>() *
+                   voxel_size_ +
+           origin_;
+}
+
+Eigen::Vector3f SparseOccupancyGrid::GetMaxBound() const {
+    return (max_bound_.cast<int>() -
+            Eigen::Vector3i::Constant(resolution_ / 2 - 1))
+                           .cast<float>() *
+                   voxel_size_ +
+           origin_;
+}
+
+Eigen::Vector3f SparseOccupancyGrid::GetCenter() const {
+    return 0.5 * (GetMinBound() + GetMaxBound());
+}
+
+AxisAlignedBoundingBox<3> SparseOccupancyGrid::GetAxisAlignedBoundingBox()
+        const {
+    AxisAlignedBoundingBox<3> box;
+    box.min_bound_ = GetMinBound();
+    box.max_bound_ = GetMaxBound();
+    return box;
+}
+
+OrientedBoundingBox SparseOccupancyGrid::GetOrientedBoundingBox() const {
+    return OrientedBoundingBox::CreateFromAxisAlignedBoundingBox(
+            GetAxisAlignedBoundingBox());
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Transform(
+        const Eigen::Matrix4f& transformation) {
+    utility::LogError("SparseOccupancyGrid::Transform is not supported");
+    return *this;
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Translate(
+        const Eigen::Vector3f& translation, bool relative) {
+    origin_ += translation;
+    return *this;
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Scale(const float scale,
+                                                bool center) {
+    voxel_size_ *= scale;
+    return *this;
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Rotate(const Eigen::Matrix3f& R,
+                                                 bool center) {
+    utility::LogError("SparseOccupancyGrid::Rotate is not supported");
+    return *this;
+}
+
+size_t SparseOccupancyGrid::BlockCapacity() const { return impl_->capacity_; }
+
+bool SparseOccupancyGrid::IsOccupied(const Eigen::Vector3f& point) const {
+    OccupancyVoxel voxel = thrust::get<1>(GetVoxel(point));
+    return !std::isnan(voxel.prob_log_) &&
+           voxel.prob_log_ > occ_prob_thres_log_;
+}
+
+bool SparseOccupancyGrid::IsUnknown(const Eigen::Vector3f& point) const {
+    return !thrust::get<0>(GetVoxel(point));
+}
+
+thrust::tuple<bool, OccupancyVoxel> SparseOccupancyGrid::GetVoxel(
+        const Eigen::Vector3f& point) const {
+    utility::device_vector<Eigen::Vector3f> points(1, point);
+    OccupancyVoxel voxel = GetVoxels(points)[0];
+    return thrust::make_tuple(!std::isnan(voxel.prob_log_), voxel);
+}
+
+utility::device_vector<OccupancyVoxel> SparseOccupancyGrid::GetVoxels(
+        const utility::device_vector<Eigen::Vector3f>& points) const {
+    utility::device_vector<OccupancyVoxel> out(points.size());
+    get_sparse_voxel_functor func(impl_->blocks_,
+                                  thrust::raw_pointer_cast(voxels_.data()),
+                                  voxel_size_, resolution_, origin_);
+    thrust::transform(points.begin(), points.end(), out.begin(), func);
+    return out;
+}
+
+template <typename Func>
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+SparseOccupancyGrid::ExtractVoxels(Func check_func) const {
+    auto out = std::make_shared<utility::device_vector<OccupancyVoxel>>(
+            voxels_.size());
+    auto end = thrust::copy_if(voxels_.begin(), voxels_.end(), out->begin(),
+                               check_func);
+    out->resize(thrust::distance(out->begin(), end));
+    return out;
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+SparseOccupancyGrid::ExtractKnownVoxels() const {
+    auto check_fn = [] __device__(const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_);
+    };
+    return ExtractVoxels(check_fn);
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+SparseOccupancyGrid::ExtractFreeVoxels() const {
+    auto check_fn = [th = occ_prob_thres_log_] __device__(
+                            const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_) && v.prob_log_ <= th;
+    };
+    return ExtractVoxels(check_fn);
+}
+
+std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+SparseOccupancyGrid::ExtractOccupiedVoxels() const {
+    auto check_fn = [th = occ_prob_thres_log_] __device__(
+                            const OccupancyVoxel& v) {
+        return !isnan(v.prob_log_) && v.prob_log_ > th;
+    };
+    return ExtractVoxels(check_fn);
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Insert(
+        const utility::device_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    if (points.empty()) return *this;
+
+    utility::device_vector<Eigen::Vector3i> free_voxels;
+    utility::device_vector<Eigen::Vector3i> occupied_voxels;
+    ComputeInsertedVoxels(points, viewpoint, max_range, voxel_size_,
+                          resolution_, origin_, free_voxels, occupied_voxels);
+    AddVoxels(free_voxels, false);
+    AddVoxels(occupied_voxels, true);
+    return *this;
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Insert(
+        const utility::pinned_host_vector<Eigen::Vector3f>& points,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    utility::device_vector<Eigen::Vector3f> dev_points(points.size());
+    cudaSafeCall(cudaMemcpy(
+            thrust::raw_pointer_cast(dev_points.data()), points.data(),
+            points.size() * sizeof(Eigen::Vector3f), cudaMemcpyHostToDevice));
+    return Insert(dev_points, viewpoint, max_range);
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::Insert(
+        const geometry::PointCloud& pointcloud,
+        const Eigen::Vector3f& viewpoint,
+        float max_range) {
+    return Insert(pointcloud.points_, viewpoint, max_range);
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::AddVoxel(const Eigen::Vector3i& voxel,
+                                                   bool occupied) {
+    if ((voxel.array() < 0).any() || (voxel.array() >= resolution_).any()) {
+        utility::LogError(
+                "[SparseOccupancyGrid] a provided voxel is not occupancy grid "
+                "range.");
+        return *this;
+    }
+    utility::device_vector<Eigen::Vector3i> voxels(1, voxel);
+    return AddVoxels(voxels, occupied);
+}
+
+SparseOccupancyGrid& SparseOccupancyGrid::AddVoxels(
+        const utility::device_vector<Eigen::Vector3i>& input, bool occupied) {
+    if (input.empty()) return *this;
+    // Voxels out of the grid range are dropped, so that the block keys and
+    // the bounds stay valid.
+    const size_t n_out =
+            thrust::count_if(input.begin(), input.end(),
+                             is_out_of_range_functor(resolution_));
+    utility::device_vector<Eigen::Vector3i> ranged;
+    if (n_out > 0) {
+        utility::LogWarning(
+                "[SparseOccupancyGrid] {:d} voxels out of the grid range are "
+                "ignored.",
+                (int)n_out);
+        ranged.resize(input.size() - n_out);
+        thrust::remove_copy_if(input.begin(), input.end(), ranged.begin(),
+                               is_out_of_range_functor(resolution_));
+        if (ranged.empty()) return *this;
+    }
+    const utility::device_vector<Eigen::Vector3i>& voxels =
+            (n_out > 0) ? ranged : input;
+    const bool was_empty = !HasVoxels();
+    AllocateBlocks(voxels);
+    Eigen::Vector3i vmin = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Constant(resolution_ - 1).eval(),
+            thrust::elementwise_minimum<Eigen::Vector3i>());
+    Eigen::Vector3i vmax = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels.begin(), voxels.end(),
+            Eigen::Vector3i::Zero().eval(),
+            thrust::elementwise_maximum<Eigen::Vector3i>());
+    if (was_empty) {
+        min_bound_ = vmin.cast<unsigned short>();
+        max_bound_ = vmax.cast<unsigned short>();
+    } else {
+        min_bound_ = min_bound_.array().min(
+                vmin.cast<unsigned short>().array());
+        max_bound_ = max_bound_.array().max(
+                vmax.cast<unsigned short>().array());
+    }
+    add_sparse_occupancy_functor func(
+            impl_->blocks_, thrust::raw_pointer_cast(voxels_.data()),
+            clamping_thres_min_, clamping_thres_max_, prob_miss_log_,
+            prob_hit_log_, occupied);
+    thrust::for_each(voxels.begin(), voxels.end(), func);
+    return *this;
+}
+
+void SparseOccupancyGrid::AllocateBlocks(
+        const utility::device_vector<Eigen::Vector3i>& voxels) {
+    utility::device_vector<Eigen::Vector3i> keys(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), keys.begin(),
+                      compute_block_key_functor());
+    thrust::sort(utility::exec_policy(0)->on(0), keys.begin(), keys.end());
+    auto end1 = thrust::unique(utility::exec_policy(0)->on(0), keys.begin(),
+                               keys.end());
+    keys.resize(thrust::distance(keys.begin(), end1));
+    auto end2 = thrust::remove_if(keys.begin(), keys.end(),
+                                  is_allocated_block_functor(impl_->blocks_));
+    keys.resize(thrust::distance(keys.begin(), end2));
+    const size_t n_new = keys.size();
+    if (n_new == 0) return;
+
+    Reserve(num_blocks_ + n_new);
+    const dim3 threads(32);
+    const dim3 blocks((n_new + threads.x - 1) / threads.x);
+    InsertBlocksKernel<<<blocks, threads>>>(
+            thrust::raw_pointer_cast(keys.data()), n_new, num_blocks_,
+            impl_->blocks_);
+    cudaSafeCall(cudaDeviceSynchronize());
+    block_keys_.insert(block_keys_.end(), keys.begin(), keys.end());
+    voxels_.resize((num_blocks_ + n_new) * OCCUPANCY_BLOCK_VOXEL_NUM);
+    initialize_block_voxels_functor func(
+            thrust::raw_pointer_cast(block_keys_.data()), num_blocks_);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator<size_t>(
+                              n_new * OCCUPANCY_BLOCK_VOXEL_NUM),
+                      voxels_.begin() + num_blocks_ * OCCUPANCY_BLOCK_VOXEL_NUM,
+                      func);
+    num_blocks_ += n_new;
+}
+
+void SparseOccupancyGrid::Reserve(size_t n_blocks) {
+    if (n_blocks <= impl_->capacity_) return;
+    size_t capacity = std::max(n_blocks, 2 * impl_->capacity_);
+    OccupancyBlockMap::destroyDeviceObject(impl_->blocks_);
+    CreateBlockMap(capacity);
+}
+
+void SparseOccupancyGrid::CreateBlockMap(size_t capacity) {
+    impl_->blocks_ = OccupancyBlockMap::createDeviceObject(capacity);
+    impl_->capacity_ = capacity;
+    if (num_blocks_ == 0) return;
+    const dim3 threads(32);
+    const dim3 blocks((num_blocks_ + threads.x - 1) / threads.x);
+    InsertBlocksKernel<<<blocks, threads>>>(
+            thrust::raw_pointer_cast(block_keys_.data()), num_blocks_, 0,
+            impl_->blocks_);
+    cudaSafeCall(cudaDeviceSynchronize());
+}
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+#include <thrust/tuple.h>
+
+#include "cupoch/geometry/geometry_base.h"
+#include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/utility/device_vector.h"
+#include "cupoch/utility/eigen.h"
+
+namespace cupoch {
+
+namespace geometry {
+class PointCloud;
+class VoxelGrid;
+class OrientedBoundingBox;
+
+/// \class SparseOccupancyGrid
+///
+/// \brief Occupancy grid whose voxels are allocated on demand.
+///
+/// Voxels are grouped into blocks of 8x8x8 voxels which are allocated in a
+/// device hash map the first time a ray touches them, so that the memory
+/// scales with the observed space instead of the bounding volume. The voxel
+/// indices follow the same convention as OccupancyGrid with a fixed virtual
+/// resolution of 65536, i.e. the map covers 65536 voxels along each axis
+/// around \p origin_ (about 3.3 km at 5 cm). The limit comes from the 16-bit
+/// grid_index_ of OccupancyVoxel shared with OccupancyGrid; voxels and
+/// points beyond it are ignored.
+class SparseOccupancyGrid : public GeometryBase3D {
+public:
+    SparseOccupancyGrid();
+    SparseOccupancyGrid(float voxel_size,
+                        const Eigen::Vector3f& origin = Eigen::Vector3f::Zero(),
+                        int block_capacity = 4096);
+    ~SparseOccupancyGrid();
+    SparseOccupancyGrid(const SparseOccupancyGrid& other);
+    SparseOccupancyGrid& operator=(const SparseOccupancyGrid& other);
+
+    SparseOccupancyGrid& Clear() override;
+    bool IsEmpty() const override;
+    Eigen::Vector3f GetMinBound() const override;
+    Eigen::Vector3f GetMaxBound() const override;
+    Eigen::Vector3f GetCenter() const override;
+    AxisAlignedBoundingBox<3> GetAxisAlignedBoundingBox() const override;
+    OrientedBoundingBox GetOrientedBoundingBox() const;
+    SparseOccupancyGrid& Transform(
+            const Eigen::Matrix4f& transformation) override;
+    SparseOccupancyGrid& Translate(const Eigen::Vector3f& translation,
+                                   bool relative = true) override;
+    SparseOccupancyGrid& Scale(const float scale, bool center = true) override;
+    SparseOccupancyGrid& Rotate(const Eigen::Matrix3f& R,
+                                bool center = true) override;
+
+    bool HasVoxels() const { return num_blocks_ > 0; }
+    bool HasColors() const {
+        return true;  // By default, the colors are (1.0, 1.0, 1.0)
+    }
+    /// Returns the number of allocated blocks.
+    size_t NumBlocks() const { return num_blocks_; }
+    /// Returns the number of blocks which can be allocated without growing
+    /// the hash map.
+    size_t BlockCapacity() const;
+
+    bool IsOccupied(const Eigen::Vector3f& point) const;
+    bool IsUnknown(const Eigen::Vector3f& point) const;
+    thrust::tuple<bool, OccupancyVoxel> GetVoxel(
+            const Eigen::Vector3f& point) const;
+    /// Batched version of GetVoxel. Voxels of unallocated blocks are returned
+    /// as unknown voxels.
+    utility::device_vector<OccupancyVoxel> GetVoxels(
+            const utility::device_vector<Eigen::Vector3f>& points) const;
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractKnownVoxels()
+            const;
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractFreeVoxels()
+            const;
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>>
+    ExtractOccupiedVoxels() const;
+
+    SparseOccupancyGrid& Insert(
+            const utility::device_vector<Eigen::Vector3f>& points,
+            const Eigen::Vector3f& viewpoint,
+            float max_range = -1.0);
+    SparseOccupancyGrid& Insert(
+            const utility::pinned_host_vector<Eigen::Vector3f>& points,
+            const Eigen::Vector3f& viewpoint,
+            float max_range = -1.0);
+    SparseOccupancyGrid& Insert(const PointCloud& pointcloud,
+                                const Eigen::Vector3f& viewpoint,
+                                float max_range = -1.0);
+
+    SparseOccupancyGrid& AddVoxel(const Eigen::Vector3i& voxel,
+                                  bool occupied = false);
+    /// Voxels out of [0, resolution_) are ignored with a warning.
+    SparseOccupancyGrid& AddVoxels(
+            const utility::device_vector<Eigen::Vector3i>& voxels,
+            bool occupied = false);
+
+    static std::shared_ptr<SparseOccupancyGrid> CreateFromVoxelGrid(
+            const VoxelGrid& input);
+
+private:
+    void AllocateBlocks(const utility::device_vector<Eigen::Vector3i>& voxels);
+    void Reserve(size_t n_blocks);
+    /// Creates a hash map of \p capacity blocks holding the allocated blocks.
+    void CreateBlockMap(size_t capacity);
+    template <typename Func>
+    std::shared_ptr<utility::device_vector<OccupancyVoxel>> ExtractVoxels(
+            Func func) const;
+
+public:
+    float voxel_size_ = 0.05;
+    int resolution_ = 65536;
+    Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    /// Voxel pool. The voxels of the i-th allocated block are stored in
+    /// [i * OCCUPANCY_BLOCK_VOXEL_NUM, (i + 1) * OCCUPANCY_BLOCK_VOXEL_NUM).
+    utility::device_vector<OccupancyVoxel> voxels_;
+    /// Block index of each slot in the voxel pool.
+    utility::device_vector<Eigen::Vector3i> block_keys_;
+    /// Hash map from the block index to the slot in the voxel pool.
+    class BlockMapImpl;
+    std::shared_ptr<BlockMapImpl> impl_;
+    size_t num_blocks_ = 0;
+
+    Eigen::Vector3ui16 min_bound_ = Eigen::Vector3ui16::Zero();
+    Eigen::Vector3ui16 max_bound_ = Eigen::Vector3ui16::Zero();
+    float clamping_thres_min_ = -2.0f;
+    float clamping_thres_max_ = 3.5f;
+    float prob_hit_log_ = 0.85f;
+    float prob_miss_log_ = -0.4f;
+    float occ_prob_thres_log_ = 0.0f;
+    bool visualize_free_area_ = true;
+};
+
+}  // namespace geometry
+
+}  // namespace cupoch
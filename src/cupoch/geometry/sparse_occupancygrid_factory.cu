@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+
+#include "cupoch/geometry/sparse_occupancygrid.h"
+#include "cupoch/geometry/voxelgrid.h"
+
+namespace cupoch {
+namespace geometry {
+
+namespace {
+
+struct shift_voxelgrid_key_functor {
+    shift_voxelgrid_key_functor(int resolution) : resolution_(resolution){};
+    const int resolution_;
+    __device__ Eigen::Vector3i operator()(const Eigen::Vector3i& key) const {
+        return key + Eigen::Vector3i::Constant(resolution_ / 2);
+    }
+};
+
+}  // namespace
+
+std::shared_ptr<SparseOccupancyGrid> SparseOccupancyGrid::CreateFromVoxelGrid(
+        const VoxelGrid& input) {
+    if (input.voxel_size_ <= 0.0) {
+        utility::LogError("[CreateFromVoxelGrid] voxel grid  voxel_size <= 0.");
+        return std::make_shared<SparseOccupancyGrid>();
+    }
+    auto output = std::make_shared<SparseOccupancyGrid>(input.voxel_size_,
+                                                        input.origin_);
+    utility::device_vector<Eigen::Vector3i> voxels(input.voxels_keys_.size());
+    thrust::transform(input.voxels_keys_.begin(), input.voxels_keys_.end(),
+                      voxels.begin(),
+                      shift_voxelgrid_key_functor(output->resolution_));
+    auto end = thrust::remove_if(
+            voxels.begin(), voxels.end(),
+            [res = output->resolution_] __device__(const Eigen::Vector3i& v) {
+                return v[0] < 0 || v[1] < 0 || v[2] < 0 || v[0] >= res ||
+                       v[1] >= res || v[2] >= res;
+            });
+    voxels.resize(thrust::distance(voxels.begin(), end));
+    output->AddVoxels(voxels, true);
+    return output;
+}
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -327,6 +327,77 @@ struct check_self_intersecting_triangles {
     }
 };
 
+/// Quadric of the plane of the triangle of a corner, keyed by the cluster of
+/// the corner vertex.
+struct compute_corner_quadric_functor {
+    compute_corner_quadric_functor(const Eigen::Vector3f *vertices,
+                                   const Eigen::Vector3i *triangles,
+                                   const int *clusters)
+        : vertices_(vertices), triangles_(triangles), clusters_(clusters){};
+    const Eigen::Vector3f *vertices_;
+    const Eigen::Vector3i *triangles_;
+    const int *clusters_;
+    __device__ thrust::tuple<int, Eigen::Matrix4f> operator()(
+            size_t idx) const {
+        const Eigen::Vector3i &tri = triangles_[idx / 3];
+        const Eigen::Vector3f &v0 = vertices_[tri[0]];
+        Eigen::Vector3f n =
+                (vertices_[tri[1]] - v0).cross(vertices_[tri[2]] - v0);
+        const float norm = n.norm();
+        Eigen::Matrix4f q = Eigen::Matrix4f::Zero();
+        if (norm > 0.0f) {
+            n /= norm;
+            const Eigen::Vector4f plane(n[0], n[1], n[2], -n.dot(v0));
+            q = plane * plane.transpose();
+        }
+        return thrust::make_tuple(clusters_[tri[idx % 3]], q);
+    }
+};
+
+/// Moves a cluster vertex to the minimizer of its quadric error. The average
+/// position is kept if the quadric is singular or the minimizer is farther
+/// than a cell from it.
+struct contract_quadric_functor {
+    contract_quadric_functor(const int *clusters,
+                             const Eigen::Matrix4f *quadrics,
+                             float voxel_size,
+                             Eigen::Vector3f *vertices)
+        : clusters_(clusters),
+          quadrics_(quadrics),
+          voxel_size_(voxel_size),
+          vertices_(vertices){};
+    const int *clusters_;
+    const Eigen::Matrix4f *quadrics_;
+    const float voxel_size_;
+    Eigen::Vector3f *vertices_;
+    __device__ void operator()(size_t idx) {
+        const Eigen::Matrix4f &q = quadrics_[idx];
+        const Eigen::Matrix3f a = q.block<3, 3>(0, 0);
+        if (abs(a.determinant()) < 1.0e-6) return;
+        const Eigen::Vector3f x = -(a.inverse() * q.block<3, 1>(0, 3));
+        Eigen::Vector3f &v = vertices_[clusters_[idx]];
+        if ((x - v).norm() <= voxel_size_) v = x;
+    }
+};
+
+/// Averages \p src over the vertices of each cluster. \p clusters are the
+/// sorted cluster indices of the vertices \p order.
+void AverageByCluster(const utility::device_vector<int> &clusters,
+                      const utility::device_vector<int> &order,
+                      const utility::device_vector<int> &counts,
+                      const utility::device_vector<Eigen::Vector3f> &src,
+                      utility::device_vector<Eigen::Vector3f> &dst) {
+    dst.resize(counts.size());
+    thrust::reduce_by_key(
+            utility::exec_policy(0)->on(0), clusters.begin(), clusters.end(),
+            thrust::make_permutation_iterator(src.begin(), order.begin()),
+            thrust::make_discard_iterator(), dst.begin());
+    thrust::transform(dst.begin(), dst.end(), counts.begin(), dst.begin(),
+                      [] __device__(const Eigen::Vector3f &sum, int count) {
+                          return (sum / count).eval();
+                      });
+}
+
 }  // namespace
 
 TriangleMesh::TriangleMesh() : MeshBase(Geometry::GeometryType::TriangleMesh) {}
@@ -869,6 +940,120 @@ std::shared_ptr<TriangleMesh> TriangleMesh::FilterSmoothTaubin(
     return mesh;
 }
 
+std::shared_ptr<TriangleMesh> TriangleMesh::SimplifyVertexClustering(
+        float voxel_size, SimplificationContraction contraction) const {
+    auto mesh = std::make_shared<TriangleMesh>();
+    if (voxel_size <= 0.0) {
+        utility::LogError("[SimplifyVertexClustering] voxel_size <= 0.");
+        return mesh;
+    }
+    if (!HasVertices()) return mesh;
+
+    // sort the vertices by the cell containing them
+    const size_t n_vertices = vertices_.size();
+    const Eigen::Vector3f voxel_min_bound =
+            GetMinBound() - Eigen::Vector3f::Constant(voxel_size * 0.5);
+    utility::device_vector<Eigen::Vector3i> cells(n_vertices);
+    thrust::transform(
+            vertices_.begin(), vertices_.end(), cells.begin(),
+            [voxel_min_bound, voxel_size] __device__(const Eigen::Vector3f &v) {
+                const Eigen::Vector3f p = (v - voxel_min_bound) / voxel_size;
+                return Eigen::Vector3i((int)floorf(p[0]), (int)floorf(p[1]),
+                                       (int)floorf(p[2]));
+            });
+    utility::device_vector<int> order(n_vertices);
+    thrust::sequence(order.begin(), order.end());
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), cells.begin(),
+                        cells.end(), order.begin());
+
+    // number the cells and map the vertices to them
+    utility::device_vector<int> clusters(n_vertices);
+    const Eigen::Vector3i *cells_ptr = thrust::raw_pointer_cast(cells.data());
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_vertices),
+                      clusters.begin(), [cells_ptr] __device__(size_t i) {
+                          return (i > 0 && cells_ptr[i] != cells_ptr[i - 1])
+                                         ? 1
+                                         : 0;
+                      });
+    thrust::inclusive_scan(utility::exec_policy(0)->on(0), clusters.begin(),
+                           clusters.end(), clusters.begin());
+    const int n_clusters = clusters.back() + 1;
+    utility::device_vector<int> index_old_to_new(n_vertices);
+    thrust::scatter(clusters.begin(), clusters.end(), order.begin(),
+                    index_old_to_new.begin());
+    utility::device_vector<int> counts(n_clusters);
+    thrust::reduce_by_key(utility::exec_policy(0)->on(0), clusters.begin(),
+                          clusters.end(),
+                          thrust::make_constant_iterator<int>(1),
+                          thrust::make_discard_iterator(), counts.begin());
+
+    AverageByCluster(clusters, order, counts, vertices_, mesh->vertices_);
+    if (HasVertexNormals()) {
+        AverageByCluster(clusters, order, counts, vertex_normals_,
+                         mesh->vertex_normals_);
+        mesh->NormalizeNormals();
+    }
+    if (HasVertexColors()) {
+        AverageByCluster(clusters, order, counts, vertex_colors_,
+                         mesh->vertex_colors_);
+    }
+
+    if (contraction == SimplificationContraction::Quadric && HasTriangles()) {
+        const size_t n_corners = triangles_.size() * 3;
+        utility::device_vector<int> corner_clusters(n_corners);
+        utility::device_vector<Eigen::Matrix4f> corner_quadrics(n_corners);
+        compute_corner_quadric_functor func1(
+                thrust::raw_pointer_cast(vertices_.data()),
+                thrust::raw_pointer_cast(triangles_.data()),
+                thrust::raw_pointer_cast(index_old_to_new.data()));
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n_corners),
+                          make_tuple_begin(corner_clusters, corner_quadrics),
+                          func1);
+        thrust::sort_by_key(utility::exec_policy(0)->on(0),
+                            corner_clusters.begin(), corner_clusters.end(),
+                            corner_quadrics.begin());
+        utility::device_vector<int> quadric_clusters(n_clusters);
+        utility::device_vector<Eigen::Matrix4f> quadrics(n_clusters);
+        auto end = thrust::reduce_by_key(
+                utility::exec_policy(0)->on(0), corner_clusters.begin(),
+                corner_clusters.end(), corner_quadrics.begin(),
+                quadric_clusters.begin(), quadrics.begin());
+        const size_t n_quadrics =
+                thrust::distance(quadric_clusters.begin(), end.first);
+        contract_quadric_functor func2(
+                thrust::raw_pointer_cast(quadric_clusters.data()),
+                thrust::raw_pointer_cast(quadrics.data()), voxel_size,
+                thrust::raw_pointer_cast(mesh->vertices_.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_quadrics), func2);
+    }
+
+    mesh->triangles_.resize(triangles_.size());
+    const int *index_old_to_new_ptr =
+            thrust::raw_pointer_cast(index_old_to_new.data());
+    thrust::transform(triangles_.begin(), triangles_.end(),
+                      mesh->triangles_.begin(),
+                      [index_old_to_new_ptr] __device__(
+                              const Eigen::Vector3i &tri) {
+                          return Eigen::Vector3i(index_old_to_new_ptr[tri[0]],
+                                                 index_old_to_new_ptr[tri[1]],
+                                                 index_old_to_new_ptr[tri[2]]);
+                      });
+    mesh->RemoveDegenerateTriangles();
+    mesh->RemoveDuplicatedTriangles();
+    mesh->RemoveUnreferencedVertices();
+    if (HasTriangleNormals()) {
+        mesh->ComputeTriangleNormals();
+    }
+    utility::LogDebug(
+            "[SimplifyVertexClustering] {:d} vertices have been merged into "
+            "{:d}.",
+            (int)n_vertices, (int)mesh->vertices_.size());
+    return mesh;
+}
+
 float TriangleMesh::GetSurfaceArea() const {
     const Eigen::Vector3f *vert_pt = thrust::raw_pointer_cast(vertices_.data());
     const Eigen::Vector3i *tri_pt = thrust::raw_pointer_cast(triangles_.data());
@@ -970,6 +1155,70 @@ std::shared_ptr<PointCloud> TriangleMesh::SamplePointsUniformly(
                                      surface_area, use_triangle_normal);
 }
 
+std::shared_ptr<PointCloud> TriangleMesh::SamplePointsPoissonDisk(
+        size_t number_of_points,
+        float init_factor /* = 5 */,
+        bool use_triangle_normal /* = false */,
+        int seed /* = 0 */) {
+    if (number_of_points <= 0) {
+        utility::LogError("[SamplePointsPoissonDisk] number_of_points <= 0");
+        return std::make_shared<PointCloud>();
+    }
+    if (triangles_.size() == 0) {
+        utility::LogError(
+                "[SamplePointsPoissonDisk] input mesh has no triangles");
+        throw std::runtime_error("input mesh has no triangles");
+    }
+    if (init_factor < 1) {
+        utility::LogError("[SamplePointsPoissonDisk] init_factor < 1");
+        return std::make_shared<PointCloud>();
+    }
+
+    utility::device_vector<float> triangle_areas;
+    float surface_area = GetSurfaceArea(triangle_areas);
+    auto pcl = SamplePointsUniformlyImpl(
+            size_t(init_factor * number_of_points), triangle_areas,
+            surface_area, use_triangle_normal);
+    if (pcl->points_.size() <= number_of_points) return pcl;
+
+    // Bisect the sampling radius between zero and the distance of the
+    // densest (hexagonal) packing of number_of_points points on the surface.
+    float min_radius = 0.0;
+    float max_radius = std::sqrt(2.0 * surface_area /
+                                 (std::sqrt(3.0) * number_of_points));
+    auto sampled = pcl;
+    for (int i = 0; i < 10; ++i) {
+        const float radius = 0.5 * (min_radius + max_radius);
+        auto candidate = pcl->PoissonDiskDownSample(radius, seed);
+        if (candidate->points_.size() >= number_of_points) {
+            sampled = candidate;
+            min_radius = radius;
+        } else {
+            max_radius = radius;
+        }
+    }
+    if (sampled->points_.size() == number_of_points) return sampled;
+
+    // Drop the surplus points at random.
+    const size_t n_sampled = sampled->points_.size();
+    utility::device_vector<unsigned int> priorities(n_sampled);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_sampled),
+                      priorities.begin(), [seed] __device__(size_t idx) {
+                          thrust::default_random_engine rng(seed);
+                          rng.discard(idx);
+                          return (unsigned int)rng();
+                      });
+    utility::device_vector<size_t> indices(n_sampled);
+    thrust::sequence(indices.begin(), indices.end());
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), priorities.begin(),
+                        priorities.end(), indices.begin());
+    indices.resize(number_of_points);
+    thrust::sort(utility::exec_policy(0)->on(0), indices.begin(),
+                 indices.end());
+    return sampled->SelectByIndex(indices);
+}
+
 TriangleMesh &TriangleMesh::RemoveDuplicatedVertices() {
     size_t old_vertex_num = vertices_.size();
     utility::device_vector<int> index_new_to_old(old_vertex_num);
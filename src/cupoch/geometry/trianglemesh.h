@@ -164,6 +164,21 @@ public:
             float mu = -0.53,
             FilterScope scope = FilterScope::All) const;
 
+    /// \brief Function to simplify the mesh by vertex clustering.
+    ///
+    /// The vertices falling in the same cell of a grid of size \p voxel_size
+    /// are merged into one vertex, placed at their average position or at
+    /// the minimizer of the quadric error of the adjacent triangle planes
+    /// depending on \p contraction. The triangles which become degenerate or
+    /// duplicated are removed.
+    ///
+    /// \param voxel_size The size of the grid cells.
+    /// \param contraction The placement of the merged vertices.
+    std::shared_ptr<TriangleMesh> SimplifyVertexClustering(
+            float voxel_size,
+            SimplificationContraction contraction =
+                    SimplificationContraction::Average) const;
+
     /// Function to compute edge list, call before edge list is
     /// needed
     TriangleMesh &ComputeEdgeList();
@@ -192,6 +207,20 @@ public:
     std::shared_ptr<PointCloud> SamplePointsUniformly(
             size_t number_of_points, bool use_triangle_normal = false);
 
+    /// Function to sample \param number_of_points points evenly spread over
+    /// the mesh. The mesh is first sampled uniformly with \param init_factor
+    /// times \param number_of_points points, which are then thinned out by
+    /// Poisson-disk sampling with the largest radius that keeps at least
+    /// \param number_of_points points. \param use_triangle_normal Set to
+    /// true to assign the triangle normals to the returned points instead of
+    /// the interpolated vertex normals. \param seed Seed of the Poisson-disk
+    /// sampling and of the removal of the surplus points.
+    std::shared_ptr<PointCloud> SamplePointsPoissonDisk(
+            size_t number_of_points,
+            float init_factor = 5,
+            bool use_triangle_normal = false,
+            int seed = 0);
+
     /// Function that returns a list of triangles that are intersecting the
     /// mesh.
     utility::device_vector<Eigen::Vector2i> GetSelfIntersectingTriangles()
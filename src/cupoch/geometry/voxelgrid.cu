@@ -20,6 +20,8 @@
  **/
 #include <thrust/iterator/discard_iterator.h>
 
+#include <stdgpu/unordered_map.cuh>
+
 #include "cupoch/camera/pinhole_camera_parameters.h"
 #include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/geometry/geometry_functor.h"
@@ -30,8 +32,101 @@
 using namespace cupoch;
 using namespace cupoch::geometry;
 
+typedef stdgpu::unordered_map<Eigen::Vector3i,
+                              int,
+                              utility::hash_eigen<Eigen::Vector3i>>
+        VoxelIndexMap;
+class VoxelGrid::VoxelIndexImpl {
+public:
+    VoxelIndexImpl(size_t capacity)
+        : capacity_(capacity),
+          map_(VoxelIndexMap::createDeviceObject(capacity)) {}
+    ~VoxelIndexImpl() { VoxelIndexMap::destroyDeviceObject(map_); }
+    size_t capacity_;
+    VoxelIndexMap map_;
+    size_t size_ = 0;
+};
+
 namespace {
 
+__global__ void InsertVoxelIndicesKernel(const Eigen::Vector3i *keys,
+                                         int n,
+                                         int offset,
+                                         VoxelIndexMap map) {
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (idx >= n) return;
+    map.emplace(keys[offset + idx], offset + idx);
+}
+
+void InsertVoxelIndices(const utility::device_vector<Eigen::Vector3i> &keys,
+                        size_t offset,
+                        VoxelIndexMap &map) {
+    const size_t n = keys.size() - offset;
+    if (n == 0) return;
+    const dim3 threads(32);
+    const dim3 blocks((n + threads.x - 1) / threads.x);
+    InsertVoxelIndicesKernel<<<blocks, threads>>>(
+            thrust::raw_pointer_cast(keys.data()), n, offset, map);
+    cudaSafeCall(cudaDeviceSynchronize());
+}
+
+struct find_voxel_index_functor {
+    find_voxel_index_functor(const VoxelIndexMap &map) : map_(map){};
+    const VoxelIndexMap map_;
+    __device__ int operator()(const Eigen::Vector3i &key) const {
+        auto itr = map_.find(key);
+        return (itr == map_.end()) ? -1 : itr->second;
+    }
+};
+
+struct contains_voxel_functor {
+    contains_voxel_functor(const VoxelIndexMap &map) : map_(map){};
+    const VoxelIndexMap map_;
+    __device__ bool operator()(const Eigen::Vector3i &key) const {
+        return map_.contains(key);
+    }
+};
+
+struct compute_voxel_key_functor {
+    compute_voxel_key_functor(const Eigen::Vector3f &origin, float voxel_size)
+        : origin_(origin), voxel_size_(voxel_size){};
+    const Eigen::Vector3f origin_;
+    const float voxel_size_;
+    __device__ Eigen::Vector3i operator()(const Eigen::Vector3f &point) const {
+        Eigen::Vector3f voxel_f = (point - origin_) / voxel_size_;
+        return Eigen::device_vectorize<float, 3, ::floor>(voxel_f)
+                .cast<int>();
+    }
+};
+
+struct average_voxel_color_functor {
+    average_voxel_color_functor(Voxel *voxels) : voxels_(voxels){};
+    Voxel *voxels_;
+    __device__ void operator()(const thrust::tuple<int, Voxel> &x) const {
+        const int idx = thrust::get<0>(x);
+        if (idx < 0) return;
+        voxels_[idx].color_ =
+                0.5f * (voxels_[idx].color_ + thrust::get<1>(x).color_);
+    }
+};
+
+struct compute_voxel_morton_code_functor {
+    compute_voxel_morton_code_functor(const Eigen::Vector3i &min_key)
+        : min_key_(min_key){};
+    const Eigen::Vector3i min_key_;
+    __device__ uint64_t operator()(const Eigen::Vector3i &key) const {
+        return MortonCodeOf((key - min_key_).eval());
+    }
+};
+
+struct is_negative_functor {
+    __device__ bool operator()(int idx) const { return idx < 0; }
+};
+
+struct is_non_negative_functor {
+    __device__ bool operator()(int idx) const { return idx >= 0; }
+};
+
 struct extract_grid_index_functor {
     __device__ Eigen::Vector3i operator()(const Voxel &voxel) const {
         return voxel.grid_index_;
@@ -130,6 +225,15 @@ VoxelGrid::VoxelGrid(const VoxelGrid &src_voxel_grid)
       voxels_keys_(src_voxel_grid.voxels_keys_),
       voxels_values_(src_voxel_grid.voxels_values_) {}
 
+VoxelGrid &VoxelGrid::operator=(const VoxelGrid &src_voxel_grid) {
+    voxel_size_ = src_voxel_grid.voxel_size_;
+    origin_ = src_voxel_grid.origin_;
+    voxels_keys_ = src_voxel_grid.voxels_keys_;
+    voxels_values_ = src_voxel_grid.voxels_values_;
+    index_.reset();
+    return *this;
+}
+
 std::pair<thrust::host_vector<Eigen::Vector3i>, thrust::host_vector<Voxel>>
 VoxelGrid::GetVoxels() const {
     thrust::host_vector<Eigen::Vector3i> h_keys = voxels_keys_;
@@ -142,6 +246,7 @@ void VoxelGrid::SetVoxels(
         const thrust::host_vector<Voxel> &voxels_values) {
     voxels_keys_ = voxels_keys;
     voxels_values_ = voxels_values;
+    index_.reset();
 }
 
 VoxelGrid &VoxelGrid::Clear() {
@@ -149,6 +254,7 @@ VoxelGrid &VoxelGrid::Clear() {
     origin_ = Eigen::Vector3f::Zero();
     voxels_keys_.clear();
     voxels_values_.clear();
+    index_.reset();
     return *this;
 }
 
@@ -248,29 +354,25 @@ VoxelGrid &VoxelGrid::operator+=(const VoxelGrid &voxelgrid) {
                 "the other not.");
     }
     if (voxelgrid.HasColors()) {
-        voxels_keys_.insert(voxels_keys_.end(), voxelgrid.voxels_keys_.begin(),
-                            voxelgrid.voxels_keys_.end());
-        voxels_values_.insert(voxels_values_.end(),
-                              voxelgrid.voxels_values_.begin(),
-                              voxelgrid.voxels_values_.end());
-        thrust::sort_by_key(utility::exec_policy(0)->on(0),
-                            voxels_keys_.begin(), voxels_keys_.end(),
-                            voxels_values_.begin());
-        utility::device_vector<int> counts(voxels_keys_.size());
-        utility::device_vector<Eigen::Vector3i> new_keys(voxels_keys_.size());
-        auto end = thrust::reduce_by_key(
-                utility::exec_policy(0)->on(0), voxels_keys_.begin(),
-                voxels_keys_.end(),
-                make_tuple_iterator(voxels_values_.begin(),
-                                    thrust::make_constant_iterator(1)),
-                new_keys.begin(), make_tuple_begin(voxels_values_, counts),
-                thrust::equal_to<Eigen::Vector3i>(), add_voxel_color_functor());
-        resize_all(thrust::distance(new_keys.begin(), end.first), new_keys,
-                   voxels_values_);
-        thrust::swap(voxels_keys_, new_keys);
-        thrust::transform(voxels_values_.begin(), voxels_values_.end(),
-                          counts.begin(), voxels_values_.begin(),
-                          devide_voxel_color_functor());
+        // Voxels stored in both grids get the average color and the others
+        // are appended, so that the stored voxels keep their positions.
+        utility::device_vector<int> indices = Find(voxelgrid.voxels_keys_);
+        thrust::for_each(
+                make_tuple_begin(indices, voxelgrid.voxels_values_),
+                make_tuple_end(indices, voxelgrid.voxels_values_),
+                average_voxel_color_functor(
+                        thrust::raw_pointer_cast(voxels_values_.data())));
+        const size_t n_new = thrust::count_if(indices.begin(), indices.end(),
+                                              is_negative_functor());
+        utility::device_vector<Eigen::Vector3i> new_keys(n_new);
+        utility::device_vector<Voxel> new_values(n_new);
+        thrust::copy_if(make_tuple_begin(voxelgrid.voxels_keys_,
+                                         voxelgrid.voxels_values_),
+                        make_tuple_end(voxelgrid.voxels_keys_,
+                                       voxelgrid.voxels_values_),
+                        indices.begin(), make_tuple_begin(new_keys, new_values),
+                        is_negative_functor());
+        AppendVoxels(new_keys, new_values);
     } else {
         this->AddVoxels(voxelgrid.voxels_values_);
     }
@@ -291,6 +393,7 @@ void VoxelGrid::AddVoxel(const Voxel &voxel) {
                                      voxels_values_.begin());
     resize_all(thrust::distance(voxels_keys_.begin(), end.first), voxels_keys_,
                voxels_values_);
+    index_.reset();
 }
 
 void VoxelGrid::AddVoxels(const utility::device_vector<Voxel> &voxels) {
@@ -307,6 +410,7 @@ void VoxelGrid::AddVoxels(const utility::device_vector<Voxel> &voxels) {
                                      voxels_values_.begin());
     resize_all(thrust::distance(voxels_keys_.begin(), end.first), voxels_keys_,
                voxels_values_);
+    index_.reset();
 }
 
 void VoxelGrid::AddVoxels(const thrust::host_vector<Voxel> &voxels) {
@@ -338,10 +442,9 @@ Eigen::Vector3i VoxelGrid::GetVoxel(const Eigen::Vector3f &point) const {
 
 Eigen::Vector3f VoxelGrid::GetVoxelCenterCoordinate(
         const Eigen::Vector3i &idx) const {
-    auto it = thrust::find(voxels_keys_.begin(), voxels_keys_.end(), idx);
-    if (it != voxels_keys_.end()) {
-        Eigen::Vector3i voxel_idx = *it;
-        return ((voxel_idx.cast<float>() + Eigen::Vector3f(0.5, 0.5, 0.5)) *
+    utility::device_vector<Eigen::Vector3i> keys(1, idx);
+    if (Contains(keys)[0]) {
+        return ((idx.cast<float>() + Eigen::Vector3f(0.5, 0.5, 0.5)) *
                 voxel_size_) +
                origin_;
     } else {
@@ -360,17 +463,139 @@ std::array<Eigen::Vector3f, 8> VoxelGrid::GetVoxelBoundingPoints(
 
 thrust::host_vector<bool> VoxelGrid::CheckIfIncluded(
         const thrust::host_vector<Eigen::Vector3f> &queries) {
-    thrust::host_vector<bool> output;
-    output.resize(queries.size());
-    for (size_t i = 0; i < queries.size(); ++i) {
-        auto query = GetVoxel(queries[i]);
-        auto itr =
-                thrust::find(voxels_keys_.begin(), voxels_keys_.end(), query);
-        output[i] = (itr != voxels_keys_.end());
-    }
+    utility::device_vector<Eigen::Vector3f> queries_dev = queries;
+    utility::device_vector<bool> output = CheckIfIncluded(queries_dev);
+    thrust::host_vector<bool> h_output = output;
+    return h_output;
+}
+
+utility::device_vector<bool> VoxelGrid::CheckIfIncluded(
+        const utility::device_vector<Eigen::Vector3f> &queries) const {
+    utility::device_vector<bool> output(queries.size());
+    const VoxelIndexImpl &index = GetIndex();
+    compute_voxel_key_functor func(origin_, voxel_size_);
+    thrust::transform(utility::exec_policy(0)->on(0),
+                      thrust::make_transform_iterator(queries.begin(), func),
+                      thrust::make_transform_iterator(queries.end(), func),
+                      output.begin(), contains_voxel_functor(index.map_));
     return output;
 }
 
+utility::device_vector<bool> VoxelGrid::Contains(
+        const utility::device_vector<Eigen::Vector3i> &keys) const {
+    utility::device_vector<bool> output(keys.size());
+    const VoxelIndexImpl &index = GetIndex();
+    thrust::transform(utility::exec_policy(0)->on(0), keys.begin(), keys.end(),
+                      output.begin(), contains_voxel_functor(index.map_));
+    return output;
+}
+
+utility::device_vector<int> VoxelGrid::Find(
+        const utility::device_vector<Eigen::Vector3i> &keys) const {
+    utility::device_vector<int> output(keys.size());
+    const VoxelIndexImpl &index = GetIndex();
+    thrust::transform(utility::exec_policy(0)->on(0), keys.begin(), keys.end(),
+                      output.begin(), find_voxel_index_functor(index.map_));
+    return output;
+}
+
+VoxelGrid &VoxelGrid::Insert(const utility::device_vector<Voxel> &voxels) {
+    if (voxels.empty()) return *this;
+    utility::device_vector<Eigen::Vector3i> keys(voxels.size());
+    thrust::transform(voxels.begin(), voxels.end(), keys.begin(),
+                      extract_grid_index_functor());
+    utility::device_vector<Voxel> values = voxels;
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), keys.begin(),
+                        keys.end(), values.begin());
+    auto end = thrust::unique_by_key(utility::exec_policy(0)->on(0),
+                                     keys.begin(), keys.end(), values.begin());
+    resize_all(thrust::distance(keys.begin(), end.first), keys, values);
+
+    utility::device_vector<int> indices = Find(keys);
+    thrust::scatter_if(values.begin(), values.end(), indices.begin(),
+                       indices.begin(), voxels_values_.begin(),
+                       is_non_negative_functor());
+    remove_if_vectors(
+            [] __device__(
+                    const thrust::tuple<Eigen::Vector3i, Voxel, int> &x) {
+                return thrust::get<2>(x) >= 0;
+            },
+            keys, values, indices);
+    AppendVoxels(keys, values);
+    return *this;
+}
+
+VoxelGrid &VoxelGrid::Erase(
+        const utility::device_vector<Eigen::Vector3i> &keys) {
+    if (keys.empty() || voxels_keys_.empty()) return *this;
+    utility::device_vector<int> indices = Find(keys);
+    utility::device_vector<bool> removed(voxels_keys_.size(), false);
+    thrust::scatter_if(thrust::make_constant_iterator(true),
+                       thrust::make_constant_iterator(true) + indices.size(),
+                       indices.begin(), indices.begin(), removed.begin(),
+                       is_non_negative_functor());
+    remove_if_vectors(
+            [] __device__(
+                    const thrust::tuple<Eigen::Vector3i, Voxel, bool> &x) {
+                return thrust::get<2>(x);
+            },
+            voxels_keys_, voxels_values_, removed);
+    // The remaining voxels have moved, so the index is rebuilt lazily.
+    index_.reset();
+    return *this;
+}
+
+VoxelGrid &VoxelGrid::SortByMortonCode() {
+    if (voxels_keys_.size() < 2) return *this;
+    Eigen::Vector3i init = voxels_keys_[0];
+    const Eigen::Vector3i min_key = thrust::reduce(
+            utility::exec_policy(0)->on(0), voxels_keys_.begin(),
+            voxels_keys_.end(), init,
+            thrust::elementwise_minimum<Eigen::Vector3i>());
+    utility::device_vector<uint64_t> codes(voxels_keys_.size());
+    thrust::transform(voxels_keys_.begin(), voxels_keys_.end(), codes.begin(),
+                      compute_voxel_morton_code_functor(min_key));
+    thrust::sort_by_key(utility::exec_policy(0)->on(0), codes.begin(),
+                        codes.end(),
+                        make_tuple_begin(voxels_keys_, voxels_values_));
+    index_.reset();
+    return *this;
+}
+
+VoxelGrid &VoxelGrid::ResetIndex() {
+    index_.reset();
+    return *this;
+}
+
+VoxelGrid::VoxelIndexImpl &VoxelGrid::GetIndex() const {
+    // Every mutator resets or extends the index. The size check only catches
+    // direct edits of voxels_keys_ that change its length; other direct edits
+    // must be followed by ResetIndex().
+    const size_t n = voxels_keys_.size();
+    if (index_ && index_->size_ == n) return *index_;
+    // Keep the load factor of the hash map at most one half.
+    index_ = std::make_shared<VoxelIndexImpl>(std::max<size_t>(2 * n, 1));
+    InsertVoxelIndices(voxels_keys_, 0, index_->map_);
+    index_->size_ = n;
+    return *index_;
+}
+
+void VoxelGrid::AppendVoxels(
+        const utility::device_vector<Eigen::Vector3i> &keys,
+        const utility::device_vector<Voxel> &values) {
+    if (keys.empty()) return;
+    const size_t n = voxels_keys_.size();
+    voxels_keys_.insert(voxels_keys_.end(), keys.begin(), keys.end());
+    voxels_values_.insert(voxels_values_.end(), values.begin(), values.end());
+    if (!index_ || index_->size_ != n ||
+        2 * voxels_keys_.size() > index_->capacity_) {
+        index_.reset();
+        return;
+    }
+    InsertVoxelIndices(voxels_keys_, n, index_->map_);
+    index_->size_ = voxels_keys_.size();
+}
+
 VoxelGrid &VoxelGrid::CarveDepthMap(
         const Image &depth_map,
         const camera::PinholeCameraParameters &camera_parameter,
@@ -395,6 +620,7 @@ VoxelGrid &VoxelGrid::CarveDepthMap(
             trans, keep_voxels_outside_image);
     remove_if_vectors(utility::exec_policy(0)->on(0), func, voxels_keys_,
                       voxels_values_);
+    index_.reset();
     return *this;
 }
 
@@ -422,5 +648,6 @@ VoxelGrid &VoxelGrid::CarveSilhouette(
             silhouette_mask.bytes_per_channel_, voxel_size_, origin_, intrinsic,
             rot, trans, keep_voxels_outside_image);
     remove_if_vectors(func, voxels_keys_, voxels_values_);
+    index_.reset();
     return *this;
 }
@@ -86,6 +86,7 @@ public:
     VoxelGrid();
     VoxelGrid(const VoxelGrid &src_voxel_grid);
     ~VoxelGrid();
+    VoxelGrid &operator=(const VoxelGrid &src_voxel_grid);
 
     std::pair<thrust::host_vector<Eigen::Vector3i>, thrust::host_vector<Voxel>>
     GetVoxels() const;
@@ -136,6 +137,29 @@ public:
     // Queries are double precision and are mapped to the closest voxel.
     thrust::host_vector<bool> CheckIfIncluded(
             const thrust::host_vector<Eigen::Vector3f> &queries);
+    utility::device_vector<bool> CheckIfIncluded(
+            const utility::device_vector<Eigen::Vector3f> &queries) const;
+
+    /// Element-wise check if a grid index is stored in the VoxelGrid.
+    utility::device_vector<bool> Contains(
+            const utility::device_vector<Eigen::Vector3i> &keys) const;
+    /// Returns the position of each grid index in voxels_keys_, or -1 if the
+    /// voxel is not stored.
+    utility::device_vector<int> Find(
+            const utility::device_vector<Eigen::Vector3i> &keys) const;
+    /// Overwrites the voxels already stored and appends the others.
+    VoxelGrid &Insert(const utility::device_vector<Voxel> &voxels);
+    /// Removes the voxels with the given grid indices.
+    VoxelGrid &Erase(const utility::device_vector<Eigen::Vector3i> &keys);
+    /// Reorders the voxels along a Morton (Z-order) curve of their grid
+    /// indices. The order is exact for grids spanning less than 2^21 voxels
+    /// along each axis.
+    VoxelGrid &SortByMortonCode();
+    /// Drops the lookup index so that it is rebuilt on the next query. The
+    /// member functions keep the index valid, but code writing voxels_keys_
+    /// directly must call this before the next Contains, Find, Insert, Erase
+    /// or operator+=.
+    VoxelGrid &ResetIndex();
 
     /// Remove all voxels from the VoxelGrid where none of the boundary points
     /// of the voxel projects to depth value that is smaller, or equal than the
@@ -199,11 +223,24 @@ public:
     static std::shared_ptr<VoxelGrid> CreateFromOccupancyGrid(
             const OccupancyGrid &input);
 
+private:
+    class VoxelIndexImpl;
+    VoxelIndexImpl &GetIndex() const;
+    void AppendVoxels(const utility::device_vector<Eigen::Vector3i> &keys,
+                      const utility::device_vector<Voxel> &values);
+
 public:
     float voxel_size_ = 0.0;
     Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
     utility::device_vector<Eigen::Vector3i> voxels_keys_;
     utility::device_vector<Voxel> voxels_values_;
+
+private:
+    /// Device hash map from the grid index to the position in voxels_keys_.
+    /// It is built lazily by the lookups, kept up to date by Insert and
+    /// operator+=, and reset by every other member function modifying
+    /// voxels_keys_.
+    mutable std::shared_ptr<VoxelIndexImpl> index_;
 };
 
 }  // namespace geometry
@@ -0,0 +1,862 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/binary_search.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/sort.h>
+
+#include <Eigen/Dense>
+
+#include "cupoch/integration/color_map_optimization.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/eigen.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/platform.h"
+
+namespace cupoch {
+namespace integration {
+
+namespace {
+
+typedef Eigen::Matrix<float, 6, 8> Matrix6x8f;
+typedef Eigen::Matrix<float, 8, 8> Matrix8f;
+typedef Eigen::Matrix<float, 8, 1> Vector8f;
+
+/// Device view of an image of the optimization with its pose and warping
+/// field.
+struct color_map_camera {
+    const uint8_t *color_;
+    const uint8_t *gray_;
+    const uint8_t *dx_;
+    const uint8_t *dy_;
+    const uint8_t *depth_;
+    /// Anchor points of the warping field, or nullptr for a rigid camera.
+    const Eigen::Vector2f *anchors_;
+    Eigen::Matrix4f_u extrinsic_;
+    float fx_;
+    float fy_;
+    float cx_;
+    float cy_;
+    int width_;
+    int height_;
+    int anchor_w_;
+    int anchor_h_;
+    float anchor_step_;
+
+    __device__ Eigen::Vector3f ToCamera(const Eigen::Vector3f &v) const {
+        return extrinsic_.block<3, 3>(0, 0) * v + extrinsic_.block<3, 1>(0, 3);
+    }
+    __device__ Eigen::Vector2f Project(const Eigen::Vector3f &p) const {
+        return Eigen::Vector2f(fx_ * p[0] / p[2] + cx_,
+                               fy_ * p[1] / p[2] + cy_);
+    }
+    /// Returns the top left anchor of the anchor cell containing \p uv and
+    /// the bilinear weights of its four anchors.
+    __device__ int AnchorCellOf(const Eigen::Vector2f &uv,
+                                float weights[4]) const {
+        const int i = min(max((int)(uv[0] / anchor_step_), 0), anchor_w_ - 2);
+        const int j = min(max((int)(uv[1] / anchor_step_), 0), anchor_h_ - 2);
+        const float p = uv[0] / anchor_step_ - i;
+        const float q = uv[1] / anchor_step_ - j;
+        weights[0] = (1.0f - p) * (1.0f - q);
+        weights[1] = p * (1.0f - q);
+        weights[2] = (1.0f - p) * q;
+        weights[3] = p * q;
+        return j * anchor_w_ + i;
+    }
+    /// Returns the k-th anchor of the anchor cell whose top left anchor is
+    /// \p a.
+    __device__ int AnchorOf(int a, int k) const {
+        return a + (k & 1) + (k >> 1) * anchor_w_;
+    }
+    __device__ Eigen::Vector2f Warp(const Eigen::Vector2f &uv) const {
+        if (anchors_ == nullptr) return uv;
+        float w[4];
+        const int a = AnchorCellOf(uv, w);
+        Eigen::Vector2f warped = Eigen::Vector2f::Zero();
+        for (int k = 0; k < 4; ++k) {
+            warped += w[k] * anchors_[AnchorOf(a, k)];
+        }
+        return warped;
+    }
+    __device__ bool IsInside(const Eigen::Vector2f &uv) const {
+        return uv[0] >= 0.0f && uv[0] <= width_ - 1 && uv[1] >= 0.0f &&
+               uv[1] <= height_ - 1;
+    }
+    __device__ float DepthAt(int u, int v) const {
+        return *geometry::PointerAt<float>(depth_, width_, u, v);
+    }
+    __device__ thrust::pair<bool, float> FloatAt(
+            const uint8_t *data, const Eigen::Vector2f &uv) const {
+        return geometry::FloatValueAt(data, uv[0], uv[1], width_, height_, 1,
+                                      4);
+    }
+    /// Bilinear interpolation of the RGB8 color in [0, 1].
+    __device__ Eigen::Vector3f ColorAt(const Eigen::Vector2f &uv) const {
+        const int ui = min(max((int)uv[0], 0), width_ - 2);
+        const int vi = min(max((int)uv[1], 0), height_ - 2);
+        const float pu = uv[0] - ui;
+        const float pv = uv[1] - vi;
+        Eigen::Vector3f c;
+        for (int ch = 0; ch < 3; ++ch) {
+            c[ch] = ((1.0f - pu) * (1.0f - pv) *
+                             *geometry::PointerAt<uint8_t>(color_, width_, 3,
+                                                           ui, vi, ch) +
+                     pu * (1.0f - pv) *
+                             *geometry::PointerAt<uint8_t>(color_, width_, 3,
+                                                           ui + 1, vi, ch) +
+                     (1.0f - pu) * pv *
+                             *geometry::PointerAt<uint8_t>(color_, width_, 3,
+                                                           ui, vi + 1, ch) +
+                     pu * pv *
+                             *geometry::PointerAt<uint8_t>(
+                                     color_, width_, 3, ui + 1, vi + 1, ch)) /
+                    255.0f;
+        }
+        return c;
+    }
+    /// A vertex is visible if it is in front of the observed depth and not
+    /// on a depth discontinuity.
+    __device__ bool IsVisible(const Eigen::Vector3f &v,
+                              float max_depth,
+                              float visibility_threshold,
+                              float discontinuity_threshold) const {
+        const Eigen::Vector3f p = ToCamera(v);
+        if (p[2] <= 0.0f || p[2] > max_depth) return false;
+        const Eigen::Vector2f uv = Project(p);
+        const int u = (int)roundf(uv[0]);
+        const int w = (int)roundf(uv[1]);
+        if (u < 1 || u >= width_ - 1 || w < 1 || w >= height_ - 1) {
+            return false;
+        }
+        const float d = DepthAt(u, w);
+        if (!isfinite(d) || d <= 0.0f || abs(d - p[2]) > visibility_threshold) {
+            return false;
+        }
+        float d_min = d;
+        float d_max = d;
+        for (int dw = -1; dw <= 1; ++dw) {
+            for (int du = -1; du <= 1; ++du) {
+                const float dn = DepthAt(u + du, w + dw);
+                if (!isfinite(dn) || dn <= 0.0f) return false;
+                d_min = fminf(d_min, dn);
+                d_max = fmaxf(d_max, dn);
+            }
+        }
+        return d_max - d_min <= discontinuity_threshold;
+    }
+    /// Computes the residual of the intensity at the vertex against its
+    /// proxy intensity, the position \p p of the vertex in the camera, its
+    /// projection \p uv before warping and the intensity gradient \p grad.
+    __device__ bool ComputeResidual(const Eigen::Vector3f &v,
+                                    float proxy,
+                                    Eigen::Vector3f &p,
+                                    Eigen::Vector2f &uv,
+                                    float &r,
+                                    Eigen::Vector2f &grad) const {
+        p = ToCamera(v);
+        if (p[2] <= 0.0f) return false;
+        uv = Project(p);
+        const Eigen::Vector2f uv_w = Warp(uv);
+        if (!IsInside(uv_w)) return false;
+        const auto gray = FloatAt(gray_, uv_w);
+        const auto dx = FloatAt(dx_, uv_w);
+        const auto dy = FloatAt(dy_, uv_w);
+        if (!gray.first || !dx.first || !dy.first) return false;
+        r = gray.second - proxy;
+        grad = Eigen::Vector2f(dx.second, dy.second);
+        return true;
+    }
+    /// Jacobian of the residual w.r.t. a small motion (rotation, translation)
+    /// of the camera. The warping field is taken as locally identity.
+    __device__ Eigen::Vector6f PoseJacobian(const Eigen::Vector3f &p,
+                                            const Eigen::Vector2f &grad) const {
+        const float invz = 1.0f / p[2];
+        const Eigen::Vector3f g(
+                grad[0] * fx_ * invz, grad[1] * fy_ * invz,
+                -(grad[0] * fx_ * p[0] + grad[1] * fy_ * p[1]) * invz * invz);
+        Eigen::Vector6f J_r;
+        J_r.head<3>() = p.cross(g);
+        J_r.tail<3>() = g;
+        return J_r;
+    }
+};
+
+struct is_vertex_visible_functor {
+    is_vertex_visible_functor(const Eigen::Vector3f *vertices,
+                              const color_map_camera &camera,
+                              float max_depth,
+                              float visibility_threshold,
+                              float discontinuity_threshold)
+        : vertices_(vertices),
+          camera_(camera),
+          max_depth_(max_depth),
+          visibility_threshold_(visibility_threshold),
+          discontinuity_threshold_(discontinuity_threshold){};
+    const Eigen::Vector3f *vertices_;
+    const color_map_camera camera_;
+    const float max_depth_;
+    const float visibility_threshold_;
+    const float discontinuity_threshold_;
+    __device__ bool operator()(int k) const {
+        return camera_.IsVisible(vertices_[k], max_depth_,
+                                 visibility_threshold_,
+                                 discontinuity_threshold_);
+    }
+};
+
+/// Adds the intensity and the color of the camera at its visible vertices.
+/// Each vertex appears once in the visibility list of a camera.
+struct accumulate_vertex_colors_functor {
+    accumulate_vertex_colors_functor(const Eigen::Vector3f *vertices,
+                                     const int *visible,
+                                     const color_map_camera &camera,
+                                     float *intensity_sums,
+                                     Eigen::Vector3f *color_sums,
+                                     int *counts)
+        : vertices_(vertices),
+          visible_(visible),
+          camera_(camera),
+          intensity_sums_(intensity_sums),
+          color_sums_(color_sums),
+          counts_(counts){};
+    const Eigen::Vector3f *vertices_;
+    const int *visible_;
+    const color_map_camera camera_;
+    float *intensity_sums_;
+    Eigen::Vector3f *color_sums_;
+    int *counts_;
+    __device__ void operator()(size_t i) {
+        const int k = visible_[i];
+        const Eigen::Vector3f p = camera_.ToCamera(vertices_[k]);
+        if (p[2] <= 0.0f) return;
+        const Eigen::Vector2f uv = camera_.Warp(camera_.Project(p));
+        if (!camera_.IsInside(uv)) return;
+        const auto gray = camera_.FloatAt(camera_.gray_, uv);
+        if (!gray.first) return;
+        intensity_sums_[k] += gray.second;
+        color_sums_[k] += camera_.ColorAt(uv);
+        counts_[k] += 1;
+    }
+};
+
+struct average_vertex_colors_functor {
+    __device__ thrust::tuple<float, Eigen::Vector3f> operator()(
+            const thrust::tuple<float, Eigen::Vector3f, int> &x) const {
+        const int n = max(thrust::get<2>(x), 1);
+        return thrust::make_tuple(thrust::get<0>(x) / n,
+                                  Eigen::Vector3f(thrust::get<1>(x) / n));
+    }
+};
+
+struct compute_rigid_jacobian_functor
+    : public utility::jacobian_residual_functor<Eigen::Vector6f> {
+    compute_rigid_jacobian_functor(const Eigen::Vector3f *vertices,
+                                   const int *visible,
+                                   const float *proxy_intensities,
+                                   const color_map_camera &camera)
+        : vertices_(vertices),
+          visible_(visible),
+          proxy_intensities_(proxy_intensities),
+          camera_(camera){};
+    const Eigen::Vector3f *vertices_;
+    const int *visible_;
+    const float *proxy_intensities_;
+    const color_map_camera camera_;
+    __device__ void operator()(int i, Eigen::Vector6f &J_r, float &r) const {
+        const int k = visible_[i];
+        Eigen::Vector3f p;
+        Eigen::Vector2f uv;
+        Eigen::Vector2f grad;
+        if (!camera_.ComputeResidual(vertices_[k], proxy_intensities_[k], p,
+                                     uv, r, grad)) {
+            J_r.setZero();
+            r = 0.0f;
+            return;
+        }
+        J_r = camera_.PoseJacobian(p, grad);
+    }
+};
+
+/// Returns the anchor cell of the residual of a visible vertex, or -1 if
+/// the vertex has no residual.
+struct anchor_cell_functor {
+    anchor_cell_functor(const Eigen::Vector3f *vertices,
+                        const int *visible,
+                        const float *proxy_intensities,
+                        const color_map_camera &camera)
+        : vertices_(vertices),
+          visible_(visible),
+          proxy_intensities_(proxy_intensities),
+          camera_(camera){};
+    const Eigen::Vector3f *vertices_;
+    const int *visible_;
+    const float *proxy_intensities_;
+    const color_map_camera camera_;
+    __device__ int operator()(int i) const {
+        const int k = visible_[i];
+        Eigen::Vector3f p;
+        Eigen::Vector2f uv;
+        Eigen::Vector2f grad;
+        float r;
+        if (!camera_.ComputeResidual(vertices_[k], proxy_intensities_[k], p,
+                                     uv, r, grad)) {
+            return -1;
+        }
+        float w[4];
+        return camera_.AnchorCellOf(uv, w);
+    }
+};
+
+/// Returns the blocks of the normal equations that a residual adds to the
+/// four anchors of its anchor cell: the pose-anchor block, the
+/// anchor-anchor block and the anchor part of JTr. The pose-pose block is
+/// the one of the rigid case.
+struct compute_anchor_system_functor {
+    compute_anchor_system_functor(const Eigen::Vector3f *vertices,
+                                  const int *visible,
+                                  const float *proxy_intensities,
+                                  const color_map_camera &camera)
+        : vertices_(vertices),
+          visible_(visible),
+          proxy_intensities_(proxy_intensities),
+          camera_(camera){};
+    const Eigen::Vector3f *vertices_;
+    const int *visible_;
+    const float *proxy_intensities_;
+    const color_map_camera camera_;
+    __device__ thrust::tuple<Matrix6x8f, Matrix8f, Vector8f> operator()(
+            int i) const {
+        const int k = visible_[i];
+        Eigen::Vector3f p;
+        Eigen::Vector2f uv;
+        Eigen::Vector2f grad;
+        float r;
+        camera_.ComputeResidual(vertices_[k], proxy_intensities_[k], p, uv, r,
+                                grad);
+        const Eigen::Vector6f J_pose = camera_.PoseJacobian(p, grad);
+        float w[4];
+        camera_.AnchorCellOf(uv, w);
+        Vector8f J_anchor;
+        for (int c = 0; c < 4; ++c) {
+            J_anchor[2 * c] = grad[0] * w[c];
+            J_anchor[2 * c + 1] = grad[1] * w[c];
+        }
+        return thrust::make_tuple(
+                Matrix6x8f(J_pose * J_anchor.transpose()),
+                Matrix8f(J_anchor * J_anchor.transpose()),
+                Vector8f(J_anchor * r));
+    }
+};
+
+/// Keeps for each triangle the camera seeing all its vertices with the
+/// smallest angle to its normal.
+struct select_texture_camera_functor {
+    select_texture_camera_functor(const Eigen::Vector3f *vertices,
+                                  const Eigen::Vector3i *triangles,
+                                  const bool *is_visible,
+                                  const Eigen::Vector3f &camera_center,
+                                  int camera_index,
+                                  float *best_scores,
+                                  int *best_cameras)
+        : vertices_(vertices),
+          triangles_(triangles),
+          is_visible_(is_visible),
+          camera_center_(camera_center),
+          camera_index_(camera_index),
+          best_scores_(best_scores),
+          best_cameras_(best_cameras){};
+    const Eigen::Vector3f *vertices_;
+    const Eigen::Vector3i *triangles_;
+    const bool *is_visible_;
+    const Eigen::Vector3f camera_center_;
+    const int camera_index_;
+    float *best_scores_;
+    int *best_cameras_;
+    __device__ void operator()(size_t t) {
+        const Eigen::Vector3i &tri = triangles_[t];
+        if (!is_visible_[tri[0]] || !is_visible_[tri[1]] ||
+            !is_visible_[tri[2]]) {
+            return;
+        }
+        const Eigen::Vector3f &v0 = vertices_[tri[0]];
+        const Eigen::Vector3f &v1 = vertices_[tri[1]];
+        const Eigen::Vector3f &v2 = vertices_[tri[2]];
+        const Eigen::Vector3f n = (v1 - v0).cross(v2 - v0);
+        const Eigen::Vector3f view = camera_center_ - (v0 + v1 + v2) / 3.0f;
+        const float norm = n.norm() * view.norm();
+        if (norm == 0.0f) return;
+        const float score = abs(n.dot(view)) / norm;
+        if (score > best_scores_[t]) {
+            best_scores_[t] = score;
+            best_cameras_[t] = camera_index_;
+        }
+    }
+};
+
+/// The atlas is made of square cells of tile_size x tile_size texels, each
+/// holding two triangles. The corners of the triangles are at the centers
+/// of the corner texels of the cell.
+struct compute_atlas_uv_functor {
+    compute_atlas_uv_functor(int tile_size,
+                             int cells_per_row,
+                             int width,
+                             int height)
+        : tile_size_(tile_size),
+          cells_per_row_(cells_per_row),
+          width_(width),
+          height_(height){};
+    const int tile_size_;
+    const int cells_per_row_;
+    const int width_;
+    const int height_;
+    __device__ Eigen::Vector2f operator()(size_t idx) const {
+        const int t = idx / 3;
+        const int c = idx % 3;
+        const int cell = t / 2;
+        const float a = 0.5f;
+        const float b = tile_size_ - 0.5f;
+        Eigen::Vector2f local;
+        if (t % 2 == 0) {
+            local = (c == 0) ? Eigen::Vector2f(a, a)
+                             : ((c == 1) ? Eigen::Vector2f(b, a)
+                                         : Eigen::Vector2f(a, b));
+        } else {
+            local = (c == 0) ? Eigen::Vector2f(b, b)
+                             : ((c == 1) ? Eigen::Vector2f(a, b)
+                                         : Eigen::Vector2f(b, a));
+        }
+        const Eigen::Vector2f origin((cell % cells_per_row_) * tile_size_,
+                                     (cell / cells_per_row_) * tile_size_);
+        const Eigen::Vector2f uv = origin + local;
+        return Eigen::Vector2f(uv[0] / width_, uv[1] / height_);
+    }
+};
+
+struct bake_texture_functor {
+    bake_texture_functor(const Eigen::Vector3f *vertices,
+                         const Eigen::Vector3i *triangles,
+                         const Eigen::Vector3f *vertex_colors,
+                         int n_triangles,
+                         const int *best_cameras,
+                         const color_map_camera *cameras,
+                         int tile_size,
+                         int cells_per_row,
+                         int width,
+                         uint8_t *texture)
+        : vertices_(vertices),
+          triangles_(triangles),
+          vertex_colors_(vertex_colors),
+          n_triangles_(n_triangles),
+          best_cameras_(best_cameras),
+          cameras_(cameras),
+          tile_size_(tile_size),
+          cells_per_row_(cells_per_row),
+          width_(width),
+          texture_(texture){};
+    const Eigen::Vector3f *vertices_;
+    const Eigen::Vector3i *triangles_;
+    const Eigen::Vector3f *vertex_colors_;
+    const int n_triangles_;
+    const int *best_cameras_;
+    const color_map_camera *cameras_;
+    const int tile_size_;
+    const int cells_per_row_;
+    const int width_;
+    uint8_t *texture_;
+    __device__ void operator()(size_t idx) {
+        const int tx = idx % width_;
+        const int ty = idx / width_;
+        const int cell = (ty / tile_size_) * cells_per_row_ + tx / tile_size_;
+        const float s = (float)(tx % tile_size_) / (tile_size_ - 1);
+        const float t = (float)(ty % tile_size_) / (tile_size_ - 1);
+        int tri;
+        Eigen::Vector3f w;
+        if (s + t <= 1.0f) {
+            tri = 2 * cell;
+            w = Eigen::Vector3f(1.0f - s - t, s, t);
+        } else {
+            tri = 2 * cell + 1;
+            w = Eigen::Vector3f(s + t - 1.0f, 1.0f - s, 1.0f - t);
+        }
+        Eigen::Vector3f color = Eigen::Vector3f::Zero();
+        if (tri < n_triangles_) {
+            w = w.cwiseMax(0.0f);
+            w /= w.sum();
+            const Eigen::Vector3i &f = triangles_[tri];
+            const Eigen::Vector3f x = w[0] * vertices_[f[0]] +
+                                      w[1] * vertices_[f[1]] +
+                                      w[2] * vertices_[f[2]];
+            bool sampled = false;
+            const int c = best_cameras_[tri];
+            if (c >= 0) {
+                const color_map_camera &camera = cameras_[c];
+                const Eigen::Vector3f p = camera.ToCamera(x);
+                if (p[2] > 0.0f) {
+                    const Eigen::Vector2f uv = camera.Warp(camera.Project(p));
+                    if (camera.IsInside(uv)) {
+                        color = camera.ColorAt(uv);
+                        sampled = true;
+                    }
+                }
+            }
+            if (!sampled && vertex_colors_ != nullptr) {
+                color = w[0] * vertex_colors_[f[0]] +
+                        w[1] * vertex_colors_[f[1]] +
+                        w[2] * vertex_colors_[f[2]];
+            }
+        }
+        for (int ch = 0; ch < 3; ++ch) {
+            texture_[3 * idx + ch] = (uint8_t)roundf(
+                    fminf(fmaxf(color[ch], 0.0f), 1.0f) * 255.0f);
+        }
+    }
+};
+
+bool IsSupportedImage(const geometry::RGBDImage &image,
+                      const camera::PinholeCameraIntrinsic &intrinsic) {
+    return image.color_.num_of_channels_ == 3 &&
+           image.color_.bytes_per_channel_ == 1 &&
+           image.depth_.num_of_channels_ == 1 &&
+           image.depth_.bytes_per_channel_ == 4 &&
+           image.color_.width_ == intrinsic.width_ &&
+           image.color_.height_ == intrinsic.height_ &&
+           image.depth_.width_ == intrinsic.width_ &&
+           image.depth_.height_ == intrinsic.height_;
+}
+
+}  // namespace
+
+void ColorMapOptimization(geometry::TriangleMesh &mesh,
+                          const std::vector<geometry::RGBDImage> &images,
+                          const camera::PinholeCameraIntrinsic &intrinsic,
+                          thrust::host_vector<Eigen::Matrix4f> &extrinsics,
+                          const ColorMapOptimizationOption &option) {
+    if (images.size() != extrinsics.size()) {
+        utility::LogError(
+                "[ColorMapOptimization] The numbers of images and extrinsics "
+                "are different.");
+        return;
+    }
+    if (option.number_of_vertical_anchors_ < 2 ||
+        option.texture_tile_size_ < 2) {
+        utility::LogError(
+                "[ColorMapOptimization] number_of_vertical_anchors and "
+                "texture_tile_size must be at least 2.");
+        return;
+    }
+    if (!mesh.HasVertices() || images.empty()) return;
+    const size_t n_images = images.size();
+    const int n_vertices = mesh.vertices_.size();
+    const int width = intrinsic.width_;
+    const int height = intrinsic.height_;
+    const Eigen::Vector3f *vertices =
+            thrust::raw_pointer_cast(mesh.vertices_.data());
+
+    // intensity images, their gradients and the warping fields
+    std::vector<std::shared_ptr<geometry::Image>> grays(n_images);
+    std::vector<std::shared_ptr<geometry::Image>> dxs(n_images);
+    std::vector<std::shared_ptr<geometry::Image>> dys(n_images);
+    for (size_t i = 0; i < n_images; ++i) {
+        if (!IsSupportedImage(images[i], intrinsic)) {
+            utility::LogError(
+                    "[ColorMapOptimization] Unsupported image format.");
+            return;
+        }
+        grays[i] = images[i].color_.CreateFloatImage();
+        dxs[i] = grays[i]->Filter(geometry::Image::FilterType::Sobel3Dx);
+        dys[i] = grays[i]->Filter(geometry::Image::FilterType::Sobel3Dy);
+    }
+    const int anchor_h = option.number_of_vertical_anchors_;
+    const float anchor_step = (height - 1) / (float)(anchor_h - 1);
+    const int anchor_w = (int)std::ceil((width - 1) / anchor_step) + 1;
+    const int n_anchors = anchor_w * anchor_h;
+    thrust::host_vector<Eigen::Vector2f> init_anchors(n_anchors);
+    for (int j = 0; j < anchor_h; ++j) {
+        for (int i = 0; i < anchor_w; ++i) {
+            init_anchors[j * anchor_w + i] =
+                    Eigen::Vector2f(i * anchor_step, j * anchor_step);
+        }
+    }
+    std::vector<utility::device_vector<Eigen::Vector2f>> anchors;
+    if (option.non_rigid_camera_coordinate_) {
+        anchors.resize(n_images, init_anchors);
+    }
+    auto make_camera = [&](size_t i) {
+        color_map_camera camera;
+        camera.color_ = thrust::raw_pointer_cast(images[i].color_.data_.data());
+        camera.gray_ = thrust::raw_pointer_cast(grays[i]->data_.data());
+        camera.dx_ = thrust::raw_pointer_cast(dxs[i]->data_.data());
+        camera.dy_ = thrust::raw_pointer_cast(dys[i]->data_.data());
+        camera.depth_ = thrust::raw_pointer_cast(images[i].depth_.data_.data());
+        camera.anchors_ = (anchors.empty())
+                                  ? nullptr
+                                  : thrust::raw_pointer_cast(anchors[i].data());
+        camera.extrinsic_ = extrinsics[i];
+        camera.fx_ = intrinsic.GetFocalLength().first;
+        camera.fy_ = intrinsic.GetFocalLength().second;
+        camera.cx_ = intrinsic.GetPrincipalPoint().first;
+        camera.cy_ = intrinsic.GetPrincipalPoint().second;
+        camera.width_ = width;
+        camera.height_ = height;
+        camera.anchor_w_ = anchor_w;
+        camera.anchor_h_ = anchor_h;
+        camera.anchor_step_ = anchor_step;
+        return camera;
+    };
+
+    // vertices visible from each camera with the initial poses
+    std::vector<utility::device_vector<int>> visible(n_images);
+    for (size_t i = 0; i < n_images; ++i) {
+        visible[i].resize(n_vertices);
+        is_vertex_visible_functor func(
+                vertices, make_camera(i), option.maximum_allowable_depth_,
+                option.depth_threshold_for_visibility_check_,
+                option.depth_threshold_for_discontinuity_check_);
+        auto end = thrust::copy_if(thrust::make_counting_iterator(0),
+                                   thrust::make_counting_iterator(n_vertices),
+                                   visible[i].begin(), func);
+        visible[i].resize(thrust::distance(visible[i].begin(), end));
+        utility::LogDebug("[ColorMapOptimization] Camera {:d} sees {:d} "
+                          "vertices.",
+                          (int)i, (int)visible[i].size());
+    }
+
+    // average intensities and colors of the vertices over the cameras
+    utility::device_vector<float> proxy_intensities(n_vertices);
+    utility::device_vector<Eigen::Vector3f> vertex_colors(n_vertices);
+    auto update_vertex_colors = [&]() {
+        utility::device_vector<int> counts(n_vertices, 0);
+        thrust::fill(proxy_intensities.begin(), proxy_intensities.end(), 0.0f);
+        thrust::fill(vertex_colors.begin(), vertex_colors.end(),
+                     Eigen::Vector3f::Zero());
+        for (size_t i = 0; i < n_images; ++i) {
+            accumulate_vertex_colors_functor func(
+                    vertices, thrust::raw_pointer_cast(visible[i].data()),
+                    make_camera(i),
+                    thrust::raw_pointer_cast(proxy_intensities.data()),
+                    thrust::raw_pointer_cast(vertex_colors.data()),
+                    thrust::raw_pointer_cast(counts.data()));
+            thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                             thrust::make_counting_iterator(visible[i].size()),
+                             func);
+        }
+        thrust::transform(
+                make_tuple_begin(proxy_intensities, vertex_colors, counts),
+                make_tuple_end(proxy_intensities, vertex_colors, counts),
+                make_tuple_begin(proxy_intensities, vertex_colors),
+                average_vertex_colors_functor());
+    };
+
+    const int n_params = 6 + 2 * n_anchors;
+    for (int iter = 0; iter < option.maximum_iteration_; ++iter) {
+        update_vertex_colors();
+        float r2_sum = 0.0f;
+        size_t n_residuals = 0;
+        for (size_t i = 0; i < n_images; ++i) {
+            const int n_visible = visible[i].size();
+            if (n_visible == 0) continue;
+            if (!option.non_rigid_camera_coordinate_) {
+                compute_rigid_jacobian_functor func(
+                        vertices, thrust::raw_pointer_cast(visible[i].data()),
+                        thrust::raw_pointer_cast(proxy_intensities.data()),
+                        make_camera(i));
+                Eigen::Matrix6f JTJ;
+                Eigen::Vector6f JTr;
+                float r2;
+                thrust::tie(JTJ, JTr, r2) = utility::ComputeJTJandJTr<
+                        Eigen::Matrix6f, Eigen::Vector6f,
+                        compute_rigid_jacobian_functor>(func, n_visible,
+                                                        false);
+                bool is_success;
+                Eigen::Matrix4f delta;
+                thrust::tie(is_success, delta) =
+                        utility::SolveJacobianSystemAndObtainExtrinsicMatrix(
+                                JTJ, JTr);
+                if (is_success) extrinsics[i] = delta * extrinsics[i];
+                r2_sum += r2;
+            } else {
+                // The pose block is reduced as in the rigid case. Each
+                // residual only touches the four anchors of its cell, so the
+                // anchor blocks are reduced per cell and scattered on the
+                // host.
+                const color_map_camera camera = make_camera(i);
+                const int *visible_ptr =
+                        thrust::raw_pointer_cast(visible[i].data());
+                const float *proxy_ptr =
+                        thrust::raw_pointer_cast(proxy_intensities.data());
+                compute_rigid_jacobian_functor pose_func(
+                        vertices, visible_ptr, proxy_ptr, camera);
+                Eigen::Matrix6f JTJ_pose;
+                Eigen::Vector6f JTr_pose;
+                float r2;
+                thrust::tie(JTJ_pose, JTr_pose, r2) = utility::ComputeJTJandJTr<
+                        Eigen::Matrix6f, Eigen::Vector6f,
+                        compute_rigid_jacobian_functor>(pose_func, n_visible,
+                                                        false);
+
+                utility::device_vector<int> cells(n_visible);
+                utility::device_vector<int> residuals(n_visible);
+                thrust::transform(thrust::make_counting_iterator(0),
+                                  thrust::make_counting_iterator(n_visible),
+                                  cells.begin(),
+                                  anchor_cell_functor(vertices, visible_ptr,
+                                                      proxy_ptr, camera));
+                thrust::sequence(residuals.begin(), residuals.end());
+                thrust::sort_by_key(utility::exec_policy(0)->on(0),
+                                    cells.begin(), cells.end(),
+                                    residuals.begin());
+                // the residuals without a cell are sorted first
+                const int n_invalid =
+                        thrust::lower_bound(cells.begin(), cells.end(), 0) -
+                        cells.begin();
+                const int n_cells = anchor_w * anchor_h;
+                utility::device_vector<int> block_cells(n_cells);
+                utility::device_vector<Matrix6x8f> JTJ_pa(n_cells);
+                utility::device_vector<Matrix8f> JTJ_aa(n_cells);
+                utility::device_vector<Vector8f> JTr_a(n_cells);
+                auto end = thrust::reduce_by_key(
+                        cells.begin() + n_invalid, cells.end(),
+                        thrust::make_transform_iterator(
+                                residuals.begin() + n_invalid,
+                                compute_anchor_system_functor(
+                                        vertices, visible_ptr, proxy_ptr,
+                                        camera)),
+                        block_cells.begin(),
+                        make_tuple_begin(JTJ_pa, JTJ_aa, JTr_a),
+                        thrust::equal_to<int>(),
+                        add_tuple_functor<Matrix6x8f, Matrix8f, Vector8f>());
+                const size_t n_blocks =
+                        thrust::distance(block_cells.begin(), end.first);
+                thrust::host_vector<int> h_cells(block_cells.begin(),
+                                                 block_cells.begin() +
+                                                         n_blocks);
+                thrust::host_vector<Matrix6x8f> h_JTJ_pa(
+                        JTJ_pa.begin(), JTJ_pa.begin() + n_blocks);
+                thrust::host_vector<Matrix8f> h_JTJ_aa(
+                        JTJ_aa.begin(), JTJ_aa.begin() + n_blocks);
+                thrust::host_vector<Vector8f> h_JTr_a(
+                        JTr_a.begin(), JTr_a.begin() + n_blocks);
+
+                Eigen::MatrixXf A = Eigen::MatrixXf::Zero(n_params, n_params);
+                Eigen::VectorXf b = Eigen::VectorXf::Zero(n_params);
+                A.topLeftCorner<6, 6>() = JTJ_pose;
+                b.head<6>() = JTr_pose;
+                for (size_t c = 0; c < n_blocks; ++c) {
+                    int m[4];
+                    for (int k = 0; k < 4; ++k) {
+                        m[k] = 6 + 2 * (h_cells[c] + (k & 1) +
+                                        (k >> 1) * anchor_w);
+                    }
+                    for (int k = 0; k < 4; ++k) {
+                        const Eigen::Matrix<float, 6, 2> pa =
+                                h_JTJ_pa[c].block<6, 2>(0, 2 * k);
+                        A.block<6, 2>(0, m[k]) += pa;
+                        A.block<2, 6>(m[k], 0) += pa.transpose();
+                        b.segment<2>(m[k]) += h_JTr_a[c].segment<2>(2 * k);
+                        for (int l = 0; l < 4; ++l) {
+                            A.block<2, 2>(m[k], m[l]) +=
+                                    h_JTJ_aa[c].block<2, 2>(2 * k, 2 * l);
+                        }
+                    }
+                }
+                // keep the anchor points close to their initial positions
+                thrust::host_vector<Eigen::Vector2f> h_anchors = anchors[i];
+                const float weight = option.non_rigid_anchor_point_weight_ *
+                                     n_visible / (width * height);
+                for (int j = 0; j < n_anchors; ++j) {
+                    for (int d = 0; d < 2; ++d) {
+                        const int m = 6 + 2 * j + d;
+                        A(m, m) += weight;
+                        b(m) += weight * (h_anchors[j][d] - init_anchors[j][d]);
+                    }
+                }
+                const Eigen::VectorXf x = A.ldlt().solve(-b);
+                const Eigen::Vector6f delta = x.head<6>();
+                extrinsics[i] = utility::TransformVector6fToMatrix4f(delta) *
+                                extrinsics[i];
+                for (int j = 0; j < n_anchors; ++j) {
+                    h_anchors[j] += x.segment<2>(6 + 2 * j);
+                }
+                anchors[i] = h_anchors;
+                r2_sum += r2;
+            }
+            n_residuals += n_visible;
+        }
+        utility::LogDebug("[ColorMapOptimization] Iteration {:d}, residual "
+                          "{:.4e}.",
+                          iter, r2_sum / std::max<size_t>(n_residuals, 1));
+    }
+    update_vertex_colors();
+    mesh.vertex_colors_ = vertex_colors;
+
+    // bake the texture atlas from the camera facing each triangle the most
+    if (!mesh.HasTriangles()) return;
+    const int n_triangles = mesh.triangles_.size();
+    utility::device_vector<float> best_scores(n_triangles, 0.0f);
+    utility::device_vector<int> best_cameras(n_triangles, -1);
+    thrust::host_vector<color_map_camera> cameras(n_images);
+    for (size_t i = 0; i < n_images; ++i) {
+        cameras[i] = make_camera(i);
+        utility::device_vector<bool> is_visible(n_vertices, false);
+        thrust::scatter(thrust::make_constant_iterator(true),
+                        thrust::make_constant_iterator(true) +
+                                visible[i].size(),
+                        visible[i].begin(), is_visible.begin());
+        const Eigen::Matrix4f pose = utility::InverseTransform(extrinsics[i]);
+        select_texture_camera_functor func(
+                vertices, thrust::raw_pointer_cast(mesh.triangles_.data()),
+                thrust::raw_pointer_cast(is_visible.data()),
+                pose.block<3, 1>(0, 3), i,
+                thrust::raw_pointer_cast(best_scores.data()),
+                thrust::raw_pointer_cast(best_cameras.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator<size_t>(n_triangles),
+                         func);
+    }
+    utility::device_vector<color_map_camera> d_cameras = cameras;
+    const int tile_size = option.texture_tile_size_;
+    const int n_cells = (n_triangles + 1) / 2;
+    const int cells_per_row = (int)std::ceil(std::sqrt((float)n_cells));
+    const int n_rows = (n_cells + cells_per_row - 1) / cells_per_row;
+    const int texture_width = cells_per_row * tile_size;
+    const int texture_height = n_rows * tile_size;
+    mesh.triangle_uvs_.resize(n_triangles * 3);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator<size_t>(n_triangles * 3),
+                      mesh.triangle_uvs_.begin(),
+                      compute_atlas_uv_functor(tile_size, cells_per_row,
+                                               texture_width, texture_height));
+    mesh.texture_.Prepare(texture_width, texture_height, 3, 1);
+    bake_texture_functor func(
+            vertices, thrust::raw_pointer_cast(mesh.triangles_.data()),
+            thrust::raw_pointer_cast(mesh.vertex_colors_.data()), n_triangles,
+            thrust::raw_pointer_cast(best_cameras.data()),
+            thrust::raw_pointer_cast(d_cameras.data()), tile_size,
+            cells_per_row, texture_width,
+            thrust::raw_pointer_cast(mesh.texture_.data_.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator<size_t>(texture_width *
+                                                            texture_height),
+                     func);
+}
+
+}  // namespace integration
+}  // namespace cupoch
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+
+#include <thrust/host_vector.h>
+
+#include <vector>
+
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/rgbdimage.h"
+#include "cupoch/geometry/trianglemesh.h"
+
+namespace cupoch {
+namespace integration {
+
+class ColorMapOptimizationOption {
+public:
+    ColorMapOptimizationOption(
+            bool non_rigid_camera_coordinate = false,
+            int number_of_vertical_anchors = 16,
+            float non_rigid_anchor_point_weight = 0.316,
+            int maximum_iteration = 300,
+            float maximum_allowable_depth = 2.5,
+            float depth_threshold_for_visibility_check = 0.03,
+            float depth_threshold_for_discontinuity_check = 0.1,
+            int texture_tile_size = 8)
+        : non_rigid_camera_coordinate_(non_rigid_camera_coordinate),
+          number_of_vertical_anchors_(number_of_vertical_anchors),
+          non_rigid_anchor_point_weight_(non_rigid_anchor_point_weight),
+          maximum_iteration_(maximum_iteration),
+          maximum_allowable_depth_(maximum_allowable_depth),
+          depth_threshold_for_visibility_check_(
+                  depth_threshold_for_visibility_check),
+          depth_threshold_for_discontinuity_check_(
+                  depth_threshold_for_discontinuity_check),
+          texture_tile_size_(texture_tile_size) {}
+    ~ColorMapOptimizationOption() {}
+
+public:
+    /// If true, a warping field of anchor points is optimized for each image
+    /// together with its pose.
+    bool non_rigid_camera_coordinate_;
+    /// Number of rows of anchor points of the warping fields. The columns
+    /// have the same spacing.
+    int number_of_vertical_anchors_;
+    /// Weight of the regularization keeping the anchor points at their
+    /// initial positions.
+    float non_rigid_anchor_point_weight_;
+    int maximum_iteration_;
+    /// Vertices farther than this depth from a camera are not visible.
+    float maximum_allowable_depth_;
+    /// A vertex is visible if its depth differs from the depth image by
+    /// less than this threshold.
+    float depth_threshold_for_visibility_check_;
+    /// A vertex projecting on a pixel whose 3x3 neighborhood has a depth
+    /// range larger than this threshold is not visible.
+    float depth_threshold_for_discontinuity_check_;
+    /// Size in pixels of the square atlas cell holding two triangles.
+    int texture_tile_size_;
+};
+
+/// \brief Function for color mapping of reconstructed scenes, based on
+/// "Color Map Optimization for 3D Reconstruction with Consumer Depth Cameras"
+/// by Q.-Y. Zhou and V. Koltun, SIGGRAPH 2014.
+///
+/// The poses of the cameras, and with non_rigid_camera_coordinate_ a
+/// warping field per image, are optimized to maximize the photometric
+/// consistency of the images at the vertices of \p mesh. The normal
+/// equations of each image are accumulated over its visible vertices in
+/// parallel. The vertex colors of \p mesh are then set to the average of
+/// the visible images, and a texture atlas sampled from the image facing
+/// each triangle the most is baked into texture_ and triangle_uvs_.
+///
+/// \param mesh Mesh to color.
+/// \param images RGB8 color images with float depth images in meters, as
+/// used by TSDFVolume::Integrate.
+/// \param intrinsic Intrinsic of the cameras.
+/// \param extrinsics Poses of the cameras, updated with the optimized ones.
+/// \param option Parameters of the optimization.
+void ColorMapOptimization(
+        geometry::TriangleMesh &mesh,
+        const std::vector<geometry::RGBDImage> &images,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        thrust::host_vector<Eigen::Matrix4f> &extrinsics,
+        const ColorMapOptimizationOption &option =
+                ColorMapOptimizationOption());
+
+}  // namespace integration
+}  // namespace cupoch
@@ -20,6 +20,7 @@
  **/
 #pragma once
 #include "cupoch/integration/uniform_tsdfvolume.h"
+#include "cupoch/utility/helper.h"
 
 namespace cupoch {
 namespace integration {
@@ -81,7 +82,8 @@ struct integrate_functor {
     const int num_of_channels_;
     const TSDFVolumeColorType color_type_;
     __device__ virtual ~integrate_functor(){};
-    __device__ void ComputeTSDF(geometry::TSDFVoxel &voxel,
+    template <typename VoxelType>
+    __device__ void ComputeTSDF(VoxelType &voxel,
                                 const Eigen::Vector3f &origin,
                                 int x,
                                 int y,
@@ -120,25 +122,25 @@ struct integrate_functor {
         if (sdf > -sdf_trunc_) {
             // integrate
             float tsdf = min(1.0f, sdf * sdf_trunc_inv_);
-            const geometry::TSDFVoxel cv = voxel;
-            voxel.tsdf_ = (cv.tsdf_ * cv.weight_ + tsdf) / (cv.weight_ + 1.0f);
+            const float w = voxel.GetWeight();
+            Eigen::Vector3f color = voxel.GetColor();
             if (color_type_ == TSDFVolumeColorType::RGB8) {
                 const uint8_t *rgb = geometry::PointerAt<uint8_t>(
                         color_, width_, num_of_channels_, u, v, 0);
                 Eigen::Vector3f rgb_f(rgb[0], rgb[1], rgb[2]);
-                voxel.color_ =
-                        (cv.color_ * cv.weight_ + rgb_f) / (cv.weight_ + 1.0f);
+                color = (color * w + rgb_f) / (w + 1.0f);
             } else if (color_type_ == TSDFVolumeColorType::Gray32) {
                 const float intensity = *geometry::PointerAt<float>(
                         color_, width_, num_of_channels_, u, v, 0);
-                voxel.color_ = (cv.color_.array() * cv.weight_ + intensity) /
-                               (cv.weight_ + 1.0f);
+                color = (color.array() * w + intensity) / (w + 1.0f);
             }
-            voxel.weight_ += 1.0f;
+            voxel.Set((voxel.GetTSDF() * w + tsdf) / (w + 1.0f), w + 1.0f,
+                      color);
         }
     }
 };
 
+template <typename VoxelType>
 struct uniform_integrate_functor : public integrate_functor {
     uniform_integrate_functor(
             float fx,
@@ -158,7 +160,7 @@ struct uniform_integrate_functor : public integrate_functor {
             int num_of_channels,
             TSDFVolumeColorType color_type,
             const Eigen::Vector3f &origin,
-            geometry::TSDFVoxel *voxels)
+            VoxelType *voxels)
         : integrate_functor(fx,
                             fy,
                             cx,
@@ -178,7 +180,7 @@ struct uniform_integrate_functor : public integrate_functor {
           origin_(origin),
           voxels_(voxels){};
     const Eigen::Vector3f origin_;
-    geometry::TSDFVoxel *voxels_;
+    VoxelType *voxels_;
     __device__ void operator()(size_t idx) {
         int res2 = resolution_ * resolution_;
         int x = idx / res2;
@@ -190,5 +192,185 @@ struct uniform_integrate_functor : public integrate_functor {
     }
 };
 
+/// Integrates only the voxels of the bricks in \p bricks. A brick is a cube
+/// of brick_size^3 voxels and idx enumerates the voxels brick by brick.
+template <typename VoxelType>
+struct uniform_brick_integrate_functor
+    : public uniform_integrate_functor<VoxelType> {
+    uniform_brick_integrate_functor(
+            const uniform_integrate_functor<VoxelType> &func,
+            const int *bricks,
+            int brick_size,
+            int brick_resolution)
+        : uniform_integrate_functor<VoxelType>(func),
+          bricks_(bricks),
+          brick_size_(brick_size),
+          brick_resolution_(brick_resolution){};
+    const int *bricks_;
+    const int brick_size_;
+    const int brick_resolution_;
+    __device__ void operator()(size_t idx) {
+        const int brick_vol = brick_size_ * brick_size_ * brick_size_;
+        const int brick = bricks_[idx / brick_vol];
+        const int local = idx % brick_vol;
+        const int bres2 = brick_resolution_ * brick_resolution_;
+        const int bs2 = brick_size_ * brick_size_;
+        int x = (brick / bres2) * brick_size_ + local / bs2;
+        int y = ((brick % bres2) / brick_resolution_) * brick_size_ +
+                (local % bs2) / brick_size_;
+        int z = (brick % brick_resolution_) * brick_size_ +
+                local % brick_size_;
+        const int res = this->resolution_;
+        if (x >= res || y >= res || z >= res) return;
+        int h_res = res / 2;
+        this->ComputeTSDF(this->voxels_[IndexOf(x, y, z, res)], this->origin_,
+                          x - h_res, y - h_res, z - h_res);
+    }
+};
+
+/// Integrates a batch of frames into the voxels of the bricks in \p bricks.
+/// The observations of all the frames are accumulated in registers and each
+/// voxel is written once, which gives the same result as integrating the
+/// frames one by one.
+template <typename VoxelType>
+struct uniform_batch_integrate_functor {
+    uniform_batch_integrate_functor(
+            float fx,
+            float fy,
+            float cx,
+            float cy,
+            float voxel_length,
+            float sdf_trunc,
+            float safe_width,
+            float safe_height,
+            int resolution,
+            const uint8_t *const *colors,
+            const uint8_t *const *depths,
+            const Eigen::Matrix4f *extrinsics,
+            int n_frames,
+            const uint8_t *depth_to_camera_distance_multiplier,
+            int width,
+            int num_of_channels,
+            TSDFVolumeColorType color_type,
+            const Eigen::Vector3f &origin,
+            VoxelType *voxels,
+            const int *bricks,
+            int brick_size,
+            int brick_resolution)
+        : fx_(fx),
+          fy_(fy),
+          cx_(cx),
+          cy_(cy),
+          voxel_length_(voxel_length),
+          sdf_trunc_(sdf_trunc),
+          sdf_trunc_inv_(1.0 / sdf_trunc),
+          safe_width_(safe_width),
+          safe_height_(safe_height),
+          resolution_(resolution),
+          colors_(colors),
+          depths_(depths),
+          extrinsics_(extrinsics),
+          n_frames_(n_frames),
+          depth_to_camera_distance_multiplier_(
+                  depth_to_camera_distance_multiplier),
+          width_(width),
+          num_of_channels_(num_of_channels),
+          color_type_(color_type),
+          origin_(origin),
+          voxels_(voxels),
+          bricks_(bricks),
+          brick_size_(brick_size),
+          brick_resolution_(brick_resolution) {}
+    const float fx_;
+    const float fy_;
+    const float cx_;
+    const float cy_;
+    const float voxel_length_;
+    const float sdf_trunc_;
+    const float sdf_trunc_inv_;
+    const float safe_width_;
+    const float safe_height_;
+    const int resolution_;
+    const uint8_t *const *colors_;
+    const uint8_t *const *depths_;
+    const Eigen::Matrix4f *extrinsics_;
+    const int n_frames_;
+    const uint8_t *depth_to_camera_distance_multiplier_;
+    const int width_;
+    const int num_of_channels_;
+    const TSDFVolumeColorType color_type_;
+    const Eigen::Vector3f origin_;
+    VoxelType *voxels_;
+    const int *bricks_;
+    const int brick_size_;
+    const int brick_resolution_;
+    __device__ void operator()(size_t idx) {
+        const int brick_vol = brick_size_ * brick_size_ * brick_size_;
+        const int brick = bricks_[idx / brick_vol];
+        const int local = idx % brick_vol;
+        const int bres2 = brick_resolution_ * brick_resolution_;
+        const int bs2 = brick_size_ * brick_size_;
+        int x = (brick / bres2) * brick_size_ + local / bs2;
+        int y = ((brick % bres2) / brick_resolution_) * brick_size_ +
+                (local % bs2) / brick_size_;
+        int z = (brick % brick_resolution_) * brick_size_ +
+                local % brick_size_;
+        if (x >= resolution_ || y >= resolution_ || z >= resolution_) return;
+        const float h_res = resolution_ / 2 - 0.5f;
+        const Eigen::Vector3f pt =
+                origin_ + voxel_length_ * (Eigen::Vector3f(x, y, z) -
+                                           Eigen::Vector3f::Constant(h_res));
+
+        float tsdf_sum = 0.0f;
+        Eigen::Vector3f color_sum = Eigen::Vector3f::Zero();
+        float n_obs = 0.0f;
+        for (int i = 0; i < n_frames_; ++i) {
+            const Eigen::Matrix4f &extrinsic = extrinsics_[i];
+            const Eigen::Vector3f pt_camera =
+                    extrinsic.block<3, 3>(0, 0) * pt +
+                    extrinsic.block<3, 1>(0, 3);
+            if (pt_camera(2) <= 0) continue;
+            const float u_f = pt_camera(0) * fx_ / pt_camera(2) + cx_ + 0.5f;
+            const float v_f = pt_camera(1) * fy_ / pt_camera(2) + cy_ + 0.5f;
+            if (!(u_f >= 0.0001f && u_f < safe_width_ && v_f >= 0.0001f &&
+                  v_f < safe_height_)) {
+                continue;
+            }
+            const int u = __float2int_rd(u_f);
+            const int v = __float2int_rd(v_f);
+            const float d =
+                    *geometry::PointerAt<float>(depths_[i], width_, u, v);
+            if (d <= 0.0f) continue;
+            const float sdf =
+                    (d - pt_camera(2)) *
+                    (*geometry::PointerAt<float>(
+                            depth_to_camera_distance_multiplier_, width_, u,
+                            v));
+            if (!(sdf > -sdf_trunc_)) continue;
+            tsdf_sum += min(1.0f, sdf * sdf_trunc_inv_);
+            if (color_type_ == TSDFVolumeColorType::RGB8) {
+                const uint8_t *rgb = geometry::PointerAt<uint8_t>(
+                        colors_[i], width_, num_of_channels_, u, v, 0);
+                color_sum += Eigen::Vector3f(rgb[0], rgb[1], rgb[2]);
+            } else if (color_type_ == TSDFVolumeColorType::Gray32) {
+                color_sum += Eigen::Vector3f::Constant(
+                        *geometry::PointerAt<float>(
+                                colors_[i], width_, num_of_channels_, u, v, 0));
+            }
+            n_obs += 1.0f;
+        }
+        if (n_obs == 0.0f) return;
+
+        VoxelType &voxel = voxels_[IndexOf(x, y, z, resolution_)];
+        const float w = voxel.GetWeight();
+        Eigen::Vector3f color = voxel.GetColor();
+        if (color_type_ != TSDFVolumeColorType::NoColor) {
+            color = (color * w + color_sum) / (w + n_obs);
+        }
+        voxel.Set((voxel.GetTSDF() * w + tsdf_sum) / (w + n_obs), w + n_obs,
+                  color);
+    }
+};
+
 }  // namespace integration
 }  // namespace cupoch
\ No newline at end of file
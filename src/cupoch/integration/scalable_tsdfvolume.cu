@@ -18,13 +18,17 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  **/
+#include <thrust/binary_search.h>
+
 #include <stdgpu/unordered_map.cuh>
+#include <unordered_map>
 
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/integration/integrate_functor.h"
 #include "cupoch/integration/marching_cubes_const.h"
 #include "cupoch/integration/scalable_tsdfvolume.h"
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/eigen.h"
 #include "cupoch/utility/platform.h"
 #include "cupoch/utility/range.h"
 
@@ -35,9 +39,32 @@ typedef stdgpu::unordered_map<Eigen::Vector3i,
                               ScalableTSDFVolume::VolumeUnit<>,
                               utility::hash_eigen<Eigen::Vector3i>>
         VolumeUnitsMap;
+typedef ScalableTSDFVolume::VolumeUnit<> VolumeUnitType;
+
 class ScalableTSDFVolume::VolumeUnitsImpl {
 public:
+    void ClearMesh() {
+        resize_all(0, vertex_edges_, vertex_units_, vertices_,
+                   vertex_colors_);
+        resize_all(0, triangle_edges_, triangle_units_);
+    }
+
     VolumeUnitsMap volume_units_;
+    /// Cached mesh of the units meshed so far. A vertex is identified by its
+    /// edge, the global index of the start voxel and the axis, and the
+    /// vertices are sorted by edge. The triangles hold the edges of their
+    /// three vertices.
+    utility::device_vector<Eigen::Vector4i> vertex_edges_;
+    utility::device_vector<Eigen::Vector3i> vertex_units_;
+    utility::device_vector<Eigen::Vector3f> vertices_;
+    utility::device_vector<Eigen::Vector3f> vertex_colors_;
+    utility::device_vector<Eigen::Vector4i> triangle_edges_;
+    utility::device_vector<Eigen::Vector3i> triangle_units_;
+    /// Voxels of the units streamed out to host memory.
+    std::unordered_map<Eigen::Vector3i,
+                       thrust::host_vector<geometry::TSDFVoxel>,
+                       utility::hash_eigen<Eigen::Vector3i>>
+            host_units_;
 };
 
 namespace {
@@ -90,7 +117,10 @@ struct scalable_integrate_functor : public integrate_functor {
         int z = yz % resolution_;
         auto &tsdfvol = (volume_units_.begin() + n_v)->second;
         if (tsdfvol.is_initialized_) {
-            ComputeTSDF(tsdfvol.voxels_[xyz], tsdfvol.origin_, x, y, z);
+            geometry::TSDFVoxel &voxel = tsdfvol.voxels_[xyz];
+            const float weight = voxel.weight_;
+            ComputeTSDF(voxel, tsdfvol.origin_, x, y, z);
+            if (voxel.weight_ != weight) tsdfvol.is_updated_ = true;
         }
     }
 };
@@ -101,7 +131,7 @@ __global__ void OpenVolumeUnitKernel(const Eigen::Vector3f *points,
                                      int n,
                                      VolumeUnitsMap volume_units) {
     int idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (idx > n) return;
+    if (idx >= n) return;
     auto min_bound =
             LocateVolumeUnit(points[idx] - Eigen::Vector3f::Constant(sdf_trunc),
                              volume_unit_length);
@@ -291,6 +321,510 @@ struct extract_pointcloud_functor {
     }
 };
 
+__constant__ int vert_table[3] = {0, 2, 1};
+
+struct get_updated_unit_functor {
+    get_updated_unit_functor(
+            const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type>
+                    &range)
+        : range_(range){};
+    const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type> range_;
+    __device__ thrust::tuple<Eigen::Vector3i, bool> operator()(
+            size_t idx) const {
+        const auto &pair_val = *(range_.begin() + idx);
+        return thrust::make_tuple(pair_val.first, pair_val.second.is_updated_);
+    }
+};
+
+struct reset_updated_unit_functor {
+    reset_updated_unit_functor(VolumeUnitsMap volume_units)
+        : volume_units_(volume_units){};
+    VolumeUnitsMap volume_units_;
+    __device__ void operator()(const Eigen::Vector3i &key) {
+        auto unit_itr = volume_units_.find(key);
+        if (unit_itr != volume_units_.end()) {
+            unit_itr->second.is_updated_ = false;
+        }
+    }
+};
+
+/// The cubes of a unit read the voxels of the 7 upper neighbor units, so the
+/// unit has to be meshed again if one of them is updated.
+struct lower_neighbor_unit_functor {
+    lower_neighbor_unit_functor(const Eigen::Vector3i *keys) : keys_(keys){};
+    const Eigen::Vector3i *keys_;
+    __device__ Eigen::Vector3i operator()(size_t idx) const {
+        const int k = idx % 8;
+        return keys_[idx / 8] -
+               Eigen::Vector3i(k & 1, (k >> 1) & 1, (k >> 2) & 1);
+    }
+};
+
+/// Finds the unit and its 7 upper neighbors, indexed by dx + 2 dy + 4 dz.
+struct find_neighbor_units_functor {
+    find_neighbor_units_functor(const VolumeUnitsMap &volume_units,
+                                const Eigen::Vector3i *keys)
+        : volume_units_(volume_units), keys_(keys){};
+    const VolumeUnitsMap volume_units_;
+    const Eigen::Vector3i *keys_;
+    __device__ const VolumeUnitType *operator()(size_t idx) const {
+        const int k = idx % 8;
+        const Eigen::Vector3i key =
+                keys_[idx / 8] +
+                Eigen::Vector3i(k & 1, (k >> 1) & 1, (k >> 2) & 1);
+        auto unit_itr = volume_units_.find(key);
+        if (unit_itr == volume_units_.end()) return nullptr;
+        return &(unit_itr->second);
+    }
+};
+
+struct mesh_volume_units_functor_base {
+    mesh_volume_units_functor_base(const VolumeUnitType *const *units,
+                                   int resolution)
+        : units_(units),
+          resolution_(resolution),
+          voxel_num_(resolution * resolution * resolution){};
+    const VolumeUnitType *const *units_;
+    const int resolution_;
+    const int voxel_num_;
+    /// Returns the observed voxel at \p idx in [0, resolution] of the i-th
+    /// unit, looking into the upper neighbors, or nullptr.
+    __device__ const geometry::TSDFVoxel *VoxelAt(
+            size_t i, const Eigen::Vector3i &idx) const {
+        const Eigen::Vector3i o((idx[0] >= resolution_) ? 1 : 0,
+                                (idx[1] >= resolution_) ? 1 : 0,
+                                (idx[2] >= resolution_) ? 1 : 0);
+        const VolumeUnitType *unit = units_[i * 8 + o[0] + 2 * o[1] + 4 * o[2]];
+        if (unit == nullptr) return nullptr;
+        const geometry::TSDFVoxel &v =
+                unit->voxels_[IndexOf(idx - o * resolution_, resolution_)];
+        return (v.weight_ == 0.0f) ? nullptr : &v;
+    }
+    __device__ Eigen::Vector3i LocalIndexOf(size_t idx) const {
+        int x, y, z;
+        thrust::tie(x, y, z) = KeyOf(idx % voxel_num_, resolution_);
+        return Eigen::Vector3i(x, y, z);
+    }
+    __device__ bool IsCrossing(const geometry::TSDFVoxel *v0,
+                               const geometry::TSDFVoxel *v1) const {
+        return v0 != nullptr && v1 != nullptr &&
+               (v0->tsdf_ < 0.0f) != (v1->tsdf_ < 0.0f);
+    }
+    __device__ int CubeIndexAt(size_t i, const Eigen::Vector3i &idx) const {
+        int cube_index = 0;
+        for (int j = 0; j < 8; ++j) {
+            const geometry::TSDFVoxel *v =
+                    VoxelAt(i, idx + Eigen::Vector3i(shift[j][0], shift[j][1],
+                                                     shift[j][2]));
+            if (v == nullptr) return -1;
+            if (v->tsdf_ < 0.0f) cube_index |= (1 << j);
+        }
+        return cube_index;
+    }
+};
+
+struct count_mesh_elements_functor : public mesh_volume_units_functor_base {
+    count_mesh_elements_functor(const VolumeUnitType *const *units,
+                                int resolution)
+        : mesh_volume_units_functor_base(units, resolution){};
+    __device__ thrust::tuple<int, int> operator()(size_t idx) const {
+        const size_t i = idx / voxel_num_;
+        const Eigen::Vector3i local = LocalIndexOf(idx);
+        const geometry::TSDFVoxel *v0 = VoxelAt(i, local);
+        int n_vertices = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            Eigen::Vector3i local1 = local;
+            local1[axis] += 1;
+            if (IsCrossing(v0, VoxelAt(i, local1))) ++n_vertices;
+        }
+        int n_triangles = 0;
+        const int cube_index = CubeIndexAt(i, local);
+        if (cube_index > 0 && cube_index < 255) {
+            for (int k = 0; tri_table[cube_index][k] != -1; k += 3) {
+                ++n_triangles;
+            }
+        }
+        return thrust::make_tuple(n_vertices, n_triangles);
+    }
+};
+
+struct extract_mesh_elements_functor : public mesh_volume_units_functor_base {
+    extract_mesh_elements_functor(const VolumeUnitType *const *units,
+                                  const Eigen::Vector3i *keys,
+                                  int resolution,
+                                  float voxel_length,
+                                  TSDFVolumeColorType color_type,
+                                  const int *vertex_offsets,
+                                  const int *triangle_offsets,
+                                  Eigen::Vector4i *vertex_edges,
+                                  Eigen::Vector3i *vertex_units,
+                                  Eigen::Vector3f *vertices,
+                                  Eigen::Vector3f *vertex_colors,
+                                  Eigen::Vector4i *triangle_edges,
+                                  Eigen::Vector3i *triangle_units)
+        : mesh_volume_units_functor_base(units, resolution),
+          keys_(keys),
+          voxel_length_(voxel_length),
+          color_type_(color_type),
+          vertex_offsets_(vertex_offsets),
+          triangle_offsets_(triangle_offsets),
+          vertex_edges_(vertex_edges),
+          vertex_units_(vertex_units),
+          vertices_(vertices),
+          vertex_colors_(vertex_colors),
+          triangle_edges_(triangle_edges),
+          triangle_units_(triangle_units){};
+    const Eigen::Vector3i *keys_;
+    const float voxel_length_;
+    const TSDFVolumeColorType color_type_;
+    const int *vertex_offsets_;
+    const int *triangle_offsets_;
+    Eigen::Vector4i *vertex_edges_;
+    Eigen::Vector3i *vertex_units_;
+    Eigen::Vector3f *vertices_;
+    Eigen::Vector3f *vertex_colors_;
+    Eigen::Vector4i *triangle_edges_;
+    Eigen::Vector3i *triangle_units_;
+    __device__ Eigen::Vector3f ColorOf(const geometry::TSDFVoxel &v) const {
+        if (color_type_ == TSDFVolumeColorType::RGB8) {
+            return v.color_ / 255.0;
+        } else if (color_type_ == TSDFVolumeColorType::Gray32) {
+            return v.color_;
+        }
+        return Eigen::Vector3f::Zero();
+    }
+    __device__ void operator()(size_t idx) {
+        const size_t i = idx / voxel_num_;
+        const Eigen::Vector3i local = LocalIndexOf(idx);
+        const Eigen::Vector3i &key = keys_[i];
+        const Eigen::Vector3i global = key * resolution_ + local;
+        const geometry::TSDFVoxel *v0 = VoxelAt(i, local);
+        int vo = vertex_offsets_[idx];
+        for (int axis = 0; axis < 3; ++axis) {
+            Eigen::Vector3i local1 = local;
+            local1[axis] += 1;
+            const geometry::TSDFVoxel *v1 = VoxelAt(i, local1);
+            if (!IsCrossing(v0, v1)) continue;
+            const float f0 = abs(v0->tsdf_);
+            const float f1 = abs(v1->tsdf_);
+            Eigen::Vector3f pt =
+                    units_[i * 8]->origin_ +
+                    (local.cast<float>() + Eigen::Vector3f::Constant(0.5)) *
+                            voxel_length_;
+            pt[axis] += f0 * voxel_length_ / (f0 + f1);
+            vertex_edges_[vo] =
+                    Eigen::Vector4i(global[0], global[1], global[2], axis);
+            vertex_units_[vo] = key;
+            vertices_[vo] = pt;
+            vertex_colors_[vo] =
+                    (f1 * ColorOf(*v0) + f0 * ColorOf(*v1)) / (f0 + f1);
+            ++vo;
+        }
+        const int cube_index = CubeIndexAt(i, local);
+        if (cube_index <= 0 || cube_index >= 255) return;
+        const int to = triangle_offsets_[idx];
+        for (int k = 0; tri_table[cube_index][k] != -1; ++k) {
+            const int e = tri_table[cube_index][k];
+            const int ti = 3 * (to + k / 3) + vert_table[k % 3];
+            triangle_edges_[ti] = Eigen::Vector4i(global[0] + edge_shift[e][0],
+                                                  global[1] + edge_shift[e][1],
+                                                  global[2] + edge_shift[e][2],
+                                                  edge_shift[e][3]);
+            triangle_units_[ti] = key;
+        }
+    }
+};
+
+struct assemble_triangles_functor {
+    assemble_triangles_functor(const Eigen::Vector4i *vertex_edges,
+                               int n_vertices,
+                               const Eigen::Vector4i *triangle_edges,
+                               const int *vertex_indices)
+        : vertex_edges_(vertex_edges),
+          n_vertices_(n_vertices),
+          triangle_edges_(triangle_edges),
+          vertex_indices_(vertex_indices){};
+    const Eigen::Vector4i *vertex_edges_;
+    const int n_vertices_;
+    const Eigen::Vector4i *triangle_edges_;
+    const int *vertex_indices_;
+    __device__ Eigen::Vector3i operator()(size_t idx) const {
+        Eigen::Vector3i triangle;
+        for (int j = 0; j < 3; ++j) {
+            const int k = vertex_indices_[3 * idx + j];
+            const Eigen::Vector4i &edge = triangle_edges_[3 * idx + j];
+            if (k >= n_vertices_ ||
+                (vertex_edges_[k].array() != edge.array()).any()) {
+                return Eigen::Vector3i::Constant(-1);
+            }
+            triangle[j] = k;
+        }
+        return triangle;
+    }
+};
+
+/// Reads the voxels of the volume units by their global voxel index.
+struct scalable_voxel_accessor {
+    scalable_voxel_accessor(const VolumeUnitsMap &volume_units,
+                            int resolution,
+                            float voxel_length)
+        : volume_units_(volume_units),
+          resolution_(resolution),
+          voxel_length_(voxel_length){};
+    const VolumeUnitsMap volume_units_;
+    const int resolution_;
+    const float voxel_length_;
+    /// Returns the voxel or nullptr if it is not observed.
+    __device__ const geometry::TSDFVoxel *GetVoxel(
+            const Eigen::Vector3i &index) const {
+        Eigen::Vector3i key;
+#pragma unroll
+        for (int i = 0; i < 3; ++i) {
+            key(i) = (index(i) >= 0) ? index(i) / resolution_
+                                     : (index(i) + 1) / resolution_ - 1;
+        }
+        auto unit_itr = volume_units_.find(key);
+        if (unit_itr == volume_units_.end()) return nullptr;
+        const geometry::TSDFVoxel &voxel =
+                unit_itr->second.voxels_[IndexOf(index - key * resolution_,
+                                                 resolution_)];
+        return (voxel.weight_ > 0.0f) ? &voxel : nullptr;
+    }
+    __device__ const geometry::TSDFVoxel *GetVoxelAt(
+            const Eigen::Vector3f &p) const {
+        return GetVoxel(
+                Eigen::device_vectorize<float, 3, ::floor>(p / voxel_length_)
+                        .cast<int>());
+    }
+    /// Trilinear interpolation of the TSDF, false if a voxel is not
+    /// observed.
+    __device__ bool InterpolateTSDF(const Eigen::Vector3f &p,
+                                    float &tsdf) const {
+        const Eigen::Vector3f p_grid =
+                p / voxel_length_ - Eigen::Vector3f::Constant(0.5f);
+        const Eigen::Vector3i index0 =
+                Eigen::device_vectorize<float, 3, ::floor>(p_grid)
+                        .cast<int>();
+        const Eigen::Vector3f r = p_grid - index0.cast<float>();
+        tsdf = 0.0f;
+        for (int i = 0; i < 8; ++i) {
+            const geometry::TSDFVoxel *voxel = GetVoxel(
+                    index0 +
+                    Eigen::Vector3i(shift[i][0], shift[i][1], shift[i][2]));
+            if (!voxel) return false;
+            const float w = (shift[i][0] ? r(0) : 1.0f - r(0)) *
+                            (shift[i][1] ? r(1) : 1.0f - r(1)) *
+                            (shift[i][2] ? r(2) : 1.0f - r(2));
+            tsdf += w * voxel->tsdf_;
+        }
+        return true;
+    }
+};
+
+struct raycast_scalable_tsdf_functor : public scalable_voxel_accessor {
+    raycast_scalable_tsdf_functor(const VolumeUnitsMap &volume_units,
+                                  int resolution,
+                                  float voxel_length,
+                                  int width,
+                                  float fx,
+                                  float fy,
+                                  float cx,
+                                  float cy,
+                                  const Eigen::Matrix4f &campose,
+                                  float sdf_trunc,
+                                  float max_depth,
+                                  TSDFVolumeColorType color_type)
+        : scalable_voxel_accessor(volume_units, resolution, voxel_length),
+          width_(width),
+          fx_(fx),
+          fy_(fy),
+          cx_(cx),
+          cy_(cy),
+          campose_(campose),
+          sdf_trunc_(sdf_trunc),
+          max_depth_(max_depth),
+          color_type_(color_type){};
+    const int width_;
+    const float fx_;
+    const float fy_;
+    const float cx_;
+    const float cy_;
+    const Eigen::Matrix4f campose_;
+    const float sdf_trunc_;
+    const float max_depth_;
+    const TSDFVolumeColorType color_type_;
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>
+    operator()(size_t idx) const {
+        const Eigen::Vector3f nanvec = Eigen::Vector3f::Constant(
+                std::numeric_limits<float>::quiet_NaN());
+        const int y = idx / width_;
+        const int x = idx % width_;
+        const Eigen::Vector3f pixel_pos((x - cx_) / fx_, (y - cy_) / fy_, 1.0f);
+        const float max_length = max_depth_ * pixel_pos.norm();
+        const Eigen::Vector3f ray_dir =
+                (campose_.block<3, 3>(0, 0) * pixel_pos).normalized();
+        const Eigen::Vector3f ray_org = campose_.block<3, 1>(0, 3);
+        const float step = sdf_trunc_ * 0.5f;
+        float prev_tsdf = 0.0f;
+        bool prev_valid = false;
+        for (float ray_len = 0.0f; ray_len < max_length; ray_len += step) {
+            const geometry::TSDFVoxel *voxel =
+                    GetVoxelAt(ray_org + ray_dir * ray_len);
+            if (!voxel) {
+                prev_valid = false;
+                continue;
+            }
+            const float tsdf = voxel->tsdf_;
+            if (prev_valid && prev_tsdf < 0.0f && tsdf > 0.0f) break;
+            if (prev_valid && prev_tsdf > 0.0f && tsdf < 0.0f) {
+                const float t_star = ray_len + step * tsdf / (prev_tsdf - tsdf);
+                const Eigen::Vector3f vertex = ray_org + ray_dir * t_star;
+                Eigen::Vector3f normal;
+                for (int i = 0; i < 3; ++i) {
+                    Eigen::Vector3f p0 = vertex;
+                    p0(i) -= voxel_length_;
+                    Eigen::Vector3f p1 = vertex;
+                    p1(i) += voxel_length_;
+                    float f0, f1;
+                    if (!InterpolateTSDF(p0, f0) || !InterpolateTSDF(p1, f1)) {
+                        return thrust::make_tuple(nanvec, nanvec, nanvec);
+                    }
+                    normal(i) = f1 - f0;
+                }
+                const float norm_nml = normal.norm();
+                if (norm_nml == 0) break;
+                normal /= norm_nml;
+                const geometry::TSDFVoxel *v = GetVoxelAt(vertex);
+                if (!v) v = voxel;
+                Eigen::Vector3f c = Eigen::Vector3f::Zero();
+                if (color_type_ == TSDFVolumeColorType::RGB8) {
+                    c = v->color_ / 255.0;
+                } else if (color_type_ == TSDFVolumeColorType::Gray32) {
+                    c = v->color_;
+                }
+                return thrust::make_tuple(vertex, normal, c);
+            }
+            prev_tsdf = tsdf;
+            prev_valid = true;
+        }
+        return thrust::make_tuple(nanvec, nanvec, nanvec);
+    }
+};
+
+struct far_unit_functor {
+    far_unit_functor(
+            const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type>
+                    &range,
+            const Eigen::Vector3f &center,
+            float radius,
+            float volume_unit_length)
+        : range_(range),
+          center_(center),
+          radius_(radius),
+          volume_unit_length_(volume_unit_length){};
+    const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type> range_;
+    const Eigen::Vector3f center_;
+    const float radius_;
+    const float volume_unit_length_;
+    __device__ thrust::tuple<Eigen::Vector3i, bool> operator()(
+            size_t idx) const {
+        const auto &pair_val = *(range_.begin() + idx);
+        const Eigen::Vector3f unit_center =
+                (pair_val.first.cast<float>() +
+                 Eigen::Vector3f::Constant(0.5f)) *
+                volume_unit_length_;
+        return thrust::make_tuple(pair_val.first,
+                                  (unit_center - center_).norm() > radius_);
+    }
+};
+
+struct copy_unit_voxels_functor {
+    copy_unit_voxels_functor(const VolumeUnitsMap &volume_units,
+                             const Eigen::Vector3i *keys)
+        : volume_units_(volume_units), keys_(keys){};
+    const VolumeUnitsMap volume_units_;
+    const Eigen::Vector3i *keys_;
+    __device__ geometry::TSDFVoxel operator()(size_t idx) const {
+        const int n_v = VolumeUnitType::GetVoxelNum();
+        auto unit_itr = volume_units_.find(keys_[idx / n_v]);
+        return unit_itr->second.voxels_[idx % n_v];
+    }
+};
+
+struct erase_unit_functor {
+    erase_unit_functor(VolumeUnitsMap volume_units)
+        : volume_units_(volume_units){};
+    VolumeUnitsMap volume_units_;
+    __device__ void operator()(const Eigen::Vector3i &key) {
+        // The integration visits every slot of the map and skips the ones
+        // which are not initialized.
+        auto unit_itr = volume_units_.find(key);
+        if (unit_itr != volume_units_.end()) {
+            unit_itr->second.is_initialized_ = false;
+        }
+        volume_units_.erase(key);
+    }
+};
+
+struct copy_unit_functor {
+    copy_unit_functor(
+            const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type>
+                    &range,
+            VolumeUnitsMap volume_units)
+        : range_(range), volume_units_(volume_units){};
+    const stdgpu::device_indexed_range<const VolumeUnitsMap::value_type> range_;
+    VolumeUnitsMap volume_units_;
+    __device__ void operator()(size_t idx) {
+        const auto &pair_val = *(range_.begin() + idx);
+        volume_units_.emplace(pair_val.first, pair_val.second);
+    }
+};
+
+struct insert_unit_functor {
+    insert_unit_functor(VolumeUnitsMap volume_units, float volume_unit_length)
+        : volume_units_(volume_units),
+          volume_unit_length_(volume_unit_length){};
+    VolumeUnitsMap volume_units_;
+    const float volume_unit_length_;
+    __device__ bool operator()(const Eigen::Vector3i &key) {
+        return volume_units_
+                .emplace(key, VolumeUnitType(key.cast<float>() *
+                                             volume_unit_length_))
+                .second;
+    }
+};
+
+struct restore_unit_voxels_functor {
+    restore_unit_voxels_functor(VolumeUnitsMap volume_units,
+                                const Eigen::Vector3i *keys,
+                                const geometry::TSDFVoxel *voxels,
+                                const bool *inserted)
+        : volume_units_(volume_units),
+          keys_(keys),
+          voxels_(voxels),
+          inserted_(inserted){};
+    VolumeUnitsMap volume_units_;
+    const Eigen::Vector3i *keys_;
+    const geometry::TSDFVoxel *voxels_;
+    const bool *inserted_;
+    __device__ void operator()(size_t idx) {
+        const int n_v = VolumeUnitType::GetVoxelNum();
+        if (!inserted_[idx / n_v]) return;
+        auto unit_itr = volume_units_.find(keys_[idx / n_v]);
+        if (unit_itr != volume_units_.end()) {
+            unit_itr->second.voxels_[idx % n_v] = voxels_[idx];
+        }
+    }
+};
+
+template <typename T>
+void AppendVector(utility::device_vector<T> &dst,
+                  const utility::device_vector<T> &src) {
+    const size_t n = dst.size();
+    dst.resize(n + src.size());
+    thrust::copy(src.begin(), src.end(), dst.begin() + n);
+}
+
 }  // namespace
 
 ScalableTSDFVolume::ScalableTSDFVolume(float voxel_length,
@@ -307,11 +841,32 @@ ScalableTSDFVolume::ScalableTSDFVolume(float voxel_length,
     impl_->volume_units_ = VolumeUnitsMap::createDeviceObject(map_size);
 }
 
+ScalableTSDFVolume::ScalableTSDFVolume(const ScalableTSDFVolume &other)
+    : TSDFVolume(other.voxel_length_, other.sdf_trunc_, other.color_type_),
+      volume_unit_length_(other.volume_unit_length_),
+      resolution_(other.resolution_),
+      volume_unit_voxel_num_(other.volume_unit_voxel_num_),
+      depth_sampling_stride_(other.depth_sampling_stride_) {
+    impl_ = std::make_shared<VolumeUnitsImpl>(*other.impl_);
+    impl_->volume_units_ = VolumeUnitsMap::createDeviceObject(
+            other.impl_->volume_units_.max_size());
+    copy_unit_functor func(other.impl_->volume_units_.device_range(),
+                           impl_->volume_units_);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(
+                             other.impl_->volume_units_.size()),
+                     func);
+}
+
 ScalableTSDFVolume::~ScalableTSDFVolume() {
     VolumeUnitsMap::destroyDeviceObject(impl_->volume_units_);
 }
 
-void ScalableTSDFVolume::Reset() { impl_->volume_units_.clear(); }
+void ScalableTSDFVolume::Reset() {
+    impl_->volume_units_.clear();
+    impl_->ClearMesh();
+    impl_->host_units_.clear();
+}
 
 void ScalableTSDFVolume::Integrate(
         const geometry::RGBDImage &image,
@@ -336,9 +891,8 @@ void ScalableTSDFVolume::Integrate(
         utility::LogError(
                 "[ScalableTSDFVolume::Integrate] Unsupported image format.");
     }
-    auto depth2cameradistance =
-            geometry::Image::CreateDepthToCameraDistanceMultiplierFloatImage(
-                    intrinsic);
+    const auto &depth2cameradistance =
+            GetDepthToCameraDistanceMultiplier(intrinsic);
     auto pointcloud = geometry::PointCloud::CreateFromDepthImage(
             image.depth_, intrinsic, extrinsic, 1000.0, 1000.0,
             depth_sampling_stride_);
@@ -350,7 +904,7 @@ void ScalableTSDFVolume::Integrate(
             volume_unit_length_, n_points, impl_->volume_units_);
     cudaSafeCall(cudaDeviceSynchronize());
     IntegrateWithDepthToCameraDistanceMultiplier(image, intrinsic, extrinsic,
-                                                 *depth2cameradistance);
+                                                 depth2cameradistance);
 }
 
 std::shared_ptr<geometry::PointCloud> ScalableTSDFVolume::ExtractPointCloud() {
@@ -375,9 +929,152 @@ std::shared_ptr<geometry::PointCloud> ScalableTSDFVolume::ExtractPointCloud() {
 
 std::shared_ptr<geometry::TriangleMesh>
 ScalableTSDFVolume::ExtractTriangleMesh() {
-    utility::LogError(
-            "ScalableTSDFVolume::ExtractTriangleMesh is not impelemented");
+    // implementation of marching cubes, based on
+    // http://paulbourke.net/geometry/polygonise/
     auto mesh = std::make_shared<geometry::TriangleMesh>();
+    VolumeUnitsImpl &impl = *impl_;
+
+    // collect the units updated since the last extraction
+    const size_t n_units = impl.volume_units_.size();
+    utility::device_vector<Eigen::Vector3i> updated_keys(n_units);
+    utility::device_vector<bool> updated_flags(n_units);
+    get_updated_unit_functor func0(impl.volume_units_.device_range());
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_units),
+                      make_tuple_begin(updated_keys, updated_flags), func0);
+    remove_if_vectors(
+            [] __device__(const thrust::tuple<Eigen::Vector3i, bool> &x) {
+                return !thrust::get<1>(x);
+            },
+            updated_keys, updated_flags);
+    thrust::for_each(updated_keys.begin(), updated_keys.end(),
+                     reset_updated_unit_functor(impl.volume_units_));
+
+    if (!updated_keys.empty()) {
+        // units to mesh again
+        utility::device_vector<Eigen::Vector3i> keys(updated_keys.size() * 8);
+        lower_neighbor_unit_functor nfunc(
+                thrust::raw_pointer_cast(updated_keys.data()));
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(keys.size()),
+                          keys.begin(), nfunc);
+        thrust::sort(utility::exec_policy(0)->on(0), keys.begin(), keys.end());
+        keys.resize(thrust::distance(
+                keys.begin(), thrust::unique(utility::exec_policy(0)->on(0),
+                                             keys.begin(), keys.end())));
+        utility::device_vector<const VolumeUnitType *> units(keys.size() * 8);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(units.size()),
+                          units.begin(),
+                          find_neighbor_units_functor(
+                                  impl.volume_units_,
+                                  thrust::raw_pointer_cast(keys.data())));
+
+        // drop the cached elements of these units
+        utility::device_vector<bool> stale(impl.vertex_units_.size());
+        thrust::binary_search(keys.begin(), keys.end(),
+                              impl.vertex_units_.begin(),
+                              impl.vertex_units_.end(), stale.begin());
+        remove_if_vectors(
+                [] __device__(const thrust::tuple<bool, Eigen::Vector4i,
+                                                  Eigen::Vector3i,
+                                                  Eigen::Vector3f,
+                                                  Eigen::Vector3f> &x) {
+                    return thrust::get<0>(x);
+                },
+                stale, impl.vertex_edges_, impl.vertex_units_, impl.vertices_,
+                impl.vertex_colors_);
+        stale.resize(impl.triangle_units_.size());
+        thrust::binary_search(keys.begin(), keys.end(),
+                              impl.triangle_units_.begin(),
+                              impl.triangle_units_.end(), stale.begin());
+        remove_if_vectors(
+                [] __device__(const thrust::tuple<bool, Eigen::Vector4i,
+                                                  Eigen::Vector3i> &x) {
+                    return thrust::get<0>(x);
+                },
+                stale, impl.triangle_edges_, impl.triangle_units_);
+
+        // count, then write the vertices and triangles of each voxel
+        const size_t n_voxels = keys.size() * volume_unit_voxel_num_;
+        utility::device_vector<int> vertex_offsets(n_voxels);
+        utility::device_vector<int> triangle_offsets(n_voxels);
+        count_mesh_elements_functor func1(
+                thrust::raw_pointer_cast(units.data()), resolution_);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(n_voxels),
+                          make_tuple_begin(vertex_offsets, triangle_offsets),
+                          func1);
+        const int n_vertices =
+                thrust::reduce(utility::exec_policy(0)->on(0),
+                               vertex_offsets.begin(), vertex_offsets.end());
+        const int n_triangles = thrust::reduce(
+                utility::exec_policy(0)->on(0), triangle_offsets.begin(),
+                triangle_offsets.end());
+        thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                               vertex_offsets.begin(), vertex_offsets.end(),
+                               vertex_offsets.begin());
+        thrust::exclusive_scan(
+                utility::exec_policy(0)->on(0), triangle_offsets.begin(),
+                triangle_offsets.end(), triangle_offsets.begin());
+        utility::device_vector<Eigen::Vector4i> vertex_edges(n_vertices);
+        utility::device_vector<Eigen::Vector3i> vertex_units(n_vertices);
+        utility::device_vector<Eigen::Vector3f> vertices(n_vertices);
+        utility::device_vector<Eigen::Vector3f> vertex_colors(n_vertices);
+        utility::device_vector<Eigen::Vector4i> triangle_edges(n_triangles * 3);
+        utility::device_vector<Eigen::Vector3i> triangle_units(n_triangles * 3);
+        extract_mesh_elements_functor func2(
+                thrust::raw_pointer_cast(units.data()),
+                thrust::raw_pointer_cast(keys.data()), resolution_,
+                voxel_length_, color_type_,
+                thrust::raw_pointer_cast(vertex_offsets.data()),
+                thrust::raw_pointer_cast(triangle_offsets.data()),
+                thrust::raw_pointer_cast(vertex_edges.data()),
+                thrust::raw_pointer_cast(vertex_units.data()),
+                thrust::raw_pointer_cast(vertices.data()),
+                thrust::raw_pointer_cast(vertex_colors.data()),
+                thrust::raw_pointer_cast(triangle_edges.data()),
+                thrust::raw_pointer_cast(triangle_units.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_voxels), func2);
+
+        AppendVector(impl.vertex_edges_, vertex_edges);
+        AppendVector(impl.vertex_units_, vertex_units);
+        AppendVector(impl.vertices_, vertices);
+        AppendVector(impl.vertex_colors_, vertex_colors);
+        AppendVector(impl.triangle_edges_, triangle_edges);
+        AppendVector(impl.triangle_units_, triangle_units);
+        thrust::sort_by_key(
+                utility::exec_policy(0)->on(0), impl.vertex_edges_.begin(),
+                impl.vertex_edges_.end(),
+                make_tuple_begin(impl.vertex_units_, impl.vertices_,
+                                 impl.vertex_colors_));
+    }
+
+    // assemble the mesh from the cache
+    mesh->vertices_ = impl.vertices_;
+    if (color_type_ != TSDFVolumeColorType::NoColor) {
+        mesh->vertex_colors_ = impl.vertex_colors_;
+    }
+    utility::device_vector<int> vertex_indices(impl.triangle_edges_.size());
+    thrust::lower_bound(impl.vertex_edges_.begin(), impl.vertex_edges_.end(),
+                        impl.triangle_edges_.begin(),
+                        impl.triangle_edges_.end(), vertex_indices.begin());
+    const size_t n_triangles = impl.triangle_edges_.size() / 3;
+    mesh->triangles_.resize(n_triangles);
+    assemble_triangles_functor func3(
+            thrust::raw_pointer_cast(impl.vertex_edges_.data()),
+            impl.vertex_edges_.size(),
+            thrust::raw_pointer_cast(impl.triangle_edges_.data()),
+            thrust::raw_pointer_cast(vertex_indices.data()));
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_triangles),
+                      mesh->triangles_.begin(), func3);
+    auto end = thrust::remove_if(
+            utility::exec_policy(0)->on(0), mesh->triangles_.begin(),
+            mesh->triangles_.end(),
+            [] __device__(const Eigen::Vector3i &idxs) { return idxs[0] < 0; });
+    mesh->triangles_.resize(thrust::distance(mesh->triangles_.begin(), end));
     return mesh;
 }
 
@@ -408,5 +1105,140 @@ void ScalableTSDFVolume::IntegrateWithDepthToCameraDistanceMultiplier(
                      func);
 }
 
+std::shared_ptr<geometry::PointCloud> ScalableTSDFVolume::Raycast(
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic,
+        float sdf_trunc,
+        float max_depth,
+        bool project_valid_depth_only) const {
+    auto pointcloud = std::make_shared<geometry::PointCloud>();
+    size_t n_total = intrinsic.width_ * intrinsic.height_;
+    const float fx = intrinsic.GetFocalLength().first;
+    const float fy = intrinsic.GetFocalLength().second;
+    const float cx = intrinsic.GetPrincipalPoint().first;
+    const float cy = intrinsic.GetPrincipalPoint().second;
+    pointcloud->points_.resize(n_total);
+    pointcloud->normals_.resize(n_total);
+    pointcloud->colors_.resize(n_total);
+    raycast_scalable_tsdf_functor func(
+            impl_->volume_units_, resolution_, voxel_length_, intrinsic.width_,
+            fx, fy, cx, cy, utility::InverseTransform(extrinsic), sdf_trunc,
+            max_depth, color_type_);
+    thrust::transform(
+            thrust::make_counting_iterator<size_t>(0),
+            thrust::make_counting_iterator(n_total),
+            make_tuple_begin(pointcloud->points_, pointcloud->normals_,
+                             pointcloud->colors_),
+            func);
+    pointcloud->RemoveNoneFinitePoints(project_valid_depth_only,
+                                       project_valid_depth_only);
+    return pointcloud;
+}
+
+size_t ScalableTSDFVolume::StreamOut(const Eigen::Vector3f &center,
+                                     float radius) {
+    VolumeUnitsImpl &impl = *impl_;
+    const size_t n_units = impl.volume_units_.size();
+    utility::device_vector<Eigen::Vector3i> keys(n_units);
+    utility::device_vector<bool> flags(n_units);
+    far_unit_functor func(impl.volume_units_.device_range(), center, radius,
+                          volume_unit_length_);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_units),
+                      make_tuple_begin(keys, flags), func);
+    remove_if_vectors(
+            [] __device__(const thrust::tuple<Eigen::Vector3i, bool> &x) {
+                return !thrust::get<1>(x);
+            },
+            keys, flags);
+    const size_t n_out = keys.size();
+    if (n_out == 0) return 0;
+
+    utility::device_vector<geometry::TSDFVoxel> voxels(
+            n_out * volume_unit_voxel_num_);
+    copy_unit_voxels_functor cfunc(impl.volume_units_,
+                                   thrust::raw_pointer_cast(keys.data()));
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(voxels.size()),
+                      voxels.begin(), cfunc);
+    thrust::for_each(keys.begin(), keys.end(),
+                     erase_unit_functor(impl.volume_units_));
+
+    thrust::host_vector<Eigen::Vector3i> h_keys = keys;
+    thrust::host_vector<geometry::TSDFVoxel> h_voxels = voxels;
+    for (size_t i = 0; i < n_out; ++i) {
+        auto begin = h_voxels.begin() + i * volume_unit_voxel_num_;
+        impl.host_units_[h_keys[i]] = thrust::host_vector<geometry::TSDFVoxel>(
+                begin, begin + volume_unit_voxel_num_);
+    }
+    return n_out;
+}
+
+size_t ScalableTSDFVolume::StreamIn(const Eigen::Vector3f &center,
+                                    float radius) {
+    VolumeUnitsImpl &impl = *impl_;
+    // Insertions into the hash map start failing before all of its slots
+    // are used, so the units are only streamed in up to 3/4 of them.
+    const size_t max_units = impl.volume_units_.max_size() / 4 * 3;
+    const size_t n_units = impl.volume_units_.size();
+    const size_t capacity = (max_units > n_units) ? max_units - n_units : 0;
+    thrust::host_vector<Eigen::Vector3i> h_keys;
+    for (const auto &unit : impl.host_units_) {
+        const Eigen::Vector3f unit_center =
+                (unit.first.cast<float>() + Eigen::Vector3f::Constant(0.5f)) *
+                volume_unit_length_;
+        if ((unit_center - center).norm() > radius) continue;
+        if (h_keys.size() >= capacity) {
+            utility::LogWarning(
+                    "[ScalableTSDFVolume::StreamIn] The hash map is full, "
+                    "some volume units stay in host memory.");
+            break;
+        }
+        h_keys.push_back(unit.first);
+    }
+    const size_t n_in = h_keys.size();
+    if (n_in == 0) return 0;
+
+    thrust::host_vector<geometry::TSDFVoxel> h_voxels(n_in *
+                                                      volume_unit_voxel_num_);
+    for (size_t i = 0; i < n_in; ++i) {
+        const auto &unit_voxels = impl.host_units_[h_keys[i]];
+        thrust::copy(unit_voxels.begin(), unit_voxels.end(),
+                     h_voxels.begin() + i * volume_unit_voxel_num_);
+    }
+    utility::device_vector<Eigen::Vector3i> keys = h_keys;
+    utility::device_vector<geometry::TSDFVoxel> voxels = h_voxels;
+    utility::device_vector<bool> inserted(n_in);
+    thrust::transform(keys.begin(), keys.end(), inserted.begin(),
+                      insert_unit_functor(impl.volume_units_,
+                                          volume_unit_length_));
+    restore_unit_voxels_functor rfunc(
+            impl.volume_units_, thrust::raw_pointer_cast(keys.data()),
+            thrust::raw_pointer_cast(voxels.data()),
+            thrust::raw_pointer_cast(inserted.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(voxels.size()), rfunc);
+
+    // The units which could not be inserted stay in host memory.
+    thrust::host_vector<bool> h_inserted = inserted;
+    size_t n_inserted = 0;
+    for (size_t i = 0; i < n_in; ++i) {
+        if (!h_inserted[i]) continue;
+        impl.host_units_.erase(h_keys[i]);
+        ++n_inserted;
+    }
+    if (n_inserted < n_in) {
+        utility::LogWarning(
+                "[ScalableTSDFVolume::StreamIn] {} volume units could not be "
+                "inserted and stay in host memory.",
+                n_in - n_inserted);
+    }
+    return n_inserted;
+}
+
+size_t ScalableTSDFVolume::GetNumStreamedOutUnits() const {
+    return impl_->host_units_.size();
+}
+
 }  // namespace integration
-}  // namespace cupoch
\ No newline at end of file
+}  // namespace cupoch
@@ -62,6 +62,8 @@ public:
         Eigen::Vector3f origin_;
         const int voxel_num_ = Num * Num * Num;
         bool is_initialized_ = false;
+        /// True if a voxel was integrated since the last mesh extraction.
+        bool is_updated_ = false;
         static int GetResolution() { return Num; };
         static int GetVoxelNum() { return Num * Num * Num; };
     };
@@ -72,6 +74,9 @@ public:
                        TSDFVolumeColorType color_type,
                        int depth_sampling_stride = 4,
                        int map_size = 1000);
+    /// Copies the volume units into a new hash map of the same capacity.
+    ScalableTSDFVolume(const ScalableTSDFVolume &other);
+    ScalableTSDFVolume &operator=(const ScalableTSDFVolume &other) = delete;
     ~ScalableTSDFVolume() override;
 
 public:
@@ -80,6 +85,13 @@ public:
                    const camera::PinholeCameraIntrinsic &intrinsic,
                    const Eigen::Matrix4f &extrinsic) override;
     std::shared_ptr<geometry::PointCloud> ExtractPointCloud() override;
+    /// \brief Extracts the iso-surface with the marching cubes algorithm.
+    ///
+    /// The mesh of each volume unit is cached and only the units integrated
+    /// since the last call, together with their lower neighbors whose cubes
+    /// reach into them, are meshed again. Each vertex belongs to the unit
+    /// holding the start voxel of its edge, so that the vertices shared by
+    /// neighboring units are welded.
     std::shared_ptr<geometry::TriangleMesh> ExtractTriangleMesh() override;
     /// Debug function to extract the voxel data into a point cloud.
     std::shared_ptr<geometry::PointCloud> ExtractVoxelPointCloud();
@@ -90,6 +102,40 @@ public:
             const Eigen::Matrix4f &extrinsic,
             const geometry::Image &depth_to_camera_distance_multiplier);
 
+    /// \brief Predicts the surface seen by a camera by raycasting the volume
+    /// units on the GPU.
+    ///
+    /// The result has a point per pixel, NaN where no surface is found, unless
+    /// \p project_valid_depth_only is true.
+    ///
+    /// \param sdf_trunc Truncation distance, half of it is the marching step.
+    /// \param max_depth Maximum depth of the surface along the rays.
+    std::shared_ptr<geometry::PointCloud> Raycast(
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4f &extrinsic,
+            float sdf_trunc,
+            float max_depth,
+            bool project_valid_depth_only = true) const;
+
+    /// \brief Moves the volume units whose center is farther than \p radius
+    /// from \p center from the GPU to host memory.
+    ///
+    /// Only the units on the GPU are integrated, extracted and raycast, so
+    /// that a large scene can be scanned with the fixed capacity of the hash
+    /// map. The cached mesh of the moved units is kept. Returns the number of
+    /// moved units.
+    size_t StreamOut(const Eigen::Vector3f &center, float radius);
+    /// \brief Moves the volume units in host memory whose center is within
+    /// \p radius from \p center back to the GPU.
+    ///
+    /// It has to be called before integrating the frames revisiting the
+    /// units. The hash map is only filled up to 3/4 of its capacity, and the
+    /// units exceeding it or failing to be inserted stay in host memory.
+    /// Returns the number of moved units.
+    size_t StreamIn(const Eigen::Vector3f &center, float radius);
+    /// Returns the number of volume units in host memory.
+    size_t GetNumStreamedOutUnits() const;
+
 public:
     /// Assume the index of the volume key is (x, y, z), then the unit spans
     /// from (x, y, z) * volume_unit_length_
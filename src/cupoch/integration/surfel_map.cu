@@ -0,0 +1,424 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include <thrust/iterator/constant_iterator.h>
+
+#include "cupoch/integration/surfel_map.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/eigen.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/platform.h"
+
+namespace cupoch {
+namespace integration {
+
+namespace {
+
+const unsigned long long kEmptyKey = ~0ULL;
+
+bool IsSupportedImage(const geometry::RGBDImage &image,
+                      const camera::PinholeCameraIntrinsic &intrinsic,
+                      TSDFVolumeColorType color_type) {
+    return !((image.depth_.num_of_channels_ != 1) ||
+             (image.depth_.bytes_per_channel_ != 4) ||
+             (image.depth_.width_ != intrinsic.width_) ||
+             (image.depth_.height_ != intrinsic.height_) ||
+             (color_type == TSDFVolumeColorType::RGB8 &&
+              image.color_.num_of_channels_ != 3) ||
+             (color_type == TSDFVolumeColorType::RGB8 &&
+              image.color_.bytes_per_channel_ != 1) ||
+             (color_type == TSDFVolumeColorType::Gray32 &&
+              image.color_.num_of_channels_ != 1) ||
+             (color_type == TSDFVolumeColorType::Gray32 &&
+              image.color_.bytes_per_channel_ != 4) ||
+             (color_type != TSDFVolumeColorType::NoColor &&
+              image.color_.width_ != intrinsic.width_) ||
+             (color_type != TSDFVolumeColorType::NoColor &&
+              image.color_.height_ != intrinsic.height_));
+}
+
+/// Projects the surfels and keeps for each pixel the closest one. The key
+/// packs the depth, whose float bits keep their order for positive values,
+/// above the surfel index.
+struct project_surfels_functor {
+    project_surfels_functor(const Surfel *surfels,
+                            const Eigen::Matrix4f &extrinsic,
+                            float fx,
+                            float fy,
+                            float cx,
+                            float cy,
+                            int width,
+                            int height,
+                            unsigned long long *keys)
+        : surfels_(surfels),
+          extrinsic_(extrinsic),
+          fx_(fx),
+          fy_(fy),
+          cx_(cx),
+          cy_(cy),
+          width_(width),
+          height_(height),
+          keys_(keys){};
+    const Surfel *surfels_;
+    const Eigen::Matrix4f extrinsic_;
+    const float fx_;
+    const float fy_;
+    const float cx_;
+    const float cy_;
+    const int width_;
+    const int height_;
+    unsigned long long *keys_;
+    __device__ void operator()(size_t idx) {
+        const Eigen::Vector3f p =
+                extrinsic_.block<3, 3>(0, 0) * surfels_[idx].position_ +
+                extrinsic_.block<3, 1>(0, 3);
+        if (p[2] <= 0.0f) return;
+        const int u = __float2int_rn(fx_ * p[0] / p[2] + cx_);
+        const int v = __float2int_rn(fy_ * p[1] / p[2] + cy_);
+        if (u < 0 || u >= width_ || v < 0 || v >= height_) return;
+        const unsigned long long key =
+                ((unsigned long long)__float_as_uint(p[2]) << 32) |
+                (unsigned long long)idx;
+        atomicMin(&keys_[v * width_ + u], key);
+    }
+};
+
+struct key_to_index_functor {
+    __device__ int operator()(unsigned long long key) const {
+        return (key == kEmptyKey) ? -1 : (int)(key & 0xffffffffULL);
+    }
+};
+
+/// Creates the surfel in the map frame measured at a pixel. The confidence
+/// of an invalid measurement is 0.
+struct compute_measurement_functor {
+    compute_measurement_functor(const uint8_t *depth,
+                                const uint8_t *color,
+                                const Eigen::Matrix4f &pose,
+                                float fx,
+                                float fy,
+                                float cx,
+                                float cy,
+                                int width,
+                                int height,
+                                float max_depth,
+                                float confidence_sigma,
+                                int time,
+                                TSDFVolumeColorType color_type)
+        : depth_(depth),
+          color_(color),
+          pose_(pose),
+          fx_(fx),
+          fy_(fy),
+          cx_(cx),
+          cy_(cy),
+          width_(width),
+          height_(height),
+          max_depth_(max_depth),
+          confidence_sigma_(confidence_sigma),
+          time_(time),
+          color_type_(color_type){};
+    const uint8_t *depth_;
+    const uint8_t *color_;
+    const Eigen::Matrix4f pose_;
+    const float fx_;
+    const float fy_;
+    const float cx_;
+    const float cy_;
+    const int width_;
+    const int height_;
+    const float max_depth_;
+    const float confidence_sigma_;
+    const int time_;
+    const TSDFVolumeColorType color_type_;
+    __device__ bool PointAt(int u, int v, Eigen::Vector3f &p) const {
+        const float d = *geometry::PointerAt<float>(depth_, width_, u, v);
+        if (!isfinite(d) || d <= 0.0f || d > max_depth_) return false;
+        p = Eigen::Vector3f((u - cx_) * d / fx_, (v - cy_) * d / fy_, d);
+        return true;
+    }
+    __device__ Surfel operator()(size_t idx) const {
+        Surfel s;
+        const int u = idx % width_;
+        const int v = idx / width_;
+        if (u < 1 || u >= width_ - 1 || v < 1 || v >= height_ - 1) return s;
+        Eigen::Vector3f p, pl, pr, pu, pd;
+        if (!PointAt(u, v, p) || !PointAt(u - 1, v, pl) ||
+            !PointAt(u + 1, v, pr) || !PointAt(u, v - 1, pu) ||
+            !PointAt(u, v + 1, pd)) {
+            return s;
+        }
+        Eigen::Vector3f n = (pr - pl).cross(pd - pu);
+        const float norm = n.norm();
+        if (norm == 0.0f) return s;
+        n /= norm;
+        if (n.dot(p) > 0.0f) n = -n;
+        // the disk covers the pixel footprint, enlarged at grazing angles
+        const float cos_view = fmaxf(-n.dot(p) / p.norm(), 0.5f);
+        s.radius_ = sqrtf(2.0f) * p[2] / (0.5f * (fx_ + fy_)) / cos_view;
+        // measurements far from the image center are less reliable
+        const float gamma = Eigen::Vector2f(u - cx_, v - cy_).norm() /
+                            Eigen::Vector2f(cx_, cy_).norm();
+        s.confidence_ = expf(-gamma * gamma /
+                             (2.0f * confidence_sigma_ * confidence_sigma_));
+        s.position_ = pose_.block<3, 3>(0, 0) * p + pose_.block<3, 1>(0, 3);
+        s.normal_ = pose_.block<3, 3>(0, 0) * n;
+        if (color_type_ == TSDFVolumeColorType::RGB8) {
+            const uint8_t *rgb =
+                    geometry::PointerAt<uint8_t>(color_, width_, 3, u, v, 0);
+            s.color_ = Eigen::Vector3f(rgb[0], rgb[1], rgb[2]) / 255.0f;
+        } else if (color_type_ == TSDFVolumeColorType::Gray32) {
+            s.color_ = Eigen::Vector3f::Constant(
+                    *geometry::PointerAt<float>(color_, width_, u, v));
+        }
+        s.timestamp_ = time_;
+        s.init_timestamp_ = time_;
+        return s;
+    }
+};
+
+/// Fuses the measurement of a pixel into the surfel rendered at the pixel
+/// when their depths and normals agree. A surfel is rendered at one pixel at
+/// most, so that the surfels are updated without conflicts. Returns true if
+/// the measurement has to be added as a new surfel.
+struct fuse_measurement_functor {
+    fuse_measurement_functor(Surfel *surfels,
+                             const int *index_map,
+                             const Eigen::Matrix4f &extrinsic,
+                             float depth_threshold,
+                             float normal_threshold,
+                             int time)
+        : surfels_(surfels),
+          index_map_(index_map),
+          extrinsic_(extrinsic),
+          depth_threshold_(depth_threshold),
+          normal_threshold_(normal_threshold),
+          time_(time){};
+    Surfel *surfels_;
+    const int *index_map_;
+    const Eigen::Matrix4f extrinsic_;
+    const float depth_threshold_;
+    const float normal_threshold_;
+    const int time_;
+    __device__ bool operator()(const thrust::tuple<size_t, Surfel> &x) {
+        const size_t idx = thrust::get<0>(x);
+        const Surfel &m = thrust::get<1>(x);
+        if (m.confidence_ <= 0.0f) return false;
+        const int si = index_map_[idx];
+        if (si < 0) return true;
+        Surfel &s = surfels_[si];
+        const Eigen::Matrix3f R = extrinsic_.block<3, 3>(0, 0);
+        const Eigen::Vector3f t = extrinsic_.block<3, 1>(0, 3);
+        const float zs = (R * s.position_ + t)[2];
+        const float zm = (R * m.position_ + t)[2];
+        if (abs(zs - zm) > depth_threshold_ ||
+            s.normal_.dot(m.normal_) < normal_threshold_) {
+            return true;
+        }
+        const float c = s.confidence_;
+        const float a = m.confidence_;
+        const float inv = 1.0f / (c + a);
+        s.position_ = (c * s.position_ + a * m.position_) * inv;
+        s.normal_ = ((c * s.normal_ + a * m.normal_) * inv).normalized();
+        s.color_ = (c * s.color_ + a * m.color_) * inv;
+        s.radius_ = (c * s.radius_ + a * m.radius_) * inv;
+        s.confidence_ = c + a;
+        s.timestamp_ = time_;
+        return false;
+    }
+};
+
+struct is_unstable_surfel_functor {
+    is_unstable_surfel_functor(float confidence_threshold,
+                               int unstable_time_window,
+                               int time)
+        : confidence_threshold_(confidence_threshold),
+          unstable_time_window_(unstable_time_window),
+          time_(time){};
+    const float confidence_threshold_;
+    const int unstable_time_window_;
+    const int time_;
+    __device__ bool operator()(const Surfel &s) const {
+        return s.confidence_ < confidence_threshold_ &&
+               time_ - s.init_timestamp_ > unstable_time_window_;
+    }
+};
+
+struct is_stable_surfel_functor {
+    is_stable_surfel_functor(float confidence_threshold)
+        : confidence_threshold_(confidence_threshold){};
+    const float confidence_threshold_;
+    __device__ bool operator()(const Surfel &s) const {
+        return s.confidence_ >= confidence_threshold_;
+    }
+};
+
+struct surfel_to_point_functor {
+    __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>
+    operator()(const Surfel &s) const {
+        return thrust::make_tuple(s.position_, s.normal_, s.color_);
+    }
+};
+
+void RenderIndexMapImpl(const utility::device_vector<Surfel> &surfels,
+                        const camera::PinholeCameraIntrinsic &intrinsic,
+                        const Eigen::Matrix4f &extrinsic,
+                        int *index_map) {
+    const int n_pixels = intrinsic.width_ * intrinsic.height_;
+    utility::device_vector<unsigned long long> keys(n_pixels, kEmptyKey);
+    project_surfels_functor func(
+            thrust::raw_pointer_cast(surfels.data()), extrinsic,
+            intrinsic.GetFocalLength().first,
+            intrinsic.GetFocalLength().second,
+            intrinsic.GetPrincipalPoint().first,
+            intrinsic.GetPrincipalPoint().second, intrinsic.width_,
+            intrinsic.height_, thrust::raw_pointer_cast(keys.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(surfels.size()), func);
+    thrust::transform(keys.begin(), keys.end(),
+                      thrust::device_pointer_cast(index_map),
+                      key_to_index_functor());
+}
+
+}  // namespace
+
+SurfelMap::SurfelMap(TSDFVolumeColorType color_type,
+                     float confidence_threshold,
+                     int unstable_time_window,
+                     float max_depth)
+    : color_type_(color_type),
+      confidence_threshold_(confidence_threshold),
+      unstable_time_window_(unstable_time_window),
+      max_depth_(max_depth) {}
+
+SurfelMap::SurfelMap(const SurfelMap &other)
+    : color_type_(other.color_type_),
+      confidence_threshold_(other.confidence_threshold_),
+      unstable_time_window_(other.unstable_time_window_),
+      max_depth_(other.max_depth_),
+      depth_threshold_(other.depth_threshold_),
+      normal_threshold_(other.normal_threshold_),
+      confidence_sigma_(other.confidence_sigma_),
+      time_(other.time_),
+      surfels_(other.surfels_) {}
+
+SurfelMap::~SurfelMap() {}
+
+void SurfelMap::Reset() {
+    surfels_.clear();
+    time_ = 0;
+}
+
+void SurfelMap::Integrate(const geometry::RGBDImage &image,
+                          const camera::PinholeCameraIntrinsic &intrinsic,
+                          const Eigen::Matrix4f &extrinsic) {
+    if (!IsSupportedImage(image, intrinsic, color_type_)) {
+        utility::LogError("[SurfelMap::Integrate] Unsupported image format.");
+        return;
+    }
+    const int width = intrinsic.width_;
+    const int height = intrinsic.height_;
+    const size_t n_pixels = width * height;
+
+    // measurements of the pixels in the map frame
+    utility::device_vector<Surfel> measurements(n_pixels);
+    compute_measurement_functor func(
+            thrust::raw_pointer_cast(image.depth_.data_.data()),
+            thrust::raw_pointer_cast(image.color_.data_.data()),
+            utility::InverseTransform(extrinsic),
+            intrinsic.GetFocalLength().first,
+            intrinsic.GetFocalLength().second,
+            intrinsic.GetPrincipalPoint().first,
+            intrinsic.GetPrincipalPoint().second, width, height, max_depth_,
+            confidence_sigma_, time_, color_type_);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pixels),
+                      measurements.begin(), func);
+
+    // projective association with the surfels rendered from the camera
+    utility::device_vector<int> index_map(n_pixels);
+    RenderIndexMapImpl(surfels_, intrinsic, extrinsic,
+                       thrust::raw_pointer_cast(index_map.data()));
+    utility::device_vector<bool> is_new(n_pixels);
+    fuse_measurement_functor fuse_func(
+            thrust::raw_pointer_cast(surfels_.data()),
+            thrust::raw_pointer_cast(index_map.data()), extrinsic,
+            depth_threshold_, normal_threshold_, time_);
+    thrust::transform(
+            thrust::make_zip_iterator(thrust::make_tuple(
+                    thrust::make_counting_iterator<size_t>(0),
+                    measurements.begin())),
+            thrust::make_zip_iterator(thrust::make_tuple(
+                    thrust::make_counting_iterator(n_pixels),
+                    measurements.end())),
+            is_new.begin(), fuse_func);
+
+    // unassociated measurements become new surfels
+    const size_t n_old = surfels_.size();
+    surfels_.resize(n_old + n_pixels);
+    auto end = thrust::copy_if(measurements.begin(), measurements.end(),
+                               is_new.begin(), surfels_.begin() + n_old,
+                               thrust::identity<bool>());
+    surfels_.resize(thrust::distance(surfels_.begin(), end));
+
+    // remove the surfels which did not become stable in time
+    auto end_stable = thrust::remove_if(
+            surfels_.begin(), surfels_.end(),
+            is_unstable_surfel_functor(confidence_threshold_,
+                                       unstable_time_window_, time_));
+    surfels_.resize(thrust::distance(surfels_.begin(), end_stable));
+    utility::LogDebug("[SurfelMap::Integrate] {:d} surfels after frame {:d}.",
+                      (int)surfels_.size(), time_);
+    ++time_;
+}
+
+std::shared_ptr<geometry::Image> SurfelMap::RenderIndexMap(
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic) const {
+    auto index_map = std::make_shared<geometry::Image>();
+    index_map->Prepare(intrinsic.width_, intrinsic.height_, 1, 4);
+    RenderIndexMapImpl(surfels_, intrinsic, extrinsic,
+                       reinterpret_cast<int *>(thrust::raw_pointer_cast(
+                               index_map->data_.data())));
+    return index_map;
+}
+
+std::shared_ptr<geometry::PointCloud> SurfelMap::ExtractPointCloud() const {
+    auto pointcloud = std::make_shared<geometry::PointCloud>();
+    utility::device_vector<Surfel> stable(surfels_.size());
+    auto end = thrust::copy_if(surfels_.begin(), surfels_.end(),
+                               stable.begin(),
+                               is_stable_surfel_functor(confidence_threshold_));
+    stable.resize(thrust::distance(stable.begin(), end));
+    resize_all(stable.size(), pointcloud->points_, pointcloud->normals_,
+               pointcloud->colors_);
+    thrust::transform(stable.begin(), stable.end(),
+                      make_tuple_begin(pointcloud->points_,
+                                       pointcloud->normals_,
+                                       pointcloud->colors_),
+                      surfel_to_point_functor());
+    if (color_type_ == TSDFVolumeColorType::NoColor) {
+        pointcloud->colors_.clear();
+    }
+    return pointcloud;
+}
+
+}  // namespace integration
+}  // namespace cupoch
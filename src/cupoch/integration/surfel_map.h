@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#pragma once
+
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/image.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/rgbdimage.h"
+#include "cupoch/integration/tsdfvolume.h"
+#include "cupoch/utility/device_vector.h"
+
+namespace cupoch {
+namespace integration {
+
+class Surfel {
+public:
+    __host__ __device__ Surfel() {}
+    __host__ __device__ ~Surfel() {}
+
+public:
+    Eigen::Vector3f position_ = Eigen::Vector3f::Zero();
+    Eigen::Vector3f normal_ = Eigen::Vector3f::Zero();
+    /// Color in [0, 1].
+    Eigen::Vector3f color_ = Eigen::Vector3f::Zero();
+    float radius_ = 0.0;
+    /// Accumulated weight of the measurements fused into the surfel.
+    float confidence_ = 0.0;
+    /// Frame of the last fused measurement.
+    int timestamp_ = 0;
+    /// Frame in which the surfel was created.
+    int init_timestamp_ = 0;
+};
+
+/// \class SurfelMap
+///
+/// \brief Map of oriented disks fused from RGB-D images, based on
+/// "ElasticFusion: Dense SLAM Without A Pose Graph" by T. Whelan et al.,
+/// RSS 2015.
+///
+/// The memory is proportional to the observed surface. Each pixel of a new
+/// image is associated with the surfel rendered at the same pixel of the
+/// index map, fused into it by a weighted average when the depths and the
+/// normals agree, and added as a new surfel otherwise. Surfels which stay
+/// below confidence_threshold_ for longer than unstable_time_window_ frames
+/// are removed.
+class SurfelMap {
+public:
+    SurfelMap(TSDFVolumeColorType color_type = TSDFVolumeColorType::RGB8,
+              float confidence_threshold = 10.0,
+              int unstable_time_window = 30,
+              float max_depth = 3.0);
+    SurfelMap(const SurfelMap &other);
+    ~SurfelMap();
+
+public:
+    void Reset();
+
+    /// Function to integrate an RGB-D image into the map. \p extrinsic
+    /// transforms the map frame to the camera frame as in
+    /// TSDFVolume::Integrate.
+    void Integrate(const geometry::RGBDImage &image,
+                   const camera::PinholeCameraIntrinsic &intrinsic,
+                   const Eigen::Matrix4f &extrinsic);
+
+    /// \brief Renders the index of the closest surfel projecting to each
+    /// pixel.
+    ///
+    /// Returns an image with one 4 bytes channel holding the surfel indices
+    /// as int, -1 for the pixels without surfel.
+    std::shared_ptr<geometry::Image> RenderIndexMap(
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4f &extrinsic) const;
+
+    /// Function to extract the surfels with a confidence of at least
+    /// confidence_threshold_ as a point cloud with normals and colors.
+    std::shared_ptr<geometry::PointCloud> ExtractPointCloud() const;
+
+    size_t GetNumSurfels() const { return surfels_.size(); }
+
+public:
+    TSDFVolumeColorType color_type_;
+    /// Confidence above which a surfel is stable.
+    float confidence_threshold_;
+    /// Number of frames after which an unstable surfel is removed.
+    int unstable_time_window_;
+    /// Depths farther than this value are not integrated.
+    float max_depth_;
+    /// Maximum depth difference of an associated measurement.
+    float depth_threshold_ = 0.05;
+    /// Minimum cosine of the angle between the normals of an associated
+    /// measurement and its surfel.
+    float normal_threshold_ = 0.8;
+    /// Standard deviation of the normalized radial distance of the
+    /// confidence weight of a measurement.
+    float confidence_sigma_ = 0.6;
+    /// Number of integrated frames.
+    int time_ = 0;
+    utility::device_vector<Surfel> surfels_;
+};
+
+}  // namespace integration
+}  // namespace cupoch
@@ -20,10 +20,15 @@
  **/
 #pragma once
 
+#include <thrust/host_vector.h>
+
+#include <vector>
+
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/rgbdimage.h"
 #include "cupoch/geometry/trianglemesh.h"
+#include "cupoch/utility/console.h"
 
 namespace cupoch {
 namespace integration {
@@ -60,6 +65,24 @@ public:
                            const camera::PinholeCameraIntrinsic &intrinsic,
                            const Eigen::Matrix4f &extrinsic) = 0;
 
+    /// Function to integrate a batch of RGB-D images taken with the same
+    /// camera intrinsic. The default implementation integrates the images
+    /// one by one.
+    virtual void IntegrateBatch(
+            const std::vector<geometry::RGBDImage> &images,
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const thrust::host_vector<Eigen::Matrix4f> &extrinsics) {
+        if (images.size() != extrinsics.size()) {
+            utility::LogError(
+                    "[TSDFVolume::IntegrateBatch] The numbers of images and "
+                    "extrinsics are different.");
+            return;
+        }
+        for (size_t i = 0; i < images.size(); ++i) {
+            Integrate(images[i], intrinsic, extrinsics[i]);
+        }
+    }
+
     /// Function to extract a point cloud with normals
     virtual std::shared_ptr<geometry::PointCloud> ExtractPointCloud() = 0;
 
@@ -67,10 +90,31 @@ public:
     /// (https://en.wikipedia.org/wiki/Marching_cubes)
     virtual std::shared_ptr<geometry::TriangleMesh> ExtractTriangleMesh() = 0;
 
+protected:
+    /// Returns the depth to camera distance multiplier image of \p intrinsic.
+    /// The image is cached and only rebuilt when the intrinsic changes.
+    const geometry::Image &GetDepthToCameraDistanceMultiplier(
+            const camera::PinholeCameraIntrinsic &intrinsic) {
+        if (!depth_to_camera_distance_multiplier_ ||
+            cached_intrinsic_.width_ != intrinsic.width_ ||
+            cached_intrinsic_.height_ != intrinsic.height_ ||
+            cached_intrinsic_.intrinsic_matrix_ !=
+                    intrinsic.intrinsic_matrix_) {
+            depth_to_camera_distance_multiplier_ = geometry::Image::
+                    CreateDepthToCameraDistanceMultiplierFloatImage(intrinsic);
+            cached_intrinsic_ = intrinsic;
+        }
+        return *depth_to_camera_distance_multiplier_;
+    }
+
 public:
     float voxel_length_;
     float sdf_trunc_;
     TSDFVolumeColorType color_type_;
+
+protected:
+    std::shared_ptr<geometry::Image> depth_to_camera_distance_multiplier_;
+    camera::PinholeCameraIntrinsic cached_intrinsic_;
 };
 
 }  // namespace integration
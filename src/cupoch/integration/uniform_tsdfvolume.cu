@@ -19,6 +19,7 @@
  * IN THE SOFTWARE.
  **/
 #include <thrust/iterator/discard_iterator.h>
+#include <thrust/transform_reduce.h>
 
 #include "cupoch/integration/integrate_functor.h"
 #include "cupoch/integration/marching_cubes_const.h"
@@ -31,8 +32,9 @@ namespace integration {
 
 namespace {
 
+template <typename VoxelType>
 __device__ float GetTSDFAt(const Eigen::Vector3f &p,
-                           const geometry::TSDFVoxel *voxels,
+                           const VoxelType *voxels,
                            float voxel_length,
                            int resolution) {
     Eigen::Vector3i idx;
@@ -44,26 +46,35 @@ __device__ float GetTSDFAt(const Eigen::Vector3f &p,
 
     float tsdf = 0;
     tsdf += (1 - r(0)) * (1 - r(1)) * (1 - r(2)) *
-            voxels[IndexOf(idx + Eigen::Vector3i(0, 0, 0), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(0, 0, 0), resolution)]
+                    .GetTSDF();
     tsdf += (1 - r(0)) * (1 - r(1)) * r(2) *
-            voxels[IndexOf(idx + Eigen::Vector3i(0, 0, 1), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(0, 0, 1), resolution)]
+                    .GetTSDF();
     tsdf += (1 - r(0)) * r(1) * (1 - r(2)) *
-            voxels[IndexOf(idx + Eigen::Vector3i(0, 1, 0), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(0, 1, 0), resolution)]
+                    .GetTSDF();
     tsdf += (1 - r(0)) * r(1) * r(2) *
-            voxels[IndexOf(idx + Eigen::Vector3i(0, 1, 1), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(0, 1, 1), resolution)]
+                    .GetTSDF();
     tsdf += r(0) * (1 - r(1)) * (1 - r(2)) *
-            voxels[IndexOf(idx + Eigen::Vector3i(1, 0, 0), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(1, 0, 0), resolution)]
+                    .GetTSDF();
     tsdf += r(0) * (1 - r(1)) * r(2) *
-            voxels[IndexOf(idx + Eigen::Vector3i(1, 0, 1), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(1, 0, 1), resolution)]
+                    .GetTSDF();
     tsdf += r(0) * r(1) * (1 - r(2)) *
-            voxels[IndexOf(idx + Eigen::Vector3i(1, 1, 0), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(1, 1, 0), resolution)]
+                    .GetTSDF();
     tsdf += r(0) * r(1) * r(2) *
-            voxels[IndexOf(idx + Eigen::Vector3i(1, 1, 1), resolution)].tsdf_;
+            voxels[IndexOf(idx + Eigen::Vector3i(1, 1, 1), resolution)]
+                    .GetTSDF();
     return tsdf;
 }
 
+template <typename VoxelType>
 __device__ Eigen::Vector3f GetNormalAt(const Eigen::Vector3f &p,
-                                       const geometry::TSDFVoxel *voxels,
+                                       const VoxelType *voxels,
                                        float voxel_length,
                                        int resolution) {
     Eigen::Vector3f n;
@@ -80,8 +91,9 @@ __device__ Eigen::Vector3f GetNormalAt(const Eigen::Vector3f &p,
     return n.normalized();
 }
 
+template <typename VoxelType>
 struct extract_pointcloud_functor {
-    extract_pointcloud_functor(const geometry::TSDFVoxel *voxels,
+    extract_pointcloud_functor(const VoxelType *voxels,
                                int resolution,
                                float voxel_length,
                                const Eigen::Vector3f &origin,
@@ -92,7 +104,7 @@ struct extract_pointcloud_functor {
           origin_(origin),
           half_voxel_length_(0.5 * voxel_length_),
           color_type_(color_type){};
-    const geometry::TSDFVoxel *voxels_;
+    const VoxelType *voxels_;
     const int resolution_;
     const float voxel_length_;
     const Eigen::Vector3f origin_;
@@ -117,9 +129,10 @@ struct extract_pointcloud_functor {
         Eigen::Vector3i idx0(x, y, z);
         Eigen::Vector3f h_res =
                 Eigen::Vector3f::Constant(resolution_ / 2) * voxel_length_;
-        float w0 = voxels_[IndexOf(idx0, resolution_)].weight_;
-        float f0 = voxels_[IndexOf(idx0, resolution_)].tsdf_;
-        const Eigen::Vector3f &c0 = voxels_[IndexOf(idx0, resolution_)].color_;
+        float w0 = voxels_[IndexOf(idx0, resolution_)].GetWeight();
+        float f0 = voxels_[IndexOf(idx0, resolution_)].GetTSDF();
+        const Eigen::Vector3f c0 =
+                voxels_[IndexOf(idx0, resolution_)].GetColor();
         if (!(w0 != 0.0f && f0 < 0.98f && f0 >= -0.98f)) {
             return thrust::make_tuple(point, normal, color);
         }
@@ -131,10 +144,10 @@ struct extract_pointcloud_functor {
         Eigen::Vector3i idx1 = idx0;
         idx1(i) += 1;
         if (idx1(i) < resolution_ - 1) {
-            float w1 = voxels_[IndexOf(idx1, resolution_)].weight_;
-            float f1 = voxels_[IndexOf(idx1, resolution_)].tsdf_;
-            const Eigen::Vector3f &c1 =
-                    voxels_[IndexOf(idx1, resolution_)].color_;
+            float w1 = voxels_[IndexOf(idx1, resolution_)].GetWeight();
+            float f1 = voxels_[IndexOf(idx1, resolution_)].GetTSDF();
+            const Eigen::Vector3f c1 =
+                    voxels_[IndexOf(idx1, resolution_)].GetColor();
             if (w1 != 0.0f && f1 < 0.98f && f1 >= -0.98f && f0 * f1 < 0) {
                 float r0 = std::fabs(f0);
                 float r1 = std::fabs(f1);
@@ -154,224 +167,262 @@ struct extract_pointcloud_functor {
     }
 };
 
-struct count_valid_voxels_functor {
-    count_valid_voxels_functor(const geometry::TSDFVoxel *voxels,
-                               int resolution)
-        : voxels_(voxels), resolution_(resolution){};
-    const geometry::TSDFVoxel *voxels_;
+/// Marching cubes on the voxels in [min_index, max_index]. Each voxel owns
+/// the vertices on its +x, +y and +z edges, keyed by (x, y, z, axis), and the
+/// triangles of the cube whose lowest corner it is, so that the vertices
+/// shared by neighboring cubes are generated once.
+template <typename VoxelType>
+struct uniform_mesh_functor_base {
+    uniform_mesh_functor_base(const VoxelType *voxels,
+                              int resolution,
+                              const Eigen::Vector3i &min_index,
+                              const Eigen::Vector3i &max_index)
+        : voxels_(voxels),
+          resolution_(resolution),
+          min_index_(min_index),
+          max_index_(max_index){};
+    const VoxelType *voxels_;
     const int resolution_;
-    __device__ bool operator()(
-            const thrust::tuple<size_t, geometry::TSDFVoxel> &kv) const {
-        size_t idx = thrust::get<0>(kv);
-        int x, y, z;
-        thrust::tie(x, y, z) = KeyOf(idx, resolution_);
-        if (x == resolution_ - 1 || y == resolution_ - 1 ||
-            z == resolution_ - 1)
-            return false;
-        geometry::TSDFVoxel v = thrust::get<1>(kv);
-#pragma unroll
-        for (int i = 0; i < 8; ++i) {
-            Eigen::Vector3i idx = Eigen::Vector3i(
-                    x + shift[i][0], y + shift[i][1], z + shift[i][2]);
-            if (voxels_[IndexOf(idx, resolution_)].weight_ == 0.0f)
-                return false;
+    const Eigen::Vector3i min_index_;
+    const Eigen::Vector3i max_index_;
+    /// Returns the observed voxel at \p idx or nullptr if it is not observed
+    /// or out of the extracted range.
+    __device__ const VoxelType *VoxelAt(const Eigen::Vector3i &idx) const {
+        if ((idx.array() < min_index_.array()).any() ||
+            (idx.array() > max_index_.array()).any()) {
+            return nullptr;
         }
-        return true;
+        const VoxelType &v = voxels_[IndexOf(idx, resolution_)];
+        return (v.GetWeight() == 0.0f) ? nullptr : &v;
     }
-};
-
-struct extract_mesh_phase0_functor {
-    extract_mesh_phase0_functor(const geometry::TSDFVoxel *voxels,
-                                int resolution)
-        : voxels_(voxels), resolution_(resolution){};
-    const geometry::TSDFVoxel *voxels_;
-    const int resolution_;
-    __device__ thrust::tuple<Eigen::Vector3i, int> operator()(size_t idx) {
-        int x, y, z;
-        thrust::tie(x, y, z) = KeyOf(idx, resolution_ - 1);
-
+    __device__ bool IsCrossing(const VoxelType *v0, const VoxelType *v1) const {
+        return v0 != nullptr && v1 != nullptr &&
+               (v0->GetTSDF() < 0.0f) != (v1->GetTSDF() < 0.0f);
+    }
+    __device__ int CubeIndexAt(const Eigen::Vector3i &idx) const {
         int cube_index = 0;
-        Eigen::Vector3i key = Eigen::Vector3i(x, y, z);
-        for (int i = 0; i < 8; ++i) {
-            Eigen::Vector3i idxs =
-                    key +
-                    Eigen::Vector3i(shift[i][0], shift[i][1], shift[i][2]);
-            if (voxels_[IndexOf(idxs, resolution_)].weight_ == 0.0f) {
-                return thrust::make_tuple(key, -1);
-            } else {
-                float f = voxels_[IndexOf(idxs, resolution_)].tsdf_;
-                if (f < 0.0f) {
-                    cube_index |= (1 << i);
-                }
+        for (int j = 0; j < 8; ++j) {
+            const VoxelType *v = VoxelAt(
+                    idx +
+                    Eigen::Vector3i(shift[j][0], shift[j][1], shift[j][2]));
+            if (v == nullptr) return -1;
+            if (v->GetTSDF() < 0.0f) cube_index |= (1 << j);
+        }
+        return cube_index;
+    }
+    __device__ thrust::tuple<int, int> CountAt(
+            const Eigen::Vector3i &idx) const {
+        const VoxelType *v0 = VoxelAt(idx);
+        if (v0 == nullptr) return thrust::make_tuple(0, 0);
+        int n_vertices = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            Eigen::Vector3i idx1 = idx;
+            idx1[axis] += 1;
+            if (IsCrossing(v0, VoxelAt(idx1))) ++n_vertices;
+        }
+        int n_triangles = 0;
+        const int cube_index = CubeIndexAt(idx);
+        if (cube_index > 0 && cube_index < 255) {
+            for (int k = 0; tri_table[cube_index][k] != -1; k += 3) {
+                ++n_triangles;
             }
         }
-        return thrust::make_tuple(key, cube_index);
+        return thrust::make_tuple(n_vertices, n_triangles);
     }
 };
 
-struct extract_mesh_phase1_functor {
-    extract_mesh_phase1_functor(const geometry::TSDFVoxel *voxels,
-                                const Eigen::Vector3i *keys,
-                                int resolution,
-                                TSDFVolumeColorType color_type)
-        : voxels_(voxels),
-          keys_(keys),
-          resolution_(resolution),
-          color_type_(color_type){};
-    const geometry::TSDFVoxel *voxels_;
-    const Eigen::Vector3i *keys_;
+/// Maps the index of a voxel in the extracted range to its index in the
+/// volume. The mapping preserves the order of the voxels.
+struct range_to_voxel_index_functor {
+    range_to_voxel_index_functor(const Eigen::Vector3i &min_index,
+                                 const Eigen::Vector3i &size,
+                                 int resolution)
+        : min_index_(min_index), size_(size), resolution_(resolution){};
+    const Eigen::Vector3i min_index_;
+    const Eigen::Vector3i size_;
     const int resolution_;
-    TSDFVolumeColorType color_type_;
-    __device__ thrust::tuple<float, Eigen::Vector3f> operator()(size_t idx) {
-        int j = idx / 8;
-        int i = idx % 8;
-        const Eigen::Vector3i &key = keys_[j];
-        Eigen::Vector3i idxs =
-                key + Eigen::Vector3i(shift[i][0], shift[i][1], shift[i][2]);
-        const geometry::TSDFVoxel v = voxels_[IndexOf(idxs, resolution_)];
-        Eigen::Vector3f c = Eigen::Vector3f::Zero();
-        if (v.weight_ == 0.0f) {
-            return thrust::make_tuple(0.0f, c);
-        } else {
-            float f = v.tsdf_;
-            if (color_type_ == TSDFVolumeColorType::RGB8) {
-                c = v.color_ / 255.0;
-            } else if (color_type_ == TSDFVolumeColorType::Gray32) {
-                c = v.color_;
-            }
-            return thrust::make_tuple(f, c);
-        }
+    __device__ int operator()(size_t idx) const {
+        const int yz = size_[1] * size_[2];
+        const Eigen::Vector3i key(idx / yz, (idx % yz) / size_[2],
+                                  idx % size_[2]);
+        return IndexOf(min_index_ + key, resolution_);
+    }
+};
+
+template <typename VoxelType>
+struct has_mesh_elements_functor : public uniform_mesh_functor_base<VoxelType> {
+    has_mesh_elements_functor(const VoxelType *voxels,
+                              int resolution,
+                              const Eigen::Vector3i &min_index,
+                              const Eigen::Vector3i &max_index)
+        : uniform_mesh_functor_base<VoxelType>(
+                  voxels, resolution, min_index, max_index){};
+    __device__ bool operator()(int voxel_index) const {
+        int x, y, z;
+        thrust::tie(x, y, z) = KeyOf(voxel_index, this->resolution_);
+        const auto counts = this->CountAt(Eigen::Vector3i(x, y, z));
+        return thrust::get<0>(counts) > 0 || thrust::get<1>(counts) > 0;
     }
 };
 
-struct extract_mesh_phase2_functor {
-    extract_mesh_phase2_functor(const Eigen::Vector3i *keys,
-                                const int *cube_indices,
-                                const Eigen::Vector3f &origin,
+template <typename VoxelType>
+struct count_mesh_elements_functor
+    : public uniform_mesh_functor_base<VoxelType> {
+    count_mesh_elements_functor(const VoxelType *voxels,
                                 int resolution,
-                                float voxel_length,
-                                const float *fs,
-                                const Eigen::Vector3f *cs,
-                                TSDFVolumeColorType color_type)
-        : keys_(keys),
-          cube_indices_(cube_indices),
-          origin_(origin),
-          resolution_(resolution),
+                                const Eigen::Vector3i &min_index,
+                                const Eigen::Vector3i &max_index)
+        : uniform_mesh_functor_base<VoxelType>(
+                  voxels, resolution, min_index, max_index){};
+    __device__ thrust::tuple<int, int> operator()(int voxel_index) const {
+        int x, y, z;
+        thrust::tie(x, y, z) = KeyOf(voxel_index, this->resolution_);
+        return this->CountAt(Eigen::Vector3i(x, y, z));
+    }
+};
+
+__constant__ int vert_table[3] = {0, 2, 1};
+
+template <typename VoxelType>
+struct extract_mesh_elements_functor
+    : public uniform_mesh_functor_base<VoxelType> {
+    extract_mesh_elements_functor(const VoxelType *voxels,
+                                  int resolution,
+                                  const Eigen::Vector3i &min_index,
+                                  const Eigen::Vector3i &max_index,
+                                  float voxel_length,
+                                  const Eigen::Vector3f &origin,
+                                  TSDFVolumeColorType color_type,
+                                  const int *voxel_indices,
+                                  const int *vertex_offsets,
+                                  const int *triangle_offsets,
+                                  Eigen::Vector4i *vertex_edges,
+                                  Eigen::Vector3f *vertices,
+                                  Eigen::Vector3f *vertex_colors,
+                                  Eigen::Vector4i *triangle_edges)
+        : uniform_mesh_functor_base<VoxelType>(
+                  voxels, resolution, min_index, max_index),
           voxel_length_(voxel_length),
-          half_voxel_length_(0.5 * voxel_length_),
-          fs_(fs),
-          cs_(cs),
-          color_type_(color_type){};
-    const Eigen::Vector3i *keys_;
-    const int *cube_indices_;
-    const Eigen::Vector3f origin_;
-    const int resolution_;
+          origin_(origin -
+                  Eigen::Vector3f::Constant(resolution / 2 - 0.5f) *
+                          voxel_length),
+          color_type_(color_type),
+          voxel_indices_(voxel_indices),
+          vertex_offsets_(vertex_offsets),
+          triangle_offsets_(triangle_offsets),
+          vertex_edges_(vertex_edges),
+          vertices_(vertices),
+          vertex_colors_(vertex_colors),
+          triangle_edges_(triangle_edges){};
     const float voxel_length_;
-    const float half_voxel_length_;
-    const float *fs_;
-    const Eigen::Vector3f *cs_;
+    /// Center of the voxel (0, 0, 0).
+    const Eigen::Vector3f origin_;
     const TSDFVolumeColorType color_type_;
-    __device__ thrust::
-            tuple<Eigen::Vector3i, int, int, Eigen::Vector3f, Eigen::Vector3f>
-            operator()(size_t idx) const {
-        int j = idx / 12;
-        const Eigen::Vector3i &xyz = keys_[j];
-        int cube_index = cube_indices_[j];
-        int offset = j * 8;
-        int x = xyz[0];
-        int y = xyz[1];
-        int z = xyz[2];
-        int i = idx % 12;
-        if (edge_table[cube_index] & (1 << i)) {
-            Eigen::Vector4i edge_index =
-                    Eigen::Vector4i(x, y, z, 0) +
-                    Eigen::Vector4i(edge_shift[i][0], edge_shift[i][1],
-                                    edge_shift[i][2], edge_shift[i][3]);
-            Eigen::Vector3f pt(
-                    half_voxel_length_ + voxel_length_ * edge_index(0),
-                    half_voxel_length_ + voxel_length_ * edge_index(1),
-                    half_voxel_length_ + voxel_length_ * edge_index(2));
-            float f0 = abs(fs_[offset + edge_to_vert[i][0]]);
-            float f1 = abs(fs_[offset + edge_to_vert[i][1]]);
-            pt(edge_index(3)) += f0 * voxel_length_ / (f0 + f1);
-            Eigen::Vector3f vertex = pt + origin_;
-            Eigen::Vector3f vertex_color = Eigen::Vector3f::Zero();
-            if (color_type_ != TSDFVolumeColorType::NoColor) {
-                const auto &c0 = cs_[offset + edge_to_vert[i][0]];
-                const auto &c1 = cs_[offset + edge_to_vert[i][1]];
-                vertex_color = (f1 * c0 + f0 * c1) / (f0 + f1);
-            }
-            return thrust::make_tuple(
-                    xyz, cube_index, i,
-                    vertex - Eigen::Vector3f::Constant(resolution_ / 2) *
-                                     voxel_length_,
-                    vertex_color);
-        } else {
-            Eigen::Vector3i index = -Eigen::Vector3i::Ones();
-            Eigen::Vector3f vertex = Eigen::Vector3f::Zero();
-            Eigen::Vector3f vertex_color = Eigen::Vector3f::Zero();
-            return thrust::make_tuple(index, cube_index, i, vertex,
-                                      vertex_color);
+    const int *voxel_indices_;
+    const int *vertex_offsets_;
+    const int *triangle_offsets_;
+    Eigen::Vector4i *vertex_edges_;
+    Eigen::Vector3f *vertices_;
+    Eigen::Vector3f *vertex_colors_;
+    Eigen::Vector4i *triangle_edges_;
+    __device__ Eigen::Vector3f ColorOf(const VoxelType &v) const {
+        if (color_type_ == TSDFVolumeColorType::RGB8) {
+            return v.GetColor() / 255.0;
+        } else if (color_type_ == TSDFVolumeColorType::Gray32) {
+            return v.GetColor();
+        }
+        return Eigen::Vector3f::Zero();
+    }
+    __device__ void operator()(size_t idx) {
+        int x, y, z;
+        thrust::tie(x, y, z) = KeyOf(voxel_indices_[idx], this->resolution_);
+        const Eigen::Vector3i key(x, y, z);
+        const VoxelType *v0 = this->VoxelAt(key);
+        int vo = vertex_offsets_[idx];
+        for (int axis = 0; axis < 3; ++axis) {
+            Eigen::Vector3i key1 = key;
+            key1[axis] += 1;
+            const VoxelType *v1 = this->VoxelAt(key1);
+            if (!this->IsCrossing(v0, v1)) continue;
+            const float f0 = abs(v0->GetTSDF());
+            const float f1 = abs(v1->GetTSDF());
+            Eigen::Vector3f pt = origin_ + key.cast<float>() * voxel_length_;
+            pt[axis] += f0 * voxel_length_ / (f0 + f1);
+            vertex_edges_[vo] = Eigen::Vector4i(x, y, z, axis);
+            vertices_[vo] = pt;
+            vertex_colors_[vo] =
+                    (f1 * ColorOf(*v0) + f0 * ColorOf(*v1)) / (f0 + f1);
+            ++vo;
+        }
+        const int cube_index = this->CubeIndexAt(key);
+        if (cube_index <= 0 || cube_index >= 255) return;
+        const int to = triangle_offsets_[idx];
+        for (int k = 0; tri_table[cube_index][k] != -1; ++k) {
+            const int e = tri_table[cube_index][k];
+            const int ti = 3 * (to + k / 3) + vert_table[k % 3];
+            triangle_edges_[ti] = Eigen::Vector4i(
+                    x + edge_shift[e][0], y + edge_shift[e][1],
+                    z + edge_shift[e][2], edge_shift[e][3]);
         }
     }
 };
 
-__constant__ int vert_table[3] = {0, 2, 1};
-
-struct extract_mesh_phase3_functor {
-    extract_mesh_phase3_functor(const int *cube_index,
-                                const int *vert_no,
-                                const int *key_index,
-                                Eigen::Vector3i *triangles)
-        : cube_index_(cube_index),
-          vert_no_(vert_no),
-          key_index_(key_index),
-          triangles_(triangles){};
-    const int *cube_index_;
-    const int *vert_no_;
-    const int *key_index_;
-    Eigen::Vector3i *triangles_;
-    __device__ void operator()(size_t idx) {
-        const int kindx0 = key_index_[idx];
-        const int kindx1 = key_index_[idx + 1];
-        for (int j = kindx0; j < kindx1; ++j) {
-            const int cindx = cube_index_[j];
-            for (int i = 0; tri_table[cindx][i] != -1; ++i) {
-                const int tri_idx = tri_table[cindx][i];
-                for (int l = kindx0; l < kindx1; ++l) {
-                    if (vert_no_[l] == tri_idx) {
-                        triangles_[idx * 4 + i / 3][vert_table[i % 3]] = l;
-                    }
-                }
+struct assemble_triangles_functor {
+    assemble_triangles_functor(const Eigen::Vector4i *vertex_edges,
+                               int n_vertices,
+                               const Eigen::Vector4i *triangle_edges,
+                               const int *vertex_indices)
+        : vertex_edges_(vertex_edges),
+          n_vertices_(n_vertices),
+          triangle_edges_(triangle_edges),
+          vertex_indices_(vertex_indices){};
+    const Eigen::Vector4i *vertex_edges_;
+    const int n_vertices_;
+    const Eigen::Vector4i *triangle_edges_;
+    const int *vertex_indices_;
+    __device__ Eigen::Vector3i operator()(size_t idx) const {
+        Eigen::Vector3i triangle;
+        for (int j = 0; j < 3; ++j) {
+            const int k = vertex_indices_[3 * idx + j];
+            const Eigen::Vector4i &edge = triangle_edges_[3 * idx + j];
+            if (k >= n_vertices_ ||
+                (vertex_edges_[k].array() != edge.array()).any()) {
+                return Eigen::Vector3i::Constant(-1);
             }
+            triangle[j] = k;
         }
+        return triangle;
     }
 };
 
+template <typename VoxelType>
 struct extract_voxel_pointcloud_functor {
-    extract_voxel_pointcloud_functor(const Eigen::Vector3f &origin,
+    extract_voxel_pointcloud_functor(const VoxelType *voxels,
+                                     const Eigen::Vector3f &origin,
                                      int resolution,
                                      float voxel_length)
-        : origin_(origin),
+        : voxels_(voxels),
+          origin_(origin),
           resolution_(resolution),
           voxel_length_(voxel_length),
           half_voxel_length_(0.5 * voxel_length){};
+    const VoxelType *voxels_;
     const Eigen::Vector3f origin_;
     const int resolution_;
     const float voxel_length_;
     const float half_voxel_length_;
     __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator()(
-            const thrust::tuple<size_t, geometry::TSDFVoxel> &kv) {
-        int idx = thrust::get<0>(kv);
+            size_t idx) {
         int x, y, z;
         int h_res = resolution_ / 2;
         thrust::tie(x, y, z) = KeyOf(idx, resolution_);
-        geometry::TSDFVoxel v = thrust::get<1>(kv);
+        const VoxelType v = voxels_[idx];
+        const float f = v.GetTSDF();
         Eigen::Vector3f pt(half_voxel_length_ + voxel_length_ * (x - h_res),
                            half_voxel_length_ + voxel_length_ * (y - h_res),
                            half_voxel_length_ + voxel_length_ * (z - h_res));
-        if (v.weight_ != 0.0f && v.tsdf_ < 0.98f && v.tsdf_ >= -0.98f) {
-            float c = (v.tsdf_ + 1.0) * 0.5;
+        if (v.GetWeight() != 0.0f && f < 0.98f && f >= -0.98f) {
+            float c = (f + 1.0) * 0.5;
             return thrust::make_tuple(pt + origin_, Eigen::Vector3f(c, c, c));
         }
         return thrust::make_tuple(
@@ -382,18 +433,20 @@ struct extract_voxel_pointcloud_functor {
     }
 };
 
+template <typename VoxelType>
 struct extract_voxel_grid_functor {
-    extract_voxel_grid_functor(int resolution) : resolution_(resolution){};
+    extract_voxel_grid_functor(const VoxelType *voxels, int resolution)
+        : voxels_(voxels), resolution_(resolution){};
+    const VoxelType *voxels_;
     const int resolution_;
     __device__ thrust::tuple<Eigen::Vector3i, geometry::Voxel> operator()(
-            const thrust::tuple<size_t, geometry::TSDFVoxel> &kv) {
-        int idx = thrust::get<0>(kv);
+            size_t idx) {
         int x, y, z;
         thrust::tie(x, y, z) = KeyOf(idx, resolution_);
         Eigen::Vector3i grid_idx = Eigen::Vector3i(x, y, z);
-        geometry::TSDFVoxel v = thrust::get<1>(kv);
-        const float w = v.weight_;
-        const float f = v.tsdf_;
+        const VoxelType v = voxels_[idx];
+        const float w = v.GetWeight();
+        const float f = v.GetTSDF();
         if (w != 0.0f && f < 0.98f && f >= -0.98f) {
             float c = (f + 1.0) * 0.5;
             return thrust::make_tuple(
@@ -406,8 +459,9 @@ struct extract_voxel_grid_functor {
     }
 };
 
+template <typename VoxelType>
 struct raycast_tsdf_functor {
-    raycast_tsdf_functor(const geometry::TSDFVoxel *voxels,
+    raycast_tsdf_functor(const VoxelType *voxels,
                          int width,
                          float fx,
                          float fy,
@@ -431,7 +485,7 @@ struct raycast_tsdf_functor {
           origin_(origin),
           sdf_trunc_(sdf_trunc),
           color_type_(color_type){};
-    const geometry::TSDFVoxel *voxels_;
+    const VoxelType *voxels_;
     const int width_;
     const float fx_;
     const float fy_;
@@ -445,7 +499,7 @@ struct raycast_tsdf_functor {
     const TSDFVolumeColorType color_type_;
     __device__ __forceinline__ float InterpolateTrilinearly(
             const Eigen::Vector3f &point,
-            const geometry::TSDFVoxel *voxels,
+            const VoxelType *voxels,
             int resolution) const {
         Eigen::Vector3i point_in_grid = point.cast<int>();
         const float vx = (float)point_in_grid[0] + 0.5f;
@@ -460,26 +514,28 @@ struct raycast_tsdf_functor {
         const float a = point[0] - ((float)point_in_grid[0] + 0.5f);
         const float b = point[1] - ((float)point_in_grid[1] + 0.5f);
         const float c = point[2] - ((float)point_in_grid[2] + 0.5f);
-        geometry::TSDFVoxel v0 = voxels[IndexOf(point_in_grid, resolution)];
-        geometry::TSDFVoxel v1 = voxels[IndexOf(
+        VoxelType v0 = voxels[IndexOf(point_in_grid, resolution)];
+        VoxelType v1 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(0, 0, 1), resolution)];
-        geometry::TSDFVoxel v2 = voxels[IndexOf(
+        VoxelType v2 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(0, 1, 0), resolution)];
-        geometry::TSDFVoxel v3 = voxels[IndexOf(
+        VoxelType v3 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(0, 1, 1), resolution)];
-        geometry::TSDFVoxel v4 = voxels[IndexOf(
+        VoxelType v4 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(1, 0, 0), resolution)];
-        geometry::TSDFVoxel v5 = voxels[IndexOf(
+        VoxelType v5 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(1, 0, 1), resolution)];
-        geometry::TSDFVoxel v6 = voxels[IndexOf(
+        VoxelType v6 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(1, 1, 0), resolution)];
-        geometry::TSDFVoxel v7 = voxels[IndexOf(
+        VoxelType v7 = voxels[IndexOf(
                 point_in_grid + Eigen::Vector3i(1, 1, 1), resolution)];
-        return v0.tsdf_ * (1 - a) * (1 - b) * (1 - c) +
-               v1.tsdf_ * (1 - a) * (1 - b) * c +
-               v2.tsdf_ * (1 - a) * b * (1 - c) + v3.tsdf_ * (1 - a) * b * c +
-               v4.tsdf_ * a * (1 - b) * (1 - c) + v5.tsdf_ * a * (1 - b) * c +
-               v6.tsdf_ * a * b * (1 - c) + v7.tsdf_ * a * b * c;
+        return v0.GetTSDF() * (1 - a) * (1 - b) * (1 - c) +
+               v1.GetTSDF() * (1 - a) * (1 - b) * c +
+               v2.GetTSDF() * (1 - a) * b * (1 - c) +
+               v3.GetTSDF() * (1 - a) * b * c +
+               v4.GetTSDF() * a * (1 - b) * (1 - c) +
+               v5.GetTSDF() * a * (1 - b) * c +
+               v6.GetTSDF() * a * b * (1 - c) + v7.GetTSDF() * a * b * c;
     }
     __device__ __forceinline__ float GetMinTime(
             float length,
@@ -552,7 +608,7 @@ struct raycast_tsdf_functor {
                     Eigen::Vector3f::Constant(
                             std::numeric_limits<float>::quiet_NaN()));
         }
-        geometry::TSDFVoxel v = voxels_[IndexOf(grid_idx, resolution_)];
+        VoxelType v = voxels_[IndexOf(grid_idx, resolution_)];
         const float max_search_length = ray_len + length * sqrt(2.0f);
         for (; ray_len < max_search_length; ray_len += sdf_trunc_ * 0.5f) {
             grid_idx = Eigen::device_vectorize<float, 3, ::floor>(
@@ -564,13 +620,13 @@ struct raycast_tsdf_functor {
                 grid_idx[1] < 1 || grid_idx[1] >= resolution_ - 1 ||
                 grid_idx[2] < 1 || grid_idx[2] >= resolution_ - 1)
                 continue;
-            const geometry::TSDFVoxel prev_v = v;
+            const float prev_f = v.GetTSDF();
             v = voxels_[IndexOf(grid_idx, resolution_)];
-            if (prev_v.tsdf_ < 0.0f && v.tsdf_ > 0.0f) break;
-            if (prev_v.tsdf_ > 0.0f && v.tsdf_ < 0.0f) {
-                const float t_star = ray_len - sdf_trunc_ * 0.5f *
-                                                       prev_v.tsdf_ /
-                                                       (v.tsdf_ - prev_v.tsdf_);
+            const float f = v.GetTSDF();
+            if (prev_f < 0.0f && f > 0.0f) break;
+            if (prev_f > 0.0f && f < 0.0f) {
+                const float t_star =
+                        ray_len - sdf_trunc_ * 0.5f * prev_f / (f - prev_f);
                 const Eigen::Vector3f vertex = t + ray_dir * t_star;
                 const Eigen::Vector3f loc_in_grid =
                         vertex / voxel_length_ + h_res.cast<float>();
@@ -617,13 +673,13 @@ struct raycast_tsdf_functor {
                 const float norm_nml = normal.norm();
                 if (norm_nml == 0) break;
                 normal /= norm_nml;
-                const geometry::TSDFVoxel v =
+                const VoxelType v =
                         voxels_[IndexOf(loc_in_grid.cast<int>(), resolution_)];
                 Eigen::Vector3f c = Eigen::Vector3f::Zero();
                 if (color_type_ == TSDFVolumeColorType::RGB8) {
-                    c = v.color_ / 255.0;
+                    c = v.GetColor() / 255.0;
                 } else if (color_type_ == TSDFVolumeColorType::Gray32) {
-                    c = v.color_;
+                    c = v.GetColor();
                 }
                 return thrust::make_tuple(vertex + origin_, normal, c);
             }
@@ -638,83 +694,175 @@ struct raycast_tsdf_functor {
     }
 };
 
-}  // namespace
+/// Side length in voxels of the bricks used to cull the integration.
+constexpr int kIntegrationBrickSize = 8;
 
-UniformTSDFVolume::UniformTSDFVolume(
-        float length,
-        int resolution,
-        float sdf_trunc,
-        TSDFVolumeColorType color_type,
-        const Eigen::Vector3f &origin /* = Eigen::Vector3f::Zero()*/)
-    : TSDFVolume(length / (float)resolution, sdf_trunc, color_type),
-      origin_(origin),
-      length_(length),
-      resolution_(resolution),
-      voxel_num_(resolution * resolution * resolution) {
-    voxels_.resize(voxel_num_);
-}
+/// Conservative test of the bounding sphere of a brick against the camera
+/// frustum bounded by the image borders and the far depth.
+struct brick_in_frustum_functor {
+    brick_in_frustum_functor(const Eigen::Matrix4f &extrinsic,
+                             float fx,
+                             float fy,
+                             float cx,
+                             float cy,
+                             float width,
+                             float height,
+                             float far_depth,
+                             float voxel_length,
+                             int resolution,
+                             int brick_resolution,
+                             const Eigen::Vector3f &origin)
+        : extrinsic_(extrinsic),
+          far_depth_(far_depth),
+          voxel_length_(voxel_length),
+          radius_(0.5f * std::sqrt(3.0f) * kIntegrationBrickSize *
+                  voxel_length),
+          resolution_(resolution),
+          brick_resolution_(brick_resolution),
+          origin_(origin) {
+        planes_[0] = Eigen::Vector3f(fx, 0.0, cx + 0.5f).normalized();
+        planes_[1] =
+                Eigen::Vector3f(-fx, 0.0, width - cx - 0.5f).normalized();
+        planes_[2] = Eigen::Vector3f(0.0, fy, cy + 0.5f).normalized();
+        planes_[3] =
+                Eigen::Vector3f(0.0, -fy, height - cy - 0.5f).normalized();
+    };
+    const Eigen::Matrix4f extrinsic_;
+    const float far_depth_;
+    const float voxel_length_;
+    const float radius_;
+    const int resolution_;
+    const int brick_resolution_;
+    const Eigen::Vector3f origin_;
+    Eigen::Vector3f planes_[4];
+    __device__ bool operator()(int brick) const {
+        const int bres2 = brick_resolution_ * brick_resolution_;
+        const Eigen::Vector3i bidx(brick / bres2,
+                                   (brick % bres2) / brick_resolution_,
+                                   brick % brick_resolution_);
+        const Eigen::Vector3f center =
+                origin_ +
+                voxel_length_ * ((bidx * kIntegrationBrickSize).cast<float>() +
+                                 Eigen::Vector3f::Constant(
+                                         0.5f * kIntegrationBrickSize -
+                                         resolution_ / 2));
+        const Eigen::Vector3f pt_camera =
+                extrinsic_.block<3, 3>(0, 0) * center +
+                extrinsic_.block<3, 1>(0, 3);
+        if (pt_camera(2) < -radius_ || pt_camera(2) > far_depth_ + radius_) {
+            return false;
+        }
+#pragma unroll
+        for (int i = 0; i < 4; ++i) {
+            if (planes_[i].dot(pt_camera) < -radius_) return false;
+        }
+        return true;
+    }
+};
 
-UniformTSDFVolume::~UniformTSDFVolume() {}
+bool IsSupportedImage(const geometry::RGBDImage &image,
+                      const camera::PinholeCameraIntrinsic &intrinsic,
+                      TSDFVolumeColorType color_type) {
+    return !((image.depth_.num_of_channels_ != 1) ||
+             (image.depth_.bytes_per_channel_ != 4) ||
+             (image.depth_.width_ != intrinsic.width_) ||
+             (image.depth_.height_ != intrinsic.height_) ||
+             (color_type == TSDFVolumeColorType::RGB8 &&
+              image.color_.num_of_channels_ != 3) ||
+             (color_type == TSDFVolumeColorType::RGB8 &&
+              image.color_.bytes_per_channel_ != 1) ||
+             (color_type == TSDFVolumeColorType::Gray32 &&
+              image.color_.num_of_channels_ != 1) ||
+             (color_type == TSDFVolumeColorType::Gray32 &&
+              image.color_.bytes_per_channel_ != 4) ||
+             (color_type != TSDFVolumeColorType::NoColor &&
+              image.color_.width_ != intrinsic.width_) ||
+             (color_type != TSDFVolumeColorType::NoColor &&
+              image.color_.height_ != intrinsic.height_));
+}
 
-UniformTSDFVolume::UniformTSDFVolume(const UniformTSDFVolume &other)
-    : TSDFVolume(other),
-      voxels_(other.voxels_),
-      origin_(other.origin_),
-      length_(other.length_),
-      resolution_(other.resolution_),
-      voxel_num_(other.voxel_num_) {}
+/// Returns the farthest finite depth of a float depth image.
+float GetMaxDepth(const geometry::Image &depth_image) {
+    const float *depth = reinterpret_cast<const float *>(
+            thrust::raw_pointer_cast(depth_image.data_.data()));
+    return thrust::transform_reduce(
+            utility::exec_policy(0)->on(0), thrust::device_pointer_cast(depth),
+            thrust::device_pointer_cast(depth) +
+                    depth_image.width_ * depth_image.height_,
+            [] __device__(float d) { return isfinite(d) ? d : 0.0f; }, 0.0f,
+            thrust::maximum<float>());
+}
 
-void UniformTSDFVolume::Reset() { voxels_.clear(); }
+template <typename VoxelType>
+struct is_valid_voxel_functor {
+    __device__ bool operator()(const VoxelType &v) const {
+        const float f = v.GetTSDF();
+        return (v.GetWeight() != 0.0f && f < 0.98f && f >= -0.98f);
+    }
+};
 
-void UniformTSDFVolume::Integrate(
-        const geometry::RGBDImage &image,
-        const camera::PinholeCameraIntrinsic &intrinsic,
-        const Eigen::Matrix4f &extrinsic) {
-    // This function goes through the voxels, and scan convert the relative
-    // depth/color value into the voxel.
-    // The following implementation is a highly optimized version.
-    if ((image.depth_.num_of_channels_ != 1) ||
-        (image.depth_.bytes_per_channel_ != 4) ||
-        (image.depth_.width_ != intrinsic.width_) ||
-        (image.depth_.height_ != intrinsic.height_) ||
-        (color_type_ == TSDFVolumeColorType::RGB8 &&
-         image.color_.num_of_channels_ != 3) ||
-        (color_type_ == TSDFVolumeColorType::RGB8 &&
-         image.color_.bytes_per_channel_ != 1) ||
-        (color_type_ == TSDFVolumeColorType::Gray32 &&
-         image.color_.num_of_channels_ != 1) ||
-        (color_type_ == TSDFVolumeColorType::Gray32 &&
-         image.color_.bytes_per_channel_ != 4) ||
-        (color_type_ != TSDFVolumeColorType::NoColor &&
-         image.color_.width_ != intrinsic.width_) ||
-        (color_type_ != TSDFVolumeColorType::NoColor &&
-         image.color_.height_ != intrinsic.height_)) {
-        utility::LogError(
-                "[UniformTSDFVolume::Integrate] Unsupported image format.");
+/// Calls \p func with a default constructed voxel of the type stored by a
+/// volume of format \p voxel_format and color type \p color_type.
+template <typename Func>
+auto DispatchVoxelType(TSDFVoxelFormat voxel_format,
+                       TSDFVolumeColorType color_type,
+                       const Func &func)
+        -> decltype(func(geometry::TSDFVoxel())) {
+    if (voxel_format == TSDFVoxelFormat::Float32) {
+        return func(geometry::TSDFVoxel());
+    }
+    switch (color_type) {
+        case TSDFVolumeColorType::RGB8:
+            return func(geometry::TSDFVoxelRGB8());
+        case TSDFVolumeColorType::Gray32:
+            return func(geometry::TSDFVoxelGray16());
+        default:
+            return func(geometry::TSDFVoxelNoColor());
     }
-    auto depth2cameradistance =
-            geometry::Image::CreateDepthToCameraDistanceMultiplierFloatImage(
-                    intrinsic);
-    IntegrateWithDepthToCameraDistanceMultiplier(image, intrinsic, extrinsic,
-                                                 *depth2cameradistance);
 }
 
-std::shared_ptr<geometry::PointCloud> UniformTSDFVolume::ExtractPointCloud() {
+template <typename VoxelType>
+VoxelType *VoxelPointer(utility::device_vector<uint8_t> &voxels) {
+    return reinterpret_cast<VoxelType *>(
+            thrust::raw_pointer_cast(voxels.data()));
+}
+
+template <typename VoxelType>
+const VoxelType *VoxelPointer(const utility::device_vector<uint8_t> &voxels) {
+    return reinterpret_cast<const VoxelType *>(
+            thrust::raw_pointer_cast(voxels.data()));
+}
+
+template <typename VoxelType>
+void ResetVoxels(utility::device_vector<uint8_t> &voxels, int voxel_num) {
+    voxels.resize(voxel_num * sizeof(VoxelType));
+    thrust::device_ptr<VoxelType> begin =
+            thrust::device_pointer_cast(VoxelPointer<VoxelType>(voxels));
+    thrust::fill(begin, begin + voxel_num, VoxelType());
+}
+
+template <typename VoxelType>
+size_t CountValidVoxels(const UniformTSDFVolume &volume) {
+    thrust::device_ptr<const VoxelType> begin = thrust::device_pointer_cast(
+            VoxelPointer<VoxelType>(volume.voxels_));
+    return thrust::count_if(utility::exec_policy(0)->on(0), begin,
+                            begin + volume.voxel_num_,
+                            is_valid_voxel_functor<VoxelType>());
+}
+
+template <typename VoxelType>
+std::shared_ptr<geometry::PointCloud> ExtractPointCloudImpl(
+        const UniformTSDFVolume &volume) {
     auto pointcloud = std::make_shared<geometry::PointCloud>();
-    size_t n_valid_voxels =
-            thrust::count_if(voxels_.begin(), voxels_.end(),
-                             [] __device__(const geometry::TSDFVoxel &v) {
-                                 return (v.weight_ != 0.0f && v.tsdf_ < 0.98f &&
-                                         v.tsdf_ >= -0.98f);
-                             });
-    extract_pointcloud_functor func(thrust::raw_pointer_cast(voxels_.data()),
-                                    resolution_, voxel_length_, origin_,
-                                    color_type_);
+    const int resolution = volume.resolution_;
+    size_t n_valid_voxels = CountValidVoxels<VoxelType>(volume);
+    extract_pointcloud_functor<VoxelType> func(
+            VoxelPointer<VoxelType>(volume.voxels_), resolution,
+            volume.voxel_length_, volume.origin_, volume.color_type_);
     pointcloud->points_.resize(n_valid_voxels);
     pointcloud->normals_.resize(n_valid_voxels);
     pointcloud->colors_.resize(n_valid_voxels);
-    size_t n_total =
-            (resolution_ - 2) * (resolution_ - 2) * (resolution_ - 2) * 3;
+    size_t n_total = (resolution - 2) * (resolution - 2) * (resolution - 2) * 3;
     auto begin = make_tuple_begin(pointcloud->points_, pointcloud->normals_,
                                   pointcloud->colors_);
     auto end_p = thrust::copy_if(
@@ -730,129 +878,119 @@ std::shared_ptr<geometry::PointCloud> UniformTSDFVolume::ExtractPointCloud() {
             });
     resize_all(thrust::distance(begin, end_p), pointcloud->points_,
                pointcloud->normals_, pointcloud->colors_);
-    if (color_type_ == TSDFVolumeColorType::NoColor)
+    if (volume.color_type_ == TSDFVolumeColorType::NoColor)
         pointcloud->colors_.clear();
     return pointcloud;
 }
 
-std::shared_ptr<geometry::TriangleMesh>
-UniformTSDFVolume::ExtractTriangleMesh() {
+template <typename VoxelType>
+std::shared_ptr<geometry::TriangleMesh> ExtractTriangleMeshImpl(
+        const UniformTSDFVolume &volume,
+        const Eigen::Vector3i &min_index,
+        const Eigen::Vector3i &max_index) {
     // implementation of marching cubes, based on
     // http://paulbourke.net/geometry/polygonise/
     auto mesh = std::make_shared<geometry::TriangleMesh>();
-    size_t n_valid_voxels = thrust::count_if(
-            enumerate_begin(voxels_), enumerate_end(voxels_),
-            count_valid_voxels_functor(thrust::raw_pointer_cast(voxels_.data()),
-                                       resolution_));
-    size_t res3 = (resolution_ - 1) * (resolution_ - 1) * (resolution_ - 1);
-
-    // compute cube indices for each voxels
-    utility::device_vector<Eigen::Vector3i> keys(n_valid_voxels);
-    utility::device_vector<int> cube_indices(n_valid_voxels);
-    extract_mesh_phase0_functor func0(thrust::raw_pointer_cast(voxels_.data()),
-                                      resolution_);
-    thrust::copy_if(
-            thrust::make_transform_iterator(
-                    thrust::make_counting_iterator<size_t>(0), func0),
-            thrust::make_transform_iterator(
-                    thrust::make_counting_iterator(res3), func0),
-            make_tuple_begin(keys, cube_indices),
-            [] __device__(const thrust::tuple<Eigen::Vector3i, int> &x) {
-                return thrust::get<1>(x) >= 0;
-            });
-    auto check_fn =
-            [] __device__(
-                    const thrust::tuple<Eigen::Vector3i, int> &x) -> bool {
-        int cidx = thrust::get<1>(x);
-        return (cidx <= 0 || cidx >= 255);
-    };
-    size_t n_result1 = remove_if_vectors(utility::exec_policy(0)->on(0),
-                                         check_fn, keys, cube_indices);
-
-    utility::device_vector<float> fs(n_result1 * 8);
-    utility::device_vector<Eigen::Vector3f> cs(n_result1 * 8);
-    extract_mesh_phase1_functor func1(thrust::raw_pointer_cast(voxels_.data()),
-                                      thrust::raw_pointer_cast(keys.data()),
-                                      resolution_, color_type_);
-    thrust::transform(thrust::make_counting_iterator<size_t>(0),
-                      thrust::make_counting_iterator(n_result1 * 8),
-                      make_tuple_begin(fs, cs), func1);
-
-    // compute vertices and vertex_colors
-    int *ci_p = thrust::raw_pointer_cast(cube_indices.data());
-    size_t n_valid_cubes =
-            thrust::count_if(thrust::make_counting_iterator<size_t>(0),
-                             thrust::make_counting_iterator(n_result1 * 12),
-                             [ci_p] __device__(size_t idx) {
-                                 int i = idx / 12;
-                                 int j = idx % 12;
-                                 return (edge_table[ci_p[i]] & (1 << j)) > 0;
-                             });
-    resize_all(n_valid_cubes, mesh->vertices_, mesh->vertex_colors_);
-    utility::device_vector<Eigen::Vector3i> repeat_keys(n_valid_cubes);
-    utility::device_vector<int> repeat_cube_indices(n_valid_cubes);
-    utility::device_vector<int> vert_no(n_valid_cubes);
-    extract_mesh_phase2_functor func2(
-            thrust::raw_pointer_cast(keys.data()),
-            thrust::raw_pointer_cast(cube_indices.data()), origin_, resolution_,
-            voxel_length_, thrust::raw_pointer_cast(fs.data()),
-            thrust::raw_pointer_cast(cs.data()), color_type_);
-    thrust::copy_if(
+    const int resolution = volume.resolution_;
+    const VoxelType *voxels = VoxelPointer<VoxelType>(volume.voxels_);
+
+    // collect the voxels owning a vertex or a triangle
+    const Eigen::Vector3i size =
+            max_index - min_index + Eigen::Vector3i::Ones();
+    const size_t n_range = (size_t)size[0] * size[1] * size[2];
+    range_to_voxel_index_functor to_voxel_index(min_index, size, resolution);
+    has_mesh_elements_functor<VoxelType> has_elements(voxels, resolution,
+                                                      min_index, max_index);
+    utility::device_vector<int> voxel_indices(n_range);
+    auto end1 = thrust::copy_if(
             thrust::make_transform_iterator(
-                    thrust::make_counting_iterator<size_t>(0), func2),
+                    thrust::make_counting_iterator<size_t>(0), to_voxel_index),
             thrust::make_transform_iterator(
-                    thrust::make_counting_iterator(n_result1 * 12), func2),
-            make_tuple_begin(repeat_keys, repeat_cube_indices, vert_no,
-                             mesh->vertices_, mesh->vertex_colors_),
-            [] __device__(
-                    const thrust::tuple<Eigen::Vector3i, int, int,
-                                        Eigen::Vector3f, Eigen::Vector3f> &x) {
-                return thrust::get<0>(x)[0] >= 0;
-            });
+                    thrust::make_counting_iterator(n_range), to_voxel_index),
+            voxel_indices.begin(), has_elements);
+    voxel_indices.resize(thrust::distance(voxel_indices.begin(), end1));
+    if (voxel_indices.empty()) return mesh;
 
-    // compute triangles
-    utility::device_vector<int> vt_offsets(n_valid_cubes + 1, 0);
-    auto end2 = thrust::reduce_by_key(
-            utility::exec_policy(0)->on(0), repeat_keys.begin(),
-            repeat_keys.end(), thrust::make_constant_iterator<int>(1),
-            thrust::make_discard_iterator(), vt_offsets.begin());
-    size_t n_result2 = thrust::distance(vt_offsets.begin(), end2.second);
-    vt_offsets.resize(n_result2 + 1);
-    thrust::exclusive_scan(utility::exec_policy(0)->on(0), vt_offsets.begin(),
-                           vt_offsets.end(), vt_offsets.begin());
-    mesh->triangles_.resize(n_result2 * 4, Eigen::Vector3i(-1, -1, -1));
-    extract_mesh_phase3_functor func3(
-            thrust::raw_pointer_cast(repeat_cube_indices.data()),
-            thrust::raw_pointer_cast(vert_no.data()),
-            thrust::raw_pointer_cast(vt_offsets.data()),
-            thrust::raw_pointer_cast(mesh->triangles_.data()));
+    // count, then write the vertices and triangles of each voxel
+    const size_t n_voxels = voxel_indices.size();
+    utility::device_vector<int> vertex_offsets(n_voxels);
+    utility::device_vector<int> triangle_offsets(n_voxels);
+    count_mesh_elements_functor<VoxelType> func1(voxels, resolution,
+                                                 min_index, max_index);
+    thrust::transform(voxel_indices.begin(), voxel_indices.end(),
+                      make_tuple_begin(vertex_offsets, triangle_offsets),
+                      func1);
+    const int n_vertices =
+            thrust::reduce(utility::exec_policy(0)->on(0),
+                           vertex_offsets.begin(), vertex_offsets.end());
+    const int n_triangles =
+            thrust::reduce(utility::exec_policy(0)->on(0),
+                           triangle_offsets.begin(), triangle_offsets.end());
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                           vertex_offsets.begin(), vertex_offsets.end(),
+                           vertex_offsets.begin());
+    thrust::exclusive_scan(utility::exec_policy(0)->on(0),
+                           triangle_offsets.begin(), triangle_offsets.end(),
+                           triangle_offsets.begin());
+    // The voxels are visited in the order of their index, so the vertex
+    // edges are written sorted.
+    utility::device_vector<Eigen::Vector4i> vertex_edges(n_vertices);
+    utility::device_vector<Eigen::Vector4i> triangle_edges(n_triangles * 3);
+    resize_all(n_vertices, mesh->vertices_, mesh->vertex_colors_);
+    extract_mesh_elements_functor<VoxelType> func2(
+            voxels, resolution, min_index, max_index, volume.voxel_length_,
+            volume.origin_, volume.color_type_,
+            thrust::raw_pointer_cast(voxel_indices.data()),
+            thrust::raw_pointer_cast(vertex_offsets.data()),
+            thrust::raw_pointer_cast(triangle_offsets.data()),
+            thrust::raw_pointer_cast(vertex_edges.data()),
+            thrust::raw_pointer_cast(mesh->vertices_.data()),
+            thrust::raw_pointer_cast(mesh->vertex_colors_.data()),
+            thrust::raw_pointer_cast(triangle_edges.data()));
     thrust::for_each(thrust::make_counting_iterator<size_t>(0),
-                     thrust::make_counting_iterator(n_result2), func3);
-    auto end3 = thrust::remove_if(
+                     thrust::make_counting_iterator(n_voxels), func2);
+    if (volume.color_type_ == TSDFVolumeColorType::NoColor) {
+        mesh->vertex_colors_.clear();
+    }
+
+    // compute triangles
+    utility::device_vector<int> vertex_indices(triangle_edges.size());
+    thrust::lower_bound(vertex_edges.begin(), vertex_edges.end(),
+                        triangle_edges.begin(), triangle_edges.end(),
+                        vertex_indices.begin());
+    mesh->triangles_.resize(n_triangles);
+    assemble_triangles_functor func3(
+            thrust::raw_pointer_cast(vertex_edges.data()), n_vertices,
+            thrust::raw_pointer_cast(triangle_edges.data()),
+            thrust::raw_pointer_cast(vertex_indices.data()));
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator<size_t>(n_triangles),
+                      mesh->triangles_.begin(), func3);
+    auto end2 = thrust::remove_if(
             utility::exec_policy(0)->on(0), mesh->triangles_.begin(),
             mesh->triangles_.end(),
             [] __device__(const Eigen::Vector3i &idxs) { return idxs[0] < 0; });
-    mesh->triangles_.resize(thrust::distance(mesh->triangles_.begin(), end3));
+    mesh->triangles_.resize(thrust::distance(mesh->triangles_.begin(), end2));
+    // A vertex on the edge of a cube with an invalid corner has no triangle.
+    mesh->RemoveUnreferencedVertices();
     return mesh;
 }
 
-std::shared_ptr<geometry::PointCloud>
-UniformTSDFVolume::ExtractVoxelPointCloud() const {
+template <typename VoxelType>
+std::shared_ptr<geometry::PointCloud> ExtractVoxelPointCloudImpl(
+        const UniformTSDFVolume &volume) {
     auto voxel = std::make_shared<geometry::PointCloud>();
-    // const float *p_tsdf = (const float *)tsdf_.data();
-    // const float *p_weight = (const float *)weight_.data();
-    // const float *p_color = (const float *)color_.data();
-    size_t n_valid_voxels =
-            thrust::count_if(voxels_.begin(), voxels_.end(),
-                             [] __device__(const geometry::TSDFVoxel &v) {
-                                 return (v.weight_ != 0.0f && v.tsdf_ < 0.98f &&
-                                         v.tsdf_ >= -0.98f);
-                             });
-    extract_voxel_pointcloud_functor func(origin_, resolution_, voxel_length_);
+    size_t n_valid_voxels = CountValidVoxels<VoxelType>(volume);
+    extract_voxel_pointcloud_functor<VoxelType> func(
+            VoxelPointer<VoxelType>(volume.voxels_), volume.origin_,
+            volume.resolution_, volume.voxel_length_);
     resize_all(n_valid_voxels, voxel->points_, voxel->colors_);
     thrust::copy_if(
-            thrust::make_transform_iterator(enumerate_begin(voxels_), func),
-            thrust::make_transform_iterator(enumerate_end(voxels_), func),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(0), func),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(volume.voxel_num_),
+                    func),
             make_tuple_begin(voxel->points_, voxel->colors_),
             [] __device__(
                     const thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> &x) {
@@ -863,24 +1001,25 @@ UniformTSDFVolume::ExtractVoxelPointCloud() const {
     return voxel;
 }
 
-std::shared_ptr<geometry::VoxelGrid> UniformTSDFVolume::ExtractVoxelGrid()
-        const {
+template <typename VoxelType>
+std::shared_ptr<geometry::VoxelGrid> ExtractVoxelGridImpl(
+        const UniformTSDFVolume &volume) {
     auto voxel_grid = std::make_shared<geometry::VoxelGrid>();
-    voxel_grid->voxel_size_ = voxel_length_;
-    voxel_grid->origin_ = origin_ - Eigen::Vector3f::Constant(resolution_ / 2) *
-                                            voxel_length_;
-    size_t n_valid_voxels = thrust::count_if(
-            utility::exec_policy(0)->on(0), voxels_.begin(), voxels_.end(),
-            [] __device__(const geometry::TSDFVoxel &v) {
-                return (v.weight_ != 0.0f && v.tsdf_ < 0.98f &&
-                        v.tsdf_ >= -0.98f);
-            });
+    voxel_grid->voxel_size_ = volume.voxel_length_;
+    voxel_grid->origin_ =
+            volume.origin_ - Eigen::Vector3f::Constant(volume.resolution_ / 2) *
+                                     volume.voxel_length_;
+    size_t n_valid_voxels = CountValidVoxels<VoxelType>(volume);
     resize_all(n_valid_voxels, voxel_grid->voxels_keys_,
                voxel_grid->voxels_values_);
-    extract_voxel_grid_functor func(resolution_);
+    extract_voxel_grid_functor<VoxelType> func(
+            VoxelPointer<VoxelType>(volume.voxels_), volume.resolution_);
     thrust::copy_if(
-            thrust::make_transform_iterator(enumerate_begin(voxels_), func),
-            thrust::make_transform_iterator(enumerate_end(voxels_), func),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(0), func),
+            thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(volume.voxel_num_),
+                    func),
             make_tuple_begin(voxel_grid->voxels_keys_,
                              voxel_grid->voxels_values_),
             [] __device__(
@@ -893,6 +1032,129 @@ std::shared_ptr<geometry::VoxelGrid> UniformTSDFVolume::ExtractVoxelGrid()
     return voxel_grid;
 }
 
+}  // namespace
+
+UniformTSDFVolume::UniformTSDFVolume(
+        float length,
+        int resolution,
+        float sdf_trunc,
+        TSDFVolumeColorType color_type,
+        const Eigen::Vector3f &origin /* = Eigen::Vector3f::Zero()*/,
+        TSDFVoxelFormat voxel_format /* = TSDFVoxelFormat::Float32*/)
+    : TSDFVolume(length / (float)resolution, sdf_trunc, color_type),
+      voxel_format_(voxel_format),
+      origin_(origin),
+      length_(length),
+      resolution_(resolution),
+      voxel_num_(resolution * resolution * resolution) {
+    DispatchVoxelType(voxel_format_, color_type_, [this](auto voxel) {
+        ResetVoxels<decltype(voxel)>(voxels_, voxel_num_);
+    });
+}
+
+UniformTSDFVolume::~UniformTSDFVolume() {}
+
+UniformTSDFVolume::UniformTSDFVolume(const UniformTSDFVolume &other)
+    : TSDFVolume(other),
+      voxels_(other.voxels_),
+      voxel_format_(other.voxel_format_),
+      origin_(other.origin_),
+      length_(other.length_),
+      resolution_(other.resolution_),
+      voxel_num_(other.voxel_num_) {}
+
+void UniformTSDFVolume::Reset() {
+    DispatchVoxelType(voxel_format_, color_type_, [this](auto voxel) {
+        ResetVoxels<decltype(voxel)>(voxels_, voxel_num_);
+    });
+}
+
+size_t UniformTSDFVolume::GetVoxelByteSize() const {
+    return DispatchVoxelType(voxel_format_, color_type_,
+                             [](auto voxel) { return sizeof(voxel); });
+}
+
+void UniformTSDFVolume::Integrate(
+        const geometry::RGBDImage &image,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic) {
+    // This function goes through the voxels, and scan convert the relative
+    // depth/color value into the voxel.
+    // The following implementation is a highly optimized version.
+    if (!IsSupportedImage(image, intrinsic, color_type_)) {
+        utility::LogError(
+                "[UniformTSDFVolume::Integrate] Unsupported image format.");
+    }
+    const auto &depth2cameradistance =
+            GetDepthToCameraDistanceMultiplier(intrinsic);
+    IntegrateWithDepthToCameraDistanceMultiplier(image, intrinsic, extrinsic,
+                                                 depth2cameradistance);
+}
+
+std::shared_ptr<geometry::PointCloud> UniformTSDFVolume::ExtractPointCloud() {
+    return DispatchVoxelType(voxel_format_, color_type_, [this](auto voxel) {
+        return ExtractPointCloudImpl<decltype(voxel)>(*this);
+    });
+}
+
+std::shared_ptr<geometry::TriangleMesh>
+UniformTSDFVolume::ExtractTriangleMesh() {
+    const Eigen::Vector3i min_index = Eigen::Vector3i::Zero();
+    const Eigen::Vector3i max_index =
+            Eigen::Vector3i::Constant(resolution_ - 1);
+    return DispatchVoxelType(voxel_format_, color_type_, [&](auto voxel) {
+        return ExtractTriangleMeshImpl<decltype(voxel)>(*this, min_index,
+                                                        max_index);
+    });
+}
+
+std::shared_ptr<geometry::TriangleMesh> UniformTSDFVolume::ExtractTriangleMesh(
+        const geometry::AxisAlignedBoundingBox<3> &roi,
+        float simplification_voxel_size,
+        geometry::MeshBase::SimplificationContraction contraction) {
+    // the center of the voxel (x, y, z) is
+    // origin_ + ((x, y, z) - resolution_ / 2 + 0.5) * voxel_length_
+    const Eigen::Vector3f offset =
+            Eigen::Vector3f::Constant(resolution_ / 2 - 0.5f);
+    const Eigen::Vector3f min_grid =
+            (roi.min_bound_ - origin_) / voxel_length_ + offset;
+    const Eigen::Vector3f max_grid =
+            (roi.max_bound_ - origin_) / voxel_length_ + offset;
+    Eigen::Vector3i min_index;
+    Eigen::Vector3i max_index;
+    for (int i = 0; i < 3; ++i) {
+        min_index[i] = (int)std::ceil(std::max(min_grid[i], 0.0f));
+        max_index[i] = (int)std::floor(
+                std::min(max_grid[i], (float)(resolution_ - 1)));
+    }
+    if ((min_index.array() > max_index.array()).any()) {
+        return std::make_shared<geometry::TriangleMesh>();
+    }
+    auto mesh = DispatchVoxelType(voxel_format_, color_type_, [&](auto voxel) {
+        return ExtractTriangleMeshImpl<decltype(voxel)>(*this, min_index,
+                                                        max_index);
+    });
+    if (simplification_voxel_size > 0.0 && mesh->HasTriangles()) {
+        return mesh->SimplifyVertexClustering(simplification_voxel_size,
+                                              contraction);
+    }
+    return mesh;
+}
+
+std::shared_ptr<geometry::PointCloud>
+UniformTSDFVolume::ExtractVoxelPointCloud() const {
+    return DispatchVoxelType(voxel_format_, color_type_, [this](auto voxel) {
+        return ExtractVoxelPointCloudImpl<decltype(voxel)>(*this);
+    });
+}
+
+std::shared_ptr<geometry::VoxelGrid> UniformTSDFVolume::ExtractVoxelGrid()
+        const {
+    return DispatchVoxelType(voxel_format_, color_type_, [this](auto voxel) {
+        return ExtractVoxelGridImpl<decltype(voxel)>(*this);
+    });
+}
+
 void UniformTSDFVolume::IntegrateWithDepthToCameraDistanceMultiplier(
         const geometry::RGBDImage &image,
         const camera::PinholeCameraIntrinsic &intrinsic,
@@ -904,20 +1166,139 @@ void UniformTSDFVolume::IntegrateWithDepthToCameraDistanceMultiplier(
     const float cy = intrinsic.GetPrincipalPoint().second;
     const float safe_width = intrinsic.width_ - 0.0001f;
     const float safe_height = intrinsic.height_ - 0.0001f;
-    voxels_.resize(voxel_num_);
-    uniform_integrate_functor func(
-            fx, fy, cx, cy, extrinsic, voxel_length_, sdf_trunc_, safe_width,
-            safe_height, resolution_,
-            thrust::raw_pointer_cast(image.color_.data_.data()),
-            thrust::raw_pointer_cast(image.depth_.data_.data()),
-            thrust::raw_pointer_cast(
-                    depth_to_camera_distance_multiplier.data_.data()),
-            image.depth_.width_, image.color_.num_of_channels_, color_type_,
-            origin_, thrust::raw_pointer_cast(voxels_.data()));
-    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
-                     thrust::make_counting_iterator<size_t>(
-                             resolution_ * resolution_ * resolution_),
-                     func);
+    // Only the voxels in front of the farthest depth plus the truncation can
+    // be updated.
+    const float max_depth = GetMaxDepth(image.depth_);
+    if (max_depth <= 0.0f) return;
+
+    // Collect the bricks intersecting the camera frustum.
+    const int brick_res = (resolution_ + kIntegrationBrickSize - 1) /
+                          kIntegrationBrickSize;
+    const int n_bricks = brick_res * brick_res * brick_res;
+    utility::device_vector<int> bricks(n_bricks);
+    brick_in_frustum_functor in_frustum(
+            extrinsic, fx, fy, cx, cy, intrinsic.width_, intrinsic.height_,
+            max_depth + sdf_trunc_, voxel_length_, resolution_, brick_res,
+            origin_);
+    auto end = thrust::copy_if(thrust::make_counting_iterator(0),
+                               thrust::make_counting_iterator(n_bricks),
+                               bricks.begin(), in_frustum);
+    bricks.resize(thrust::distance(bricks.begin(), end));
+    if (bricks.empty()) return;
+
+    DispatchVoxelType(voxel_format_, color_type_, [&](auto voxel) {
+        using VoxelType = decltype(voxel);
+        if (voxels_.size() != voxel_num_ * sizeof(VoxelType)) {
+            ResetVoxels<VoxelType>(voxels_, voxel_num_);
+        }
+        uniform_integrate_functor<VoxelType> func(
+                fx, fy, cx, cy, extrinsic, voxel_length_, sdf_trunc_,
+                safe_width, safe_height, resolution_,
+                thrust::raw_pointer_cast(image.color_.data_.data()),
+                thrust::raw_pointer_cast(image.depth_.data_.data()),
+                thrust::raw_pointer_cast(
+                        depth_to_camera_distance_multiplier.data_.data()),
+                image.depth_.width_, image.color_.num_of_channels_,
+                color_type_, origin_, VoxelPointer<VoxelType>(voxels_));
+        uniform_brick_integrate_functor<VoxelType> brick_func(
+                func, thrust::raw_pointer_cast(bricks.data()),
+                kIntegrationBrickSize, brick_res);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator<size_t>(
+                                 bricks.size() * kIntegrationBrickSize *
+                                 kIntegrationBrickSize * kIntegrationBrickSize),
+                         brick_func);
+    });
+}
+
+void UniformTSDFVolume::IntegrateBatch(
+        const std::vector<geometry::RGBDImage> &images,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const thrust::host_vector<Eigen::Matrix4f> &extrinsics) {
+    if (images.size() != extrinsics.size()) {
+        utility::LogError(
+                "[UniformTSDFVolume::IntegrateBatch] The numbers of images "
+                "and extrinsics are different.");
+        return;
+    }
+    const float fx = intrinsic.GetFocalLength().first;
+    const float fy = intrinsic.GetFocalLength().second;
+    const float cx = intrinsic.GetPrincipalPoint().first;
+    const float cy = intrinsic.GetPrincipalPoint().second;
+    const float safe_width = intrinsic.width_ - 0.0001f;
+    const float safe_height = intrinsic.height_ - 0.0001f;
+
+    // Collect the frames with a valid depth and the bricks intersecting the
+    // camera frustum of any of them.
+    const int brick_res = (resolution_ + kIntegrationBrickSize - 1) /
+                          kIntegrationBrickSize;
+    const int n_bricks = brick_res * brick_res * brick_res;
+    utility::device_vector<bool> visible(n_bricks, false);
+    thrust::host_vector<const uint8_t *> colors;
+    thrust::host_vector<const uint8_t *> depths;
+    thrust::host_vector<Eigen::Matrix4f> batch_extrinsics;
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (!IsSupportedImage(images[i], intrinsic, color_type_)) {
+            utility::LogError(
+                    "[UniformTSDFVolume::IntegrateBatch] Unsupported image "
+                    "format.");
+            return;
+        }
+        const float max_depth = GetMaxDepth(images[i].depth_);
+        if (max_depth <= 0.0f) continue;
+        brick_in_frustum_functor in_frustum(
+                extrinsics[i], fx, fy, cx, cy, intrinsic.width_,
+                intrinsic.height_, max_depth + sdf_trunc_, voxel_length_,
+                resolution_, brick_res, origin_);
+        thrust::transform(thrust::make_counting_iterator(0),
+                          thrust::make_counting_iterator(n_bricks),
+                          visible.begin(), visible.begin(),
+                          [in_frustum] __device__(int brick, bool v) {
+                              return v || in_frustum(brick);
+                          });
+        colors.push_back(
+                thrust::raw_pointer_cast(images[i].color_.data_.data()));
+        depths.push_back(
+                thrust::raw_pointer_cast(images[i].depth_.data_.data()));
+        batch_extrinsics.push_back(extrinsics[i]);
+    }
+    if (depths.empty()) return;
+    utility::device_vector<int> bricks(n_bricks);
+    auto end = thrust::copy_if(thrust::make_counting_iterator(0),
+                               thrust::make_counting_iterator(n_bricks),
+                               visible.begin(), bricks.begin(),
+                               thrust::identity<bool>());
+    bricks.resize(thrust::distance(bricks.begin(), end));
+    if (bricks.empty()) return;
+
+    const auto &depth2cameradistance =
+            GetDepthToCameraDistanceMultiplier(intrinsic);
+    utility::device_vector<const uint8_t *> d_colors = colors;
+    utility::device_vector<const uint8_t *> d_depths = depths;
+    utility::device_vector<Eigen::Matrix4f> d_extrinsics = batch_extrinsics;
+    DispatchVoxelType(voxel_format_, color_type_, [&](auto voxel) {
+        using VoxelType = decltype(voxel);
+        if (voxels_.size() != voxel_num_ * sizeof(VoxelType)) {
+            ResetVoxels<VoxelType>(voxels_, voxel_num_);
+        }
+        uniform_batch_integrate_functor<VoxelType> func(
+                fx, fy, cx, cy, voxel_length_, sdf_trunc_, safe_width,
+                safe_height, resolution_,
+                thrust::raw_pointer_cast(d_colors.data()),
+                thrust::raw_pointer_cast(d_depths.data()),
+                thrust::raw_pointer_cast(d_extrinsics.data()),
+                d_depths.size(),
+                thrust::raw_pointer_cast(depth2cameradistance.data_.data()),
+                intrinsic.width_, images[0].color_.num_of_channels_,
+                color_type_, origin_, VoxelPointer<VoxelType>(voxels_),
+                thrust::raw_pointer_cast(bricks.data()), kIntegrationBrickSize,
+                brick_res);
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator<size_t>(
+                                 bricks.size() * kIntegrationBrickSize *
+                                 kIntegrationBrickSize * kIntegrationBrickSize),
+                         func);
+    });
 }
 
 std::shared_ptr<geometry::PointCloud> UniformTSDFVolume::Raycast(
@@ -934,16 +1315,19 @@ std::shared_ptr<geometry::PointCloud> UniformTSDFVolume::Raycast(
     pointcloud->points_.resize(n_total);
     pointcloud->normals_.resize(n_total);
     pointcloud->colors_.resize(n_total);
-    raycast_tsdf_functor func(
-            thrust::raw_pointer_cast(voxels_.data()), intrinsic.width_, fx, fy,
-            cx, cy, utility::InverseTransform(extrinsic), voxel_length_,
-            resolution_, origin_, sdf_trunc, color_type_);
-    thrust::transform(
-            thrust::make_counting_iterator<size_t>(0),
-            thrust::make_counting_iterator(n_total),
-            make_tuple_begin(pointcloud->points_, pointcloud->normals_,
-                             pointcloud->colors_),
-            func);
+    DispatchVoxelType(voxel_format_, color_type_, [&](auto voxel) {
+        using VoxelType = decltype(voxel);
+        raycast_tsdf_functor<VoxelType> func(
+                VoxelPointer<VoxelType>(voxels_), intrinsic.width_, fx, fy, cx,
+                cy, utility::InverseTransform(extrinsic), voxel_length_,
+                resolution_, origin_, sdf_trunc, color_type_);
+        thrust::transform(
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator(n_total),
+                make_tuple_begin(pointcloud->points_, pointcloud->normals_,
+                                 pointcloud->colors_),
+                func);
+    });
     pointcloud->RemoveNoneFinitePoints(project_valid_depth_only,
                                        project_valid_depth_only);
     return pointcloud;
@@ -20,6 +20,7 @@
  **/
 #pragma once
 
+#include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch/integration/tsdfvolume.h"
 
@@ -34,23 +35,141 @@ public:
         : color_(color) {}
     __host__ __device__ ~TSDFVoxel() {}
 
+public:
+    __host__ __device__ float GetTSDF() const { return tsdf_; }
+    __host__ __device__ float GetWeight() const { return weight_; }
+    __host__ __device__ Eigen::Vector3f GetColor() const { return color_; }
+    __host__ __device__ void Set(float tsdf,
+                                 float weight,
+                                 const Eigen::Vector3f &color) {
+        tsdf_ = tsdf;
+        weight_ = weight;
+        color_ = color;
+    }
+
 public:
     float tsdf_ = 0;
     float weight_ = 0;
     Eigen::Vector3f color_ = Eigen::Vector3f(1.0, 1.0, 1.0);
 };
 
+/// Quantization of the compact voxels. The TSDF in [-1, 1] is stored as an
+/// int16 and the weight as an uint16 saturating at 65535.
+__host__ __device__ inline int16_t QuantizeTSDF(float tsdf) {
+    return (int16_t)roundf(fminf(fmaxf(tsdf, -1.0f), 1.0f) * 32767.0f);
+}
+
+__host__ __device__ inline float DequantizeTSDF(int16_t tsdf) {
+    return tsdf * (1.0f / 32767.0f);
+}
+
+__host__ __device__ inline uint16_t QuantizeWeight(float weight) {
+    return (uint16_t)fminf(weight, 65535.0f);
+}
+
+/// 4 bytes voxel of a volume without color.
+class TSDFVoxelNoColor {
+public:
+    __host__ __device__ TSDFVoxelNoColor() {}
+    __host__ __device__ ~TSDFVoxelNoColor() {}
+
+public:
+    __host__ __device__ float GetTSDF() const { return DequantizeTSDF(tsdf_); }
+    __host__ __device__ float GetWeight() const { return weight_; }
+    __host__ __device__ Eigen::Vector3f GetColor() const {
+        return Eigen::Vector3f::Ones();
+    }
+    __host__ __device__ void Set(float tsdf,
+                                 float weight,
+                                 const Eigen::Vector3f &color) {
+        tsdf_ = QuantizeTSDF(tsdf);
+        weight_ = QuantizeWeight(weight);
+    }
+
+public:
+    int16_t tsdf_ = 0;
+    uint16_t weight_ = 0;
+};
+
+/// 8 bytes voxel of a volume with RGB8 color. The color is stored as uint8 in
+/// [0, 255] like the color_ of TSDFVoxel.
+class TSDFVoxelRGB8 {
+public:
+    __host__ __device__ TSDFVoxelRGB8() {}
+    __host__ __device__ ~TSDFVoxelRGB8() {}
+
+public:
+    __host__ __device__ float GetTSDF() const { return DequantizeTSDF(tsdf_); }
+    __host__ __device__ float GetWeight() const { return weight_; }
+    __host__ __device__ Eigen::Vector3f GetColor() const {
+        return Eigen::Vector3f(color_[0], color_[1], color_[2]);
+    }
+    __host__ __device__ void Set(float tsdf,
+                                 float weight,
+                                 const Eigen::Vector3f &color) {
+        tsdf_ = QuantizeTSDF(tsdf);
+        weight_ = QuantizeWeight(weight);
+        for (int i = 0; i < 3; ++i) {
+            color_[i] = (uint8_t)roundf(fminf(fmaxf(color[i], 0.0f), 255.0f));
+        }
+    }
+
+public:
+    int16_t tsdf_ = 0;
+    uint16_t weight_ = 0;
+    uint8_t color_[3] = {255, 255, 255};
+};
+
+/// 6 bytes voxel of a volume with Gray32 color. The intensity in [0, 1] is
+/// stored as an uint16.
+class TSDFVoxelGray16 {
+public:
+    __host__ __device__ TSDFVoxelGray16() {}
+    __host__ __device__ ~TSDFVoxelGray16() {}
+
+public:
+    __host__ __device__ float GetTSDF() const { return DequantizeTSDF(tsdf_); }
+    __host__ __device__ float GetWeight() const { return weight_; }
+    __host__ __device__ Eigen::Vector3f GetColor() const {
+        return Eigen::Vector3f::Constant(intensity_ * (1.0f / 65535.0f));
+    }
+    __host__ __device__ void Set(float tsdf,
+                                 float weight,
+                                 const Eigen::Vector3f &color) {
+        tsdf_ = QuantizeTSDF(tsdf);
+        weight_ = QuantizeWeight(weight);
+        intensity_ =
+                (uint16_t)roundf(fminf(fmaxf(color[0], 0.0f), 1.0f) * 65535.0f);
+    }
+
+public:
+    int16_t tsdf_ = 0;
+    uint16_t weight_ = 0;
+    uint16_t intensity_ = 65535;
+};
+
 }  // namespace geometry
 
 namespace integration {
 
+/// Storage format of the voxels of a UniformTSDFVolume.
+enum class TSDFVoxelFormat {
+    /// geometry::TSDFVoxel, 20 bytes with float TSDF, weight and color.
+    Float32 = 0,
+    /// Quantized voxel chosen by the color type: geometry::TSDFVoxelNoColor
+    /// (4 bytes), geometry::TSDFVoxelRGB8 (8 bytes) or
+    /// geometry::TSDFVoxelGray16 (6 bytes).
+    Compact = 1,
+};
+
 class UniformTSDFVolume : public TSDFVolume {
 public:
     UniformTSDFVolume(float length,
                       int resolution,
                       float sdf_trunc,
                       TSDFVolumeColorType color_type,
-                      const Eigen::Vector3f &origin = Eigen::Vector3f::Zero());
+                      const Eigen::Vector3f &origin = Eigen::Vector3f::Zero(),
+                      TSDFVoxelFormat voxel_format = TSDFVoxelFormat::Float32);
     ~UniformTSDFVolume() override;
     UniformTSDFVolume(const UniformTSDFVolume &other);
 
@@ -59,15 +178,36 @@ public:
     void Integrate(const geometry::RGBDImage &image,
                    const camera::PinholeCameraIntrinsic &intrinsic,
                    const Eigen::Matrix4f &extrinsic) override;
+    /// Integrates the batch with a single pass over the bricks of voxels
+    /// seen by any of the frames. Each voxel accumulates the observations of
+    /// all the frames before being written once.
+    void IntegrateBatch(
+            const std::vector<geometry::RGBDImage> &images,
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const thrust::host_vector<Eigen::Matrix4f> &extrinsics) override;
     std::shared_ptr<geometry::PointCloud> ExtractPointCloud() override;
+    /// Extracts the mesh with marching cubes. A vertex shared by neighboring
+    /// cubes is generated once and referenced by index.
     std::shared_ptr<geometry::TriangleMesh> ExtractTriangleMesh() override;
+    /// \brief Extracts the mesh of the region of interest \p roi only.
+    ///
+    /// The cubes whose voxel centers all lie in \p roi are extracted. If
+    /// \p simplification_voxel_size is positive, the mesh is then simplified
+    /// with TriangleMesh::SimplifyVertexClustering.
+    std::shared_ptr<geometry::TriangleMesh> ExtractTriangleMesh(
+            const geometry::AxisAlignedBoundingBox<3> &roi,
+            float simplification_voxel_size = 0.0,
+            geometry::MeshBase::SimplificationContraction contraction =
+                    geometry::MeshBase::SimplificationContraction::Quadric);
 
     /// Debug function to extract the voxel data into a VoxelGrid
     std::shared_ptr<geometry::PointCloud> ExtractVoxelPointCloud() const;
     std::shared_ptr<geometry::VoxelGrid> ExtractVoxelGrid() const;
 
     /// Faster Integrate function that uses depth_to_camera_distance_multiplier
-    /// precomputed from camera intrinsic
+    /// precomputed from camera intrinsic. Only the bricks of voxels
+    /// intersecting the camera frustum, bounded by the farthest depth plus
+    /// sdf_trunc_, are visited.
     void IntegrateWithDepthToCameraDistanceMultiplier(
             const geometry::RGBDImage &image,
             const camera::PinholeCameraIntrinsic &intrinsic,
@@ -80,8 +220,14 @@ public:
             float sdf_trunc,
             bool project_valid_depth_only = true) const;
 
+    /// Size in bytes of a voxel of the format and color type of the volume.
+    size_t GetVoxelByteSize() const;
+
 public:
-    utility::device_vector<geometry::TSDFVoxel> voxels_;
+    /// voxel_num_ voxels of the type selected by voxel_format_ and
+    /// color_type_, stored as raw bytes.
+    utility::device_vector<uint8_t> voxels_;
+    TSDFVoxelFormat voxel_format_;
     Eigen::Vector3f origin_;
     float length_;
     int resolution_;
@@ -42,6 +42,7 @@ void HostVoxelGrid::ToDevice(geometry::VoxelGrid& voxelgrid) const {
                             voxels_keys_.size() * sizeof(Eigen::Vector3i), cudaMemcpyHostToDevice));
     cudaSafeCall(cudaMemcpy(thrust::raw_pointer_cast(voxelgrid.voxels_values_.data()), voxels_values_.data(),
                             voxels_values_.size() * sizeof(geometry::Voxel), cudaMemcpyHostToDevice));
+    voxelgrid.ResetIndex();
 }
 
 void HostVoxelGrid::Clear() {
@@ -29,19 +29,43 @@ namespace kinfu {
 KinfuPipeline::KinfuPipeline(const camera::PinholeCameraIntrinsic& intrinsic,
                    const KinfuOption& option)
     : intrinsic_(intrinsic),
-      volume_(option.tsdf_length_,
-              option.tsdf_resolution_,
-              option.sdf_trunc_,
-              option.tsdf_color_type_,
-              option.tsdf_origin_),
       model_pyramid_(option.num_pyramid_levels_),
-      option_(option) {}
+      option_(option) {
+    if (option.scalable_tsdf_) {
+        volume_ = std::make_shared<integration::ScalableTSDFVolume>(
+                option.tsdf_length_ / option.tsdf_resolution_,
+                option.sdf_trunc_, option.tsdf_color_type_, 4,
+                option.tsdf_map_size_);
+    } else {
+        volume_ = std::make_shared<integration::UniformTSDFVolume>(
+                option.tsdf_length_, option.tsdf_resolution_,
+                option.sdf_trunc_, option.tsdf_color_type_,
+                option.tsdf_origin_, option.tsdf_voxel_format_);
+    }
+}
+
+KinfuPipeline::KinfuPipeline(const KinfuPipeline& other)
+    : intrinsic_(other.intrinsic_),
+      cur_pose_(other.cur_pose_),
+      frame_id_(other.frame_id_),
+      model_pyramid_(other.model_pyramid_),
+      option_(other.option_) {
+    if (option_.scalable_tsdf_) {
+        volume_ = std::make_shared<integration::ScalableTSDFVolume>(
+                static_cast<const integration::ScalableTSDFVolume&>(
+                        *other.volume_));
+    } else {
+        volume_ = std::make_shared<integration::UniformTSDFVolume>(
+                static_cast<const integration::UniformTSDFVolume&>(
+                        *other.volume_));
+    }
+}
 
 KinfuPipeline::~KinfuPipeline() {}
 
 void KinfuPipeline::Reset() {
     cur_pose_ = Eigen::Matrix4f::Identity();
-    volume_.Reset();
+    volume_->Reset();
     for (auto m : model_pyramid_) {
         m.reset();
     }
@@ -66,21 +90,26 @@ bool KinfuPipeline::ProcessFrame(const geometry::RGBDImage& image) {
         }
         cur_pose_ = utility::InverseTransform(extrinsic);
     }
-    volume_.Integrate(*smooth_img_pyramid[0], intrinsic_, extrinsic);
-    for (int i = 0; i < option_.num_pyramid_levels_; ++i) {
-        model_pyramid_[i] = volume_.Raycast(intrinsic_.CreatePyramidLevel(i),
-                                            extrinsic, option_.sdf_trunc_);
+    if (option_.scalable_tsdf_) {
+        // Keep the volume units around the camera on the GPU.
+        auto volume = std::static_pointer_cast<integration::ScalableTSDFVolume>(
+                volume_);
+        const Eigen::Vector3f center = cur_pose_.block<3, 1>(0, 3);
+        volume->StreamOut(center, option_.working_radius_);
+        volume->StreamIn(center, option_.working_radius_);
     }
+    volume_->Integrate(*smooth_img_pyramid[0], intrinsic_, extrinsic);
+    model_pyramid_ = ModelPrediction(extrinsic);
     frame_id_++;
     return true;
 }
 
 std::shared_ptr<geometry::PointCloud> KinfuPipeline::ExtractPointCloud() {
-    return volume_.ExtractPointCloud();
+    return volume_->ExtractPointCloud();
 }
 
 std::shared_ptr<geometry::TriangleMesh> KinfuPipeline::ExtractTriangleMesh() {
-    return volume_.ExtractTriangleMesh();
+    return volume_->ExtractTriangleMesh();
 }
 
 std::tuple<geometry::RGBDImagePyramid,
@@ -103,10 +132,63 @@ KinfuPipeline::SurfaceMeasurement(const geometry::RGBDImage& image) const {
                            std::move(pc_pyramid));
 }
 
+PointCloudPyramid KinfuPipeline::ModelPrediction(
+        const Eigen::Matrix4f& extrinsic) const {
+    PointCloudPyramid model_pyramid(option_.num_pyramid_levels_);
+    std::shared_ptr<geometry::PointCloud> model;
+    if (option_.scalable_tsdf_) {
+        model = std::static_pointer_cast<integration::ScalableTSDFVolume>(
+                        volume_)
+                        ->Raycast(intrinsic_, extrinsic, option_.sdf_trunc_,
+                                  option_.depth_cutoff_ + option_.sdf_trunc_,
+                                  false);
+    } else {
+        model = std::static_pointer_cast<integration::UniformTSDFVolume>(
+                        volume_)
+                        ->Raycast(intrinsic_, extrinsic, option_.sdf_trunc_,
+                                  false);
+    }
+    int width = intrinsic_.width_;
+    int height = intrinsic_.height_;
+    for (int i = 0; i < option_.num_pyramid_levels_; ++i) {
+        if (i > 0) {
+            model = model->OrganizedDownSample(width, height,
+                                               option_.sdf_trunc_);
+            width /= 2;
+            height /= 2;
+        }
+        model_pyramid[i] = std::make_shared<geometry::PointCloud>(*model);
+        if (!UseProjectiveICP()) {
+            model_pyramid[i]->RemoveNoneFinitePoints();
+        }
+    }
+    return model_pyramid;
+}
+
 std::tuple<Eigen::Matrix4f, bool> KinfuPipeline::PoseEstimation(
         const Eigen::Matrix4f& extrinsic,
         const PointCloudPyramid& frame_data,
         const PointCloudPyramid& target_data) {
+    if (UseProjectiveICP()) {
+        // The measurement is aligned to the organized model, which is
+        // raycast from the previous camera pose and thus projected with the
+        // previous extrinsic. The estimated transformation is the new pose.
+        Eigen::Matrix4f pose = utility::InverseTransform(extrinsic);
+        bool success = true;
+        for (int level = option_.num_pyramid_levels_ - 1; level >= 0;
+             --level) {
+            registration::ICPConvergenceCriteria criteria;
+            criteria.max_iteration_ = option_.icp_iterations_[level];
+            auto res = registration::RegistrationProjectiveICP(
+                    *target_data[level], *frame_data[level],
+                    intrinsic_.CreatePyramidLevel(level), extrinsic,
+                    option_.distance_threshold_, pose, criteria);
+            pose = res.transformation_;
+            success = res.fitness_ > 0.0f;
+        }
+        return std::make_tuple(utility::InverseTransform(pose), success);
+    }
+
     Eigen::Matrix4f cur_global_trans = extrinsic;
 
     for (int level = option_.num_pyramid_levels_ - 1; level >= 0; --level) {
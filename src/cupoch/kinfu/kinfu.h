@@ -23,6 +23,7 @@
 
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/rgbdimage.h"
+#include "cupoch/integration/scalable_tsdfvolume.h"
 #include "cupoch/integration/uniform_tsdfvolume.h"
 #include "cupoch/registration/transformation_estimation.h"
 
@@ -49,7 +50,13 @@ public:
             const Eigen::Vector3f& tsdf_origin = Eigen::Vector3f::Zero(),
             float distance_threshold = 0.5f,
             const std::vector<int>& icp_iterations = {20, 20, 20, 20},
-            registration::TransformationEstimationType tf_type = registration::TransformationEstimationType::PointToPlane)
+            registration::TransformationEstimationType tf_type = registration::TransformationEstimationType::PointToPlane,
+            bool projective_icp = true,
+            bool scalable_tsdf = false,
+            float working_radius = 4.0f,
+            int tsdf_map_size = 5000,
+            integration::TSDFVoxelFormat tsdf_voxel_format =
+                    integration::TSDFVoxelFormat::Float32)
         : num_pyramid_levels_(num_pyramid_levels),
           diameter_(diameter),
           sigma_depth_(sigma_depth),
@@ -62,7 +69,12 @@ public:
           tsdf_origin_(tsdf_origin),
           distance_threshold_(distance_threshold),
           icp_iterations_(icp_iterations),
-          tf_type_(tf_type) {};
+          tf_type_(tf_type),
+          projective_icp_(projective_icp),
+          scalable_tsdf_(scalable_tsdf),
+          working_radius_(working_radius),
+          tsdf_map_size_(tsdf_map_size),
+          tsdf_voxel_format_(tsdf_voxel_format) {};
     ~KinfuOption(){};
     int num_pyramid_levels_;
     int diameter_;
@@ -77,12 +89,26 @@ public:
     float distance_threshold_;
     std::vector<int> icp_iterations_;
     registration::TransformationEstimationType tf_type_;
+    /// Use the projective data association instead of the KD-tree search
+    /// for the point to plane ICP.
+    bool projective_icp_;
+    /// Use a ScalableTSDFVolume with voxels of tsdf_length_ / tsdf_resolution_
+    /// instead of a UniformTSDFVolume.
+    bool scalable_tsdf_;
+    /// Radius around the camera of the volume units kept on the GPU by the
+    /// ScalableTSDFVolume, the others are streamed out to host memory.
+    float working_radius_;
+    /// Capacity of the hash map of the ScalableTSDFVolume.
+    int tsdf_map_size_;
+    /// Voxel storage of the UniformTSDFVolume.
+    integration::TSDFVoxelFormat tsdf_voxel_format_;
 };
 
 class KinfuPipeline {
 public:
     KinfuPipeline(const camera::PinholeCameraIntrinsic& intrinsic,
              const KinfuOption& option = KinfuOption());
+    KinfuPipeline(const KinfuPipeline& other);
     ~KinfuPipeline();
 
     void Reset();
@@ -96,6 +122,17 @@ private:
                PointCloudPyramid>
     SurfaceMeasurement(const geometry::RGBDImage& image) const;
 
+    /// Raycasts the volume once at full resolution and builds the coarser
+    /// levels by downsampling the organized vertex and normal maps. The
+    /// levels are kept organized for the projective ICP.
+    PointCloudPyramid ModelPrediction(const Eigen::Matrix4f& extrinsic) const;
+
+    bool UseProjectiveICP() const {
+        return option_.projective_icp_ &&
+               option_.tf_type_ == registration::TransformationEstimationType::
+                                           PointToPlane;
+    }
+
     std::tuple<Eigen::Matrix4f, bool> PoseEstimation(
             const Eigen::Matrix4f& extrinsic,
             const PointCloudPyramid& frame_data,
@@ -105,7 +142,9 @@ public:
     camera::PinholeCameraIntrinsic intrinsic_;
     Eigen::Matrix4f cur_pose_ = Eigen::Matrix4f::Identity();
     int frame_id_ = 0;
-    integration::UniformTSDFVolume volume_;
+    /// UniformTSDFVolume or ScalableTSDFVolume depending on
+    /// KinfuOption::scalable_tsdf_.
+    std::shared_ptr<integration::TSDFVolume> volume_;
     PointCloudPyramid model_pyramid_;
     KinfuOption option_;
 };
@@ -18,6 +18,7 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  **/
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/kdtree_flann.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/registration/registration.h"
@@ -78,6 +79,93 @@ RegistrationResult GetRegistrationResultAndCorrespondences(
     return result;
 }
 
+struct projective_association_functor {
+    projective_association_functor(const Eigen::Vector3f *source,
+                                   const Eigen::Vector3f *target_points,
+                                   const Eigen::Vector3f *target_normals,
+                                   const Eigen::Matrix4f &transformation,
+                                   const Eigen::Matrix4f &target_extrinsic,
+                                   const Eigen::Matrix3f &intrinsic,
+                                   int width,
+                                   int height,
+                                   float max_correspondence_distance)
+        : source_(source),
+          target_points_(target_points),
+          target_normals_(target_normals),
+          transformation_(transformation),
+          target_extrinsic_(target_extrinsic),
+          intrinsic_(intrinsic),
+          width_(width),
+          height_(height),
+          max_dist2_(max_correspondence_distance *
+                     max_correspondence_distance){};
+    const Eigen::Vector3f *source_;
+    const Eigen::Vector3f *target_points_;
+    const Eigen::Vector3f *target_normals_;
+    const Eigen::Matrix4f transformation_;
+    const Eigen::Matrix4f target_extrinsic_;
+    const Eigen::Matrix3f intrinsic_;
+    const int width_;
+    const int height_;
+    const float max_dist2_;
+    /// Returns the index of the target point matched with the source point
+    /// idx or -1, and the transformed source point in \p vs.
+    __device__ int Associate(int idx, Eigen::Vector3f &vs) const {
+        vs = transformation_.block<3, 3>(0, 0) * source_[idx] +
+             transformation_.block<3, 1>(0, 3);
+        const Eigen::Vector3f vc = target_extrinsic_.block<3, 3>(0, 0) * vs +
+                                   target_extrinsic_.block<3, 1>(0, 3);
+        if (vc(2) <= 0.0f) return -1;
+        const int u = __float2int_rn(intrinsic_(0, 0) * vc(0) / vc(2) +
+                                     intrinsic_(0, 2));
+        const int v = __float2int_rn(intrinsic_(1, 1) * vc(1) / vc(2) +
+                                     intrinsic_(1, 2));
+        if (u < 0 || u >= width_ || v < 0 || v >= height_) return -1;
+        const int j = v * width_ + u;
+        const Eigen::Vector3f &vt = target_points_[j];
+        const Eigen::Vector3f &nt = target_normals_[j];
+        if (!isfinite(vt(0)) || !isfinite(vt(1)) || !isfinite(vt(2)) ||
+            !isfinite(nt(0)) || !isfinite(nt(1)) || !isfinite(nt(2))) {
+            return -1;
+        }
+        if ((vs - vt).squaredNorm() > max_dist2_) return -1;
+        return j;
+    }
+};
+
+struct projective_pt2pl_functor : public projective_association_functor {
+    projective_pt2pl_functor(const projective_association_functor &func)
+        : projective_association_functor(func){};
+    __device__ thrust::tuple<Eigen::Matrix6f, Eigen::Vector6f, float, int>
+    operator()(int idx) const {
+        Eigen::Vector3f vs;
+        const int j = Associate(idx, vs);
+        if (j < 0) {
+            return thrust::make_tuple(Eigen::Matrix6f::Zero(),
+                                      Eigen::Vector6f::Zero(), 0.0f, 0);
+        }
+        const Eigen::Vector3f &nt = target_normals_[j];
+        const float r = (vs - target_points_[j]).dot(nt);
+        Eigen::Vector6f J_r;
+        J_r.block<3, 1>(0, 0) = vs.cross(nt);
+        J_r.block<3, 1>(3, 0) = nt;
+        return thrust::make_tuple(Eigen::Matrix6f(J_r * J_r.transpose()),
+                                  Eigen::Vector6f(J_r * r), r * r, 1);
+    }
+};
+
+struct projective_correspondence_functor
+    : public projective_association_functor {
+    projective_correspondence_functor(
+            const projective_association_functor &func)
+        : projective_association_functor(func){};
+    __device__ Eigen::Vector2i operator()(int idx) const {
+        Eigen::Vector3f vs;
+        const int j = Associate(idx, vs);
+        return (j < 0) ? Eigen::Vector2i(-1, -1) : Eigen::Vector2i(idx, j);
+    }
+};
+
 }  // namespace
 
 RegistrationResult::RegistrationResult(const Eigen::Matrix4f &transformation)
@@ -169,4 +257,104 @@ RegistrationResult cupoch::registration::RegistrationICP(
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+RegistrationResult cupoch::registration::RegistrationProjectiveICP(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        const camera::PinholeCameraIntrinsic &target_intrinsic,
+        const Eigen::Matrix4f &target_extrinsic,
+        float max_correspondence_distance,
+        const Eigen::Matrix4f &init /* = Eigen::Matrix4f::Identity()*/,
+        const ICPConvergenceCriteria
+                &criteria /* = ICPConvergenceCriteria()*/,
+        float det_thresh /* = 1.0e-6*/) {
+    if (max_correspondence_distance <= 0.0) {
+        utility::LogError("Invalid max_correspondence_distance.");
+    }
+    if (target.points_.size() !=
+        (size_t)(target_intrinsic.width_ * target_intrinsic.height_)) {
+        utility::LogError(
+                "[RegistrationProjectiveICP] The target is not organized as "
+                "{}x{} points.",
+                target_intrinsic.width_, target_intrinsic.height_);
+        return RegistrationResult(init);
+    }
+    if (!target.HasNormals()) {
+        utility::LogError(
+                "[RegistrationProjectiveICP] Requires pre-computed target "
+                "normal vectors.");
+        return RegistrationResult(init);
+    }
+
+    const int n_pt = source.points_.size();
+    RegistrationResult result(init);
+    RegistrationResult backup;
+    Eigen::Matrix4f transformation = init;
+    for (int i = 0; i <= criteria.max_iteration_; i++) {
+        projective_association_functor assoc(
+                thrust::raw_pointer_cast(source.points_.data()),
+                thrust::raw_pointer_cast(target.points_.data()),
+                thrust::raw_pointer_cast(target.normals_.data()),
+                transformation, target_extrinsic,
+                target_intrinsic.intrinsic_matrix_, target_intrinsic.width_,
+                target_intrinsic.height_, max_correspondence_distance);
+        Eigen::Matrix6f JTJ = Eigen::Matrix6f::Zero();
+        Eigen::Vector6f JTr = Eigen::Vector6f::Zero();
+        float r2 = 0.0f;
+        int n_corres = 0;
+        thrust::tie(JTJ, JTr, r2, n_corres) = thrust::transform_reduce(
+                utility::exec_policy(0)->on(0),
+                thrust::make_counting_iterator(0),
+                thrust::make_counting_iterator(n_pt),
+                projective_pt2pl_functor(assoc),
+                thrust::make_tuple(JTJ, JTr, r2, n_corres),
+                add_tuple_functor<Eigen::Matrix6f, Eigen::Vector6f, float,
+                                  int>());
+        backup = result;
+        result.transformation_ = transformation;
+        result.fitness_ = (n_pt > 0) ? (float)n_corres / (float)n_pt : 0.0f;
+        result.inlier_rmse_ =
+                (n_corres > 0) ? std::sqrt(r2 / (float)n_corres) : 0.0f;
+        utility::LogDebug("ICP Iteration #{:d}: Fitness {:.4f}, RMSE {:.4f}",
+                          i, result.fitness_, result.inlier_rmse_);
+        if (n_corres == 0 || i == criteria.max_iteration_ ||
+            (i > 0 &&
+             std::abs(backup.fitness_ - result.fitness_) <
+                     criteria.relative_fitness_ &&
+             std::abs(backup.inlier_rmse_ - result.inlier_rmse_) <
+                     criteria.relative_rmse_)) {
+            break;
+        }
+        bool is_success;
+        Eigen::Matrix4f update;
+        thrust::tie(is_success, update) =
+                utility::SolveJacobianSystemAndObtainExtrinsicMatrix(
+                        JTJ, JTr, det_thresh);
+        if (!is_success) break;
+        transformation = update * transformation;
+    }
+
+    projective_correspondence_functor corres_func(
+            projective_association_functor(
+                    thrust::raw_pointer_cast(source.points_.data()),
+                    thrust::raw_pointer_cast(target.points_.data()),
+                    thrust::raw_pointer_cast(target.normals_.data()),
+                    result.transformation_, target_extrinsic,
+                    target_intrinsic.intrinsic_matrix_,
+                    target_intrinsic.width_, target_intrinsic.height_,
+                    max_correspondence_distance));
+    result.correspondence_set_.resize(n_pt);
+    thrust::transform(thrust::make_counting_iterator(0),
+                      thrust::make_counting_iterator(n_pt),
+                      result.correspondence_set_.begin(), corres_func);
+    auto end =
+            thrust::remove_if(result.correspondence_set_.begin(),
+                              result.correspondence_set_.end(),
+                              [] __device__(const Eigen::Vector2i &x) -> bool {
+                                  return (x[0] < 0);
+                              });
+    result.correspondence_set_.resize(
+            thrust::distance(result.correspondence_set_.begin(), end));
+    return result;
+}
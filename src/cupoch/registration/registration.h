@@ -26,6 +26,10 @@
 
 namespace cupoch {
 
+namespace camera {
+class PinholeCameraIntrinsic;
+}
+
 namespace geometry {
 class PointCloud;
 }
@@ -90,5 +94,36 @@ RegistrationResult RegistrationICP(
                 TransformationEstimationPointToPoint(),
         const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria());
 
+/// \brief Function for point-to-plane ICP registration with projective data
+/// association.
+///
+/// The target is an organized point cloud of target_intrinsic.width_ x
+/// target_intrinsic.height_ points in row major order with NaN for the
+/// invalid pixels, e.g. a raycast of a TSDF volume or a point cloud created
+/// from a depth image without removing the invalid pixels. Each transformed
+/// source point is projected into the target image and matched with the
+/// target point of that pixel, so no KD-tree is built. The Gauss-Newton
+/// system of an iteration is accumulated in a single reduction.
+///
+/// \param source The source point cloud.
+/// \param target The organized target point cloud with normals.
+/// \param target_intrinsic Intrinsic of the camera of the target.
+/// \param target_extrinsic Extrinsic of the camera of the target, mapping
+/// the frame of the target points to the camera frame.
+/// \param max_correspondence_distance Maximum correspondence points-pair
+/// distance.
+/// \param init Initial transformation from source to target.
+/// \param criteria Convergence criteria.
+/// \param det_thresh Threshold of the determinant of the normal equations.
+RegistrationResult RegistrationProjectiveICP(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        const camera::PinholeCameraIntrinsic &target_intrinsic,
+        const Eigen::Matrix4f &target_extrinsic,
+        float max_correspondence_distance,
+        const Eigen::Matrix4f &init = Eigen::Matrix4f::Identity(),
+        const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria(),
+        float det_thresh = 1.0e-6);
+
 }  // namespace registration
 }  // namespace cupoch
\ No newline at end of file
@@ -415,6 +415,59 @@ __host__ __device__ inline thrust::tuple<int, int, int> KeyOf(size_t idx,
     return thrust::make_tuple(x, y, z);
 }
 
+// Spreads the lower 21 bits of v so that two zero bits separate each bit.
+__host__ __device__ inline uint64_t SpreadBits3(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+__host__ __device__ inline uint64_t CompactBits3(uint64_t v) {
+    v &= 0x1249249249249249;
+    v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3;
+    v = (v ^ (v >> 4)) & 0x100f00f00f00f00f;
+    v = (v ^ (v >> 8)) & 0x1f0000ff0000ff;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffff;
+    v = (v ^ (v >> 32)) & 0x1fffff;
+    return v;
+}
+
+/// Returns the Morton (Z-order) code of non-negative indices below 2^21.
+__host__ __device__ inline uint64_t MortonCodeOf(const Eigen::Vector3i &xyz) {
+    return (SpreadBits3(xyz(0)) << 2) | (SpreadBits3(xyz(1)) << 1) |
+           SpreadBits3(xyz(2));
+}
+
+__host__ __device__ inline Eigen::Vector3i MortonKeyOf(uint64_t code) {
+    return Eigen::Vector3i(CompactBits3(code >> 2), CompactBits3(code >> 1),
+                           CompactBits3(code));
+}
+
+/// Number of cells along each axis that a 64-bit Morton code can address.
+constexpr int MORTON_AXIS_CELLS = 1 << 21;
+
+/// Returns the Morton code of \p point quantized into cells of size
+/// 1 / \p scale from \p min_bound. Points outside the addressable range
+/// are clamped into it, so the code only serves as a locality order.
+__host__ __device__ inline uint64_t MortonCodeOf(
+        const Eigen::Vector3f &point,
+        const Eigen::Vector3f &min_bound,
+        float scale) {
+    Eigen::Vector3i cell;
+#pragma unroll
+    for (int i = 0; i < 3; ++i) {
+        const float c = (point[i] - min_bound[i]) * scale;
+        cell[i] = (!(c > 0.0f)) ? 0
+                  : (c >= MORTON_AXIS_CELLS - 1) ? MORTON_AXIS_CELLS - 1
+                                                 : int(c);
+    }
+    return MortonCodeOf(cell);
+}
+
 template <typename T>
 inline void copy_device_to_host(const utility::device_vector<T> &src,
                                 utility::pinned_host_vector<T> &dist) {
@@ -295,22 +295,23 @@ struct copy_distance_voxel_functor {
     copy_distance_voxel_functor(float voxel_size,
                                 int resolution,
                                 const Eigen::Vector3f& origin,
+                                const Eigen::Vector3i& ring_offset,
                                 float distance_max)
         : voxel_size_(voxel_size), resolution_(resolution),
-        origin_(origin), distance_max_(distance_max){};
+        origin_(origin), ring_offset_(ring_offset), distance_max_(distance_max){};
     const float voxel_size_;
     const int resolution_;
     const Eigen::Vector3f origin_;
+    const Eigen::Vector3i ring_offset_;
     const float distance_max_;
     __device__ thrust::tuple<Eigen::Vector3f, Eigen::Vector4f>
     operator()(const thrust::tuple<size_t, geometry::DistanceVoxel>& kv) const {
         int idx = thrust::get<0>(kv);
         geometry::DistanceVoxel v = thrust::get<1>(kv);
-        int res2 = resolution_ * resolution_;
-        int x = idx / res2;
-        int yz = idx % res2;
-        int y = yz / resolution_;
-        int z = yz % resolution_;
+        Eigen::Vector3i key = geometry::RingKeyOf(idx, ring_offset_, resolution_);
+        int x = key[0];
+        int y = key[1];
+        int z = key[2];
         // Voxel color (applied to all points)
         Eigen::Vector4f voxel_color = Eigen::Vector4f::Ones();
         int h_res = resolution_ / 2;
@@ -894,7 +895,7 @@ bool SimpleShaderForDistanceTransform::PrepareBinding(
     size_t n_out = dist_trans.voxels_.size();
     copy_distance_voxel_functor
             func(dist_trans.voxel_size_, dist_trans.resolution_, dist_trans.origin_,
-                 dist_trans.voxel_size_ * dist_trans.resolution_ * 0.1);
+                 dist_trans.ring_offset_, dist_trans.voxel_size_ * dist_trans.resolution_ * 0.1);
     thrust::transform(make_tuple_iterator(thrust::make_counting_iterator<size_t>(0), dist_trans.voxels_.begin()),
                       make_tuple_iterator(thrust::make_counting_iterator(n_out), dist_trans.voxels_.end()),
                       make_tuple_iterator(points, colors), func);
@@ -21,8 +21,10 @@
 #include "cupoch_pybind/collision/collision.h"
 
 #include "cupoch/collision/collision.h"
+#include "cupoch/geometry/distancetransform.h"
 #include "cupoch/geometry/lineset.h"
 #include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/geometry/sparse_occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch_pybind/docstring.h"
 
@@ -73,6 +75,8 @@ void pybind_collision_methods(py::module& m) {
                    collision::CollisionResult::CollisionType::OccupancyGrid)
             .value("LineSet",
                    collision::CollisionResult::CollisionType::LineSet)
+            .value("DistanceTransform",
+                   collision::CollisionResult::CollisionType::DistanceTransform)
             .export_values();
 
     m.def("compute_intersection",
@@ -148,6 +152,64 @@ void pybind_collision_methods(py::module& m) {
           },
           "Compute intersection betweeen OccupancyGrid and Primitives.",
           "occgrid"_a, "primitives"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          py::overload_cast<const geometry::VoxelGrid&,
+                            const geometry::SparseOccupancyGrid&, float>(
+                  &collision::ComputeIntersection),
+          "Compute intersection betweeen VoxelGrid and SparseOccupancyGrid.",
+          "voxelgrid"_a, "occgrid"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          py::overload_cast<const geometry::SparseOccupancyGrid&,
+                            const geometry::VoxelGrid&, float>(
+                  &collision::ComputeIntersection),
+          "Compute intersection betweeen SparseOccupancyGrid and VoxelGrid.",
+          "occgrid"_a, "voxelgrid"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          py::overload_cast<const geometry::LineSet<3>&,
+                            const geometry::SparseOccupancyGrid&, float>(
+                  &collision::ComputeIntersection),
+          "Compute intersection betweeen LineSet and SparseOccupancyGrid.",
+          "lineset"_a, "occgrid"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          py::overload_cast<const geometry::SparseOccupancyGrid&,
+                            const geometry::LineSet<3>&, float>(
+                  &collision::ComputeIntersection),
+          "Compute intersection betweeen SparseOccupancyGrid and LineSet.",
+          "occgrid"_a, "lineset"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          [](const wrapper::device_vector_primitives& primitives,
+             const geometry::SparseOccupancyGrid& occgrid, float margin) {
+              return collision::ComputeIntersection(primitives.data_, occgrid,
+                                                    margin);
+          },
+          "Compute intersection betweeen Primitives and SparseOccupancyGrid.",
+          "primitives"_a, "occgrid"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          [](const geometry::SparseOccupancyGrid& occgrid,
+             const wrapper::device_vector_primitives& primitives,
+             float margin) {
+              return collision::ComputeIntersection(occgrid, primitives.data_,
+                                                    margin);
+          },
+          "Compute intersection betweeen SparseOccupancyGrid and Primitives.",
+          "occgrid"_a, "primitives"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          [](const wrapper::device_vector_primitives& primitives,
+             const geometry::DistanceTransform& dt, float margin) {
+              return collision::ComputeIntersection(primitives.data_, dt,
+                                                    margin);
+          },
+          "Compute intersection betweeen Primitives and DistanceTransform.",
+          "primitives"_a, "dt"_a, "margin"_a = 0.0f);
+    m.def("compute_intersection",
+          [](const geometry::DistanceTransform& dt,
+             const wrapper::device_vector_primitives& primitives,
+             float margin) {
+              return collision::ComputeIntersection(dt, primitives.data_,
+                                                    margin);
+          },
+          "Compute intersection betweeen DistanceTransform and Primitives.",
+          "dt"_a, "primitives"_a, "margin"_a = 0.0f);
 }
 
 void pybind_collision(py::module& m) {
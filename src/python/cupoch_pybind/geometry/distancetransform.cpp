@@ -21,6 +21,7 @@
 #include "cupoch/geometry/distancetransform.h"
 
 #include "cupoch/camera/pinhole_camera_parameters.h"
+#include "cupoch/geometry/occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch_pybind/device_map_wrapper.h"
 #include "cupoch_pybind/docstring.h"
@@ -72,18 +73,60 @@ void pybind_distancetransform(py::module &m) {
                             std::to_string(distancetransform.resolution_) +
                             " resolution.";
                  })
+            .def("shift_window",
+                 [](geometry::DistanceTransform &self, const Eigen::Vector3i &shift) {
+                     self.ShiftWindow(shift);
+                 },
+                 "Move the grid window by the number of voxels keeping the "
+                 "voxels which remain inside of it.",
+                 "shift"_a)
+            .def("recenter",
+                 [](geometry::DistanceTransform &self, const Eigen::Vector3f &center) {
+                     self.Recenter(center);
+                 },
+                 "Move the grid window to the center keeping the voxels "
+                 "which remain inside of it.",
+                 "center"_a)
             .def("reconstruct", &geometry::DistanceTransform::Reconstruct,
                  "Reconstruct distance transform.")
             .def("compute_edt",
                  py::overload_cast<const geometry::VoxelGrid&>(
                          &geometry::DistanceTransform::ComputeEDT),
                  "Function to compute EDT from voxel grid.")
+            .def("compute_edt",
+                 py::overload_cast<const geometry::OccupancyGrid&>(
+                         &geometry::DistanceTransform::ComputeEDT),
+                 "Function to compute EDT from the occupied voxels of an "
+                 "occupancy grid.")
+            .def("compute_signed_edt",
+                 py::overload_cast<const geometry::VoxelGrid&>(
+                         &geometry::DistanceTransform::ComputeSignedEDT),
+                 "Function to compute signed EDT from voxel grid. Distances "
+                 "inside of obstacles are negative.")
+            .def("update_edt",
+                 py::overload_cast<geometry::OccupancyGrid&, float>(
+                         &geometry::DistanceTransform::UpdateEDT),
+                 "Function to update EDT incrementally from the voxels "
+                 "changed in an occupancy grid.",
+                 "occupancy_grid"_a, "max_distance"_a = -1.0)
             .def("get_distance", &geometry::DistanceTransform::GetDistance)
             .def("get_distances",
                  [] (const geometry::DistanceTransform& self,
                      const wrapper::device_vector_vector3f& points) {
                      return wrapper::device_vector_float(self.GetDistances(points.data_));
                  })
+            .def("get_interpolated_distances",
+                 [] (const geometry::DistanceTransform& self,
+                     const wrapper::device_vector_vector3f& points) {
+                     auto res = self.GetInterpolatedDistances(points.data_);
+                     return std::make_tuple(
+                             wrapper::device_vector_float(res.first),
+                             wrapper::device_vector_vector3f(res.second));
+                 },
+                 "Function to get trilinearly interpolated distances and "
+                 "their gradients.",
+                 "queries"_a)
+            .def("is_signed", &geometry::DistanceTransform::IsSigned)
             .def_static(
                     "create_from_occupancy_grid",
                     &geometry::DistanceTransform::CreateFromOccupancyGrid,
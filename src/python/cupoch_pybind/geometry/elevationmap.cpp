@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/geometry/elevationmap.h"
+
+#include "cupoch/geometry/graph.h"
+#include "cupoch/geometry/occupancygrid.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch_pybind/docstring.h"
+#include "cupoch_pybind/geometry/geometry.h"
+#include "cupoch_pybind/geometry/geometry_trampoline.h"
+
+using namespace cupoch;
+
+void pybind_elevationmap(py::module &m) {
+    py::class_<geometry::ElevationCell, std::shared_ptr<geometry::ElevationCell>>
+            cell(m, "ElevationCell",
+                 "Cell of an elevation map holding the fused height and the "
+                 "traversability layers.");
+    py::detail::bind_default_constructor<geometry::ElevationCell>(cell);
+    py::detail::bind_copy_functions<geometry::ElevationCell>(cell);
+    cell.def("__repr__",
+             [](const geometry::ElevationCell &cell) {
+                 std::ostringstream repr;
+                 repr << "geometry::ElevationCell with height: "
+                      << cell.height_ << ", variance: " << cell.variance_
+                      << ", traversability: " << cell.traversability_;
+                 return repr.str();
+             })
+            .def_readwrite("height", &geometry::ElevationCell::height_,
+                           "Float32: Fused height of the top surface.")
+            .def_readwrite("variance", &geometry::ElevationCell::variance_,
+                           "Float32: Variance of the fused height.")
+            .def_readwrite("min_height",
+                           &geometry::ElevationCell::min_height_)
+            .def_readwrite("max_height",
+                           &geometry::ElevationCell::max_height_)
+            .def_readwrite("mean_height",
+                           &geometry::ElevationCell::mean_height_)
+            .def_readwrite("num_points",
+                           &geometry::ElevationCell::num_points_)
+            .def_readwrite("slope", &geometry::ElevationCell::slope_)
+            .def_readwrite("roughness", &geometry::ElevationCell::roughness_)
+            .def_readwrite("step_height",
+                           &geometry::ElevationCell::step_height_)
+            .def_readwrite("traversability",
+                           &geometry::ElevationCell::traversability_,
+                           "Float32: Traversability score in [0, 1].");
+
+    py::class_<geometry::ElevationMap, PyGeometry2D<geometry::ElevationMap>,
+               std::shared_ptr<geometry::ElevationMap>,
+               geometry::GeometryBase2D>
+            elevationmap(m, "ElevationMap",
+                         "ElevationMap is a 2.5D grid map storing the "
+                         "elevation of the terrain and its traversability.");
+    py::detail::bind_default_constructor<geometry::ElevationMap>(elevationmap);
+    py::detail::bind_copy_functions<geometry::ElevationMap>(elevationmap);
+    elevationmap
+            .def(py::init<float, int, const Eigen::Vector2f &>(),
+                 "Create an elevation map", "cell_size"_a,
+                 "resolution"_a = 256, "origin"_a = Eigen::Vector2f::Zero())
+            .def("__repr__",
+                 [](const geometry::ElevationMap &map) {
+                     return std::string("geometry::ElevationMap with ") +
+                            std::to_string(map.resolution_) + "x" +
+                            std::to_string(map.resolution_) + " cells.";
+                 })
+            .def("get_cell",
+                 [](const geometry::ElevationMap &self,
+                    const Eigen::Vector2f &point) {
+                     auto res = self.GetCell(point);
+                     return py::make_tuple(thrust::get<0>(res),
+                                           thrust::get<1>(res));
+                 },
+                 "Returns whether the point is inside of the map and its cell.",
+                 "point"_a)
+            .def("extract_pointcloud",
+                 &geometry::ElevationMap::ExtractPointCloud,
+                 "Returns the heights of the known cells as a point cloud.")
+            .def("reconstruct", &geometry::ElevationMap::Reconstruct,
+                 "Reconstruct the map with a new cell size and resolution.",
+                 "cell_size"_a, "resolution"_a)
+            .def("shift_window",
+                 [](geometry::ElevationMap &self, const Eigen::Vector2i &shift) {
+                     self.ShiftWindow(shift);
+                 },
+                 "Move the map window by the number of cells keeping the "
+                 "cells which remain inside of it.",
+                 "shift"_a)
+            .def("recenter",
+                 [](geometry::ElevationMap &self, const Eigen::Vector2f &center) {
+                     self.Recenter(center);
+                 },
+                 "Move the map window to the center keeping the cells "
+                 "which remain inside of it.",
+                 "center"_a)
+            .def("integrate",
+                 py::overload_cast<const geometry::PointCloud &, float>(
+                         &geometry::ElevationMap::Integrate),
+                 "Fuse the heights of a point cloud.", "pointcloud"_a,
+                 "height_variance"_a = 0.0025)
+            .def("integrate",
+                 py::overload_cast<const geometry::OccupancyGrid &, float>(
+                         &geometry::ElevationMap::Integrate),
+                 "Fuse the top faces of the occupied voxels.",
+                 "occupancy_grid"_a, "height_variance"_a = 0.0025)
+            .def("update_traversability",
+                 &geometry::ElevationMap::UpdateTraversability,
+                 "Compute the slope, roughness, step height and "
+                 "traversability layers.")
+            .def("create_graph", &geometry::ElevationMap::CreateGraph,
+                 "Create an 8-connected graph on the traversable cells.",
+                 "min_traversability"_a = 0.0, "allow_unknown"_a = false)
+            .def_readonly("cell_size", &geometry::ElevationMap::cell_size_)
+            .def_readonly("resolution", &geometry::ElevationMap::resolution_)
+            .def_readwrite("origin", &geometry::ElevationMap::origin_)
+            .def_readwrite("min_variance",
+                           &geometry::ElevationMap::min_variance_)
+            .def_readwrite("mahalanobis_thres",
+                           &geometry::ElevationMap::mahalanobis_thres_)
+            .def_readwrite("traversability_radius",
+                           &geometry::ElevationMap::traversability_radius_)
+            .def_readwrite("critical_slope",
+                           &geometry::ElevationMap::critical_slope_)
+            .def_readwrite("critical_roughness",
+                           &geometry::ElevationMap::critical_roughness_)
+            .def_readwrite("critical_step_height",
+                           &geometry::ElevationMap::critical_step_height_)
+            .def_readwrite("slope_weight",
+                           &geometry::ElevationMap::slope_weight_)
+            .def_readwrite("roughness_weight",
+                           &geometry::ElevationMap::roughness_weight_)
+            .def_readwrite("step_height_weight",
+                           &geometry::ElevationMap::step_height_weight_)
+            .def_readwrite("traversability_cost",
+                           &geometry::ElevationMap::traversability_cost_);
+}
@@ -182,4 +182,5 @@ void pybind_geometry(py::module &m) {
     pybind_trianglemesh(m_submodule);
     pybind_image(m_submodule);
     pybind_boundingvolume(m_submodule);
+    pybind_elevationmap(m_submodule);
 }
\ No newline at end of file
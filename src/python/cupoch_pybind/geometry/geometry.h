@@ -34,4 +34,5 @@ void pybind_meshbase(py::module &m);
 void pybind_trianglemesh(py::module &m);
 void pybind_image(py::module &m);
 void pybind_kdtreeflann(py::module &m);
-void pybind_boundingvolume(py::module &m);
\ No newline at end of file
+void pybind_boundingvolume(py::module &m);
+void pybind_elevationmap(py::module &m);
\ No newline at end of file
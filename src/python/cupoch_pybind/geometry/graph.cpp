@@ -76,6 +76,15 @@ void bind_def(GraphT& graph) {
                      auto res = graph.DijkstraPath(start_node, end_node);
                      return *res;
                  })
+            .def("minimum_spanning_tree",
+                 &geometry::Graph<Dim>::MinimumSpanningTree,
+                 "Compute the minimum spanning forest of the graph")
+            .def("connected_components",
+                 [](const geometry::Graph<Dim> &graph) {
+                     return wrapper::device_vector_int(
+                             graph.ConnectedComponents());
+                 },
+                 "Label the connected components of the graph")
             .def_static("create_from_triangle_mesh",
                         &geometry::Graph<Dim>::template CreateFromTriangleMesh<Dim>,
                         "Function to make graph from a TriangleMesh", "input"_a)
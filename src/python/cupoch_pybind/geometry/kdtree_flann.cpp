@@ -21,6 +21,8 @@
 #include "cupoch/geometry/kdtree_flann.h"
 
 #include "cupoch/geometry/geometry.h"
+#include "cupoch/geometry/neighbor_list.h"
+#include "cupoch/geometry/pointcloud.h"
 #include "cupoch_pybind/docstring.h"
 #include "cupoch_pybind/geometry/geometry.h"
 
@@ -79,6 +81,37 @@ void pybind_kdtreeflann(py::module &m) {
                     "max_nn", &geometry::KDTreeSearchParamRadius::max_nn_,
                     "At maximum, ``max_nn`` neighbors will be searched.");
 
+    // cupoch.geometry.NeighborList
+    py::class_<geometry::NeighborList, std::shared_ptr<geometry::NeighborList>>
+            neighborlist(m, "NeighborList",
+                         "Neighbor lists of points in compressed sparse row "
+                         "layout.");
+    neighborlist.def(py::init<>())
+            .def("__repr__",
+                 [](const geometry::NeighborList &neighbors) {
+                     return std::string("geometry::NeighborList with ") +
+                            std::to_string(neighbors.Size()) + " queries and " +
+                            std::to_string(neighbors.NumNeighbors()) +
+                            " neighbors.";
+                 })
+            .def("size", &geometry::NeighborList::Size)
+            .def("num_neighbors", &geometry::NeighborList::NumNeighbors)
+            .def_property_readonly(
+                    "offsets",
+                    [](geometry::NeighborList &neighbors) {
+                        return wrapper::device_vector_int(neighbors.offsets_);
+                    })
+            .def_property_readonly(
+                    "indices",
+                    [](geometry::NeighborList &neighbors) {
+                        return wrapper::device_vector_int(neighbors.indices_);
+                    })
+            .def_static("create_from_point_cloud",
+                        &geometry::NeighborList::CreateFromPointCloud,
+                        "Function to search the neighbors of every point in "
+                        "a point cloud",
+                        "pointcloud"_a, "search_param"_a);
+
     // cupoch.geometry.KDTreeFlann
     static const std::unordered_map<std::string, std::string>
             map_kd_tree_flann_method_docs = {
@@ -21,7 +21,10 @@
 #include "cupoch/geometry/occupancygrid.h"
 
 #include "cupoch/camera/pinhole_camera_parameters.h"
+#include "cupoch/geometry/image.h"
+#include "cupoch/geometry/octree_occupancygrid.h"
 #include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/sparse_occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch_pybind/device_map_wrapper.h"
 #include "cupoch_pybind/docstring.h"
@@ -99,6 +102,20 @@ void pybind_occupanygrid(py::module &m) {
                                    [](const geometry::OccupancyGrid &og) {
                                        return og.ExtractKnownVoxels();
                                    })
+            .def("shift_window",
+                 [](geometry::OccupancyGrid &self, const Eigen::Vector3i &shift) {
+                     self.ShiftWindow(shift);
+                 },
+                 "Move the grid window by the number of voxels keeping the "
+                 "voxels which remain inside of it.",
+                 "shift"_a)
+            .def("recenter",
+                 [](geometry::OccupancyGrid &self, const Eigen::Vector3f &center) {
+                     self.Recenter(center);
+                 },
+                 "Move the grid window to the center keeping the voxels "
+                 "which remain inside of it.",
+                 "center"_a)
             .def("reconstruct", &geometry::OccupancyGrid::Reconstruct,
                  "Reconstruct dense voxel grid.")
             .def("insert",
@@ -108,6 +125,18 @@ void pybind_occupanygrid(py::module &m) {
                  "Function to insert occupancy grid from pointcloud.",
                  "pointcloud"_a, "viewpoint"_a, "max_range"_a = -1.0)
             .def("set_free_area", &geometry::OccupancyGrid::SetFreeArea)
+            .def("decay", &geometry::OccupancyGrid::Decay,
+                 "Decays the log-odds of the known voxels toward unknown.",
+                 "stamp"_a)
+            .def("clear_visible_voxels",
+                 &geometry::OccupancyGrid::ClearVisibleVoxels,
+                 "Updates as a miss every occupied voxel that a depth image "
+                 "sees through.",
+                 "depth"_a, "intrinsic"_a, "extrinsic"_a,
+                 "depth_margin"_a = 0.1)
+            .def("num_active_blocks",
+                 &geometry::OccupancyGrid::NumActiveBlocks,
+                 "Returns the number of blocks holding known voxels.")
             .def_static(
                     "create_from_voxel_grid",
                     &geometry::OccupancyGrid::CreateFromVoxelGrid,
@@ -126,5 +155,179 @@ void pybind_occupanygrid(py::module &m) {
             .def_readwrite("occ_prob_thres_log",
                            &geometry::OccupancyGrid::occ_prob_thres_log_)
             .def_readwrite("visualize_free_area",
-                           &geometry::OccupancyGrid::visualize_free_area_);
+                           &geometry::OccupancyGrid::visualize_free_area_)
+            .def_readwrite("track_changed_voxels",
+                           &geometry::OccupancyGrid::track_changed_voxels_)
+            .def_readwrite("decay_rate", &geometry::OccupancyGrid::decay_rate_)
+            .def_readwrite("decay_unknown_thres",
+                           &geometry::OccupancyGrid::decay_unknown_thres_)
+            .def_readonly("decay_stamp",
+                          &geometry::OccupancyGrid::decay_stamp_);
+
+    py::class_<geometry::SparseOccupancyGrid,
+               PyGeometry3D<geometry::SparseOccupancyGrid>,
+               std::shared_ptr<geometry::SparseOccupancyGrid>,
+               geometry::GeometryBase3D>
+            sparse_occupancygrid(
+                    m, "SparseOccupancyGrid",
+                    "SparseOccupancyGrid is an occupancy grid whose voxels are "
+                    "allocated in blocks only where they are observed.");
+    py::detail::bind_default_constructor<geometry::SparseOccupancyGrid>(
+            sparse_occupancygrid);
+    py::detail::bind_copy_functions<geometry::SparseOccupancyGrid>(
+            sparse_occupancygrid);
+    sparse_occupancygrid
+            .def(py::init<float, const Eigen::Vector3f &, int>(),
+                 "Create a sparse occupancy grid", "voxel_size"_a,
+                 "origin"_a = Eigen::Vector3f::Zero(),
+                 "block_capacity"_a = 4096)
+            .def("__repr__",
+                 [](const geometry::SparseOccupancyGrid &occupancygrid) {
+                     return std::string("geometry::SparseOccupancyGrid with ") +
+                            std::to_string(occupancygrid.ExtractKnownVoxels()
+                                                   ->size()) +
+                            " voxels in " +
+                            std::to_string(occupancygrid.NumBlocks()) +
+                            " blocks.";
+                 })
+            .def_property_readonly(
+                    "voxels",
+                    [](const geometry::SparseOccupancyGrid &og) {
+                        return og.ExtractKnownVoxels();
+                    })
+            .def("num_blocks", &geometry::SparseOccupancyGrid::NumBlocks,
+                 "Returns the number of allocated blocks.")
+            .def("is_occupied", &geometry::SparseOccupancyGrid::IsOccupied,
+                 "Returns whether the voxel containing the point is occupied.",
+                 "point"_a)
+            .def("is_unknown", &geometry::SparseOccupancyGrid::IsUnknown,
+                 "Returns whether the voxel containing the point is unknown.",
+                 "point"_a)
+            .def("extract_occupied_voxels",
+                 &geometry::SparseOccupancyGrid::ExtractOccupiedVoxels,
+                 "Returns the occupied voxels.")
+            .def("extract_free_voxels",
+                 &geometry::SparseOccupancyGrid::ExtractFreeVoxels,
+                 "Returns the free voxels.")
+            .def("insert",
+                 py::overload_cast<const geometry::PointCloud &,
+                                   const Eigen::Vector3f &, float>(
+                         &geometry::SparseOccupancyGrid::Insert),
+                 "Function to insert occupancy grid from pointcloud.",
+                 "pointcloud"_a, "viewpoint"_a, "max_range"_a = -1.0)
+            .def_static(
+                    "create_from_voxel_grid",
+                    &geometry::SparseOccupancyGrid::CreateFromVoxelGrid,
+                    "Function to make sparse occupancy grid from a Voxel Grid")
+            .def_readwrite("voxel_size",
+                           &geometry::SparseOccupancyGrid::voxel_size_)
+            .def_readonly("resolution",
+                          &geometry::SparseOccupancyGrid::resolution_)
+            .def_readwrite("origin", &geometry::SparseOccupancyGrid::origin_)
+            .def_readwrite("clamping_thres_min",
+                           &geometry::SparseOccupancyGrid::clamping_thres_min_)
+            .def_readwrite("clamping_thres_max",
+                           &geometry::SparseOccupancyGrid::clamping_thres_max_)
+            .def_readwrite("prob_hit_log",
+                           &geometry::SparseOccupancyGrid::prob_hit_log_)
+            .def_readwrite("prob_miss_log",
+                           &geometry::SparseOccupancyGrid::prob_miss_log_)
+            .def_readwrite("occ_prob_thres_log",
+                           &geometry::SparseOccupancyGrid::occ_prob_thres_log_)
+            .def_readwrite(
+                    "visualize_free_area",
+                    &geometry::SparseOccupancyGrid::visualize_free_area_);
+    py::class_<geometry::OctreeOccupancyGrid,
+               PyGeometry3D<geometry::OctreeOccupancyGrid>,
+               std::shared_ptr<geometry::OctreeOccupancyGrid>,
+               geometry::GeometryBase3D>
+            octree_occupancygrid(
+                    m, "OctreeOccupancyGrid",
+                    "OctreeOccupancyGrid is a multi-resolution occupancy grid "
+                    "whose homogeneous regions are pruned into single nodes.");
+    py::detail::bind_default_constructor<geometry::OctreeOccupancyGrid>(
+            octree_occupancygrid);
+    py::detail::bind_copy_functions<geometry::OctreeOccupancyGrid>(
+            octree_occupancygrid);
+    octree_occupancygrid
+            .def(py::init<float, int, const Eigen::Vector3f &>(),
+                 "Create an octree occupancy grid", "voxel_size"_a,
+                 "max_depth"_a = 16, "origin"_a = Eigen::Vector3f::Zero())
+            .def("__repr__",
+                 [](const geometry::OctreeOccupancyGrid &occupancygrid) {
+                     return std::string("geometry::OctreeOccupancyGrid with ") +
+                            std::to_string(occupancygrid.NumLeaves()) +
+                            " leaves.";
+                 })
+            .def_property_readonly(
+                    "voxels",
+                    [](const geometry::OctreeOccupancyGrid &og) {
+                        return og.ExtractKnownVoxels();
+                    })
+            .def("num_leaves", &geometry::OctreeOccupancyGrid::NumLeaves,
+                 "Returns the number of stored leaves.")
+            .def("get_resolution",
+                 &geometry::OctreeOccupancyGrid::GetResolution,
+                 "Returns the number of voxels along each axis at the finest "
+                 "depth.")
+            .def("is_occupied", &geometry::OctreeOccupancyGrid::IsOccupied,
+                 "Returns whether the voxel containing the point is occupied.",
+                 "point"_a)
+            .def("is_unknown", &geometry::OctreeOccupancyGrid::IsUnknown,
+                 "Returns whether the voxel containing the point is unknown.",
+                 "point"_a)
+            .def("extract_known_voxels",
+                 &geometry::OctreeOccupancyGrid::ExtractKnownVoxels,
+                 "Returns the known voxels at the given depth.",
+                 "depth"_a = -1)
+            .def("extract_occupied_voxels",
+                 &geometry::OctreeOccupancyGrid::ExtractOccupiedVoxels,
+                 "Returns the occupied voxels at the given depth.",
+                 "depth"_a = -1)
+            .def("extract_free_voxels",
+                 &geometry::OctreeOccupancyGrid::ExtractFreeVoxels,
+                 "Returns the free voxels at the given depth.", "depth"_a = -1)
+            .def("insert",
+                 py::overload_cast<const geometry::PointCloud &,
+                                   const Eigen::Vector3f &, float>(
+                         &geometry::OctreeOccupancyGrid::Insert),
+                 "Function to insert occupancy grid from pointcloud.",
+                 "pointcloud"_a, "viewpoint"_a, "max_range"_a = -1.0)
+            .def("prune", &geometry::OctreeOccupancyGrid::Prune,
+                 "Collapses sibling leaves sharing the same log-odds.")
+            .def("expand", &geometry::OctreeOccupancyGrid::Expand,
+                 "Splits the leaves above the given depth.", "depth"_a = -1)
+            .def("export_binary_stream",
+                 [](const geometry::OctreeOccupancyGrid &og) {
+                     const auto stream = og.ExportBinaryStream();
+                     return py::bytes(
+                             reinterpret_cast<const char *>(stream.data()),
+                             stream.size());
+                 },
+                 "Serializes the tree structure into bytes.")
+            .def("import_binary_stream",
+                 [](geometry::OctreeOccupancyGrid &og, const py::bytes &data) {
+                     const std::string str = data;
+                     return og.ImportBinaryStream(
+                             std::vector<uint8_t>(str.begin(), str.end()));
+                 },
+                 "Restores a tree written by export_binary_stream.", "data"_a)
+            .def_readwrite("voxel_size",
+                           &geometry::OctreeOccupancyGrid::voxel_size_)
+            .def_readonly("max_depth",
+                          &geometry::OctreeOccupancyGrid::max_depth_)
+            .def_readwrite("origin", &geometry::OctreeOccupancyGrid::origin_)
+            .def_readwrite("clamping_thres_min",
+                           &geometry::OctreeOccupancyGrid::clamping_thres_min_)
+            .def_readwrite("clamping_thres_max",
+                           &geometry::OctreeOccupancyGrid::clamping_thres_max_)
+            .def_readwrite("prob_hit_log",
+                           &geometry::OctreeOccupancyGrid::prob_hit_log_)
+            .def_readwrite("prob_miss_log",
+                           &geometry::OctreeOccupancyGrid::prob_miss_log_)
+            .def_readwrite("occ_prob_thres_log",
+                           &geometry::OctreeOccupancyGrid::occ_prob_thres_log_)
+            .def_readwrite(
+                    "visualize_free_area",
+                    &geometry::OctreeOccupancyGrid::visualize_free_area_);
 }
\ No newline at end of file
@@ -21,8 +21,10 @@
 #include "cupoch/geometry/pointcloud.h"
 
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/cluster_statistics.h"
 #include "cupoch/geometry/rgbdimage.h"
 #include "cupoch/geometry/laserscanbuffer.h"
+#include "cupoch/geometry/neighbor_list.h"
 #include "cupoch_pybind/dl_converter.h"
 #include "cupoch_pybind/docstring.h"
 #include "cupoch_pybind/geometry/geometry.h"
@@ -31,6 +33,60 @@
 using namespace cupoch;
 
 void pybind_pointcloud(py::module &m) {
+    // cupoch.geometry.ClusterStatistics
+    py::class_<geometry::ClusterStatistics,
+               std::shared_ptr<geometry::ClusterStatistics>>
+            cluster_stats(m, "ClusterStatistics",
+                          "Per-cluster statistics of a labeled point cloud.");
+    cluster_stats.def(py::init<>())
+            .def("__repr__",
+                 [](const geometry::ClusterStatistics &stats) {
+                     return std::string("geometry::ClusterStatistics with ") +
+                            std::to_string(stats.NumClusters()) +
+                            " clusters.";
+                 })
+            .def("num_clusters", &geometry::ClusterStatistics::NumClusters)
+            .def("get_axis_aligned_bounding_boxes",
+                 &geometry::ClusterStatistics::GetAxisAlignedBoundingBoxes,
+                 "Returns the axis aligned bounding boxes of the clusters.")
+            .def("get_oriented_bounding_boxes",
+                 &geometry::ClusterStatistics::GetOrientedBoundingBoxes,
+                 "Returns the oriented bounding boxes of the clusters.")
+            .def_property_readonly(
+                    "counts",
+                    [](geometry::ClusterStatistics &stats) {
+                        return wrapper::device_vector_int(stats.counts_);
+                    })
+            .def_property_readonly(
+                    "centroids",
+                    [](geometry::ClusterStatistics &stats) {
+                        return wrapper::device_vector_vector3f(
+                                stats.centroids_);
+                    })
+            .def_property_readonly(
+                    "min_bounds",
+                    [](geometry::ClusterStatistics &stats) {
+                        return wrapper::device_vector_vector3f(
+                                stats.min_bounds_);
+                    })
+            .def_property_readonly(
+                    "max_bounds",
+                    [](geometry::ClusterStatistics &stats) {
+                        return wrapper::device_vector_vector3f(
+                                stats.max_bounds_);
+                    })
+            .def_static("create_from_labels",
+                        [](const geometry::PointCloud &pcd,
+                           const wrapper::device_vector_int &labels,
+                           int num_clusters) {
+                            return geometry::ClusterStatistics::
+                                    CreateFromLabels(pcd, labels.data_,
+                                                     num_clusters);
+                        },
+                        "Function to compute the statistics of labeled "
+                        "clusters",
+                        "pointcloud"_a, "labels"_a, "num_clusters"_a);
+
     py::class_<geometry::PointCloud, PyGeometry3D<geometry::PointCloud>,
                std::shared_ptr<geometry::PointCloud>, geometry::GeometryBase3D>
             pointcloud(m, "PointCloud",
@@ -149,9 +205,48 @@ void pybind_pointcloud(py::module &m) {
                  "points with "
                  "the 0-th point always chosen, not at random.",
                  "every_k_points"_a)
-            .def("gaussian_filter", &geometry::PointCloud::GaussianFilter,
+            .def("organized_down_sample",
+                 &geometry::PointCloud::OrganizedDownSample,
+                 "Function to halve the resolution of an organized "
+                 "pointcloud by averaging 2x2 blocks of valid points.",
+                 "width"_a, "height"_a,
+                 "max_distance"_a = std::numeric_limits<float>::infinity())
+            .def("farthest_point_down_sample",
+                 &geometry::PointCloud::FarthestPointDownSample,
+                 "Function to downsample input pointcloud into output "
+                 "pointcloud by farthest point sampling.",
+                 "num_samples"_a, "start_index"_a = 0)
+            .def("poisson_disk_down_sample",
+                 &geometry::PointCloud::PoissonDiskDownSample,
+                 "Function to downsample input pointcloud into output "
+                 "pointcloud with a minimum distance between the points.",
+                 "radius"_a, "seed"_a = 0)
+            .def("gaussian_filter",
+                 py::overload_cast<float, float, int>(
+                         &geometry::PointCloud::GaussianFilter),
                  "Function to apply Gaussian Filter to input pointcloud",
                  "search_radius"_a, "sigma2"_a, "num_max_search_points"_a = 50)
+            .def("gaussian_filter",
+                 py::overload_cast<const geometry::NeighborList &, float>(
+                         &geometry::PointCloud::GaussianFilter, py::const_),
+                 "Function to apply Gaussian Filter to input pointcloud "
+                 "with precomputed neighbor lists",
+                 "neighbors"_a, "sigma2"_a)
+            .def("smooth_mls", &geometry::PointCloud::SmoothMLS,
+                 "Function to smooth input pointcloud by moving least squares",
+                 "neighbors"_a, "search_radius"_a, "polynomial_order"_a = 2,
+                 "upsampling_radius"_a = 0.0f, "upsampling_step"_a = 0.0f)
+            .def("bilateral_filter_normals",
+                 &geometry::PointCloud::BilateralFilterNormals,
+                 "Function to apply Bilateral Filter to the normals of input "
+                 "pointcloud",
+                 "neighbors"_a, "sigma_s"_a, "sigma_n"_a,
+                 "num_iterations"_a = 1)
+            .def("bilateral_filter", &geometry::PointCloud::BilateralFilter,
+                 "Function to denoise input pointcloud with an edge-aware "
+                 "Bilateral Filter",
+                 "neighbors"_a, "sigma_s"_a, "sigma_r"_a,
+                 "num_iterations"_a = 1)
             .def("pass_through_filter", &geometry::PointCloud::PassThroughFilter,
                  "Function to apply Pass Through Filter to input pointcloud",
                  "axis_no"_a, "min_bound"_a, "max_bound"_a)
@@ -173,6 +268,14 @@ void pybind_pointcloud(py::module &m) {
                  &geometry::PointCloud::RemoveNoneFinitePoints,
                  "Function to remove none-finite points from the PointCloud",
                  "remove_nan"_a = true, "remove_infinite"_a = true)
+            .def(
+                    "sort_by_morton_code",
+                    [](geometry::PointCloud &pcd) {
+                        return wrapper::device_vector_size_t(
+                                pcd.SortByMortonCode());
+                    },
+                    "Function to reorder the points along a Morton curve. "
+                    "Returns the original index of each reordered point.")
             .def(
                     "remove_radius_outlier",
                     [](const geometry::PointCloud &pcd, size_t nb_points,
@@ -206,11 +309,34 @@ void pybind_pointcloud(py::module &m) {
                  "Function to compute the normals of a point cloud. Normals "
                  "are oriented with respect to the input point cloud if "
                  "normals exist",
-                 "search_param"_a = geometry::KDTreeSearchParamKNN())
+                 "search_param"_a = geometry::KDTreeSearchParamKNN(),
+                 "start_index"_a = 0)
+            .def(
+                    "estimate_normals_with_curvatures",
+                    [](geometry::PointCloud &pcd,
+                       const geometry::KDTreeSearchParam &search_param,
+                       size_t start_index) {
+                        auto res = pcd.EstimateNormalsWithCurvatures(
+                                search_param, start_index);
+                        return std::make_tuple(
+                                wrapper::device_vector_float(
+                                        std::move(std::get<0>(res))),
+                                wrapper::device_vector_float(
+                                        std::move(std::get<1>(res))));
+                    },
+                    "Function to compute the normals of a point cloud and "
+                    "return the curvature and planarity of each point",
+                    "search_param"_a = geometry::KDTreeSearchParamKNN(),
+                    "start_index"_a = 0)
             .def("orient_normals_to_align_with_direction",
                  &geometry::PointCloud::OrientNormalsToAlignWithDirection,
                  "Function to orient the normals of a point cloud",
                  "orientation_reference"_a = Eigen::Vector3f(0.0, 0.0, 1.0))
+            .def("orient_normals_consistent_tangent_plane",
+                 &geometry::PointCloud::OrientNormalsConsistentTangentPlane,
+                 "Function to orient the normals with respect to consistent "
+                 "tangent planes",
+                 "k"_a)
             .def(
                     "cluster_dbscan",
                     [](const geometry::PointCloud &pcd, float eps,
@@ -229,6 +355,48 @@ void pybind_pointcloud(py::module &m) {
                     "labels, -1 indicates noise according to the algorithm.",
                     "eps"_a, "min_points"_a, "print_progress"_a = false,
                     "max_edges"_a = geometry::NUM_MAX_NN)
+            .def(
+                    "cluster_euclidean",
+                    [](const geometry::PointCloud &pcd, float tolerance,
+                       size_t min_cluster_size, size_t max_cluster_size,
+                       size_t max_edges) {
+                        auto res = pcd.ClusterEuclidean(
+                                tolerance, min_cluster_size, max_cluster_size,
+                                max_edges);
+                        return std::make_tuple(
+                                wrapper::device_vector_int(
+                                        std::move(std::get<0>(res))),
+                                std::get<1>(res));
+                    },
+                    "Cluster PointCloud by Euclidean connectivity. Returns "
+                    "the point labels, -1 indicates a point in a cluster out "
+                    "of the size range, and the per-cluster statistics.",
+                    "tolerance"_a, "min_cluster_size"_a = 1,
+                    "max_cluster_size"_a = std::numeric_limits<int>::max(),
+                    "max_edges"_a = geometry::NUM_MAX_NN)
+            .def(
+                    "cluster_region_growing",
+                    [](const geometry::PointCloud &pcd,
+                       const geometry::NeighborList &neighbors,
+                       const wrapper::device_vector_float &curvatures,
+                       float angle_threshold, float curvature_threshold,
+                       size_t min_cluster_size, size_t max_cluster_size) {
+                        auto res = pcd.ClusterRegionGrowing(
+                                neighbors, curvatures.data_, angle_threshold,
+                                curvature_threshold, min_cluster_size,
+                                max_cluster_size);
+                        return std::make_tuple(
+                                wrapper::device_vector_int(
+                                        std::move(std::get<0>(res))),
+                                std::get<1>(res));
+                    },
+                    "Segment PointCloud into smooth regions by region "
+                    "growing. Returns the point labels, -1 indicates a point "
+                    "in a cluster out of the size range, and the per-cluster "
+                    "statistics.",
+                    "neighbors"_a, "curvatures"_a, "angle_threshold"_a,
+                    "curvature_threshold"_a, "min_cluster_size"_a = 1,
+                    "max_cluster_size"_a = std::numeric_limits<int>::max())
             .def("segment_plane",
                  [](const geometry::PointCloud &pcd,
                     float distance_threshold,
@@ -303,6 +471,19 @@ void pybind_pointcloud(py::module &m) {
             m, "PointCloud", "uniform_down_sample",
             {{"every_k_points",
               "Sample rate, the selected point indices are [0, k, 2k, ...]"}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "organized_down_sample",
+            {{"width", "Width of the organized pointcloud."},
+             {"height", "Height of the organized pointcloud."},
+             {"max_distance", "Maximum distance of the averaged points."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "farthest_point_down_sample",
+            {{"num_samples", "Number of points to be sampled."},
+             {"start_index", "Index of the first selected point."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "poisson_disk_down_sample",
+            {{"radius", "Minimum distance between the selected points."},
+             {"seed", "Seed of the random visiting order of the points."}});
     docstring::ClassMethodDocInject(
             m, "PointCloud", "remove_none_finite_points",
             {{"remove_nan", "Remove NaN values from the PointCloud"},
@@ -320,14 +501,29 @@ void pybind_pointcloud(py::module &m) {
             m, "PointCloud", "estimate_normals",
             {{"search_param",
               "The KDTree search parameters for neighborhood search."},
+             {"start_index",
+              "Only the normals of the points from this index on are "
+              "estimated."},
              {"fast_normal_computation",
               "If true, the normal estiamtion uses a non-iterative method to "
               "extract the eigenvector from the covariance matrix. This is "
               "faster, but is not as numerical stable."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "estimate_normals_with_curvatures",
+            {{"search_param",
+              "The KDTree search parameters for neighborhood search."},
+             {"start_index",
+              "Only the normals of the points from this index on are "
+              "estimated."}});
     docstring::ClassMethodDocInject(
             m, "PointCloud", "orient_normals_to_align_with_direction",
             {{"orientation_reference",
               "Normals are oriented with respect to orientation_reference."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "orient_normals_consistent_tangent_plane",
+            {{"k",
+              "Number of k nearest neighbors used in constructing the "
+              "Riemannian graph used to propagate normal orientation."}});
     docstring::ClassMethodDocInject(
             m, "PointCloud", "cluster_dbscan",
             {{"eps",
@@ -335,6 +531,23 @@ void pybind_pointcloud(py::module &m) {
              {"min_points", "Minimum number of points to form a cluster."},
              {"print_progress",
               "If true the progress is visualized in the console."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "cluster_euclidean",
+            {{"tolerance", "Maximum distance between connected points."},
+             {"min_cluster_size", "Minimum number of points of a cluster."},
+             {"max_cluster_size", "Maximum number of points of a cluster."},
+             {"max_edges", "Maximum number of neighbors searched per point."}});
+    docstring::ClassMethodDocInject(
+            m, "PointCloud", "cluster_region_growing",
+            {{"neighbors", "Neighbor lists of the points."},
+             {"curvatures", "Curvatures of the points."},
+             {"angle_threshold",
+              "Maximum angle between normals in radians."},
+             {"curvature_threshold",
+              "Maximum curvature of the points through which the regions "
+              "grow."},
+             {"min_cluster_size", "Minimum number of points of a cluster."},
+             {"max_cluster_size", "Maximum number of points of a cluster."}});
     docstring::ClassMethodDocInject(
             m, "PointCloud", "create_from_depth_image",
             {
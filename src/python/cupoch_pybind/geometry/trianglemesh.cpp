@@ -137,6 +137,12 @@ void pybind_trianglemesh(py::module &m) {
                  "shrinkage of the triangle mesh.",
                  "number_of_iterations"_a = 1, "lambda"_a = 0.5, "mu"_a = -0.53,
                  "filter_scope"_a = geometry::MeshBase::FilterScope::All)
+            .def("simplify_vertex_clustering",
+                 &geometry::TriangleMesh::SimplifyVertexClustering,
+                 "Function to simplify mesh using vertex clustering.",
+                 "voxel_size"_a,
+                 "contraction"_a =
+                         geometry::MeshBase::SimplificationContraction::Average)
             .def("has_vertices", &geometry::TriangleMesh::HasVertices,
                  "Returns ``True`` if the mesh contains vertices.")
             .def("has_triangles", &geometry::TriangleMesh::HasTriangles,
@@ -170,6 +176,13 @@ void pybind_trianglemesh(py::module &m) {
                  &geometry::TriangleMesh::SamplePointsUniformly,
                  "Function to uniformly sample points from the mesh.",
                  "number_of_points"_a = 100, "use_triangle_normal"_a = false)
+            .def("sample_points_poisson_disk",
+                 &geometry::TriangleMesh::SamplePointsPoissonDisk,
+                 "Function to sample points from the mesh, where each point "
+                 "has approximately the same distance to the neighbouring "
+                 "points (blue noise).",
+                 "number_of_points"_a, "init_factor"_a = 5,
+                 "use_triangle_normal"_a = false, "seed"_a = 0)
             .def_static("create_box", &geometry::TriangleMesh::CreateBox,
                         "Factory function to create a box. The left bottom "
                         "corner on the "
@@ -358,6 +371,14 @@ void pybind_trianglemesh(py::module &m) {
              {"lambda", "Filter parameter."},
              {"mu", "Filter parameter."},
              {"scope", "Mesh property that should be filtered."}});
+    docstring::ClassMethodDocInject(
+            m, "TriangleMesh", "simplify_vertex_clustering",
+            {{"voxel_size",
+              "The size of the voxel within vertices are pooled."},
+             {"contraction",
+              "Method to aggregate vertex information. Average computes a "
+              "simple average, Quadric minimizes the distance to the "
+              "adjacent planes."}});
     docstring::ClassMethodDocInject(
             m, "TriangleMesh", "paint_uniform_color",
             {{"color", "RGB color for the PointCloud."}});
@@ -92,6 +92,7 @@ void pybind_voxelgrid(py::module &m) {
                     [](geometry::VoxelGrid &vg, const wrapper::VoxelMap &map) {
                         wrapper::FromWrapper(vg.voxels_keys_, vg.voxels_values_,
                                              map);
+                        vg.ResetIndex();
                     })
             .def(py::self + py::self)
             .def(py::self += py::self)
@@ -106,11 +107,42 @@ void pybind_voxelgrid(py::module &m) {
                  [] (geometry::VoxelGrid& self, const wrapper::device_vector_size_t& indices, const Eigen::Vector3f& color) {
                      return self.PaintIndexedColor(indices.data_, color);
                  })
-            .def("check_if_included", &geometry::VoxelGrid::CheckIfIncluded,
+            .def("check_if_included",
+                 py::overload_cast<const thrust::host_vector<Eigen::Vector3f>
+                                           &>(
+                         &geometry::VoxelGrid::CheckIfIncluded),
                  "queries"_a,
                  "Element-wise check if a query in the list is included in "
                  "the VoxelGrid. Queries are double precision and "
                  "are mapped to the closest voxel.")
+            .def("contains",
+                 [](const geometry::VoxelGrid &self,
+                    const wrapper::device_vector_vector3i &keys) {
+                     thrust::host_vector<bool> output =
+                             self.Contains(keys.data_);
+                     return output;
+                 },
+                 "keys"_a,
+                 "Element-wise check if a grid index is stored in the "
+                 "VoxelGrid.")
+            .def("find",
+                 [](const geometry::VoxelGrid &self,
+                    const wrapper::device_vector_vector3i &keys) {
+                     return wrapper::device_vector_int(self.Find(keys.data_));
+                 },
+                 "keys"_a,
+                 "Returns the position of each grid index in the voxel list, "
+                 "or -1 if the voxel is not stored.")
+            .def("erase",
+                 [](geometry::VoxelGrid &self,
+                    const wrapper::device_vector_vector3i &keys) {
+                     return self.Erase(keys.data_);
+                 },
+                 "keys"_a, "Removes the voxels with the given grid indices.")
+            .def("sort_by_morton_code",
+                 &geometry::VoxelGrid::SortByMortonCode,
+                 "Reorders the voxels along a Morton curve of their grid "
+                 "indices.")
             .def("carve_depth_map", &geometry::VoxelGrid::CarveDepthMap,
                  "depth_map"_a, "camera_params"_a,
                  "keep_voxels_outside_image"_a = false,
@@ -21,9 +21,11 @@
 #include "cupoch_pybind/integration/integration.h"
 
 #include "cupoch/geometry/voxelgrid.h"
+#include "cupoch/integration/color_map_optimization.h"
 #include "cupoch/integration/tsdfvolume.h"
 #include "cupoch/integration/uniform_tsdfvolume.h"
 #include "cupoch/integration/scalable_tsdfvolume.h"
+#include "cupoch/integration/surfel_map.h"
 #include "cupoch_pybind/docstring.h"
 
 using namespace cupoch;
@@ -65,6 +67,19 @@ void pybind_integration_classes(py::module &m) {
             }),
             py::none(), py::none(), "");
 
+    // cupoch.integration.TSDFVoxelFormat
+    py::enum_<integration::TSDFVoxelFormat> tsdf_voxel_format(
+            m, "TSDFVoxelFormat", py::arithmetic());
+    tsdf_voxel_format
+            .value("Float32", integration::TSDFVoxelFormat::Float32)
+            .value("Compact", integration::TSDFVoxelFormat::Compact)
+            .export_values();
+    tsdf_voxel_format.attr("__doc__") = docstring::static_property(
+            py::cpp_function([](py::handle arg) -> std::string {
+                return "Enum class for TSDFVoxelFormat.";
+            }),
+            py::none(), py::none(), "");
+
     // cupoch.integration.TSDFVolume
     py::class_<integration::TSDFVolume, PyTSDFVolume<integration::TSDFVolume>>
             tsdfvolume(m, "TSDFVolume", R"(Base class of the Truncated
@@ -80,6 +95,10 @@ In SIGGRAPH, 1996)");
             .def("integrate", &integration::TSDFVolume::Integrate,
                  "Function to integrate an RGB-D image into the volume",
                  "image"_a, "intrinsic"_a, "extrinsic"_a)
+            .def("integrate_batch", &integration::TSDFVolume::IntegrateBatch,
+                 "Function to integrate a batch of RGB-D images taken with "
+                 "the same intrinsic into the volume",
+                 "images"_a, "intrinsic"_a, "extrinsics"_a)
             .def("extract_point_cloud",
                  &integration::TSDFVolume::ExtractPointCloud,
                  "Function to extract a point cloud with normals")
@@ -116,11 +135,16 @@ In SIGGRAPH, 1996)");
             uniform_tsdfvolume);
     uniform_tsdfvolume
             .def(py::init([](float length, int resolution, float sdf_trunc,
-                             integration::TSDFVolumeColorType color_type) {
+                             integration::TSDFVolumeColorType color_type,
+                             const Eigen::Vector3f &origin,
+                             integration::TSDFVoxelFormat voxel_format) {
                      return new integration::UniformTSDFVolume(
-                             length, resolution, sdf_trunc, color_type);
+                             length, resolution, sdf_trunc, color_type, origin,
+                             voxel_format);
                  }),
-                 "length"_a, "resolution"_a, "sdf_trunc"_a, "color_type"_a)
+                 "length"_a, "resolution"_a, "sdf_trunc"_a, "color_type"_a,
+                 "origin"_a = Eigen::Vector3f::Zero(),
+                 "voxel_format"_a = integration::TSDFVoxelFormat::Float32)
             .def("__repr__",
                  [](const integration::UniformTSDFVolume &vol) {
                      return std::string("integration::UniformTSDFVolume ") +
@@ -130,6 +154,21 @@ In SIGGRAPH, 1996)");
                                      ? std::string("without color.")
                                      : std::string("with color."));
                  })  // todo: extend
+            .def("extract_triangle_mesh",
+                 py::overload_cast<>(
+                         &integration::UniformTSDFVolume::ExtractTriangleMesh),
+                 "Function to extract a triangle mesh")
+            .def("extract_triangle_mesh",
+                 py::overload_cast<
+                         const geometry::AxisAlignedBoundingBox<3> &, float,
+                         geometry::MeshBase::SimplificationContraction>(
+                         &integration::UniformTSDFVolume::ExtractTriangleMesh),
+                 "Function to extract the triangle mesh of a region of "
+                 "interest, simplified by vertex clustering if "
+                 "simplification_voxel_size is positive.",
+                 "roi"_a, "simplification_voxel_size"_a = 0.0,
+                 "contraction"_a =
+                         geometry::MeshBase::SimplificationContraction::Quadric)
             .def("extract_voxel_point_cloud",
                  &integration::UniformTSDFVolume::ExtractVoxelPointCloud,
                  "Debug function to extract the voxel data into a point cloud.")
@@ -146,7 +185,14 @@ In SIGGRAPH, 1996)");
             .def_readwrite("resolution",
                            &integration::UniformTSDFVolume::resolution_,
                            "Resolution over the total length, where "
-                           "``voxel_length = length / resolution``");
+                           "``voxel_length = length / resolution``")
+            .def_readonly("voxel_format",
+                          &integration::UniformTSDFVolume::voxel_format_,
+                          "integration.TSDFVoxelFormat: Storage format of "
+                          "the voxels.")
+            .def("get_voxel_byte_size",
+                 &integration::UniformTSDFVolume::GetVoxelByteSize,
+                 "Size in bytes of a voxel of the volume.");
     docstring::ClassMethodDocInject(m, "UniformTSDFVolume",
                                     "extract_voxel_point_cloud");
 
@@ -183,6 +229,21 @@ In SIGGRAPH, 2013)");
                  }),
                  "voxel_length"_a, "sdf_trunc"_a, "color_type"_a,
                  "depth_sampling_stride"_a = 4)
+            .def("raycast", &integration::ScalableTSDFVolume::Raycast,
+                 "intrinsic"_a, "extrinsic"_a, "sdf_trunc"_a, "max_depth"_a,
+                 "project_valid_depth_only"_a = true,
+                 "Predict the surface by raycasting.")
+            .def("stream_out", &integration::ScalableTSDFVolume::StreamOut,
+                 "center"_a, "radius"_a,
+                 "Move the volume units farther than radius from center to "
+                 "host memory.")
+            .def("stream_in", &integration::ScalableTSDFVolume::StreamIn,
+                 "center"_a, "radius"_a,
+                 "Move the volume units in host memory within radius from "
+                 "center back to the GPU.")
+            .def("get_num_streamed_out_units",
+                 &integration::ScalableTSDFVolume::GetNumStreamedOutUnits,
+                 "Returns the number of volume units in host memory.")
             .def("__repr__",
                  [](const integration::ScalableTSDFVolume &vol) {
                      return std::string(
@@ -195,8 +256,123 @@ In SIGGRAPH, 2013)");
                  });
 }
 
+    // cupoch.integration.SurfelMap
+    py::class_<integration::SurfelMap> surfel_map(m, "SurfelMap", R"(The
+SurfelMap fuses RGB-D images into oriented disks whose memory is
+proportional to the observed surface.
+Ref: ElasticFusion: Dense SLAM Without A Pose Graph
+T. Whelan, S. Leutenegger, R. F. Salas-Moreno, B. Glocker and A. J. Davison
+In RSS, 2015)");
+    py::detail::bind_copy_functions<integration::SurfelMap>(surfel_map);
+    surfel_map
+            .def(py::init<integration::TSDFVolumeColorType, float, int,
+                          float>(),
+                 "color_type"_a = integration::TSDFVolumeColorType::RGB8,
+                 "confidence_threshold"_a = 10.0,
+                 "unstable_time_window"_a = 30, "max_depth"_a = 3.0)
+            .def("reset", &integration::SurfelMap::Reset,
+                 "Function to reset the SurfelMap")
+            .def("integrate", &integration::SurfelMap::Integrate,
+                 "Function to integrate an RGB-D image into the map",
+                 "image"_a, "intrinsic"_a, "extrinsic"_a)
+            .def("render_index_map", &integration::SurfelMap::RenderIndexMap,
+                 "Render the index of the closest surfel at each pixel, -1 "
+                 "for the pixels without surfel.",
+                 "intrinsic"_a, "extrinsic"_a)
+            .def("extract_point_cloud",
+                 &integration::SurfelMap::ExtractPointCloud,
+                 "Function to extract the stable surfels as a point cloud")
+            .def("get_num_surfels", &integration::SurfelMap::GetNumSurfels)
+            .def_readwrite("color_type", &integration::SurfelMap::color_type_)
+            .def_readwrite("confidence_threshold",
+                           &integration::SurfelMap::confidence_threshold_)
+            .def_readwrite("unstable_time_window",
+                           &integration::SurfelMap::unstable_time_window_)
+            .def_readwrite("max_depth", &integration::SurfelMap::max_depth_)
+            .def_readwrite("depth_threshold",
+                           &integration::SurfelMap::depth_threshold_)
+            .def_readwrite("normal_threshold",
+                           &integration::SurfelMap::normal_threshold_)
+            .def_readwrite("confidence_sigma",
+                           &integration::SurfelMap::confidence_sigma_)
+            .def_readonly("time", &integration::SurfelMap::time_)
+            .def("__repr__", [](const integration::SurfelMap &map) {
+                return std::string("integration::SurfelMap with ") +
+                       std::to_string(map.GetNumSurfels()) + " surfels.";
+            });
+
+    // cupoch.integration.ColorMapOptimizationOption
+    py::class_<integration::ColorMapOptimizationOption>
+            color_map_optimization_option(
+                    m, "ColorMapOptimizationOption",
+                    "Defines options for color map optimization.");
+    py::detail::bind_default_constructor<
+            integration::ColorMapOptimizationOption>(
+            color_map_optimization_option);
+    color_map_optimization_option
+            .def_readwrite("non_rigid_camera_coordinate",
+                           &integration::ColorMapOptimizationOption::
+                                   non_rigid_camera_coordinate_,
+                           "bool: Optimize a warping field per image.")
+            .def_readwrite("number_of_vertical_anchors",
+                           &integration::ColorMapOptimizationOption::
+                                   number_of_vertical_anchors_,
+                           "int: Number of rows of anchor points of the "
+                           "warping fields.")
+            .def_readwrite("non_rigid_anchor_point_weight",
+                           &integration::ColorMapOptimizationOption::
+                                   non_rigid_anchor_point_weight_,
+                           "float: Weight of the anchor point "
+                           "regularization.")
+            .def_readwrite("maximum_iteration",
+                           &integration::ColorMapOptimizationOption::
+                                   maximum_iteration_,
+                           "int: Number of iterations.")
+            .def_readwrite("maximum_allowable_depth",
+                           &integration::ColorMapOptimizationOption::
+                                   maximum_allowable_depth_,
+                           "float: Maximum depth of the visible vertices.")
+            .def_readwrite("depth_threshold_for_visibility_check",
+                           &integration::ColorMapOptimizationOption::
+                                   depth_threshold_for_visibility_check_,
+                           "float: Depth difference threshold of the "
+                           "visibility check.")
+            .def_readwrite("depth_threshold_for_discontinuity_check",
+                           &integration::ColorMapOptimizationOption::
+                                   depth_threshold_for_discontinuity_check_,
+                           "float: Depth range threshold of the "
+                           "discontinuity check.")
+            .def_readwrite("texture_tile_size",
+                           &integration::ColorMapOptimizationOption::
+                                   texture_tile_size_,
+                           "int: Size in pixels of the texture atlas cell "
+                           "holding two triangles.")
+            .def("__repr__",
+                 [](const integration::ColorMapOptimizationOption &option) {
+                     return std::string(
+                                    "integration::ColorMapOptimizationOption "
+                                    "with ") +
+                            std::to_string(option.maximum_iteration_) +
+                            " iterations.";
+                 });
+}
+
 void pybind_integration_methods(py::module &m) {
-    // Currently empty
+    m.def("color_map_optimization",
+          [](geometry::TriangleMesh &mesh,
+             const std::vector<geometry::RGBDImage> &images,
+             const camera::PinholeCameraIntrinsic &intrinsic,
+             thrust::host_vector<Eigen::Matrix4f> extrinsics,
+             const integration::ColorMapOptimizationOption &option) {
+              integration::ColorMapOptimization(mesh, images, intrinsic,
+                                                extrinsics, option);
+              return extrinsics;
+          },
+          "Function for color mapping of reconstructed scenes. The colors "
+          "and the texture of the mesh are updated and the optimized "
+          "extrinsics are returned.",
+          "mesh"_a, "images"_a, "intrinsic"_a, "extrinsics"_a,
+          "option"_a = integration::ColorMapOptimizationOption());
 }
 
 void pybind_integration(py::module &m) {
@@ -41,7 +41,13 @@ void pybind_kinfu_classes(py::module &m) {
       .def_readwrite("tsdf_origin", &kinfu::KinfuOption::tsdf_origin_)
       .def_readwrite("distance_threshold", &kinfu::KinfuOption::distance_threshold_)
       .def_readwrite("icp_iterations", &kinfu::KinfuOption::icp_iterations_)
-      .def_readwrite("tf_type", &kinfu::KinfuOption::tf_type_);
+      .def_readwrite("tf_type", &kinfu::KinfuOption::tf_type_)
+      .def_readwrite("projective_icp", &kinfu::KinfuOption::projective_icp_)
+      .def_readwrite("scalable_tsdf", &kinfu::KinfuOption::scalable_tsdf_)
+      .def_readwrite("working_radius", &kinfu::KinfuOption::working_radius_)
+      .def_readwrite("tsdf_map_size", &kinfu::KinfuOption::tsdf_map_size_)
+      .def_readwrite("tsdf_voxel_format",
+                     &kinfu::KinfuOption::tsdf_voxel_format_);
 
     // cupoch.kinfu.KinfuPipeline
     py::class_<kinfu::KinfuPipeline> pipline(
@@ -20,6 +20,7 @@
 **/
 #include "cupoch_pybind/registration/registration.h"
 
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/registration/colored_icp.h"
 #include "cupoch/registration/fast_global_registration.h"
@@ -363,6 +364,10 @@ static const std::unordered_map<std::string, std::string>
                 {"source", "The source point cloud."},
                 {"target_feature", "Target point cloud feature."},
                 {"target", "The target point cloud."},
+                {"target_extrinsic",
+                 "Extrinsic of the camera of the organized target."},
+                {"target_intrinsic",
+                 "Intrinsic of the camera of the organized target."},
                 {"transformation",
                  "The 4x4 transformation matrix to transform ``source`` to "
                  "``target``"}};
@@ -388,6 +393,18 @@ void pybind_registration_methods(py::module &m) {
     docstring::FunctionDocInject(m, "registration_colored_icp",
                                  map_shared_argument_docstrings);
 
+    m.def("registration_projective_icp",
+          &registration::RegistrationProjectiveICP,
+          "Function for point-to-plane ICP registration with projective "
+          "data association against an organized target point cloud",
+          "source"_a, "target"_a, "target_intrinsic"_a,
+          "target_extrinsic"_a, "max_correspondence_distance"_a,
+          "init"_a = Eigen::Matrix4f::Identity(),
+          "criteria"_a = registration::ICPConvergenceCriteria(),
+          "det_thresh"_a = 1.0e-6);
+    docstring::FunctionDocInject(m, "registration_projective_icp",
+                                 map_shared_argument_docstrings);
+
     m.def("registration_fast_based_on_feature_matching",
           &registration::FastGlobalRegistration<33>,
           "Function for fast global registration based on feature matching",
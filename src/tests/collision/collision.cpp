@@ -20,6 +20,7 @@
 **/
 #include "cupoch/collision/collision.h"
 
+#include "cupoch/geometry/distancetransform.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "cupoch/geometry/lineset.h"
 #include "tests/test_utility/raw.h"
@@ -70,4 +71,28 @@ TEST(Collision, VoxelLineSet) {
     EXPECT_TRUE(res2->IsCollided());
     EXPECT_EQ(res2->collision_index_pairs_.size(), 1);
     EXPECT_EQ(res2->GetCollisionIndexPairs()[0], Eigen::Vector2i(0, 1));
-}
\ No newline at end of file
+}
+
+TEST(Collision, PrimitivesDistanceTransform) {
+    geometry::VoxelGrid voxel;
+    voxel.voxel_size_ = 1.0;
+    voxel.AddVoxel(geometry::Voxel(Eigen::Vector3i(5, 5, 5)));
+    geometry::DistanceTransform dt(1.0, 64);
+    dt.ComputeEDT(voxel);
+    collision::PrimitiveArray primitives(3);
+    collision::PrimitivePack pack;
+    // Touches the face of the obstacle voxel.
+    pack.sphere_ = collision::Sphere(2.5, Eigen::Vector3f(8.5, 5.5, 5.5));
+    primitives[0] = pack;
+    pack.sphere_ = collision::Sphere(3.5, Eigen::Vector3f(5.5, 8.5, 5.5));
+    primitives[1] = pack;
+    pack.sphere_ = collision::Sphere(1.5, Eigen::Vector3f(5.5, 5.5, 10.5));
+    primitives[2] = pack;
+    auto res = collision::ComputeIntersection(primitives, dt);
+    EXPECT_EQ(res->collision_index_pairs_.size(), 2);
+    const auto pairs = res->GetCollisionIndexPairs();
+    EXPECT_EQ(pairs[0],
+              Eigen::Vector2i(0, IndexOf(Eigen::Vector3i(37, 37, 37), 64)));
+    EXPECT_EQ(pairs[1],
+              Eigen::Vector2i(1, IndexOf(Eigen::Vector3i(37, 37, 37), 64)));
+}
@@ -20,6 +20,7 @@
 **/
 #include "cupoch/geometry/distancetransform.h"
 
+#include "cupoch/geometry/occupancygrid.h"
 #include "cupoch/geometry/voxelgrid.h"
 #include "tests/test_utility/raw.h"
 #include "tests/test_utility/unit_test.h"
@@ -43,4 +44,97 @@ TEST(DistanceTransform, ComputeVoronoiDiagram) {
     EXPECT_EQ(
             thrust::get<1>(v).nearest_index_,
             ref.cast<unsigned short>() + Eigen::Vector3ui16::Constant(512 / 2));
-}
\ No newline at end of file
+}
+
+TEST(DistanceTransform, ShiftWindow) {
+    geometry::VoxelGrid voxelgrid;
+    voxelgrid.voxel_size_ = 1.0;
+    thrust::host_vector<Eigen::Vector3i> h_keys;
+    h_keys.push_back(Eigen::Vector3i(5, 5, 5));
+    voxelgrid.SetVoxels(h_keys, thrust::host_vector<geometry::Voxel>());
+    geometry::DistanceTransform dt(1.0, 64);
+    dt.ComputeEDT(voxelgrid);
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(8.5, 5.5, 5.5)), 3.0,
+                THRESHOLD_1E_4);
+    dt.ShiftWindow(Eigen::Vector3i(2, 0, 0));
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(8.5, 5.5, 5.5)), 3.0,
+                THRESHOLD_1E_4);
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(32.5, 5.5, 5.5)), 0.0,
+                THRESHOLD_1E_4);
+    // The nearest obstacle index follows the window.
+    auto kept = dt.GetVoxel(Eigen::Vector3f(8.5, 5.5, 5.5));
+    EXPECT_EQ(thrust::get<1>(kept).nearest_index_,
+              Eigen::Vector3ui16(35, 37, 37));
+    auto exposed = dt.GetVoxel(Eigen::Vector3f(32.5, 5.5, 5.5));
+    EXPECT_EQ(thrust::get<1>(exposed).nearest_index_,
+              Eigen::Vector3ui16::Constant(
+                      std::numeric_limits<unsigned short>::max()));
+    dt.ComputeEDT(voxelgrid);
+    utility::device_vector<Eigen::Vector3f> queries(
+            2, Eigen::Vector3f(8.5, 5.5, 5.5));
+    queries[1] = Eigen::Vector3f(32.5, 5.5, 5.5);
+    auto dists = dt.GetDistances(queries);
+    EXPECT_NEAR(dists[0], 3.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(dists[1], 27.0, THRESHOLD_1E_4);
+}
+
+TEST(DistanceTransform, UpdateEDT) {
+    geometry::OccupancyGrid occgrid(1.0, 64);
+    occgrid.track_changed_voxels_ = true;
+    occgrid.AddVoxel(Eigen::Vector3i(40, 32, 32), true);
+    geometry::DistanceTransform dt(1.0, 64);
+    dt.ComputeEDT(occgrid);
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(-6.5, 0.5, 0.5)), 15.0,
+                THRESHOLD_1E_4);
+
+    occgrid.AddVoxel(Eigen::Vector3i(20, 32, 32), true);
+    dt.UpdateEDT(occgrid);
+    EXPECT_TRUE(occgrid.changed_voxels_.empty());
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(-6.5, 0.5, 0.5)), 5.0,
+                THRESHOLD_1E_4);
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(-11.5, 3.5, 0.5)), 3.0,
+                THRESHOLD_1E_4);
+
+    for (int i = 0; i < 3; ++i) {
+        occgrid.AddVoxel(Eigen::Vector3i(40, 32, 32), false);
+    }
+    dt.UpdateEDT(occgrid);
+    geometry::DistanceTransform ref(1.0, 64);
+    ref.ComputeEDT(occgrid);
+    utility::device_vector<Eigen::Vector3f> queries(3);
+    queries[0] = Eigen::Vector3f(8.5, 0.5, 0.5);
+    queries[1] = Eigen::Vector3f(-11.5, 3.5, 0.5);
+    queries[2] = Eigen::Vector3f(30.5, 0.5, 0.5);
+    auto dists = dt.GetDistances(queries);
+    auto ref_dists = ref.GetDistances(queries);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(dists[i], ref_dists[i], THRESHOLD_1E_4);
+    }
+    EXPECT_NEAR(dists[0], 20.0, THRESHOLD_1E_4);
+}
+
+TEST(DistanceTransform, GetInterpolatedDistances) {
+    geometry::VoxelGrid voxelgrid;
+    voxelgrid.voxel_size_ = 1.0;
+    thrust::host_vector<Eigen::Vector3i> h_keys;
+    h_keys.push_back(Eigen::Vector3i(5, 5, 5));
+    voxelgrid.SetVoxels(h_keys, thrust::host_vector<geometry::Voxel>());
+    geometry::DistanceTransform dt(1.0, 64);
+    dt.ComputeSignedEDT(voxelgrid);
+    EXPECT_TRUE(dt.IsSigned());
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(5.5, 5.5, 5.5)), -0.5,
+                THRESHOLD_1E_4);
+    EXPECT_NEAR(dt.GetDistance(Eigen::Vector3f(8.5, 5.5, 5.5)), 2.5,
+                THRESHOLD_1E_4);
+
+    utility::device_vector<Eigen::Vector3f> queries(2);
+    queries[0] = Eigen::Vector3f(7.0, 5.5, 5.5);
+    queries[1] = Eigen::Vector3f(6.0, 5.5, 5.5);
+    auto res = dt.GetInterpolatedDistances(queries);
+    EXPECT_NEAR(res.first[0], 1.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(res.first[1], 0.0, THRESHOLD_1E_4);
+    Eigen::Vector3f grad0 = res.second[0];
+    Eigen::Vector3f grad1 = res.second[1];
+    EXPECT_NEAR(grad0[0], 1.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(grad1[0], 1.0, THRESHOLD_1E_4);
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/geometry/elevationmap.h"
+
+#include "cupoch/geometry/graph.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(ElevationMap, Integrate) {
+    geometry::ElevationMap map(1.0, 16);
+    thrust::host_vector<Eigen::Vector3f> points;
+    points.push_back(Eigen::Vector3f(0.5, 0.5, 1.0));
+    points.push_back(Eigen::Vector3f(0.5, 0.5, 0.8));
+    points.push_back(Eigen::Vector3f(100.0, 0.5, 0.0));
+    map.Integrate(utility::device_vector<Eigen::Vector3f>(points), 0.01);
+    auto res1 = map.GetCell(Eigen::Vector2f(0.5, 0.5));
+    EXPECT_TRUE(thrust::get<0>(res1));
+    EXPECT_NEAR(thrust::get<1>(res1).height_, 1.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(thrust::get<1>(res1).variance_, 0.01, THRESHOLD_1E_4);
+    EXPECT_NEAR(thrust::get<1>(res1).mean_height_, 0.9, THRESHOLD_1E_4);
+    EXPECT_FALSE(thrust::get<0>(map.GetCell(Eigen::Vector2f(100.0, 0.5))));
+
+    // Kalman update of a consistent measurement.
+    points.clear();
+    points.push_back(Eigen::Vector3f(0.5, 0.5, 1.1));
+    map.Integrate(utility::device_vector<Eigen::Vector3f>(points), 0.01);
+    auto res2 = map.GetCell(Eigen::Vector2f(0.5, 0.5));
+    EXPECT_NEAR(thrust::get<1>(res2).height_, 1.05, THRESHOLD_1E_4);
+    EXPECT_NEAR(thrust::get<1>(res2).variance_, 0.005, THRESHOLD_1E_4);
+    EXPECT_NEAR(thrust::get<1>(res2).max_height_, 1.1, THRESHOLD_1E_4);
+
+    // A much higher point replaces the elevation and a lower one is ignored.
+    points.clear();
+    points.push_back(Eigen::Vector3f(0.5, 0.5, 3.0));
+    map.Integrate(utility::device_vector<Eigen::Vector3f>(points), 0.01);
+    points.clear();
+    points.push_back(Eigen::Vector3f(0.5, 0.5, 0.0));
+    map.Integrate(utility::device_vector<Eigen::Vector3f>(points), 0.01);
+    auto res3 = map.GetCell(Eigen::Vector2f(0.5, 0.5));
+    EXPECT_NEAR(thrust::get<1>(res3).height_, 3.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(thrust::get<1>(res3).min_height_, 0.0, THRESHOLD_1E_4);
+    EXPECT_EQ(thrust::get<1>(res3).num_points_, 5);
+
+    map.ShiftWindow(Eigen::Vector2i(2, 0));
+    auto res4 = map.GetCell(Eigen::Vector2f(0.5, 0.5));
+    EXPECT_TRUE(thrust::get<0>(res4));
+    EXPECT_NEAR(thrust::get<1>(res4).height_, 3.0, THRESHOLD_1E_4);
+    EXPECT_EQ(map.ExtractPointCloud()->points_.size(), 1);
+    map.ShiftWindow(Eigen::Vector2i(-10, 0));
+    EXPECT_EQ(map.ExtractPointCloud()->points_.size(), 0);
+}
+
+TEST(ElevationMap, TraversabilityGraph) {
+    const int res = 8;
+    geometry::ElevationMap map(1.0, res);
+    thrust::host_vector<Eigen::Vector3f> points;
+    for (int i = 0; i < res; ++i) {
+        for (int j = 0; j < res; ++j) {
+            const float x = i - res / 2 + 0.5;
+            const float y = j - res / 2 + 0.5;
+            points.push_back(Eigen::Vector3f(x, y, (i == 4) ? 1.0 : 0.0));
+        }
+    }
+    map.Integrate(utility::device_vector<Eigen::Vector3f>(points));
+    map.UpdateTraversability();
+    auto flat = thrust::get<1>(map.GetCell(Eigen::Vector2f(-3.5, 0.5)));
+    EXPECT_NEAR(flat.slope_, 0.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(flat.roughness_, 0.0, THRESHOLD_1E_4);
+    EXPECT_NEAR(flat.traversability_, 1.0, THRESHOLD_1E_4);
+    auto edge = thrust::get<1>(map.GetCell(Eigen::Vector2f(-0.5, 0.5)));
+    EXPECT_NEAR(edge.step_height_, 1.0, THRESHOLD_1E_4);
+    EXPECT_EQ(edge.traversability_, 0.0);
+
+    auto graph = map.CreateGraph();
+    EXPECT_EQ(graph->points_.size(), res * res);
+    const Eigen::Vector2f first_node = graph->points_[0];
+    ExpectEQ(first_node, Eigen::Vector2f(-3.5, -3.5));
+    thrust::host_vector<float> weights = graph->GetEdgeWeights();
+    for (size_t i = 0; i < weights.size(); ++i) {
+        EXPECT_TRUE(std::abs(weights[i] - 1.0) < THRESHOLD_1E_4 ||
+                    std::abs(weights[i] - std::sqrt(2.0)) < THRESHOLD_1E_4);
+    }
+    thrust::host_vector<int> labels = graph->ConnectedComponents();
+    EXPECT_EQ(labels[2 * res + 7], labels[0]);
+    EXPECT_EQ(labels[7 * res], labels[6 * res]);
+    EXPECT_NE(labels[7 * res], labels[0]);
+    EXPECT_EQ(labels[4 * res], 4 * res);
+}
@@ -102,4 +102,37 @@ TEST(Graph, DijkstraPath) {
     EXPECT_EQ((*res)[2].shortest_distance_, 2.0);
     EXPECT_EQ((*res)[3].shortest_distance_, 2.0);
     EXPECT_EQ((*res)[4].shortest_distance_, 3.0);
-}
\ No newline at end of file
+}
+
+TEST(Graph, MinimumSpanningTree) {
+    geometry::Graph<3> gp;
+    thrust::host_vector<Eigen::Vector3f> points;
+    points.push_back({0.0, 0.0, 0.0});
+    points.push_back({1.0, 0.0, 0.0});
+    points.push_back({0.0, 1.0, 0.0});
+    points.push_back({1.0, 1.0, 0.0});
+    points.push_back({2.0, 2.0, 0.0});
+    points.push_back({5.0, 5.0, 0.0});
+    points.push_back({6.0, 5.0, 0.0});
+    gp.SetPoints(points);
+    gp.AddEdge({0, 1});
+    gp.AddEdge({0, 2}, 2.0);
+    gp.AddEdge({1, 3});
+    gp.AddEdge({2, 3});
+    gp.AddEdge({3, 4});
+    gp.AddEdge({5, 6});
+
+    auto mst = gp.MinimumSpanningTree();
+    EXPECT_TRUE(mst->IsConstructed());
+    EXPECT_EQ(mst->lines_.size(), 10);
+    thrust::host_vector<float> weights = mst->GetEdgeWeights();
+    float total = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i) total += weights[i];
+    EXPECT_EQ(total, 10.0);
+
+    thrust::host_vector<int> labels = mst->ConnectedComponents();
+    EXPECT_EQ(labels.size(), 7);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(labels[i], 0);
+    EXPECT_EQ(labels[5], 5);
+    EXPECT_EQ(labels[6], 5);
+}
@@ -131,4 +131,36 @@ TEST(KDTreeFlann, SearchRadius) {
     thrust::sort(distance2.begin(), distance2.end());
     ExpectEQ(ref_indices, indices);
     ExpectEQ(ref_distance2, distance2);
-}
\ No newline at end of file
+}
+
+TEST(KDTreeFlann, ReorderQueries) {
+    int size = 1000;
+
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    thrust::host_vector<Eigen::Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    geometry::KDTreeFlann kdtree(pc);
+    int knn = 5;
+    utility::device_vector<int> indices;
+    utility::device_vector<float> distance2;
+    kdtree.reorder_queries_threshold_ = std::numeric_limits<size_t>::max();
+    kdtree.SearchKNN(pc.points_, knn, indices, distance2);
+    thrust::host_vector<int> ref_indices = indices;
+
+    kdtree.reorder_queries_threshold_ = 0;
+    kdtree.SearchKNN(pc.points_, knn, indices, distance2);
+    thrust::host_vector<int> reordered_indices = indices;
+    thrust::host_vector<float> reordered_distance2 = distance2;
+    EXPECT_EQ(reordered_indices.size(), size * knn);
+    for (int i = 0; i < size; ++i) {
+        EXPECT_EQ(reordered_indices[i * knn], i);
+        EXPECT_NEAR(reordered_distance2[i * knn], 0.0, THRESHOLD_1E_4);
+    }
+    ExpectEQ(ref_indices, reordered_indices);
+}
@@ -20,6 +20,8 @@
 **/
 #include "cupoch/geometry/occupancygrid.h"
 
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/image.h"
 #include "tests/test_utility/unit_test.h"
 
 using namespace Eigen;
@@ -84,9 +86,119 @@ TEST(OccupancyGrid, Insert) {
     EXPECT_FALSE(thrust::get<0>(res5));
 }
 
+TEST(OccupancyGrid, InsertOverlappedRays) {
+    auto occupancy_grid = std::make_shared<geometry::OccupancyGrid>();
+    occupancy_grid->origin_ = Eigen::Vector3f(-0.5, -0.5, 0);
+    occupancy_grid->voxel_size_ = 1.0;
+    utility::pinned_host_vector<Eigen::Vector3f> host_points;
+    for (int i = 0; i < 100; ++i) {
+        host_points.push_back({0.0, 0.0, 3.5});
+    }
+    host_points.push_back({0.0, 0.0, 1.5});
+    occupancy_grid->Insert(host_points, Eigen::Vector3f::Zero());
+    EXPECT_EQ(occupancy_grid->ExtractKnownVoxels()->size(), 4);
+    EXPECT_EQ(occupancy_grid->ExtractOccupiedVoxels()->size(), 2);
+    auto res1 = occupancy_grid->GetVoxel(Eigen::Vector3f(0.0, 0.0, 0.5));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res1).prob_log_,
+                    occupancy_grid->prob_miss_log_);
+    auto res2 = occupancy_grid->GetVoxel(Eigen::Vector3f(0.0, 0.0, 1.5));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res2).prob_log_,
+                    occupancy_grid->prob_hit_log_);
+    auto res3 = occupancy_grid->GetVoxel(Eigen::Vector3f(0.0, 0.0, 3.5));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res3).prob_log_,
+                    occupancy_grid->prob_hit_log_);
+}
+
 TEST(OccupancyGrid, SetFreeArea) {
     auto occupancy_grid = std::make_shared<geometry::OccupancyGrid>();
     occupancy_grid->SetFreeArea(Eigen::Vector3f(0, 0, 0), Eigen::Vector3f(0.1, 0.1, 0.1));
     auto res = occupancy_grid->ExtractFreeVoxels();
     EXPECT_EQ(res->size(), 27);
-}
\ No newline at end of file
+
+    auto tracked = std::make_shared<geometry::OccupancyGrid>(1.0, 64);
+    const int h_res = tracked->resolution_ / 2;
+    tracked->track_changed_voxels_ = true;
+    tracked->AddVoxel(Eigen::Vector3i(h_res + 1, h_res, h_res), true);
+    tracked->changed_voxels_.clear();
+    const Eigen::Vector3f p(1.5, 0.5, 0.5);
+    tracked->SetFreeArea(p, p);
+    EXPECT_TRUE(tracked->IsOccupied(p));
+    EXPECT_EQ(tracked->changed_voxels_.size(), 0);
+    tracked->SetFreeArea(p, p);
+    tracked->SetFreeArea(p, p);
+    EXPECT_FALSE(tracked->IsOccupied(p));
+    EXPECT_EQ(tracked->changed_voxels_.size(), 1);
+    Eigen::Vector3i changed = tracked->changed_voxels_[0];
+    EXPECT_EQ(changed, Eigen::Vector3i(h_res + 1, h_res, h_res));
+}
+
+TEST(OccupancyGrid, ShiftWindow) {
+    auto occupancy_grid = std::make_shared<geometry::OccupancyGrid>(1.0);
+    int h_res = 512 / 2;
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res + 1, h_res, h_res), true);
+    occupancy_grid->AddVoxel(Eigen::Vector3i(0, h_res, h_res), true);
+    occupancy_grid->ShiftWindow(Eigen::Vector3i(1, 0, 0));
+    ExpectEQ(occupancy_grid->origin_, Eigen::Vector3f(1.0, 0.0, 0.0));
+    EXPECT_TRUE(occupancy_grid->IsOccupied(Eigen::Vector3f(1.5, 0.0, 0.0)));
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(256.5, 0.0, 0.0)));
+    auto voxels = occupancy_grid->ExtractOccupiedVoxels();
+    EXPECT_EQ(voxels->size(), 1);
+    geometry::OccupancyVoxel v = (*voxels)[0];
+    EXPECT_EQ(v.grid_index_, Eigen::Vector3ui16::Constant(h_res));
+
+    occupancy_grid->Recenter(Eigen::Vector3f(-3.2, 0.0, 0.0));
+    ExpectEQ(occupancy_grid->origin_, Eigen::Vector3f(-3.0, 0.0, 0.0));
+    EXPECT_TRUE(occupancy_grid->IsOccupied(Eigen::Vector3f(1.5, 0.0, 0.0)));
+    auto res = occupancy_grid->GetVoxel(Eigen::Vector3f(1.5, 0.0, 0.0));
+    EXPECT_EQ(thrust::get<1>(res).grid_index_,
+              Eigen::Vector3ui16(h_res + 4, h_res, h_res));
+}
+
+TEST(OccupancyGrid, Decay) {
+    auto occupancy_grid = std::make_shared<geometry::OccupancyGrid>(1.0, 64);
+    const int h_res = occupancy_grid->resolution_ / 2;
+    occupancy_grid->decay_rate_ = std::log(2.0);
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res + 1, h_res, h_res), true);
+    occupancy_grid->Decay(0.0);
+    EXPECT_EQ(occupancy_grid->NumActiveBlocks(), 0);
+    occupancy_grid->Decay(1.0);
+    EXPECT_EQ(occupancy_grid->NumActiveBlocks(), 1);
+    auto res = occupancy_grid->GetVoxel(Eigen::Vector3f(1.5, 0.5, 0.5));
+    EXPECT_TRUE(thrust::get<0>(res));
+    EXPECT_NEAR(thrust::get<1>(res).prob_log_,
+                0.5 * occupancy_grid->prob_hit_log_, THRESHOLD_1E_4);
+
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res - 20, h_res, h_res), false);
+    EXPECT_EQ(occupancy_grid->NumActiveBlocks(), 2);
+    occupancy_grid->Decay(4.0);
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(1.5, 0.5, 0.5)));
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(-19.5, 0.5, 0.5)));
+    EXPECT_EQ(occupancy_grid->NumActiveBlocks(), 0);
+}
+
+TEST(OccupancyGrid, ClearVisibleVoxels) {
+    auto occupancy_grid = std::make_shared<geometry::OccupancyGrid>(1.0, 64);
+    const int h_res = occupancy_grid->resolution_ / 2;
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res, h_res, h_res + 5), true);
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res, h_res, h_res + 20), true);
+
+    thrust::host_vector<float> depth_values(9, 10.0);
+    thrust::host_vector<uint8_t> data(9 * sizeof(float));
+    memcpy(data.data(), depth_values.data(), data.size());
+    geometry::Image depth;
+    depth.Prepare(3, 3, 1, 4);
+    depth.SetData(data);
+    camera::PinholeCameraIntrinsic intrinsic(3, 3, 1.0, 1.0, 1.5, 1.5);
+
+    occupancy_grid->ClearVisibleVoxels(depth, intrinsic,
+                                       Eigen::Matrix4f::Identity());
+    auto res1 = occupancy_grid->GetVoxel(Eigen::Vector3f(0.5, 0.5, 5.5));
+    EXPECT_NEAR(thrust::get<1>(res1).prob_log_,
+                occupancy_grid->prob_hit_log_ + occupancy_grid->prob_miss_log_,
+                THRESHOLD_1E_4);
+    // The voxel behind the measured depth is kept.
+    auto res2 = occupancy_grid->GetVoxel(Eigen::Vector3f(0.5, 0.5, 20.5));
+    EXPECT_NEAR(thrust::get<1>(res2).prob_log_, occupancy_grid->prob_hit_log_,
+                THRESHOLD_1E_4);
+    EXPECT_EQ(occupancy_grid->NumActiveBlocks(), 2);
+}
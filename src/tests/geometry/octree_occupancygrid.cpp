@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+**/
+#include "cupoch/geometry/octree_occupancygrid.h"
+
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(OctreeOccupancyGrid, Prune) {
+    auto octree = std::make_shared<geometry::OctreeOccupancyGrid>(1.0, 4);
+    const int h_res = octree->GetResolution() / 2;
+    EXPECT_TRUE(octree->IsEmpty());
+    thrust::host_vector<Eigen::Vector3i> h_voxels;
+    for (int i = 0; i < 8; ++i) {
+        h_voxels.push_back(Eigen::Vector3i(h_res + (i & 1),
+                                           h_res + ((i >> 1) & 1),
+                                           h_res + ((i >> 2) & 1)));
+    }
+    utility::device_vector<Eigen::Vector3i> voxels = h_voxels;
+    octree->AddVoxels(voxels, true);
+    EXPECT_EQ(octree->NumLeaves(), 8);
+    octree->Prune();
+    EXPECT_EQ(octree->NumLeaves(), 1);
+    EXPECT_TRUE(octree->IsOccupied(Eigen::Vector3f(0.5, 1.5, 0.5)));
+    EXPECT_TRUE(octree->IsUnknown(Eigen::Vector3f(2.5, 0.5, 0.5)));
+    EXPECT_EQ(octree->ExtractOccupiedVoxels()->size(), 8);
+    EXPECT_EQ(octree->ExtractOccupiedVoxels(2)->size(), 1);
+
+    octree->AddVoxel(Eigen::Vector3i(h_res, h_res, h_res), false);
+    EXPECT_EQ(octree->NumLeaves(), 8);
+    auto res = octree->GetVoxel(Eigen::Vector3f(0.5, 0.5, 0.5));
+    EXPECT_TRUE(thrust::get<0>(res));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res).prob_log_,
+                    octree->prob_hit_log_ + octree->prob_miss_log_);
+    auto coarse = octree->GetVoxel(Eigen::Vector3f(0.5, 0.5, 0.5), 3);
+    EXPECT_TRUE(thrust::get<0>(coarse));
+    EXPECT_FLOAT_EQ(thrust::get<1>(coarse).prob_log_, octree->prob_hit_log_);
+    EXPECT_TRUE(octree->IsUnknown(Eigen::Vector3f(-0.5, 0.5, 0.5)));
+    auto other = octree->GetVoxel(Eigen::Vector3f(-0.5, 0.5, 0.5), 3);
+    EXPECT_FALSE(thrust::get<0>(other));
+    auto root = octree->GetVoxel(Eigen::Vector3f(7.5, 7.5, 7.5), 0);
+    EXPECT_FLOAT_EQ(thrust::get<1>(root).prob_log_, octree->prob_hit_log_);
+}
+
+TEST(OctreeOccupancyGrid, InvalidMaxDepth) {
+    geometry::OctreeOccupancyGrid octree(1.0, 20);
+    EXPECT_EQ(octree.max_depth_, 16);
+    EXPECT_EQ(octree.GetResolution(), 65536);
+}
+
+TEST(OctreeOccupancyGrid, PruneIncompleteSiblings) {
+    auto octree = std::make_shared<geometry::OctreeOccupancyGrid>(1.0, 4);
+    const int h_res = octree->GetResolution() / 2;
+    thrust::host_vector<Eigen::Vector3i> h_voxels;
+    for (int i = 0; i < 7; ++i) {
+        h_voxels.push_back(Eigen::Vector3i(h_res + ((i >> 2) & 1),
+                                           h_res + ((i >> 1) & 1),
+                                           h_res + (i & 1)));
+    }
+    // The first child of the next parent follows the seventh sibling.
+    h_voxels.push_back(Eigen::Vector3i(h_res, h_res, h_res + 2));
+    utility::device_vector<Eigen::Vector3i> voxels = h_voxels;
+    octree->AddVoxels(voxels, true);
+    EXPECT_EQ(octree->NumLeaves(), 8);
+    octree->Prune();
+    EXPECT_EQ(octree->NumLeaves(), 8);
+    EXPECT_TRUE(octree->IsUnknown(Eigen::Vector3f(1.5, 1.5, 1.5)));
+    EXPECT_EQ(octree->ExtractOccupiedVoxels()->size(), 8);
+
+    utility::device_vector<Eigen::Vector3i> outside(
+            1, Eigen::Vector3i(octree->GetResolution(), h_res, h_res));
+    octree->AddVoxels(outside, true);
+    EXPECT_EQ(octree->NumLeaves(), 8);
+}
+
+TEST(OctreeOccupancyGrid, BinaryStream) {
+    auto octree = std::make_shared<geometry::OctreeOccupancyGrid>(
+            0.5, 6, Eigen::Vector3f(1.0, 2.0, 3.0));
+    utility::pinned_host_vector<Eigen::Vector3f> host_points;
+    host_points.push_back({1.0, 2.0, 5.1});
+    host_points.push_back({2.1, 2.0, 3.0});
+    octree->Insert(host_points, Eigen::Vector3f(1.0, 2.0, 3.0));
+    const auto n_occupied = octree->ExtractOccupiedVoxels()->size();
+    const auto n_free = octree->ExtractFreeVoxels()->size();
+    EXPECT_EQ(n_occupied, 2);
+
+    const auto stream = octree->ExportBinaryStream();
+    geometry::OctreeOccupancyGrid restored;
+    EXPECT_TRUE(restored.ImportBinaryStream(stream));
+    EXPECT_EQ(restored.max_depth_, 6);
+    EXPECT_FLOAT_EQ(restored.voxel_size_, 0.5);
+    ExpectEQ(restored.origin_, octree->origin_);
+    EXPECT_EQ(restored.NumLeaves(), octree->NumLeaves());
+    EXPECT_EQ(restored.ExtractOccupiedVoxels()->size(), n_occupied);
+    EXPECT_EQ(restored.ExtractFreeVoxels()->size(), n_free);
+    EXPECT_TRUE(restored.IsOccupied(Eigen::Vector3f(1.0, 2.0, 5.1)));
+
+    std::vector<uint8_t> broken(stream.begin(), stream.begin() + 3);
+    EXPECT_FALSE(restored.ImportBinaryStream(broken));
+}
@@ -24,6 +24,8 @@
 #include <thrust/unique.h>
 
 #include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/cluster_statistics.h"
+#include "cupoch/geometry/neighbor_list.h"
 #include "tests/test_utility/unit_test.h"
 
 using namespace Eigen;
@@ -347,6 +349,39 @@ TEST(PointCloud, SelectByIndex) {
     ExpectEQ(ref, output_pt);
 }
 
+TEST(PointCloud, SortByMortonCode) {
+    size_t size = 100;
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(1000.0, 1000.0, 1000.0);
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    thrust::host_vector<Vector3f> colors(size);
+    Rand(colors, Vector3f::Zero(), Vector3f::Ones(), 1);
+    pc.SetPoints(points);
+    pc.SetColors(colors);
+
+    thrust::host_vector<size_t> indices = pc.SortByMortonCode();
+    auto sorted_points = pc.GetPoints();
+    auto sorted_colors = pc.GetColors();
+    EXPECT_EQ(sorted_points.size(), size);
+    EXPECT_EQ(sorted_colors.size(), size);
+
+    const Vector3f min_bound = pc.GetMinBound();
+    const float scale = (MORTON_AXIS_CELLS - 1) /
+                        (pc.GetMaxBound() - min_bound).maxCoeff();
+    for (size_t i = 0; i < size; ++i) {
+        ExpectEQ(sorted_points[i], points[indices[i]]);
+        ExpectEQ(sorted_colors[i], colors[indices[i]]);
+        if (i > 0) {
+            EXPECT_LE(MortonCodeOf(sorted_points[i - 1], min_bound, scale),
+                      MortonCodeOf(sorted_points[i], min_bound, scale));
+        }
+    }
+}
+
 TEST(PointCloud, VoxelDownSample) {
     thrust::host_vector<Vector3f> ref_points;
     ref_points.push_back(Vector3f(19.607843, 454.901961, 62.745098));
@@ -491,6 +526,80 @@ TEST(PointCloud, UniformDownSample) {
     ExpectEQ(ref, output_pc->GetPoints());
 }
 
+TEST(PointCloud, OrganizedDownSample) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    thrust::host_vector<Vector3f> points;
+    points.push_back(Vector3f(0.0, 0.0, 1.0));
+    points.push_back(Vector3f(0.1, 0.0, 1.0));
+    points.push_back(Vector3f(1.0, 0.0, 1.0));
+    points.push_back(Vector3f(nan, nan, nan));
+    points.push_back(Vector3f(0.0, 0.1, 1.0));
+    points.push_back(Vector3f(0.1, 0.1, 1.0));
+    points.push_back(Vector3f(5.0, 5.0, 5.0));
+    points.push_back(Vector3f(nan, nan, nan));
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    thrust::host_vector<Vector3f> ref;
+    ref.push_back(Vector3f(0.05, 0.05, 1.0));
+    ref.push_back(Vector3f(1.0, 0.0, 1.0));
+
+    auto output_pc = pc.OrganizedDownSample(4, 2, 0.5);
+    ExpectEQ(ref, output_pc->GetPoints());
+    EXPECT_FALSE(output_pc->HasNormals());
+}
+
+TEST(PointCloud, FarthestPointDownSample) {
+    thrust::host_vector<Vector3f> points;
+    points.push_back(Vector3f(0.0, 0.0, 0.0));
+    points.push_back(Vector3f(0.1, 0.0, 0.0));
+    points.push_back(Vector3f(10.0, 0.0, 0.0));
+    points.push_back(Vector3f(9.9, 0.1, 0.0));
+    points.push_back(Vector3f(5.0, 5.0, 0.0));
+    points.push_back(Vector3f(5.0, 4.9, 0.0));
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    thrust::host_vector<Vector3f> ref;
+    ref.push_back(Vector3f(0.0, 0.0, 0.0));
+    ref.push_back(Vector3f(10.0, 0.0, 0.0));
+    ref.push_back(Vector3f(5.0, 5.0, 0.0));
+
+    auto output_pc = pc.FarthestPointDownSample(3);
+    ExpectEQ(ref, output_pc->GetPoints());
+    EXPECT_EQ(points.size(), pc.FarthestPointDownSample(10)->points_.size());
+}
+
+TEST(PointCloud, PoissonDiskDownSample) {
+    size_t size = 2000;
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    const float radius = 2.0;
+    auto output_pc = pc.PoissonDiskDownSample(radius);
+    thrust::host_vector<Vector3f> sampled = output_pc->GetPoints();
+    EXPECT_GT(sampled.size(), 0);
+    EXPECT_LT(sampled.size(), size);
+    for (size_t i = 0; i < sampled.size(); ++i) {
+        for (size_t j = i + 1; j < sampled.size(); ++j) {
+            EXPECT_GE((sampled[i] - sampled[j]).norm(), radius);
+        }
+    }
+    for (size_t i = 0; i < size; ++i) {
+        float min_dist = std::numeric_limits<float>::max();
+        for (size_t j = 0; j < sampled.size(); ++j) {
+            min_dist = std::min(min_dist, (points[i] - sampled[j]).norm());
+        }
+        EXPECT_LT(min_dist, radius);
+    }
+}
+
 TEST(PointCloud, CropPointCloud) {
     size_t size = 100;
     geometry::PointCloud pc;
@@ -575,6 +684,58 @@ TEST(PointCloud, EstimateNormals) {
     ExpectEQ(ref, normals);
 }
 
+TEST(PointCloud, EstimateNormalsWithCurvatures) {
+    thrust::host_vector<Vector3f> points;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            points.push_back(Vector3f(i * 0.1, j * 0.1, 0.0));
+        }
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    auto res = pc.EstimateNormalsWithCurvatures(
+            geometry::KDTreeSearchParamRadius(0.25, 20));
+    thrust::host_vector<float> curvatures = std::get<0>(res);
+    thrust::host_vector<float> planarities = std::get<1>(res);
+    EXPECT_EQ(points.size(), curvatures.size());
+    EXPECT_EQ(points.size(), planarities.size());
+    thrust::host_vector<Vector3f> normals = pc.GetNormals();
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_NEAR(1.0, std::abs(normals[i](2)), unit_test::THRESHOLD_1E_4);
+        EXPECT_NEAR(0.0, curvatures[i], unit_test::THRESHOLD_1E_4);
+        EXPECT_GT(planarities[i], 0.0);
+    }
+
+    // Re-estimate only the appended points.
+    pc.OrientNormalsToAlignWithDirection(Vector3f(0.0, 0.0, -1.0));
+    size_t n_old = points.size();
+    for (int i = 0; i < 10; ++i) {
+        points.push_back(Vector3f(i * 0.1, 1.0, 0.0));
+    }
+    pc.SetPoints(points);
+    pc.EstimateNormals(geometry::KDTreeSearchParamRadius(0.25, 20), n_old);
+    normals = pc.GetNormals();
+    EXPECT_EQ(pc.points_.size(), normals.size());
+    for (size_t i = 0; i < n_old; ++i) {
+        ExpectEQ(Vector3f(0.0, 0.0, -1.0), normals[i]);
+    }
+    for (size_t i = n_old; i < normals.size(); ++i) {
+        EXPECT_NEAR(1.0, std::abs(normals[i](2)), unit_test::THRESHOLD_1E_4);
+    }
+
+    // Points skipped by start_index without a normal get the default one.
+    geometry::PointCloud skipped;
+    skipped.SetPoints(points);
+    skipped.EstimateNormals(geometry::KDTreeSearchParamRadius(0.25, 20),
+                            n_old);
+    normals = skipped.GetNormals();
+    EXPECT_EQ(skipped.points_.size(), normals.size());
+    for (size_t i = 0; i < n_old; ++i) {
+        ExpectEQ(Vector3f(0.0, 0.0, 1.0), normals[i]);
+    }
+}
+
 TEST(PointCloud, OrientNormalsToAlignWithDirection) {
     thrust::host_vector<Vector3f> ref;
     ref.push_back(Vector3f(0.282003, 0.866394, 0.412111));
@@ -635,6 +796,161 @@ TEST(PointCloud, OrientNormalsToAlignWithDirection) {
     ExpectEQ(ref, pc.GetNormals());
 }
 
+TEST(PointCloud, OrientNormalsConsistentTangentPlane) {
+    thrust::host_vector<Vector3f> points;
+    thrust::host_vector<Vector3f> normals;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            points.push_back(Vector3f(i * 0.1, j * 0.1, 0.0));
+            normals.push_back(((i + j) % 2 == 0) ? Vector3f(0.0, 0.0, 1.0)
+                                                 : Vector3f(0.0, 0.0, -1.0));
+        }
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+
+    EXPECT_TRUE(pc.OrientNormalsConsistentTangentPlane(8));
+    thrust::host_vector<Vector3f> oriented = pc.GetNormals();
+    for (size_t i = 1; i < oriented.size(); ++i) {
+        ExpectEQ(oriented[0], oriented[i]);
+    }
+}
+
+TEST(PointCloud, SmoothingWithNeighborList) {
+    thrust::host_vector<Vector3f> points;
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            points.push_back(Vector3f(i * 0.05, j * 0.05,
+                                      ((i * 7 + j * 13) % 5 - 2) * 0.002));
+        }
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.EstimateNormals(geometry::KDTreeSearchParamRadius(0.15, 30));
+    pc.OrientNormalsToAlignWithDirection(Vector3f(0.0, 0.0, 1.0));
+
+    auto neighbors = geometry::NeighborList::CreateFromPointCloud(
+            pc, geometry::KDTreeSearchParamRadius(0.15, 30));
+    EXPECT_EQ(points.size(), neighbors->Size());
+    EXPECT_LE(neighbors->NumNeighbors(), points.size() * 30);
+
+    auto max_abs_z = [](const geometry::PointCloud &cloud) {
+        thrust::host_vector<Vector3f> pts = cloud.GetPoints();
+        float max_z = 0.0;
+        for (size_t i = 0; i < pts.size(); ++i) {
+            max_z = std::max(max_z, std::abs(pts[i](2)));
+        }
+        return max_z;
+    };
+
+    auto mls = pc.SmoothMLS(*neighbors, 0.15, 1);
+    EXPECT_EQ(points.size(), mls->points_.size());
+    EXPECT_LT(max_abs_z(*mls), max_abs_z(pc));
+
+    auto upsampled = pc.SmoothMLS(*neighbors, 0.15, 2, 0.02, 0.01);
+    EXPECT_GT(upsampled->points_.size(), points.size());
+    EXPECT_TRUE(upsampled->HasNormals());
+
+    auto normals = pc.BilateralFilterNormals(*neighbors, 0.1, 0.3, 3);
+    thrust::host_vector<Vector3f> filtered = normals->GetNormals();
+    for (size_t i = 0; i < filtered.size(); ++i) {
+        EXPECT_NEAR(1.0, filtered[i].norm(), unit_test::THRESHOLD_1E_4);
+        EXPECT_GT(filtered[i](2), 0.9);
+    }
+
+    auto denoised = normals->BilateralFilter(*neighbors, 0.1, 0.01, 3);
+    EXPECT_EQ(points.size(), denoised->points_.size());
+    EXPECT_LT(max_abs_z(*denoised), max_abs_z(pc));
+}
+
+TEST(PointCloud, ClusterEuclidean) {
+    thrust::host_vector<Vector3f> points;
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            points.push_back(Vector3f(i * 0.1, j * 0.1, 0.0));
+        }
+    }
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            points.push_back(Vector3f(10.0 + i * 0.1, j * 0.1, 0.0));
+        }
+    }
+    points.push_back(Vector3f(5.0, 5.0, 5.0));
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    auto res = pc.ClusterEuclidean(0.15, 2);
+    thrust::host_vector<int> labels = std::get<0>(res);
+    auto stats = std::get<1>(res);
+    EXPECT_EQ(points.size(), labels.size());
+    for (size_t i = 0; i < 25; ++i) {
+        EXPECT_EQ(0, labels[i]);
+        EXPECT_EQ(1, labels[i + 25]);
+    }
+    EXPECT_EQ(-1, labels[50]);
+
+    EXPECT_EQ(2, stats->NumClusters());
+    thrust::host_vector<int> counts = stats->counts_;
+    EXPECT_EQ(25, counts[0]);
+    EXPECT_EQ(25, counts[1]);
+    thrust::host_vector<Vector3f> centroids = stats->centroids_;
+    ExpectEQ(Vector3f(0.2, 0.2, 0.0), centroids[0]);
+    ExpectEQ(Vector3f(10.2, 0.2, 0.0), centroids[1]);
+    auto aabbs = stats->GetAxisAlignedBoundingBoxes();
+    ExpectEQ(Vector3f(0.0, 0.0, 0.0), aabbs[0].min_bound_);
+    ExpectEQ(Vector3f(0.4, 0.4, 0.0), aabbs[0].max_bound_);
+    ExpectEQ(Vector3f(10.0, 0.0, 0.0), aabbs[1].min_bound_);
+    ExpectEQ(Vector3f(10.4, 0.4, 0.0), aabbs[1].max_bound_);
+    auto obbs = stats->GetOrientedBoundingBoxes();
+    ExpectEQ(Vector3f(0.2, 0.2, 0.0), obbs[0].center_);
+    EXPECT_NEAR(0.0, obbs[0].Volume(), unit_test::THRESHOLD_1E_4);
+
+    // Labels beyond num_clusters are ignored.
+    auto first = geometry::ClusterStatistics::CreateFromLabels(
+            pc, std::get<0>(res), 1);
+    EXPECT_EQ(1, first->NumClusters());
+    counts = first->counts_;
+    EXPECT_EQ(25, counts[0]);
+}
+
+TEST(PointCloud, ClusterRegionGrowing) {
+    thrust::host_vector<Vector3f> points;
+    thrust::host_vector<Vector3f> normals;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            points.push_back(Vector3f(i * 0.1, j * 0.1, 0.0));
+            normals.push_back(Vector3f(0.0, 0.0, 1.0));
+        }
+    }
+    for (int i = 1; i <= 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            points.push_back(Vector3f(0.0, j * 0.1, i * 0.1));
+            normals.push_back(Vector3f(1.0, 0.0, 0.0));
+        }
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    thrust::host_vector<float> h_curvatures(points.size(), 0.0);
+    h_curvatures[55] = 1.0;
+    utility::device_vector<float> curvatures = h_curvatures;
+
+    auto neighbors = geometry::NeighborList::CreateFromPointCloud(
+            pc, geometry::KDTreeSearchParamRadius(0.15, 30));
+    auto res = pc.ClusterRegionGrowing(*neighbors, curvatures, 0.2, 0.5);
+    thrust::host_vector<int> labels = std::get<0>(res);
+    auto stats = std::get<1>(res);
+    EXPECT_EQ(2, stats->NumClusters());
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(0, labels[i]);
+        EXPECT_EQ(1, labels[i + 100]);
+    }
+    thrust::host_vector<int> counts = stats->counts_;
+    EXPECT_EQ(100, counts[0]);
+    EXPECT_EQ(100, counts[1]);
+}
+
 TEST(PointCloud, SegmentPlaneKnownPlane) {
     // Points sampled from the plane x + y + z + 1 = 0
     thrust::host_vector<Eigen::Vector3f> ref_points;
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+**/
+#include "cupoch/geometry/sparse_occupancygrid.h"
+
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(SparseOccupancyGrid, GetVoxel) {
+    auto occupancy_grid = std::make_shared<geometry::SparseOccupancyGrid>(1.0);
+    size_t h_res = occupancy_grid->resolution_ / 2;
+    EXPECT_TRUE(occupancy_grid->IsEmpty());
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res + 1, h_res, h_res), true);
+    EXPECT_EQ(occupancy_grid->NumBlocks(), 1);
+    auto res1 = occupancy_grid->GetVoxel(Eigen::Vector3f(1.5, 0.0, 0.0));
+    EXPECT_TRUE(thrust::get<0>(res1));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res1).prob_log_,
+                    occupancy_grid->prob_hit_log_);
+    occupancy_grid->AddVoxel(Eigen::Vector3i(h_res + 1, h_res, h_res), false);
+    auto res2 = occupancy_grid->GetVoxel(Eigen::Vector3f(1.5, 0.0, 0.0));
+    EXPECT_TRUE(thrust::get<0>(res2));
+    EXPECT_FLOAT_EQ(thrust::get<1>(res2).prob_log_,
+                    occupancy_grid->prob_hit_log_ +
+                            occupancy_grid->prob_miss_log_);
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(2.5, 0.0, 0.0)));
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(100.0, 0.0, 0.0)));
+}
+
+TEST(SparseOccupancyGrid, Insert) {
+    auto occupancy_grid = std::make_shared<geometry::SparseOccupancyGrid>(
+            1.0, Eigen::Vector3f(-0.5, -0.5, 0));
+    utility::pinned_host_vector<Eigen::Vector3f> host_points;
+    host_points.push_back({0.0, 0.0, 3.5});
+    occupancy_grid->Insert(host_points, Eigen::Vector3f::Zero());
+    EXPECT_EQ(occupancy_grid->ExtractKnownVoxels()->size(), 4);
+    EXPECT_EQ(occupancy_grid->ExtractOccupiedVoxels()->size(), 1);
+    EXPECT_EQ(occupancy_grid->ExtractFreeVoxels()->size(), 3);
+    EXPECT_FALSE(occupancy_grid->IsUnknown(Eigen::Vector3f(0.0, 0.0, 0.5)));
+    EXPECT_FALSE(occupancy_grid->IsOccupied(Eigen::Vector3f(0.0, 0.0, 2.5)));
+    EXPECT_TRUE(occupancy_grid->IsOccupied(Eigen::Vector3f(0.0, 0.0, 3.5)));
+    EXPECT_TRUE(occupancy_grid->IsUnknown(Eigen::Vector3f(0.0, 0.0, 4.5)));
+}
+
+TEST(SparseOccupancyGrid, InsertFarFromOrigin) {
+    auto occupancy_grid = std::make_shared<geometry::SparseOccupancyGrid>(
+            1.0, Eigen::Vector3f(-0.5, -0.5, 0), 1);
+    const Eigen::Vector3f viewpoint(10000.0, -10000.0, 0.0);
+    utility::pinned_host_vector<Eigen::Vector3f> host_points;
+    host_points.push_back(viewpoint + Eigen::Vector3f(0.0, 0.0, 3.5));
+    host_points.push_back(viewpoint + Eigen::Vector3f(0.0, 0.0, -10.5));
+    occupancy_grid->Insert(host_points, viewpoint);
+    EXPECT_EQ(occupancy_grid->ExtractOccupiedVoxels()->size(), 2);
+    EXPECT_EQ(occupancy_grid->ExtractKnownVoxels()->size(), 15);
+    EXPECT_EQ(occupancy_grid->NumBlocks(), 3);
+    EXPECT_GE(occupancy_grid->BlockCapacity(), 3);
+    EXPECT_TRUE(occupancy_grid->IsOccupied(viewpoint +
+                                           Eigen::Vector3f(0.0, 0.0, 3.5)));
+    ExpectEQ(occupancy_grid->GetMinBound(),
+             Eigen::Vector3f(9999.5, -10000.5, -11.0));
+    ExpectEQ(occupancy_grid->GetMaxBound(),
+             Eigen::Vector3f(10000.5, -9999.5, 4.0));
+
+    geometry::SparseOccupancyGrid copied(*occupancy_grid);
+    EXPECT_TRUE(copied.IsOccupied(viewpoint + Eigen::Vector3f(0.0, 0.0, 3.5)));
+    EXPECT_EQ(copied.NumBlocks(), 3);
+
+    geometry::SparseOccupancyGrid assigned(1.0);
+    assigned.AddVoxel(Eigen::Vector3i::Zero(), true);
+    assigned = copied;
+    copied.Clear();
+    EXPECT_TRUE(
+            assigned.IsOccupied(viewpoint + Eigen::Vector3f(0.0, 0.0, 3.5)));
+    EXPECT_EQ(assigned.NumBlocks(), 3);
+}
+
+TEST(SparseOccupancyGrid, AddVoxelsOutOfRange) {
+    auto occupancy_grid = std::make_shared<geometry::SparseOccupancyGrid>(1.0);
+    const int res = occupancy_grid->resolution_;
+    thrust::host_vector<Eigen::Vector3i> h_voxels;
+    h_voxels.push_back(Eigen::Vector3i(-1, 0, 0));
+    h_voxels.push_back(Eigen::Vector3i(0, -9, 0));
+    h_voxels.push_back(Eigen::Vector3i(res, 0, 0));
+    utility::device_vector<Eigen::Vector3i> voxels = h_voxels;
+    occupancy_grid->AddVoxels(voxels, true);
+    EXPECT_TRUE(occupancy_grid->IsEmpty());
+    EXPECT_EQ(occupancy_grid->NumBlocks(), 0);
+
+    h_voxels.push_back(Eigen::Vector3i(res / 2, res / 2, res / 2));
+    voxels = h_voxels;
+    occupancy_grid->AddVoxels(voxels, true);
+    EXPECT_EQ(occupancy_grid->NumBlocks(), 1);
+    EXPECT_TRUE(occupancy_grid->IsOccupied(Eigen::Vector3f(0.5, 0.5, 0.5)));
+    ExpectEQ(occupancy_grid->GetMinBound(), Eigen::Vector3f(0.0, 0.0, 0.0));
+    ExpectEQ(occupancy_grid->GetMaxBound(), Eigen::Vector3f(1.0, 1.0, 1.0));
+}
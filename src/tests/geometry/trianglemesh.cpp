@@ -755,6 +755,35 @@ TEST(TriangleMesh, SamplePointsUniformly) {
     }
 }
 
+TEST(TriangleMesh, SamplePointsPoissonDisk) {
+    auto mesh_empty = geometry::TriangleMesh();
+    EXPECT_THROW(mesh_empty.SamplePointsPoissonDisk(100), std::runtime_error);
+
+    thrust::host_vector<Vector3f> vertices;
+    vertices.push_back(Vector3f(0, 0, 0));
+    vertices.push_back(Vector3f(1, 0, 0));
+    vertices.push_back(Vector3f(0, 1, 0));
+    thrust::host_vector<Vector3i> triangles;
+    triangles.push_back(Vector3i(0, 1, 2));
+
+    auto mesh_simple = geometry::TriangleMesh();
+    mesh_simple.SetVertices(vertices);
+    mesh_simple.SetTriangles(triangles);
+
+    size_t n_points = 100;
+    auto pcd_simple = mesh_simple.SamplePointsPoissonDisk(n_points);
+    EXPECT_TRUE(pcd_simple->points_.size() == n_points);
+    EXPECT_TRUE(pcd_simple->normals_.size() == 0);
+
+    pcd_simple = mesh_simple.SamplePointsPoissonDisk(n_points, 5, true);
+    EXPECT_TRUE(pcd_simple->points_.size() == n_points);
+    EXPECT_TRUE(pcd_simple->normals_.size() == n_points);
+    thrust::host_vector<Vector3f> hn = pcd_simple->GetNormals();
+    for (size_t pidx = 0; pidx < n_points; ++pidx) {
+        ExpectEQ(hn[pidx], Vector3f(0, 0, 1));
+    }
+}
+
 TEST(TriangleMesh, FilterSharpen) {
     auto mesh = std::make_shared<geometry::TriangleMesh>();
     thrust::host_vector<Eigen::Vector3f> vertices;
@@ -895,6 +924,39 @@ TEST(TriangleMesh, FilterSmoothTaubin) {
     ExpectEQ(mesh->GetVertices(), ref2);
 }
 
+TEST(TriangleMesh, SimplifyVertexClustering) {
+    auto mesh = std::make_shared<geometry::TriangleMesh>();
+    thrust::host_vector<Eigen::Vector3f> vertices;
+    vertices.push_back({0, 0, 0});
+    vertices.push_back({0.1, 0, 0});
+    vertices.push_back({1, 0, 0});
+    vertices.push_back({0, 1, 0});
+    thrust::host_vector<Eigen::Vector3i> triangles;
+    triangles.push_back({0, 2, 3});
+    triangles.push_back({1, 2, 3});
+    mesh->SetVertices(vertices);
+    mesh->SetTriangles(triangles);
+
+    thrust::host_vector<Eigen::Vector3f> ref_vertices;
+    ref_vertices.push_back({0.05, 0, 0});
+    ref_vertices.push_back({0, 1, 0});
+    ref_vertices.push_back({1, 0, 0});
+    thrust::host_vector<Eigen::Vector3i> ref_triangles;
+    ref_triangles.push_back({0, 2, 1});
+
+    auto average = mesh->SimplifyVertexClustering(
+            0.5, geometry::MeshBase::SimplificationContraction::Average);
+    ExpectEQ(average->GetVertices(), ref_vertices);
+    ExpectEQ(average->GetTriangles(), ref_triangles);
+
+    // The quadric of coplanar triangles is singular, so the average position
+    // is kept.
+    auto quadric = mesh->SimplifyVertexClustering(
+            0.5, geometry::MeshBase::SimplificationContraction::Quadric);
+    ExpectEQ(quadric->GetVertices(), ref_vertices);
+    ExpectEQ(quadric->GetTriangles(), ref_triangles);
+}
+
 TEST(TriangleMesh, HasVertices) {
     int size = 100;
 
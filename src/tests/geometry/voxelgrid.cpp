@@ -65,4 +65,67 @@ TEST(VoxelGrid, CreateFromPointCloudWithinBounds) {
         Eigen::Vector3f(100.0, 100.0, 100.0));
 
     EXPECT_EQ(voxel_grid->voxels_keys_.size(), 1);
-}
\ No newline at end of file
+}
+
+TEST(VoxelGrid, HashedLookup) {
+    auto voxel_grid = std::make_shared<geometry::VoxelGrid>();
+    voxel_grid->voxel_size_ = 1.0;
+    thrust::host_vector<geometry::Voxel> h_voxels;
+    h_voxels.push_back(geometry::Voxel(Eigen::Vector3i(0, 0, 0)));
+    h_voxels.push_back(geometry::Voxel(Eigen::Vector3i(-1, 2, 0)));
+    h_voxels.push_back(geometry::Voxel(Eigen::Vector3i(3, 0, 1)));
+    utility::device_vector<geometry::Voxel> voxels = h_voxels;
+    voxel_grid->Insert(voxels);
+    EXPECT_EQ(voxel_grid->voxels_keys_.size(), 3);
+
+    thrust::host_vector<Eigen::Vector3i> h_keys;
+    h_keys.push_back(Eigen::Vector3i(3, 0, 1));
+    h_keys.push_back(Eigen::Vector3i(1, 1, 1));
+    utility::device_vector<Eigen::Vector3i> keys = h_keys;
+    thrust::host_vector<bool> contains = voxel_grid->Contains(keys);
+    EXPECT_TRUE(contains[0]);
+    EXPECT_FALSE(contains[1]);
+    thrust::host_vector<int> indices = voxel_grid->Find(keys);
+    EXPECT_GE(indices[0], 0);
+    EXPECT_EQ(indices[1], -1);
+    ExpectEQ(Eigen::Vector3i(voxel_grid->voxels_keys_[indices[0]]),
+             Eigen::Vector3i(3, 0, 1));
+
+    thrust::host_vector<Eigen::Vector3f> queries;
+    queries.push_back(Eigen::Vector3f(-0.5, 2.5, 0.5));
+    queries.push_back(Eigen::Vector3f(0.5, 2.5, 0.5));
+    auto included = voxel_grid->CheckIfIncluded(queries);
+    EXPECT_TRUE(included[0]);
+    EXPECT_FALSE(included[1]);
+
+    geometry::VoxelGrid other;
+    other.voxel_size_ = 1.0;
+    other.AddVoxel(geometry::Voxel(Eigen::Vector3i(0, 0, 0),
+                                   Eigen::Vector3f(0.0, 0.0, 0.0)));
+    other.AddVoxel(geometry::Voxel(Eigen::Vector3i(1, 1, 1)));
+    *voxel_grid += other;
+    EXPECT_EQ(voxel_grid->voxels_keys_.size(), 4);
+    contains = voxel_grid->Contains(keys);
+    EXPECT_TRUE(contains[1]);
+    utility::device_vector<Eigen::Vector3i> origin_key(
+            1, Eigen::Vector3i(0, 0, 0));
+    const int origin_idx = voxel_grid->Find(origin_key)[0];
+    geometry::Voxel merged = voxel_grid->voxels_values_[origin_idx];
+    ExpectEQ(merged.color_, Eigen::Vector3f(0.5, 0.5, 0.5));
+
+    voxel_grid->Erase(keys);
+    EXPECT_EQ(voxel_grid->voxels_keys_.size(), 2);
+    contains = voxel_grid->Contains(keys);
+    EXPECT_FALSE(contains[0]);
+    EXPECT_FALSE(contains[1]);
+    EXPECT_TRUE(voxel_grid->Contains(origin_key)[0]);
+
+    // Direct edits of the keys keeping their number need ResetIndex.
+    const int idx = voxel_grid->Find(origin_key)[0];
+    const Eigen::Vector3i moved(5, 5, 5);
+    voxel_grid->voxels_keys_[idx] = moved;
+    voxel_grid->ResetIndex();
+    utility::device_vector<Eigen::Vector3i> moved_key(1, moved);
+    EXPECT_EQ(voxel_grid->Find(moved_key)[0], idx);
+    EXPECT_FALSE(voxel_grid->Contains(origin_key)[0]);
+}
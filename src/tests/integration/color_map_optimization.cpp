@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/integration/color_map_optimization.h"
+
+#include "cupoch/utility/eigen.h"
+#include "tests/test_utility/rgbd.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace cupoch;
+using namespace unit_test;
+
+namespace {
+
+const int width = 64;
+const int height = 48;
+const float focal = 50.0;
+const float cx = 31.5;
+const float cy = 23.5;
+
+/// Frame of a textured plane at depth 1 seen from the identity pose.
+geometry::RGBDImage CreateTexturedPlaneImage() {
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    thrust::host_vector<uint8_t> color_data(width * height * 3);
+    for (int v = 0; v < height; ++v) {
+        for (int u = 0; u < width; ++u) {
+            const float x = (u - cx) / focal;
+            const float y = (v - cy) / focal;
+            const float value = 0.5 + 0.2 * std::sin(2.0 * M_PI * x / 0.2) +
+                                0.2 * std::sin(2.0 * M_PI * y / 0.15);
+            for (int ch = 0; ch < 3; ++ch) {
+                color_data[(v * width + u) * 3 + ch] = value * 255.0;
+            }
+        }
+    }
+    rgbd.color_.SetData(color_data);
+    return rgbd;
+}
+
+/// Grid of triangles on the plane at depth 1.
+geometry::TriangleMesh CreatePlaneMesh() {
+    const float step = 0.02;
+    const int nx = 41;
+    const int ny = 31;
+    thrust::host_vector<Eigen::Vector3f> vertices;
+    thrust::host_vector<Eigen::Vector3i> triangles;
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            vertices.push_back(
+                    Eigen::Vector3f(-0.4 + i * step, -0.3 + j * step, 1.0));
+            if (i + 1 < nx && j + 1 < ny) {
+                const int k = j * nx + i;
+                triangles.push_back(Eigen::Vector3i(k, k + 1, k + nx));
+                triangles.push_back(Eigen::Vector3i(k + 1, k + nx + 1, k + nx));
+            }
+        }
+    }
+    geometry::TriangleMesh mesh;
+    mesh.SetVertices(vertices);
+    mesh.SetTriangles(triangles);
+    return mesh;
+}
+
+}  // namespace
+
+TEST(ColorMapOptimization, RigidOptimization) {
+    geometry::TriangleMesh mesh = CreatePlaneMesh();
+    std::vector<geometry::RGBDImage> images(2, CreateTexturedPlaneImage());
+    camera::PinholeCameraIntrinsic intrinsic(width, height, focal, focal, cx,
+                                             cy);
+    thrust::host_vector<Eigen::Matrix4f> extrinsics(
+            2, Eigen::Matrix4f::Identity());
+    extrinsics[1](0, 3) = 0.01;
+
+    integration::ColorMapOptimizationOption option;
+    option.maximum_iteration_ = 20;
+    integration::ColorMapOptimization(mesh, images, intrinsic, extrinsics,
+                                      option);
+
+    // Both images see the same texture, so the relative pose goes back to
+    // the identity.
+    const Eigen::Matrix4f relative =
+            extrinsics[1] * utility::InverseTransform(extrinsics[0]);
+    EXPECT_LT(relative.block<3, 1>(0, 3).norm(), 0.002);
+
+    EXPECT_EQ(mesh.vertex_colors_.size(), mesh.vertices_.size());
+    EXPECT_FALSE(mesh.texture_.IsEmpty());
+    EXPECT_EQ(mesh.triangle_uvs_.size(), mesh.triangles_.size() * 3);
+    thrust::host_vector<Eigen::Vector2f> uvs = mesh.triangle_uvs_;
+    for (size_t i = 0; i < uvs.size(); ++i) {
+        EXPECT_GE(uvs[i].minCoeff(), 0.0);
+        EXPECT_LE(uvs[i].maxCoeff(), 1.0);
+    }
+}
+
+TEST(ColorMapOptimization, NonRigidOptimization) {
+    geometry::TriangleMesh mesh = CreatePlaneMesh();
+    std::vector<geometry::RGBDImage> images(2, CreateTexturedPlaneImage());
+    camera::PinholeCameraIntrinsic intrinsic(width, height, focal, focal, cx,
+                                             cy);
+    thrust::host_vector<Eigen::Matrix4f> extrinsics(
+            2, Eigen::Matrix4f::Identity());
+    extrinsics[1](0, 3) = 0.01;
+
+    integration::ColorMapOptimizationOption option;
+    option.non_rigid_camera_coordinate_ = true;
+    option.number_of_vertical_anchors_ = 4;
+    option.maximum_iteration_ = 20;
+    integration::ColorMapOptimization(mesh, images, intrinsic, extrinsics,
+                                      option);
+
+    // The anchor points are regularized, so most of the offset is taken back
+    // by the poses.
+    const Eigen::Matrix4f relative =
+            extrinsics[1] * utility::InverseTransform(extrinsics[0]);
+    EXPECT_LT(relative.block<3, 1>(0, 3).norm(), 0.005);
+
+    // The vertex in front of the principal point has the texture value at
+    // the center of the images.
+    EXPECT_EQ(mesh.vertex_colors_.size(), mesh.vertices_.size());
+    const Eigen::Vector3f center_color = mesh.vertex_colors_[15 * 41 + 20];
+    ExpectEQ(center_color, Eigen::Vector3f::Constant(0.5), 0.05);
+
+    // Invalid options leave the inputs untouched.
+    option.number_of_vertical_anchors_ = 1;
+    thrust::host_vector<Eigen::Matrix4f> invalid(2,
+                                                 Eigen::Matrix4f::Identity());
+    invalid[1](0, 3) = 0.01;
+    integration::ColorMapOptimization(mesh, images, intrinsic, invalid,
+                                      option);
+    EXPECT_FLOAT_EQ(invalid[1](0, 3), 0.01);
+}
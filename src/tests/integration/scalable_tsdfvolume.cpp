@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/integration/scalable_tsdfvolume.h"
+
+#include <algorithm>
+
+#include "tests/test_utility/rgbd.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace cupoch;
+using namespace unit_test;
+
+namespace {
+
+const int width = 64;
+const int height = 48;
+
+}  // namespace
+
+TEST(ScalableTSDFVolume, ExtractTriangleMesh) {
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+
+    integration::ScalableTSDFVolume volume(
+            0.02, 0.06, integration::TSDFVolumeColorType::NoColor, 1);
+    volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    auto mesh = volume.ExtractTriangleMesh();
+    EXPECT_GT(mesh->vertices_.size(), 0u);
+    EXPECT_GT(mesh->triangles_.size(), 0u);
+
+    thrust::host_vector<Eigen::Vector3f> vertices = mesh->vertices_;
+    for (const auto &v : vertices) {
+        EXPECT_NEAR(v[2], 1.0, 0.005);
+    }
+    // the vertices shared by the cubes and the units are welded
+    std::vector<Eigen::Vector3f> sorted(vertices.begin(), vertices.end());
+    auto less = [](const Eigen::Vector3f &a, const Eigen::Vector3f &b) {
+        return std::tie(a[0], a[1], a[2]) < std::tie(b[0], b[1], b[2]);
+    };
+    std::sort(sorted.begin(), sorted.end(), less);
+    auto equal = [](const Eigen::Vector3f &a, const Eigen::Vector3f &b) {
+        return (a.array() == b.array()).all();
+    };
+    EXPECT_EQ(std::unique(sorted.begin(), sorted.end(), equal) -
+                      sorted.begin(),
+              int(sorted.size()));
+    thrust::host_vector<Eigen::Vector3i> triangles = mesh->triangles_;
+    for (const auto &t : triangles) {
+        EXPECT_GE(t.minCoeff(), 0);
+        EXPECT_LT(t.maxCoeff(), int(vertices.size()));
+        EXPECT_TRUE(t[0] != t[1] && t[1] != t[2] && t[2] != t[0]);
+    }
+
+    // the cached mesh is returned when nothing was integrated
+    auto mesh2 = volume.ExtractTriangleMesh();
+    EXPECT_EQ(mesh2->vertices_.size(), mesh->vertices_.size());
+    EXPECT_EQ(mesh2->triangles_.size(), mesh->triangles_.size());
+
+    // integrating the same frame again gives the same surface
+    volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    auto mesh3 = volume.ExtractTriangleMesh();
+    EXPECT_EQ(mesh3->vertices_.size(), mesh->vertices_.size());
+    EXPECT_EQ(mesh3->triangles_.size(), mesh->triangles_.size());
+
+    volume.Reset();
+    EXPECT_EQ(volume.ExtractTriangleMesh()->vertices_.size(), 0u);
+}
+
+TEST(ScalableTSDFVolume, RaycastAndStreaming) {
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    integration::ScalableTSDFVolume volume(
+            0.02, 0.06, integration::TSDFVolumeColorType::NoColor, 1);
+    volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+
+    auto model = volume.Raycast(intrinsic, Eigen::Matrix4f::Identity(), 0.06,
+                                2.0, false);
+    EXPECT_EQ(model->points_.size(), width * height);
+    const Eigen::Vector3f center_point = model->points_[23 * width + 31];
+    const Eigen::Vector3f center_normal = model->normals_[23 * width + 31];
+    EXPECT_NEAR(center_point[2], 1.0, 0.01);
+    EXPECT_NEAR(center_normal[2], -1.0, 0.01);
+
+    const size_t n_points = volume.ExtractPointCloud()->points_.size();
+    EXPECT_GT(n_points, 0u);
+    const size_t n_out =
+            volume.StreamOut(Eigen::Vector3f(0.0, 0.0, 100.0), 1.0);
+    EXPECT_GT(n_out, 0u);
+    EXPECT_EQ(volume.GetNumStreamedOutUnits(), n_out);
+    EXPECT_EQ(volume.ExtractPointCloud()->points_.size(), 0u);
+    EXPECT_EQ(volume.StreamIn(Eigen::Vector3f(0.0, 0.0, 1.0), 100.0), n_out);
+    EXPECT_EQ(volume.GetNumStreamedOutUnits(), 0u);
+    EXPECT_EQ(volume.ExtractPointCloud()->points_.size(), n_points);
+
+    // the copy owns its volume units
+    integration::ScalableTSDFVolume copied(volume);
+    volume.Reset();
+    EXPECT_EQ(copied.ExtractPointCloud()->points_.size(), n_points);
+}
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/integration/surfel_map.h"
+
+#include "tests/test_utility/rgbd.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace cupoch;
+using namespace unit_test;
+
+namespace {
+
+const int width = 64;
+const int height = 48;
+
+}  // namespace
+
+TEST(SurfelMap, Integrate) {
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height, 255, 255, 255);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    integration::SurfelMap map;
+
+    // Every pixel but the border ones creates a surfel.
+    map.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    const size_t n_surfels = (width - 2) * (height - 2);
+    EXPECT_EQ(map.GetNumSurfels(), n_surfels);
+    EXPECT_EQ(map.ExtractPointCloud()->points_.size(), 0u);
+
+    // The same frame is fused into the existing surfels.
+    map.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    EXPECT_EQ(map.GetNumSurfels(), n_surfels);
+    auto index_map = map.RenderIndexMap(intrinsic, Eigen::Matrix4f::Identity());
+    thrust::host_vector<uint8_t> index_data = index_map->data_;
+    const int *indices = reinterpret_cast<const int *>(index_data.data());
+    EXPECT_EQ(indices[0], -1);
+    EXPECT_GE(indices[10 * width + 10], 0);
+
+    // The surfels close to the image center become stable first.
+    for (int i = 0; i < 10; ++i) {
+        map.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    }
+    auto pcd = map.ExtractPointCloud();
+    EXPECT_GT(pcd->points_.size(), 0u);
+    EXPECT_LT(pcd->points_.size(), n_surfels);
+    EXPECT_EQ(pcd->colors_.size(), pcd->points_.size());
+    thrust::host_vector<Eigen::Vector3f> points = pcd->points_;
+    thrust::host_vector<Eigen::Vector3f> normals = pcd->normals_;
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_NEAR(points[i][2], 1.0, THRESHOLD_1E_4);
+        EXPECT_NEAR(normals[i][2], -1.0, THRESHOLD_1E_4);
+    }
+
+    // The unstable surfels are removed once the time window is over.
+    map.unstable_time_window_ = 0;
+    map.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    EXPECT_EQ(map.GetNumSurfels(), map.ExtractPointCloud()->points_.size());
+}
+
+TEST(SurfelMap, IntegrateUnsupportedImage) {
+    const geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    integration::SurfelMap map;
+
+    // An RGB8 map rejects a frame without color.
+    const geometry::RGBDImage no_color(geometry::Image(), rgbd.depth_);
+    map.Integrate(no_color, intrinsic, Eigen::Matrix4f::Identity());
+    EXPECT_EQ(map.GetNumSurfels(), 0u);
+
+    // The map is still usable afterwards.
+    map.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    EXPECT_EQ(map.GetNumSurfels(), size_t((width - 2) * (height - 2)));
+}
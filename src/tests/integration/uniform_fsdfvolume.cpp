@@ -21,6 +21,7 @@
 #include "cupoch/integration/uniform_tsdfvolume.h"
 #include "cupoch/io/class_io/image_io.h"
 #include "cupoch/utility/filesystem.h"
+#include "tests/test_utility/rgbd.h"
 #include "tests/test_utility/unit_test.h"
 
 using namespace cupoch;
@@ -83,7 +84,122 @@ TEST(UniformTSDFVolume, Constructor) {
     EXPECT_EQ(tsdf_volume.length_, length);
     EXPECT_EQ(tsdf_volume.resolution_, resolution);
     EXPECT_EQ(tsdf_volume.voxel_num_, resolution * resolution * resolution);
-    EXPECT_EQ(int(tsdf_volume.voxels_.size()), tsdf_volume.voxel_num_);
+    EXPECT_EQ(tsdf_volume.voxel_format_, integration::TSDFVoxelFormat::Float32);
+    EXPECT_EQ(tsdf_volume.GetVoxelByteSize(), sizeof(geometry::TSDFVoxel));
+    EXPECT_EQ(tsdf_volume.voxels_.size(),
+              tsdf_volume.voxel_num_ * tsdf_volume.GetVoxelByteSize());
+}
+
+TEST(UniformTSDFVolume, CompactVoxels) {
+    const int width = 64;
+    const int height = 48;
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height, 200, 100, 50);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+
+    integration::UniformTSDFVolume float_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::RGB8);
+    integration::UniformTSDFVolume compact_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::RGB8,
+            Eigen::Vector3f::Zero(), integration::TSDFVoxelFormat::Compact);
+    EXPECT_EQ(compact_volume.GetVoxelByteSize(), 8u);
+    EXPECT_EQ(compact_volume.voxels_.size(), compact_volume.voxel_num_ * 8u);
+    integration::UniformTSDFVolume nocolor_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::NoColor,
+            Eigen::Vector3f::Zero(), integration::TSDFVoxelFormat::Compact);
+    EXPECT_EQ(nocolor_volume.GetVoxelByteSize(), 4u);
+
+    for (int i = 0; i < 3; ++i) {
+        float_volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+        compact_volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+        nocolor_volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+    }
+
+    auto float_pcd = float_volume.ExtractPointCloud();
+    auto compact_pcd = compact_volume.ExtractPointCloud();
+    auto nocolor_pcd = nocolor_volume.ExtractPointCloud();
+    EXPECT_GT(float_pcd->points_.size(), 0u);
+    EXPECT_EQ(compact_pcd->points_.size(), float_pcd->points_.size());
+    EXPECT_EQ(nocolor_pcd->points_.size(), float_pcd->points_.size());
+    EXPECT_TRUE(nocolor_pcd->colors_.empty());
+    thrust::host_vector<Eigen::Vector3f> points = compact_pcd->points_;
+    for (const auto& pt : points) {
+        EXPECT_NEAR(pt[2], 1.0, 1.0e-3);
+    }
+    thrust::host_vector<Eigen::Vector3f> colors = compact_pcd->colors_;
+    for (const auto& c : colors) {
+        ExpectEQ(c, Eigen::Vector3f(200.0 / 255.0, 100.0 / 255.0,
+                                    50.0 / 255.0),
+                 THRESHOLD_1E_4);
+    }
+
+    auto float_mesh = float_volume.ExtractTriangleMesh();
+    auto compact_mesh = compact_volume.ExtractTriangleMesh();
+    EXPECT_EQ(compact_mesh->vertices_.size(), float_mesh->vertices_.size());
+    EXPECT_EQ(compact_mesh->triangles_.size(), float_mesh->triangles_.size());
+
+    auto compact_raycast = compact_volume.Raycast(
+            intrinsic, Eigen::Matrix4f::Identity(), 0.12);
+    EXPECT_GT(compact_raycast->points_.size(), 0u);
+    thrust::host_vector<Eigen::Vector3f> ray_points = compact_raycast->points_;
+    for (const auto& pt : ray_points) {
+        EXPECT_NEAR(pt[2], 1.0, 0.01);
+    }
+
+    // Reset keeps the storage of the voxel format.
+    compact_volume.Reset();
+    EXPECT_EQ(compact_volume.voxels_.size(), compact_volume.voxel_num_ * 8u);
+    EXPECT_EQ(compact_volume.ExtractPointCloud()->points_.size(), 0u);
+}
+
+TEST(UniformTSDFVolume, ExtractTriangleMesh) {
+    const int width = 64;
+    const int height = 48;
+    geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    integration::UniformTSDFVolume volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::NoColor);
+    volume.Integrate(rgbd, intrinsic, Eigen::Matrix4f::Identity());
+
+    // The vertices shared by neighboring cubes are generated once.
+    auto mesh = volume.ExtractTriangleMesh();
+    EXPECT_GT(mesh->triangles_.size(), 0u);
+    EXPECT_TRUE(mesh->vertex_colors_.empty());
+    geometry::TriangleMesh dedup(*mesh);
+    dedup.RemoveDuplicatedVertices();
+    EXPECT_EQ(dedup.vertices_.size(), mesh->vertices_.size());
+    // Every vertex belongs to a triangle.
+    geometry::TriangleMesh referenced(*mesh);
+    referenced.RemoveUnreferencedVertices();
+    EXPECT_EQ(referenced.vertices_.size(), mesh->vertices_.size());
+    thrust::host_vector<Eigen::Vector3f> vertices = mesh->vertices_;
+    for (const auto& v : vertices) {
+        EXPECT_NEAR(v[2], 1.0, 1.0e-3);
+    }
+
+    const geometry::AxisAlignedBoundingBox<3> roi(
+            Eigen::Vector3f(-0.2, -0.2, 0.5), Eigen::Vector3f(0.2, 0.2, 1.5));
+    auto roi_mesh = volume.ExtractTriangleMesh(roi);
+    EXPECT_GT(roi_mesh->triangles_.size(), 0u);
+    EXPECT_LT(roi_mesh->vertices_.size(), mesh->vertices_.size());
+    thrust::host_vector<Eigen::Vector3f> roi_vertices = roi_mesh->vertices_;
+    for (const auto& v : roi_vertices) {
+        EXPECT_GE(v[0], -0.2 - volume.voxel_length_);
+        EXPECT_LE(v[0], 0.2 + volume.voxel_length_);
+        EXPECT_GE(v[1], -0.2 - volume.voxel_length_);
+        EXPECT_LE(v[1], 0.2 + volume.voxel_length_);
+    }
+
+    auto simplified = volume.ExtractTriangleMesh(roi, 0.1);
+    EXPECT_GT(simplified->triangles_.size(), 0u);
+    EXPECT_LT(simplified->vertices_.size(), roi_mesh->vertices_.size());
+    thrust::host_vector<Eigen::Vector3f> simplified_vertices =
+            simplified->vertices_;
+    for (const auto& v : simplified_vertices) {
+        EXPECT_NEAR(v[2], 1.0, 1.0e-3);
+    }
+    EXPECT_TRUE(roi_mesh->SimplifyVertexClustering(0.0)->IsEmpty());
 }
 
 TEST(UniformTSDFVolume, RealData) {
@@ -181,4 +297,63 @@ TEST(UniformTSDFVolume, RealData) {
     }
     ExpectEQ(color_sum, Eigen::Vector3f(2096.428416, 2096.428416, 2096.428416),
              /*threshold*/ 0.1);
-}
\ No newline at end of file
+}
+
+TEST(UniformTSDFVolume, IntegrateBatch) {
+    const int width = 64;
+    const int height = 48;
+    const geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+
+    std::vector<geometry::RGBDImage> images;
+    thrust::host_vector<Eigen::Matrix4f> extrinsics;
+    for (int i = 0; i < 4; ++i) {
+        images.push_back(rgbd);
+        Eigen::Matrix4f extrinsic = Eigen::Matrix4f::Identity();
+        extrinsic(0, 3) = 0.05 * i;
+        extrinsic(2, 3) = 0.01 * i;
+        extrinsics.push_back(extrinsic);
+    }
+
+    integration::UniformTSDFVolume sequential_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::NoColor);
+    integration::UniformTSDFVolume batch_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::NoColor);
+    for (size_t i = 0; i < images.size(); ++i) {
+        sequential_volume.Integrate(images[i], intrinsic, extrinsics[i]);
+    }
+    batch_volume.IntegrateBatch(images, intrinsic, extrinsics);
+
+    thrust::host_vector<geometry::TSDFVoxel> sequential_voxels(
+            sequential_volume.voxel_num_);
+    thrust::host_vector<geometry::TSDFVoxel> batch_voxels(
+            batch_volume.voxel_num_);
+    ASSERT_EQ(sequential_volume.voxels_.size(), batch_volume.voxels_.size());
+    thrust::host_vector<uint8_t> sequential_data = sequential_volume.voxels_;
+    thrust::host_vector<uint8_t> batch_data = batch_volume.voxels_;
+    memcpy(sequential_voxels.data(), sequential_data.data(),
+           sequential_data.size());
+    memcpy(batch_voxels.data(), batch_data.data(), batch_data.size());
+    // Voxels projecting exactly on a pixel border may differ by rounding.
+    int n_observed = 0;
+    int n_different = 0;
+    for (int i = 0; i < sequential_volume.voxel_num_; ++i) {
+        if (batch_voxels[i].weight_ > 0.0f) ++n_observed;
+        if (batch_voxels[i].weight_ != sequential_voxels[i].weight_) {
+            ++n_different;
+            continue;
+        }
+        EXPECT_NEAR(batch_voxels[i].tsdf_, sequential_voxels[i].tsdf_,
+                    THRESHOLD_1E_4);
+    }
+    EXPECT_GT(n_observed, 0);
+    EXPECT_LE(n_different, n_observed / 100);
+
+    // Mismatched inputs leave the volume untouched.
+    extrinsics.pop_back();
+    integration::UniformTSDFVolume empty_volume(
+            2.56, 64, 0.12, integration::TSDFVolumeColorType::NoColor);
+    empty_volume.IntegrateBatch(images, intrinsic, extrinsics);
+    EXPECT_EQ(empty_volume.ExtractPointCloud()->points_.size(), 0u);
+}
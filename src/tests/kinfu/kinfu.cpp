@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ **/
+#include "cupoch/kinfu/kinfu.h"
+
+#include "tests/test_utility/rgbd.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace cupoch;
+using namespace unit_test;
+
+TEST(KinfuPipeline, ProcessFrame) {
+    const int width = 64;
+    const int height = 48;
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    kinfu::KinfuOption option;
+    option.tsdf_length_ = 2.0;
+    option.tsdf_resolution_ = 128;
+    option.tsdf_origin_ = Eigen::Vector3f(-1.0, -1.0, 0.0);
+    kinfu::KinfuPipeline pipeline(intrinsic, option);
+    const geometry::RGBDImage rgbd = CreatePlaneImage(width, height);
+
+    // The frames after the first one are tracked against the raycast model,
+    // and the camera does not move.
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(pipeline.ProcessFrame(rgbd));
+        EXPECT_EQ(pipeline.frame_id_, i + 1);
+        ExpectEQ(pipeline.cur_pose_, Eigen::Matrix4f::Identity().eval(),
+                 1.0e-3);
+    }
+    auto pcd = pipeline.ExtractPointCloud();
+    EXPECT_GT(pcd->points_.size(), 0u);
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+**/
+#include "cupoch/registration/registration.h"
+
+#include <Eigen/Geometry>
+
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(Registration, RegistrationProjectiveICP) {
+    const int width = 64;
+    const int height = 48;
+    camera::PinholeCameraIntrinsic intrinsic(width, height, 50.0, 50.0, 31.5,
+                                             23.5);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // Organized wavy surface in front of the camera.
+    thrust::host_vector<Vector3f> points(width * height);
+    for (int v = 0; v < height; ++v) {
+        for (int u = 0; u < width; ++u) {
+            const float z = 2.0 + 0.2 * std::sin(0.3 * u) +
+                            0.2 * std::cos(0.3 * v);
+            points[v * width + u] = Vector3f((u - 31.5) / 50.0 * z,
+                                             (v - 23.5) / 50.0 * z, z);
+        }
+    }
+    thrust::host_vector<Vector3f> normals(width * height,
+                                          Vector3f(nan, nan, nan));
+    thrust::host_vector<Vector3f> valid_points;
+    for (int v = 0; v < height - 1; ++v) {
+        for (int u = 0; u < width - 1; ++u) {
+            const int i = v * width + u;
+            const Vector3f n = (points[i + 1] - points[i])
+                                       .cross(points[i + width] - points[i])
+                                       .normalized();
+            normals[i] = (n(2) > 0) ? -n : n;
+            valid_points.push_back(points[i]);
+        }
+    }
+    for (int v = 0; v < height; ++v) {
+        points[v * width + width - 1] = Vector3f(nan, nan, nan);
+    }
+    for (int u = 0; u < width; ++u) {
+        points[(height - 1) * width + u] = Vector3f(nan, nan, nan);
+    }
+    geometry::PointCloud target;
+    target.SetPoints(points);
+    target.SetNormals(normals);
+
+    Matrix4f ref_tf = Matrix4f::Identity();
+    ref_tf.block<3, 3>(0, 0) =
+            AngleAxisf(0.02, Vector3f(0.3, 1.0, 0.2).normalized())
+                    .toRotationMatrix();
+    ref_tf.block<3, 1>(0, 3) = Vector3f(0.02, -0.01, 0.03);
+    geometry::PointCloud source;
+    source.SetPoints(valid_points);
+    source.Transform(utility::InverseTransform(ref_tf));
+
+    auto res = registration::RegistrationProjectiveICP(
+            source, target, intrinsic, Matrix4f::Identity(), 0.1);
+    EXPECT_GT(res.fitness_, 0.9);
+    EXPECT_LT(res.inlier_rmse_, 1.0e-3);
+    EXPECT_TRUE(Matrix4f(res.transformation_).isApprox(ref_tf, 1.0e-2));
+    EXPECT_GT(res.correspondence_set_.size(), 0);
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2020 Neka-Nat
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+**/
+#include "tests/test_utility/rgbd.h"
+
+#include <thrust/host_vector.h>
+
+#include <cstring>
+
+using namespace cupoch;
+
+// ----------------------------------------------------------------------------
+// Frame of a plane at depth 1 with a uniform color.
+// ----------------------------------------------------------------------------
+geometry::RGBDImage unit_test::CreatePlaneImage(
+        int width, int height, uint8_t r, uint8_t g, uint8_t b) {
+    thrust::host_vector<float> depth_values(width * height, 1.0);
+    thrust::host_vector<uint8_t> depth_data(depth_values.size() *
+                                            sizeof(float));
+    memcpy(depth_data.data(), depth_values.data(), depth_data.size());
+    geometry::Image depth;
+    depth.Prepare(width, height, 1, 4);
+    depth.SetData(depth_data);
+    thrust::host_vector<uint8_t> color_data(width * height * 3);
+    for (size_t i = 0; i < color_data.size(); i += 3) {
+        color_data[i] = r;
+        color_data[i + 1] = g;
+        color_data[i + 2] = b;
+    }
+    geometry::Image color;
+    color.Prepare(width, height, 3, 1);
+    color.SetData(color_data);
+    return geometry::RGBDImage(color, depth);
+}